@@ -173,23 +173,37 @@ LOCAL_SRC_FILES := \
 	src/hddsp/unicode.c \
 	src/addon.cpp \
 	src/channeladd.cpp \
+	src/channelizer.cpp \
+	src/channelscanner.cpp \
 	src/channelsettings.cpp \
 	src/database.cpp \
+	src/devicehub.cpp \
+	src/devicemanager.cpp \
 	src/dabmuxscanner.cpp \
+	src/dabprobe.cpp \
 	src/dabstream.cpp \
 	src/filedevice.cpp \
+	src/fftwcache.cpp \
+	src/flacencoder.cpp \
+	src/fmchannelbank.cpp \
 	src/fmstream.cpp \
 	src/hdmuxscanner.cpp \
 	src/hdstream.cpp \
 	src/id3v1tag.cpp \
 	src/id3v2tag.cpp \
+	src/iqconvert.cpp \
 	src/libusb_exception.cpp \
 	src/rdsdecoder.cpp \
+	src/recorder.cpp \
+	src/recordingdevice.cpp \
+	src/recordingstream.cpp \
+	src/replaybuffer.cpp \
 	src/signalmeter.cpp \
 	src/sqlite_exception.cpp \
 	src/uecp.cpp \
 	src/usbdevice.cpp \
 	src/tcpdevice.cpp \
+	src/timeshiftstream.cpp \
 	src/wxstream.cpp
 
 include $(BUILD_SHARED_LIBRARY)
@@ -411,6 +425,39 @@ LOCAL_SRC_FILES := \
 	
 include $(BUILD_EXECUTABLE)
 
+# rtl_tcpx
+#
+include $(CLEAR_VARS)
+LOCAL_MODULE := rtl_tcpx
+
+LOCAL_C_INCLUDES += \
+	depends/libusb/$(TARGET_ABI)/include \
+	depends/rtl-sdr/include
+	
+LOCAL_CFLAGS += \
+	-DNDEBUG
+
+LOCAL_CPPFLAGS += \
+	-std=c++14 \
+	-Wno-unknown-pragmas
+
+LOCAL_STATIC_LIBRARIES += \
+	libusb-prebuilt
+
+LOCAL_LDLIBS += \
+	-llog
+
+LOCAL_SRC_FILES := \
+	depends/rtl-sdr/src/librtlsdr.c \
+	depends/rtl-sdr/src/tuner_e4k.c \
+	depends/rtl-sdr/src/tuner_fc0012.c \
+	depends/rtl-sdr/src/tuner_fc0013.c \
+	depends/rtl-sdr/src/tuner_fc2580.c \
+	depends/rtl-sdr/src/tuner_r82xx.c \
+	src/rtl_tcpx.cpp
+	
+include $(BUILD_EXECUTABLE)
+
 # rtl_test
 #
 include $(CLEAR_VARS)
@@ -24,12 +24,16 @@
 
 #include "addon.h"
 
+#include <algorithm>
 #include <assert.h>
+#include <chrono>
 #include <kodi/Filesystem.h>
 #include <kodi/General.h>
 #include <kodi/gui/dialogs/FileBrowser.h>
 #include <kodi/gui/dialogs/OK.h>
+#include <kodi/gui/dialogs/Progress.h>
 #include <kodi/gui/dialogs/Select.h>
+#include <map>
 #include <rapidjson/document.h>
 #include <rapidjson/error/en.h>
 #include <rapidjson/prettywriter.h>
@@ -42,15 +46,20 @@
 #endif
 
 #include "channeladd.h"
+#include "channelscanner.h"
 #include "channelsettings.h"
 #include "dbtypes.h"
+#include "fftwcache.h"
 #include "filedevice.h"
 #include "dabstream.h"
 #include "fmstream.h"
 #include "hdstream.h"
+#include "recordingdevice.h"
+#include "recordingstream.h"
 #include "string_exception.h"
 #include "sqlite_exception.h"
 #include "tcpdevice.h"
+#include "timeshiftstream.h"
 #include "usbdevice.h"
 #include "wxstream.h"
 
@@ -141,7 +150,7 @@ bool addon::channeladd_dab(struct settings const& settings, struct channelprops&
 	tunerprops.freqcorrection = settings.device_frequency_correction;
 
 	// Create and initialize a channel settings dialog instance to allow the user to fine-tune the channel
-	std::unique_ptr<channelsettings> settingsdialog = channelsettings::create(create_device(settings), tunerprops, channelprops, true);
+	std::unique_ptr<channelsettings> settingsdialog = channelsettings::create(create_device(settings, devicepriority::scan), tunerprops, channelprops, true);
 	settingsdialog->DoModal();
 
 	if(settingsdialog->get_dialog_result()) {
@@ -231,7 +240,7 @@ bool addon::channeladd_fm(struct settings const& settings, struct channelprops&
 		tunerprops.freqcorrection = settings.device_frequency_correction;
 
 		// Create and initialize the dialog box against a new signal meter instance
-		std::unique_ptr<channelsettings> settingsdialog = channelsettings::create(create_device(settings), tunerprops, channelprops, true);
+		std::unique_ptr<channelsettings> settingsdialog = channelsettings::create(create_device(settings, devicepriority::scan), tunerprops, channelprops, true);
 		settingsdialog->DoModal();
 
 		if(settingsdialog->get_dialog_result()) {
@@ -290,7 +299,7 @@ bool addon::channeladd_hd(struct settings const& settings, struct channelprops&
 		tunerprops.freqcorrection = settings.device_frequency_correction;
 
 		// Create and initialize a channel settings dialog instance to allow the user to fine-tune the channel
-		std::unique_ptr<channelsettings> settingsdialog = channelsettings::create(create_device(settings), tunerprops, channelprops, true);
+		std::unique_ptr<channelsettings> settingsdialog = channelsettings::create(create_device(settings, devicepriority::scan), tunerprops, channelprops, true);
 		settingsdialog->DoModal();
 
 		if(settingsdialog->get_dialog_result()) {
@@ -404,7 +413,7 @@ bool addon::channeladd_wx(struct settings const& settings, struct channelprops&
 	tunerprops.freqcorrection = settings.device_frequency_correction;
 
 	// Create and initialize a channel settings dialog instance to allow the user to fine-tune the channel
-	std::unique_ptr<channelsettings> settingsdialog = channelsettings::create(create_device(settings), tunerprops, channelprops, true);
+	std::unique_ptr<channelsettings> settingsdialog = channelsettings::create(create_device(settings, devicepriority::scan), tunerprops, channelprops, true);
 	settingsdialog->DoModal();
 
 	if(settingsdialog->get_dialog_result() == true) {
@@ -445,47 +454,196 @@ inline struct settings addon::copy_settings(void) const
 // Arguments:
 //
 //	settings		- Current addon settings structure
+//	priority		- Priority of the device request
 
-std::unique_ptr<rtldevice> addon::create_device(struct settings const& settings) const
+std::unique_ptr<rtldevice> addon::create_device(struct settings const& settings, enum devicepriority priority) const
 {
-	// Pull a database handle out of the connection pool
-	connectionpool::handle dbhandle(m_connpool);
+	std::vector<std::string>						names;		// File names
+	std::vector<std::pair<std::string, uint32_t>>	files;		// File paths and sample rates
 
-	// File device
-	if(has_rawfiles(dbhandle)) {
+	// Enumerate the available raw files registered in the database; the database handle is
+	// released before waiting on the tuner device pool, which can block for some time.  Only
+	// live streams and the interactive channel dialogs can prompt for a file; recordings and
+	// background jobs don't run on the GUI thread and must always use a real tuner device
+	if((priority == devicepriority::live) || (priority == devicepriority::scan)) {
 
-		std::vector<std::string>						names;		// File names
-		std::vector<std::pair<std::string, uint32_t>>	files;		// File paths and sample rates
+		connectionpool::handle dbhandle(m_connpool);
 
-		// Enumerate the available raw files registered in the database
-		enumerate_rawfiles(dbhandle, [&](struct rawfile const& item) -> void {
+		if(has_rawfiles(dbhandle)) enumerate_rawfiles(dbhandle, [&](struct rawfile const& item) -> void {
 
-			if((item.path != nullptr) && (item.name != nullptr) && (item.samplerate > 0)) {
+			if((item.path != nullptr) && (item.name != nullptr)) {
 
 				names.emplace_back(std::string(item.name));
 				files.emplace_back(std::string(item.path), item.samplerate);
 			}
 		});
+	}
+
+	// File device
+	if(!files.empty()) {
 
 		// Prompt to select from among the available files, or cancel the operation
 		int selected = kodi::gui::dialogs::Select::Show(kodi::addon::GetLocalizedString(30412), names, -1, 0);
 		if(selected >= 0) {
 
 			auto const& item = files[selected];
-			return filedevice::create(item.first.c_str(), item.second);
+			return filedevice::create(item.first.c_str(), item.second, !settings.device_rawfile_maxspeed);
 		}
 	}
 
-	// USB device
-	if(settings.device_connection == device_connection::usb)
-		return usbdevice::create(settings.device_connection_usb_index);
+	// Refresh the tuner device pool endpoints and acquire any available tuner from it; the
+	// recording scheduler doesn't wait for a tuner, it tries again on the next pass instead
+	m_devicemanager->set_endpoints(enumerate_device_endpoints(settings));
+	std::unique_ptr<rtldevice> device = (priority == devicepriority::recording) ? m_devicemanager->try_acquire(priority) : m_devicemanager->acquire(priority);
+	if(!device) throw string_exception("no RTL-SDR tuner devices are available");
 
-	// Network device
-	if(settings.device_connection == device_connection::rtltcp)
-		return tcpdevice::create(settings.device_connection_tcp_host.c_str(), static_cast<uint16_t>(settings.device_connection_tcp_port));
+	// Live stream devices can keep the most recent raw I/Q samples for an instant replay
+	if((settings.device_replay_seconds > 0) && (priority == devicepriority::live))
+		device = m_replaybuffer->attach(std::move(device), static_cast<uint32_t>(settings.device_replay_seconds));
 
-	// Unknown device type
-	throw string_exception("invalid device_connection type specified");
+	// Live stream devices can be decorated to record the raw I/Q samples for diagnostics
+	if(settings.device_record_iq && (priority == devicepriority::live)) {
+
+		std::string folder = UserPath() + "/iqrecordings";
+		if(kodi::vfs::DirectoryExists(folder) || kodi::vfs::CreateDirectory(folder)) {
+
+			log_info(__func__, ": recording raw I/Q samples into folder ", folder.c_str());
+			return recordingdevice::create(std::move(device), folder.c_str());
+		}
+
+		log_warning(__func__, ": unable to create raw I/Q recording folder ", folder.c_str());
+	}
+
+	return device;
+}
+
+//---------------------------------------------------------------------------
+// addon::create_stream (private)
+//
+// Creates the PVR stream instance for a channel
+//
+// Arguments:
+//
+//	settings		- Current addon settings
+//	channelprops	- Channel properties
+//	subchannel		- Subchannel number
+//	priority		- Device lease priority
+
+std::unique_ptr<pvrstream> addon::create_stream(struct settings const& settings, struct channelprops const& channelprops, uint32_t subchannel, enum devicepriority priority) const
+{
+	// Set up the tuner device properties
+	struct tunerprops tunerprops = {};
+	tunerprops.freqcorrection = settings.device_frequency_correction;
+
+	// FM Radio
+	//
+	if(channelprops.modulation == modulation::fm) {
+
+		// Set up the FM digital signal processor properties
+		struct fmprops fmprops = {};
+		fmprops.decoderds = settings.fmradio_enable_rds;
+		fmprops.isnorthamerica = is_region_northamerica(settings);
+		fmprops.samplerate = settings.fmradio_sample_rate;
+		fmprops.downsamplequality = static_cast<int>(settings.fmradio_downsample_quality);
+		fmprops.outputrate = settings.fmradio_output_samplerate;
+		fmprops.outputgain = settings.fmradio_output_gain;
+
+		// Log information about the stream for diagnostic purposes
+		log_info(__func__, ": Creating fmstream for channel \"", channelprops.name, "\"");
+		log_info(__func__, ": tunerprops.freqcorrection = ", tunerprops.freqcorrection, " PPM");
+		log_info(__func__, ": fmprops.decoderds = ", (fmprops.decoderds) ? "true" : "false");
+		log_info(__func__, ": fmprops.isnorthamerica = ", (fmprops.isnorthamerica) ? "true" : "false");
+		log_info(__func__, ": fmrops.samplerate = ", fmprops.samplerate, " Hz");
+		log_info(__func__, ": fmprops.downsamplequality = ", downsample_quality_to_string(static_cast<enum downsample_quality>(fmprops.downsamplequality)));
+		log_info(__func__, ": fmprops.outputgain = ", fmprops.outputgain, " dB");
+		log_info(__func__, ": fmprops.outputrate = ", fmprops.outputrate, " Hz");
+		log_info(__func__, ": channelprops.frequency = ", channelprops.frequency, " Hz");
+		log_info(__func__, ": channelprops.autogain = ", (channelprops.autogain) ? "true" : "false");
+		log_info(__func__, ": channelprops.manualgain = ", channelprops.manualgain / 10, " dB");
+		log_info(__func__, ": channelprops.freqcorrection = ", channelprops.freqcorrection, " PPM");
+
+		// Create the FM Radio stream
+		return fmstream::create(create_device(settings, priority), tunerprops, channelprops, fmprops);
+	}
+
+	// HD Radio
+	//
+	if(channelprops.modulation == modulation::hd) {
+
+		// Set up the HD Radio digital signal processor properties
+		struct hdprops hdprops = {};
+		hdprops.outputgain = settings.hdradio_output_gain;
+
+		// Log information about the stream for diagnostic purposes
+		log_info(__func__, ": Creating hdstream for channel \"", channelprops.name, "\"");
+		log_info(__func__, ": subchannel = ", subchannel);
+		log_info(__func__, ": tunerprops.freqcorrection = ", tunerprops.freqcorrection, " PPM");
+		log_info(__func__, ": hdprops.outputgain = ", hdprops.outputgain, " dB");
+		log_info(__func__, ": channelprops.frequency = ", channelprops.frequency, " Hz");
+		log_info(__func__, ": channelprops.autogain = ", (channelprops.autogain) ? "true" : "false");
+		log_info(__func__, ": channelprops.manualgain = ", channelprops.manualgain / 10, " dB");
+		log_info(__func__, ": channelprops.freqcorrection = ", channelprops.freqcorrection, " PPM");
+		if(channelprops.acquisition.valid) log_info(__func__, ": channelprops.acquisition.hdcfo = ", channelprops.acquisition.hdcfo);
+
+		// Create the HD Radio stream
+		return hdstream::create(create_device(settings, priority), tunerprops, channelprops, hdprops, subchannel);
+	}
+
+	// DAB
+	//
+	if(channelprops.modulation == modulation::dab) {
+
+		// Set up the DAB digital signal processor properties
+		struct dabprops dabprops = {};
+		dabprops.outputgain = settings.dabradio_output_gain;
+		dabprops.passthrough = settings.dabradio_passthrough;
+
+		// Log information about the stream for diagnostic purposes
+		log_info(__func__, ": Creating dabstream for channel \"", channelprops.name, "\"");
+		log_info(__func__, ": subchannel = ", subchannel);
+		log_info(__func__, ": tunerprops.freqcorrection = ", tunerprops.freqcorrection, " PPM");
+		log_info(__func__, ": dabrops.outputgain = ", dabprops.outputgain, " dB");
+		log_info(__func__, ": dabprops.passthrough = ", (dabprops.passthrough) ? "true" : "false");
+		log_info(__func__, ": channelprops.frequency = ", channelprops.frequency, " Hz");
+		log_info(__func__, ": channelprops.autogain = ", (channelprops.autogain) ? "true" : "false");
+		log_info(__func__, ": channelprops.manualgain = ", channelprops.manualgain / 10, " dB");
+		log_info(__func__, ": channelprops.freqcorrection = ", channelprops.freqcorrection, " PPM");
+		if(channelprops.acquisition.valid) {
+
+			log_info(__func__, ": channelprops.acquisition.dabfinecorrector = ", channelprops.acquisition.dabfinecorrector, " Hz");
+			log_info(__func__, ": channelprops.acquisition.dabcoarsecorrector = ", channelprops.acquisition.dabcoarsecorrector, " Hz");
+		}
+
+		// Create the DAB stream
+		return dabstream::create(create_device(settings, priority), tunerprops, channelprops, dabprops, subchannel);
+	}
+
+	// Weather Radio
+	//
+	if(channelprops.modulation == modulation::wx) {
+
+		// Set up the FM digital signal processor properties
+		struct wxprops wxprops = {};
+		wxprops.samplerate = settings.wxradio_sample_rate;
+		wxprops.outputrate = settings.wxradio_output_samplerate;
+		wxprops.outputgain = settings.wxradio_output_gain;
+
+		// Log information about the stream for diagnostic purposes
+		log_info(__func__, ": Creating wxstream for channel \"", channelprops.name, "\"");
+		log_info(__func__, ": tunerprops.freqcorrection = ", tunerprops.freqcorrection, " PPM");
+		log_info(__func__, ": wxprops.samplerate = ", wxprops.samplerate, " Hz");
+		log_info(__func__, ": wxprops.outputgain = ", wxprops.outputgain, " dB");
+		log_info(__func__, ": wxprops.outputrate = ", wxprops.outputrate, " Hz");
+		log_info(__func__, ": channelprops.frequency = ", channelprops.frequency, " Hz");
+		log_info(__func__, ": channelprops.autogain = ", (channelprops.autogain) ? "true" : "false");
+		log_info(__func__, ": channelprops.manualgain = ", channelprops.manualgain / 10, " dB");
+		log_info(__func__, ": channelprops.freqcorrection = ", channelprops.freqcorrection, " PPM");
+
+		// Create the Weather Radio stream
+		return wxstream::create(create_device(settings, priority), tunerprops, channelprops, wxprops);
+	}
+
+	throw string_exception("channel ", channelprops.name.c_str(), " has an unknown modulation type");
 }
 
 //---------------------------------------------------------------------------
@@ -529,6 +687,123 @@ std::string addon::device_connection_to_string(enum device_connection connection
 	return "Unknown";
 }
 
+//---------------------------------------------------------------------------
+// addon::enumerate_device_endpoints (private)
+//
+// Enumerates the tuner device endpoints that make up the device pool
+//
+// Arguments:
+//
+//	settings		- Current addon settings structure
+
+std::vector<devicemanager::endpoint> addon::enumerate_device_endpoints(struct settings const& settings) const
+{
+	std::vector<devicemanager::endpoint> endpoints;
+
+	// USB devices
+	if(settings.device_connection == device_connection::usb) {
+
+		// The configured device index is always the preferred tuner
+		uint32_t const preferred = static_cast<uint32_t>(settings.device_connection_usb_index);
+		endpoints.push_back({ "usb:" + std::to_string(preferred), [=]() -> std::unique_ptr<rtldevice> { return usbdevice::create(preferred); } });
+
+		// If all connected devices are to be used, add every other device index to the pool
+		if(settings.device_connection_usb_all) {
+
+			uint32_t const count = usbdevice::get_device_count();
+			for(uint32_t index = 0; index < count; index++) {
+
+				if(index == preferred) continue;
+				endpoints.push_back({ "usb:" + std::to_string(index), [=]() -> std::unique_ptr<rtldevice> { return usbdevice::create(index); } });
+			}
+		}
+	}
+
+	// Network devices
+	else if(settings.device_connection == device_connection::rtltcp) {
+
+		// add_endpoint (local)
+		//
+		// Adds an rtl_tcp endpoint to the pool, ignoring any duplicates
+		auto add_endpoint = [&](std::string const& host, uint16_t port) -> void {
+
+			std::string key = "tcp:" + host + ":" + std::to_string(port);
+			for(auto const& endpoint : endpoints) if(endpoint.key == key) return;
+			endpoints.push_back({ key, [=]() -> std::unique_ptr<rtldevice> { return tcpdevice::create(host.c_str(), port); } });
+		};
+
+		// The configured rtl_tcp server is always the preferred tuner
+		uint16_t const defaultport = static_cast<uint16_t>(settings.device_connection_tcp_port);
+		add_endpoint(settings.device_connection_tcp_host, defaultport);
+
+		// Additional rtl_tcp servers are specified as host[:port] or [address][:port] separated
+		// by commas, semicolons or spaces; the bracketed form is required for IPv6 literals
+		std::string const& additional = settings.device_connection_tcp_additional;
+		size_t pos = 0;
+		while(pos < additional.length()) {
+
+			size_t end = additional.find_first_of(",; ", pos);
+			if(end == std::string::npos) end = additional.length();
+
+			std::string const item = additional.substr(pos, end - pos);
+			pos = end + 1;
+			if(item.empty()) continue;
+
+			std::string host;
+			std::string portstr;
+
+			if(item[0] == '[') {
+
+				// [address] or [address]:port
+				size_t const close = item.find(']');
+				if((close == std::string::npos) || ((close + 1 < item.length()) && (item[close + 1] != ':'))) {
+
+					log_warning(__func__, ": ignoring invalid rtl_tcp endpoint \"", item.c_str(), "\"");
+					continue;
+				}
+
+				host = item.substr(1, close - 1);
+				if(close + 1 < item.length()) portstr = item.substr(close + 2);
+				else portstr = std::to_string(defaultport);
+			}
+
+			else {
+
+				// host or host:port; more than one colon is an unbracketed IPv6 address
+				size_t const colon = item.find(':');
+				if((colon != std::string::npos) && (item.find(':', colon + 1) != std::string::npos)) {
+
+					log_warning(__func__, ": ignoring invalid rtl_tcp endpoint \"", item.c_str(), "\" (IPv6 addresses must be enclosed in brackets)");
+					continue;
+				}
+
+				host = item.substr(0, colon);
+				if(colon != std::string::npos) portstr = item.substr(colon + 1);
+				else portstr = std::to_string(defaultport);
+			}
+
+			// The port must be entirely numeric and in the range 1 - 65535
+			unsigned long port = 0;
+			bool const valid = (!host.empty() && !portstr.empty() && (portstr.length() <= 5) &&
+				(portstr.find_first_not_of("0123456789") == std::string::npos));
+			if(valid) port = strtoul(portstr.c_str(), nullptr, 10);
+
+			if(!valid || (port < 1) || (port > 65535)) {
+
+				log_warning(__func__, ": ignoring invalid rtl_tcp endpoint \"", item.c_str(), "\"");
+				continue;
+			}
+
+			add_endpoint(host, static_cast<uint16_t>(port));
+		}
+	}
+
+	// Unknown device type
+	else throw string_exception("invalid device_connection type specified");
+
+	return endpoints;
+}
+
 //---------------------------------------------------------------------------
 // addon::is_region_northamerica (private)
 //
@@ -872,6 +1147,121 @@ void addon::menuhook_importchannels(void)
 	}
 }
 
+//---------------------------------------------------------------------------
+// addon::menuhook_savereplay (private)
+//
+// Menu hook to save the instant replay buffer
+//
+// Arguments:
+//
+//	NONE
+
+void addon::menuhook_savereplay(void)
+{
+	std::string						filename;				// Saved recording file name
+
+	try {
+
+		// The recordings are saved alongside any raw I/Q recordings of live streams
+		std::string folder = UserPath() + "/iqrecordings";
+		if(!kodi::vfs::DirectoryExists(folder) && !kodi::vfs::CreateDirectory(folder))
+			throw string_exception("unable to create folder ", folder.c_str());
+
+		uint64_t samples = (m_replaybuffer) ? m_replaybuffer->save(folder.c_str(), filename) : 0;
+		if(samples == 0) {
+
+			kodi::gui::dialogs::OK::ShowAndGetInput(kodi::addon::GetLocalizedString(30420), "The instant replay buffer is empty.",
+				"", "Set the instant replay buffer length and start a live stream to use it.");
+			return;
+		}
+
+		log_info(__func__, ": saved ", samples, " instant replay samples to file ", filename.c_str());
+		kodi::gui::dialogs::OK::ShowAndGetInput(kodi::addon::GetLocalizedString(30420), "Instant replay successfully saved to:", "", filename.c_str());
+	}
+
+	catch(std::exception& ex) {
+
+		// Log the error, inform the user that the operation failed, and re-throw the exception with this function name
+		handle_stdexception(__func__, ex);
+		kodi::gui::dialogs::OK::ShowAndGetInput(kodi::addon::GetLocalizedString(30420), "An error occurred saving the instant replay:", "", ex.what());
+		throw string_exception(__func__, ": ", ex.what());
+	}
+
+	catch(...) { handle_generalexception(__func__); }
+}
+
+//---------------------------------------------------------------------------
+// addon::prewarm_streams (private)
+//
+// Worker thread procedure that builds the device-independent DSP state
+//
+// Arguments:
+//
+//	NONE
+
+void addon::prewarm_streams(void)
+{
+	auto start = std::chrono::steady_clock::now();
+	std::string wisdomfile = UserPath() + "/fftw.wisdom";
+
+	// The device-independent DSP state is shared process-wide once it has been built,
+	// a failure here only means that the first stream of that type will be slower
+	try {
+
+		// Import the FFTW wisdom measured by a previous run, this allows the cached plans
+		// to be created instantly rather than having to be measured again
+		if(fftwcache::load_wisdom(wisdomfile.c_str())) log_info(__func__, ": loaded FFTW wisdom from ", wisdomfile.c_str());
+
+		dabstream::prewarm();
+		hdstream::prewarm();
+
+		if(!fftwcache::save_wisdom(wisdomfile.c_str())) log_warning(__func__, ": unable to save FFTW wisdom to ", wisdomfile.c_str());
+	}
+
+	catch(std::exception& ex) { handle_stdexception(__func__, ex); }
+	catch(...) { handle_generalexception(__func__); }
+
+	log_info(__func__, ": DSP state prepared in ", std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count(), " ms");
+}
+
+//---------------------------------------------------------------------------
+// addon::recording_folder (private)
+//
+// Gets the folder that contains the files of a recording
+//
+// Arguments:
+//
+//	recordingid		- Recording identifier
+
+std::string addon::recording_folder(unsigned int recordingid) const
+{
+	return UserPath() + "/recordings/" + std::to_string(recordingid);
+}
+
+//---------------------------------------------------------------------------
+// addon::recording_scheduler (private)
+//
+// Worker thread procedure that starts and stops the scheduled recordings
+//
+// Arguments:
+//
+//	started		- Condition variable to set when thread has started
+
+void addon::recording_scheduler(scalar_condition<bool>& started)
+{
+	started = true;					// Signal that the thread has started
+
+	// Check the timers once a second until the addon is unloaded; the timers are not
+	// expected to be precise, a recording starting a second late is of no consequence
+	do {
+
+		try { update_recordings(); }
+		catch(std::exception& ex) { handle_stdexception(__func__, ex); }
+		catch(...) { handle_generalexception(__func__); }
+
+	} while(!m_scheduler_stop.wait_until_equals(true, 1000));
+}
+
 //---------------------------------------------------------------------------
 // addon::regioncode_to_string (private, static)
 //
@@ -895,118 +1285,361 @@ std::string addon::regioncode_to_string(enum regioncode code)
 }
 
 //---------------------------------------------------------------------------
-// addon::update_regioncode (private)
+// addon::reset_stream (private)
 //
-// Updates the addon region code
+// Closes and releases the active PVR stream; m_pvrstream_lock must be held
 //
 // Arguments:
 //
-//	code		- The updated region code
+//	NONE
 
-void addon::update_regioncode(enum regioncode code) const
+void addon::reset_stream(void)
 {
-	std::string region = regioncode_to_string(code);
+	// Other threads may still be holding a reference to the stream, close it explicitly
+	// so that the device is released now rather than when the last reference goes away;
+	// the demultiplexer lock ensures that the stream is not closed during a read
+	std::unique_lock<std::mutex> demux(m_pvrstream_demuxlock);
+	std::shared_ptr<pvrstream> stream = std::atomic_exchange(&m_pvrstream, std::shared_ptr<pvrstream>());
+	if(stream) stream->close();
+}
 
-	// NORTH AMERICA
-	//
-	if(code == regioncode::northamerica) {
+//---------------------------------------------------------------------------
+// addon::start_recording (private)
+//
+// Starts a new recording for a timer
+//
+// Arguments:
+//
+//	settings	- Current addon settings
+//	timer		- Timer that has become due
 
-		kodi::addon::SetSettingBoolean("fmradio_enable", true);
-		log_info(__func__, ": setting fmradio_enable systemically changed to true for region ", region);
+struct addon::activerecording_t addon::start_recording(struct settings const& settings, struct timer const& timer)
+{
+	channelid channelid(timer.channelid);				// Convert the timer channel back into a channelid
 
-		kodi::addon::SetSettingBoolean("hdradio_enable", true);
-		log_info(__func__, ": setting hdradio_enable systemically changed to true for region ", region);
+	// Retrieve the tuning properties for the channel from the database
+	struct channelprops channelprops = {};
+	std::vector<struct subchannelprops> subchannelprops;
+	if(!get_channel_properties(connectionpool::handle(m_connpool), channelid.frequency(), channelid.modulation(), channelprops, subchannelprops))
+		throw string_exception("channel ", timer.channelid, " was not found in the database");
 
-		kodi::addon::SetSettingBoolean("dabradio_enable", false);
-		log_info(__func__, ": setting dabradio_enable systemically changed to false for region ", region);
+	// Name the recording after the channel the same way it's presented to Kodi
+	std::string channelname = channelprops.name;
+	for(auto const& subchannel : subchannelprops) {
 
-		kodi::addon::SetSettingBoolean("wxradio_enable", true);
-		log_info(__func__, ": setting wxradio_enable systemically changed to true for region ", region);
+		if((subchannel.number == static_cast<uint32_t>(channelid.subchannel())) && (!subchannel.name.empty()))
+			channelname += " " + subchannel.name;
 	}
 
-	// EUROPE/AUSTRALIA
-	//
-	else if(code == regioncode::europe) {
+	log_info(__func__, ": Starting recording \"", timer.title, "\" on channel \"", channelname.c_str(), "\"");
 
-		kodi::addon::SetSettingBoolean("fmradio_enable", true);
-		log_info(__func__, ": setting fmradio_enable systemically changed to true for region ", region);
+	// Recordings lease their device at the highest priority; they can take a tuner away from
+	// a background job or a channel scan, but never from a live stream
+	std::unique_ptr<pvrstream> stream = create_stream(settings, channelprops, channelid.subchannel(), devicepriority::recording);
 
-		kodi::addon::SetSettingBoolean("hdradio_enable", false);
-		log_info(__func__, ": setting hdradio_enable systemically changed to false for region ", region);
+	// Pull a database handle out of the connection pool only once the device has been acquired
+	connectionpool::handle dbhandle(m_connpool);
 
-		kodi::addon::SetSettingBoolean("dabradio_enable", true);
-		log_info(__func__, ": setting dabradio_enable systemically changed to true for region ", region);
+	// Create the recording in the database first, its identifier names the folder
+	struct recording recording = { 0, timer.channelid, channelname.c_str(), timer.title, time(nullptr), 0 };
+	unsigned int recordingid = add_recording(dbhandle, recording);
 
-		kodi::addon::SetSettingBoolean("wxradio_enable", false);
-		log_info(__func__, ": setting wxradio_enable systemically changed to false for region ", region);
+	try {
+
+		std::string root = UserPath() + "/recordings";
+		if(!kodi::vfs::DirectoryExists(root) && !kodi::vfs::CreateDirectory(root)) throw string_exception("unable to create recordings folder ", root.c_str());
+
+		std::string folder = recording_folder(recordingid);
+		if(!kodi::vfs::DirectoryExists(folder) && !kodi::vfs::CreateDirectory(folder)) throw string_exception("unable to create recording folder ", folder.c_str());
+
+		return { recordingid, recorder::create(std::move(stream), folder.c_str()) };
 	}
 
-	// WORLD
-	//
-	else {
+	catch(...) { delete_recording(dbhandle, recordingid); throw; }
+}
 
-		kodi::addon::SetSettingBoolean("fmradio_enable", true);
-		log_info(__func__, ": setting fmradio_enable systemically changed to true for region ", region);
+//---------------------------------------------------------------------------
+// addon::stop_recording (private)
+//
+// Stops a recording that is in progress
+//
+// Arguments:
+//
+//	recording	- Active recording to be stopped
 
-		kodi::addon::SetSettingBoolean("hdradio_enable", false);
-		log_info(__func__, ": setting hdradio_enable systemically changed to false for region ", region);
+void addon::stop_recording(struct activerecording_t& recording)
+{
+	assert(recording.writer);
 
-		kodi::addon::SetSettingBoolean("dabradio_enable", false);
-		log_info(__func__, ": setting dabradio_enable systemically changed to false for region ", region);
+	// A recording that stopped on its own because of an error is reported to the user,
+	// the files that were written before the error are still usable
+	try { recording.writer->stop(); }
+	catch(std::exception& ex) {
 
-		kodi::addon::SetSettingBoolean("wxradio_enable", false);
-		log_info(__func__, ": setting wxradio_enable systemically changed to false for region ", region);
+		log_error(__func__, ": recording ", recording.recordingid, " failed: ", ex.what());
+		kodi::QueueFormattedNotification(QueueMsg::QUEUE_ERROR, "Recording failed (%s).", ex.what());
 	}
-}
 
-//---------------------------------------------------------------------------
-// CADDONBASE IMPLEMENTATION
-//---------------------------------------------------------------------------
+	update_recording_duration(connectionpool::handle(m_connpool), recording.recordingid, recording.writer->duration());
+	log_info(__func__, ": Stopped recording ", recording.recordingid, " (", recording.writer->duration(), " seconds)");
+
+	recording.writer.reset();
+}
 
 //---------------------------------------------------------------------------
-// addon::Create (CAddonBase)
+// addon::update_recordings (private)
 //
-// Initializes the addon instance
+// Starts and stops recordings based on the current timers
 //
 // Arguments:
 //
 //	NONE
 
-ADDON_STATUS addon::Create(void)
+void addon::update_recordings(void)
 {
-	try {
+	// scheduled_t
+	//
+	// Copy of a timer that outlives the enumeration
+	struct scheduled_t {
 
-#ifdef _WINDOWS
-		// On Windows, initialize winsock in case broadcast discovery is used; WSAStartup is
-		// reference-counted so if it has already been called this won't hurt anything
-		WSADATA wsaData;
-		int wsaresult = WSAStartup(MAKEWORD(2, 2), &wsaData);
-		if(wsaresult != 0) throw string_exception(__func__, ": WSAStartup failed with error code ", wsaresult);
-#endif
+		unsigned int		id;				// Timer identifier
+		unsigned int		channelid;		// Timer channel identifier
+		std::string			title;			// Timer title
+		time_t				starttime;		// Timer start time
+		time_t				endtime;		// Timer end time
+	};
 
-		// Initialize SQLite
-		int result = sqlite3_initialize();
-		if(result != SQLITE_OK) throw sqlite_exception(result, "sqlite3_initialize() failed");
+	// stopping_t
+	//
+	// Recording that has been taken out of the active recordings to be stopped
+	struct stopping_t {
 
-		// Throw a banner out to the Kodi log indicating that the add-on is being loaded
-		log_info(__func__, ": ", VERSION_PRODUCTNAME_ANSI, " v", VERSION_VERSION3_ANSI, " loading");
+		unsigned int				timerid;		// Timer identifier
+		bool						completed;		// Flag if the timer is completed
+		struct activerecording_t	recording;		// Recording to be stopped
+	};
 
-		try {
+	std::vector<struct scheduled_t>		timers;				// Current timers
+	std::vector<struct stopping_t>		stopping;			// Recordings to be stopped
+	bool								changed = false;	// Flag if anything was changed
 
-			// The user data path doesn't always exist when an addon has been installed
-			if(!kodi::vfs::DirectoryExists(UserPath())) {
+	// Create a copy of the current addon settings structure
+	struct settings settings = copy_settings();
 
-				log_info(__func__, ": user data directory ", UserPath().c_str(), " does not exist");
-				if(!kodi::vfs::CreateDirectory(UserPath())) throw string_exception(__func__, ": unable to create addon user data directory");
-				log_info(__func__, ": user data directory ", UserPath().c_str(), " created");
-			}
+	// The database handle is only held for the enumeration, not while recordings are started
+	time_t now = time(nullptr);
+	enumerate_timers(connectionpool::handle(m_connpool), [&](struct timer const& item) -> void {
 
-			// Load the device settings
-			m_settings.device_connection = kodi::addon::GetSettingEnum("device_connection", device_connection::usb);
-			m_settings.device_connection_usb_index = kodi::addon::GetSettingInt("device_connection_usb_index", 0);
-			m_settings.device_connection_tcp_host = kodi::addon::GetSettingString("device_connection_tcp_host");
+		timers.push_back({ item.id, item.channelid, (item.title != nullptr) ? item.title : "", item.starttime, item.endtime });
+	});
+
+	// Forget about any deferred timers that have since been deleted
+	for(auto iterator = m_deferred_timers.begin(); iterator != m_deferred_timers.end();) {
+
+		bool const exists = std::any_of(timers.begin(), timers.end(), [&](struct scheduled_t const& timer) -> bool { return timer.id == *iterator; });
+		iterator = (exists) ? std::next(iterator) : m_deferred_timers.erase(iterator);
+	}
+
+	// Find the recordings whose timer has been deleted or has ended, along with any that
+	// have stopped on their own; they are taken out of the active recordings under the lock
+	// and stopped after it has been released, stopping a recording can take some time
+	std::unique_lock<std::mutex> lock(m_recordings_lock);
+	for(auto iterator = m_recordings.begin(); iterator != m_recordings.end();) {
+
+		auto found = std::find_if(timers.begin(), timers.end(), [&](struct scheduled_t const& timer) -> bool { return timer.id == iterator->first; });
+		if((found != timers.end()) && (now < found->endtime) && (!iterator->second.writer->stopped())) { ++iterator; continue; }
+
+		stopping.push_back({ iterator->first, (found != timers.end()), std::move(iterator->second) });
+		if(found != timers.end()) timers.erase(found);
+
+		iterator = m_recordings.erase(iterator);
+	}
+	lock.unlock();
+
+	// Stop the recordings; completed timers are removed from the database
+	for(auto& item : stopping) {
+
+		stop_recording(item.recording);
+		if(item.completed) delete_timer(connectionpool::handle(m_connpool), item.timerid);
+
+		changed = true;
+	}
+
+	// Start the recordings for any timers that have become due; the lock is not held while
+	// the stream is created since acquiring a device can take some time
+	for(auto const& timer : timers) {
+
+		lock.lock();
+		bool active = (m_recordings.find(timer.id) != m_recordings.end());
+		lock.unlock();
+
+		if(active || (now < timer.starttime)) continue;
+
+		// Timers that ended while the addon was not running cannot be recorded
+		if(now >= timer.endtime) {
+
+			log_warning(__func__, ": timer \"", timer.title.c_str(), "\" ended before it could be recorded");
+			m_deferred_timers.erase(timer.id);
+			delete_timer(connectionpool::handle(m_connpool), timer.id);
+			changed = true;
+			continue;
+		}
+
+		try {
+
+			struct activerecording_t recording = start_recording(settings, { timer.id, timer.channelid, timer.title.c_str(), timer.starttime, timer.endtime });
+
+			lock.lock();
+			m_recordings.emplace(timer.id, std::move(recording));
+			lock.unlock();
+
+			m_deferred_timers.erase(timer.id);
+		}
+
+		// A timer that fails to start, for example because every tuner is in use, is retried
+		// on each pass until it ends; the user is only notified of the first failure
+		catch(std::exception& ex) {
+
+			if(m_deferred_timers.insert(timer.id).second) {
+
+				handle_stdexception(__func__, ex);
+				kodi::QueueFormattedNotification(QueueMsg::QUEUE_WARNING, "Recording \"%s\" could not be started yet (%s).", timer.title.c_str(), ex.what());
+			}
+
+			continue;
+		}
+
+		changed = true;
+	}
+
+	// Let Kodi know that the timers and/or recordings have changed
+	if(changed) {
+
+		TriggerTimerUpdate();
+		TriggerRecordingUpdate();
+	}
+}
+
+//---------------------------------------------------------------------------
+// addon::update_regioncode (private)
+//
+// Updates the addon region code
+//
+// Arguments:
+//
+//	code		- The updated region code
+
+void addon::update_regioncode(enum regioncode code) const
+{
+	std::string region = regioncode_to_string(code);
+
+	// NORTH AMERICA
+	//
+	if(code == regioncode::northamerica) {
+
+		kodi::addon::SetSettingBoolean("fmradio_enable", true);
+		log_info(__func__, ": setting fmradio_enable systemically changed to true for region ", region);
+
+		kodi::addon::SetSettingBoolean("hdradio_enable", true);
+		log_info(__func__, ": setting hdradio_enable systemically changed to true for region ", region);
+
+		kodi::addon::SetSettingBoolean("dabradio_enable", false);
+		log_info(__func__, ": setting dabradio_enable systemically changed to false for region ", region);
+
+		kodi::addon::SetSettingBoolean("wxradio_enable", true);
+		log_info(__func__, ": setting wxradio_enable systemically changed to true for region ", region);
+	}
+
+	// EUROPE/AUSTRALIA
+	//
+	else if(code == regioncode::europe) {
+
+		kodi::addon::SetSettingBoolean("fmradio_enable", true);
+		log_info(__func__, ": setting fmradio_enable systemically changed to true for region ", region);
+
+		kodi::addon::SetSettingBoolean("hdradio_enable", false);
+		log_info(__func__, ": setting hdradio_enable systemically changed to false for region ", region);
+
+		kodi::addon::SetSettingBoolean("dabradio_enable", true);
+		log_info(__func__, ": setting dabradio_enable systemically changed to true for region ", region);
+
+		kodi::addon::SetSettingBoolean("wxradio_enable", false);
+		log_info(__func__, ": setting wxradio_enable systemically changed to false for region ", region);
+	}
+
+	// WORLD
+	//
+	else {
+
+		kodi::addon::SetSettingBoolean("fmradio_enable", true);
+		log_info(__func__, ": setting fmradio_enable systemically changed to true for region ", region);
+
+		kodi::addon::SetSettingBoolean("hdradio_enable", false);
+		log_info(__func__, ": setting hdradio_enable systemically changed to false for region ", region);
+
+		kodi::addon::SetSettingBoolean("dabradio_enable", false);
+		log_info(__func__, ": setting dabradio_enable systemically changed to false for region ", region);
+
+		kodi::addon::SetSettingBoolean("wxradio_enable", false);
+		log_info(__func__, ": setting wxradio_enable systemically changed to false for region ", region);
+	}
+}
+
+//---------------------------------------------------------------------------
+// CADDONBASE IMPLEMENTATION
+//---------------------------------------------------------------------------
+
+//---------------------------------------------------------------------------
+// addon::Create (CAddonBase)
+//
+// Initializes the addon instance
+//
+// Arguments:
+//
+//	NONE
+
+ADDON_STATUS addon::Create(void)
+{
+	try {
+
+#ifdef _WINDOWS
+		// On Windows, initialize winsock in case broadcast discovery is used; WSAStartup is
+		// reference-counted so if it has already been called this won't hurt anything
+		WSADATA wsaData;
+		int wsaresult = WSAStartup(MAKEWORD(2, 2), &wsaData);
+		if(wsaresult != 0) throw string_exception(__func__, ": WSAStartup failed with error code ", wsaresult);
+#endif
+
+		// Initialize SQLite
+		int result = sqlite3_initialize();
+		if(result != SQLITE_OK) throw sqlite_exception(result, "sqlite3_initialize() failed");
+
+		// Throw a banner out to the Kodi log indicating that the add-on is being loaded
+		log_info(__func__, ": ", VERSION_PRODUCTNAME_ANSI, " v", VERSION_VERSION3_ANSI, " loading");
+
+		try {
+
+			// The user data path doesn't always exist when an addon has been installed
+			if(!kodi::vfs::DirectoryExists(UserPath())) {
+
+				log_info(__func__, ": user data directory ", UserPath().c_str(), " does not exist");
+				if(!kodi::vfs::CreateDirectory(UserPath())) throw string_exception(__func__, ": unable to create addon user data directory");
+				log_info(__func__, ": user data directory ", UserPath().c_str(), " created");
+			}
+
+			// Load the device settings
+			m_settings.device_connection = kodi::addon::GetSettingEnum("device_connection", device_connection::usb);
+			m_settings.device_connection_usb_index = kodi::addon::GetSettingInt("device_connection_usb_index", 0);
+			m_settings.device_connection_usb_all = kodi::addon::GetSettingBoolean("device_connection_usb_all", false);
+			m_settings.device_connection_tcp_host = kodi::addon::GetSettingString("device_connection_tcp_host");
 			m_settings.device_connection_tcp_port = kodi::addon::GetSettingInt("device_connection_tcp_port", 1234);
+			m_settings.device_connection_tcp_additional = kodi::addon::GetSettingString("device_connection_tcp_additional");
 			m_settings.device_frequency_correction = kodi::addon::GetSettingInt("device_frequency_correction", 0);
+			m_settings.device_rawfile_maxspeed = kodi::addon::GetSettingBoolean("device_rawfile_maxspeed", false);
+			m_settings.device_record_iq = kodi::addon::GetSettingBoolean("device_record_iq", false);
+			m_settings.device_replay_seconds = kodi::addon::GetSettingInt("device_replay_seconds", 0);
+			m_settings.device_timeshift_memory = kodi::addon::GetSettingInt("device_timeshift_memory", 32);
+			m_settings.device_timeshift_disk = kodi::addon::GetSettingInt("device_timeshift_disk", 0);
 
 			// Load the region settings
 			m_settings.region_regioncode = kodi::addon::GetSettingEnum("region_regioncode", regioncode::notset);
@@ -1027,6 +1660,7 @@ ADDON_STATUS addon::Create(void)
 			// Load the DAB settings
 			m_settings.dabradio_enable = kodi::addon::GetSettingBoolean("dabradio_enable", false);
 			m_settings.dabradio_output_gain = kodi::addon::GetSettingFloat("dabradio_output_gain", -3.0f);
+			m_settings.dabradio_passthrough = kodi::addon::GetSettingBoolean("dabradio_passthrough", false);
 
 			// Load the Weather Radio settings
 			m_settings.wxradio_enable = kodi::addon::GetSettingBoolean("wxradio_enable", false);
@@ -1037,11 +1671,19 @@ ADDON_STATUS addon::Create(void)
 			// Log the setting values
 			log_info(__func__, ": m_settings.dabradio_enable                   = ", m_settings.dabradio_enable);
 			log_info(__func__, ": m_settings.dabradio_output_gain              = ", m_settings.dabradio_output_gain);
+			log_info(__func__, ": m_settings.dabradio_passthrough              = ", m_settings.dabradio_passthrough);
 			log_info(__func__, ": m_settings.device_connection                 = ", device_connection_to_string(m_settings.device_connection));
+			log_info(__func__, ": m_settings.device_connection_tcp_additional  = ", m_settings.device_connection_tcp_additional);
 			log_info(__func__, ": m_settings.device_connection_tcp_host        = ", m_settings.device_connection_tcp_host);
 			log_info(__func__, ": m_settings.device_connection_tcp_port        = ", m_settings.device_connection_tcp_port);
+			log_info(__func__, ": m_settings.device_connection_usb_all         = ", m_settings.device_connection_usb_all);
 			log_info(__func__, ": m_settings.device_connection_usb_index       = ", m_settings.device_connection_usb_index);
 			log_info(__func__, ": m_settings.device_frequency_correction       = ", m_settings.device_frequency_correction);
+			log_info(__func__, ": m_settings.device_rawfile_maxspeed           = ", m_settings.device_rawfile_maxspeed);
+			log_info(__func__, ": m_settings.device_record_iq                  = ", m_settings.device_record_iq);
+			log_info(__func__, ": m_settings.device_replay_seconds             = ", m_settings.device_replay_seconds);
+			log_info(__func__, ": m_settings.device_timeshift_disk             = ", m_settings.device_timeshift_disk);
+			log_info(__func__, ": m_settings.device_timeshift_memory           = ", m_settings.device_timeshift_memory);
 			log_info(__func__, ": m_settings.fmradio_downsample_quality        = ", downsample_quality_to_string(m_settings.fmradio_downsample_quality));
 			log_info(__func__, ": m_settings.fmradio_enable_rds                = ", m_settings.fmradio_enable_rds);
 			log_info(__func__, ": m_settings.fmradio_prepend_channel_numbers   = ", m_settings.fmradio_prepend_channel_numbers);
@@ -1061,6 +1703,7 @@ ADDON_STATUS addon::Create(void)
 			AddMenuHook(kodi::addon::PVRMenuhook(MENUHOOK_SETTING_IMPORTCHANNELS, 30400, PVR_MENUHOOK_SETTING));
 			AddMenuHook(kodi::addon::PVRMenuhook(MENUHOOK_SETTING_EXPORTCHANNELS, 30401, PVR_MENUHOOK_SETTING));
 			AddMenuHook(kodi::addon::PVRMenuhook(MENUHOOK_SETTING_CLEARCHANNELS, 30402, PVR_MENUHOOK_SETTING));
+			AddMenuHook(kodi::addon::PVRMenuhook(MENUHOOK_SETTING_SAVEREPLAY, 30420, PVR_MENUHOOK_SETTING));
 
 			// Generate the local file system and URL-based file names for the channels database
 			std::string databasefile = UserPath() + "/channels.db";
@@ -1074,6 +1717,12 @@ ADDON_STATUS addon::Create(void)
 				throw;
 			}
 
+			// Create the device manager instance to keep recently used devices open
+			m_devicemanager = devicemanager::create();
+
+			// Create the instant replay buffer; it does not allocate anything until a stream is started
+			m_replaybuffer = replaybuffer::create();
+
 			// If the user has not specified a region code, attempt to get them to do it during startup
 			if(m_settings.region_regioncode == regioncode::notset) {
 
@@ -1106,6 +1755,15 @@ ADDON_STATUS addon::Create(void)
 					update_regioncode(regioncodes[result]);
 				}
 			}
+
+			// Prepare the device-independent DSP state in the background so that opening
+			// the first stream of each type doesn't have to wait for it to be built
+			m_prewarm = std::thread(&addon::prewarm_streams, this);
+
+			// Start the recording scheduler
+			scalar_condition<bool> started{ false };
+			m_scheduler = std::thread(&addon::recording_scheduler, this, std::ref(started));
+			started.wait_until_equals(true);
 		}
 
 		catch(std::exception& ex) { handle_stdexception(__func__, ex); throw; }
@@ -1137,7 +1795,27 @@ void addon::Destroy(void) noexcept
 		// Throw a message out to the Kodi log indicating that the add-on is being unloaded
 		log_info(__func__, ": ", VERSION_PRODUCTNAME_ANSI, " v", VERSION_VERSION3_ANSI, " unloading");
 
-		m_pvrstream.reset();					// Destroy any active stream instance
+		// Stop the recording scheduler
+		m_scheduler_stop = true;
+		if(m_scheduler.joinable()) m_scheduler.join();
+
+		// Wait for the DSP state to finish being prepared; this cannot be interrupted
+		if(m_prewarm.joinable()) m_prewarm.join();
+
+		// Complete any recordings that are still in progress; the timers are left in place
+		// so that a new recording is started if the addon is reloaded before they end
+		for(auto& iterator : m_recordings) stop_recording(iterator.second);
+		m_recordings.clear();
+
+		reset_stream();							// Destroy any active stream instance
+		m_devicemanager.reset();				// Close any idle device instances
+		m_replaybuffer.reset();					// Release the instant replay buffer
+
+		// Save any FFTW wisdom accumulated since the addon was loaded and release the cached
+		// plans; nothing that executes them can still exist at this point
+		std::string wisdomfile = UserPath() + "/fftw.wisdom";
+		if(!fftwcache::save_wisdom(wisdomfile.c_str())) log_warning(__func__, ": unable to save FFTW wisdom to ", wisdomfile.c_str());
+		fftwcache::release();
 
 		// Check for more than just the global connection pool reference during shutdown
 		long poolrefs = m_connpool.use_count();
@@ -1198,6 +1876,18 @@ ADDON_STATUS addon::SetSetting(std::string const& settingName, kodi::addon::CSet
 		}
 	}
 
+	// device_connection_usb_all
+	//
+	else if(settingName == "device_connection_usb_all") {
+
+		bool bvalue = settingValue.GetBoolean();
+		if(bvalue != m_settings.device_connection_usb_all) {
+
+			m_settings.device_connection_usb_all = bvalue;
+			log_info(__func__, ": setting device_connection_usb_all changed to ", bvalue);
+		}
+	}
+
 	// device_connection_tcp_host
 	//
 	else if(settingName == "device_connection_tcp_host") {
@@ -1222,6 +1912,18 @@ ADDON_STATUS addon::SetSetting(std::string const& settingName, kodi::addon::CSet
 		}
 	}
 
+	// device_connection_tcp_additional
+	//
+	else if(settingName == "device_connection_tcp_additional") {
+
+		std::string strvalue = settingValue.GetString();
+		if(strvalue != m_settings.device_connection_tcp_additional) {
+
+			m_settings.device_connection_tcp_additional = strvalue;
+			log_info(__func__, ": setting device_connection_tcp_additional changed to ", strvalue.c_str());
+		}
+	}
+
 	// device_frequency_correction
 	//
 	else if(settingName == "device_frequency_correction") {
@@ -1234,6 +1936,66 @@ ADDON_STATUS addon::SetSetting(std::string const& settingName, kodi::addon::CSet
 		}
 	}
 
+	// device_rawfile_maxspeed
+	//
+	else if(settingName == "device_rawfile_maxspeed") {
+
+		bool bvalue = settingValue.GetBoolean();
+		if(bvalue != m_settings.device_rawfile_maxspeed) {
+
+			m_settings.device_rawfile_maxspeed = bvalue;
+			log_info(__func__, ": setting device_rawfile_maxspeed changed to ", bvalue);
+		}
+	}
+
+	// device_record_iq
+	//
+	else if(settingName == "device_record_iq") {
+
+		bool bvalue = settingValue.GetBoolean();
+		if(bvalue != m_settings.device_record_iq) {
+
+			m_settings.device_record_iq = bvalue;
+			log_info(__func__, ": setting device_record_iq changed to ", bvalue);
+		}
+	}
+
+	// device_replay_seconds
+	//
+	else if(settingName == "device_replay_seconds") {
+
+		int nvalue = settingValue.GetInt();
+		if(nvalue != m_settings.device_replay_seconds) {
+
+			m_settings.device_replay_seconds = nvalue;
+			log_info(__func__, ": setting device_replay_seconds changed to ", m_settings.device_replay_seconds);
+		}
+	}
+
+	// device_timeshift_disk
+	//
+	else if(settingName == "device_timeshift_disk") {
+
+		int nvalue = settingValue.GetInt();
+		if(nvalue != m_settings.device_timeshift_disk) {
+
+			m_settings.device_timeshift_disk = nvalue;
+			log_info(__func__, ": setting device_timeshift_disk changed to ", m_settings.device_timeshift_disk);
+		}
+	}
+
+	// device_timeshift_memory
+	//
+	else if(settingName == "device_timeshift_memory") {
+
+		int nvalue = settingValue.GetInt();
+		if(nvalue != m_settings.device_timeshift_memory) {
+
+			m_settings.device_timeshift_memory = nvalue;
+			log_info(__func__, ": setting device_timeshift_memory changed to ", m_settings.device_timeshift_memory);
+		}
+	}
+
 	// fmradio_enable_rds
 	//
 	else if(settingName == "fmradio_enable_rds") {
@@ -1378,6 +2140,18 @@ ADDON_STATUS addon::SetSetting(std::string const& settingName, kodi::addon::CSet
 		}
 	}
 
+	// dabradio_passthrough
+	//
+	else if(settingName == "dabradio_passthrough") {
+
+		bool bvalue = settingValue.GetBoolean();
+		if(bvalue != m_settings.dabradio_passthrough) {
+
+			m_settings.dabradio_passthrough = bvalue;
+			log_info(__func__, ": setting dabradio_passthrough changed to ", bvalue);
+		}
+	}
+
 	// region_regioncode
 	//
 	if(settingName == "region_regioncode") {
@@ -1451,6 +2225,37 @@ ADDON_STATUS addon::SetSetting(std::string const& settingName, kodi::addon::CSet
 // CINSTANCEPVRCLIENT IMPLEMENTATION
 //---------------------------------------------------------------------------
 
+//-----------------------------------------------------------------------------
+// addon::AddTimer (CInstancePVRClient)
+//
+// Add a timer on the backend
+//
+// Arguments:
+//
+//	timer		- The timer to add
+
+PVR_ERROR addon::AddTimer(kodi::addon::PVRTimer const& timer)
+{
+	try {
+
+		// A start time of zero indicates that the recording should start immediately
+		time_t starttime = (timer.GetStartTime() == 0) ? time(nullptr) : timer.GetStartTime();
+		if(timer.GetEndTime() <= starttime) return PVR_ERROR::PVR_ERROR_INVALID_PARAMETERS;
+
+		// Timers have to be for a specific channel, there is no EPG to select one from
+		if(timer.GetClientChannelUid() == PVR_TIMER_ANY_CHANNEL) return PVR_ERROR::PVR_ERROR_INVALID_PARAMETERS;
+
+		std::string title = timer.GetTitle();
+		add_timer(connectionpool::handle(m_connpool), { 0, static_cast<unsigned int>(timer.GetClientChannelUid()), title.c_str(), starttime, timer.GetEndTime() });
+		TriggerTimerUpdate();
+	}
+
+	catch(std::exception& ex) { return handle_stdexception(__func__, ex, PVR_ERROR::PVR_ERROR_FAILED); }
+	catch(...) { return handle_generalexception(__func__, PVR_ERROR::PVR_ERROR_FAILED); }
+
+	return PVR_ERROR::PVR_ERROR_NO_ERROR;
+}
+
 //-----------------------------------------------------------------------------
 // addon::CallSettingsMenuHook (CInstancePVRClient)
 //
@@ -1468,6 +2273,7 @@ PVR_ERROR addon::CallSettingsMenuHook(kodi::addon::PVRMenuhook const& menuhook)
 		if(menuhook.GetHookId() == MENUHOOK_SETTING_IMPORTCHANNELS) menuhook_importchannels();
 		else if(menuhook.GetHookId() == MENUHOOK_SETTING_EXPORTCHANNELS) menuhook_exportchannels();
 		else if(menuhook.GetHookId() == MENUHOOK_SETTING_CLEARCHANNELS) menuhook_clearchannels();
+		else if(menuhook.GetHookId() == MENUHOOK_SETTING_SAVEREPLAY) menuhook_savereplay();
 	}
 
 	catch(std::exception& ex) { return handle_stdexception(__func__, ex, PVR_ERROR::PVR_ERROR_FAILED); }
@@ -1476,6 +2282,24 @@ PVR_ERROR addon::CallSettingsMenuHook(kodi::addon::PVRMenuhook const& menuhook)
 	return PVR_ERROR::PVR_ERROR_NO_ERROR;
 }
 
+//-----------------------------------------------------------------------------
+// addon::CanPauseStream (CInstancePVRClient)
+//
+// Check if the backend supports pausing the currently playing stream
+//
+// Arguments:
+//
+//	NONE
+
+bool addon::CanPauseStream(void)
+{
+	std::shared_ptr<pvrstream> stream = std::atomic_load(&m_pvrstream);
+
+	try { return (stream) ? stream->canpause() : false; }
+	catch(std::exception& ex) { return handle_stdexception(__func__, ex, false); }
+	catch(...) { return handle_generalexception(__func__, false); }
+}
+
 //-----------------------------------------------------------------------------
 // addon::CanSeekStream (CInstancePVRClient)
 //
@@ -1487,7 +2311,9 @@ PVR_ERROR addon::CallSettingsMenuHook(kodi::addon::PVRMenuhook const& menuhook)
 
 bool addon::CanSeekStream(void)
 {
-	try { return (m_pvrstream) ? m_pvrstream->canseek() : false; }
+	std::shared_ptr<pvrstream> stream = std::atomic_load(&m_pvrstream);
+
+	try { return (stream) ? stream->canseek() : false; }
 	catch(std::exception& ex) { return handle_stdexception(__func__, ex, false); }
 	catch(...) { return handle_generalexception(__func__, false); }
 }
@@ -1503,22 +2329,55 @@ bool addon::CanSeekStream(void)
 
 void addon::CloseLiveStream(void)
 {
-	// Prevent race condition with GetSignalStatus()
+	// Prevent race condition with functions that modify or read from m_pvrstream
 	std::unique_lock<std::mutex> lock(m_pvrstream_lock);
 
-	try { m_pvrstream.reset(); }
+	try {
+
+		// Get the signal acquisition state from the stream prior to closing it
+		struct acquisitionprops acquisitionprops = {};
+		std::unique_lock<std::mutex> demux(m_pvrstream_demuxlock);
+		bool cacheacquisition = (m_pvrstream && m_pvrstream->acquisition(acquisitionprops));
+		demux.unlock();
+
+		reset_stream();
+
+		// Cache (or invalidate) the acquisition state to warm start the next stream on this channel
+		if(cacheacquisition) update_channel_acquisition(connectionpool::handle(m_connpool), m_pvrstream_channelprops.frequency,
+			m_pvrstream_channelprops.modulation, acquisitionprops);
+	}
+
 	catch(std::exception& ex) { return handle_stdexception(__func__, ex); } 
 	catch(...) { return handle_generalexception(__func__); }
 }
 
 //-----------------------------------------------------------------------------
-// addon::DeleteChannel (CInstancePVRClient)
+// addon::CloseRecordedStream (CInstancePVRClient)
 //
-// Deletes a channel from the backend
+// Close an open stream from a recording
 //
 // Arguments:
 //
-//	channel		- Channel to be deleted
+//	NONE
+
+void addon::CloseRecordedStream(void)
+{
+	// Prevent race condition with functions that modify or read from m_pvrstream
+	std::unique_lock<std::mutex> lock(m_pvrstream_lock);
+
+	try { reset_stream(); }
+	catch(std::exception& ex) { return handle_stdexception(__func__, ex); }
+	catch(...) { return handle_generalexception(__func__); }
+}
+
+//-----------------------------------------------------------------------------
+// addon::DeleteChannel (CInstancePVRClient)
+//
+// Deletes a channel from the backend
+//
+// Arguments:
+//
+//	channel		- Channel to be deleted
 
 PVR_ERROR addon::DeleteChannel(kodi::addon::PVRChannel const& channel)
 {
@@ -1545,6 +2404,77 @@ PVR_ERROR addon::DeleteChannel(kodi::addon::PVRChannel const& channel)
 	return PVR_ERROR::PVR_ERROR_NO_ERROR;
 }
 
+//-----------------------------------------------------------------------------
+// addon::DeleteRecording (CInstancePVRClient)
+//
+// Delete a recording on the backend
+//
+// Arguments:
+//
+//	recording	- The recording to delete
+
+PVR_ERROR addon::DeleteRecording(kodi::addon::PVRRecording const& recording)
+{
+	try {
+
+		unsigned int recordingid = static_cast<unsigned int>(std::stoul(recording.GetRecordingId()));
+		connectionpool::handle dbhandle(m_connpool);
+
+		// A recording that is still in progress is stopped, along with the timer that started it
+		std::unique_lock<std::mutex> lock(m_recordings_lock);
+		for(auto iterator = m_recordings.begin(); iterator != m_recordings.end(); ++iterator) {
+
+			if(iterator->second.recordingid != recordingid) continue;
+
+			stop_recording(iterator->second);
+			delete_timer(dbhandle, iterator->first);
+			m_recordings.erase(iterator);
+			TriggerTimerUpdate();
+			break;
+		}
+		lock.unlock();
+
+		// Remove the recording files and folder before removing it from the database
+		std::string folder = recording_folder(recordingid);
+		recorder::remove(folder.c_str());
+		if(kodi::vfs::DirectoryExists(folder) && !kodi::vfs::RemoveDirectory(folder)) log_warning(__func__, ": unable to remove recording folder ", folder.c_str());
+
+		delete_recording(dbhandle, recordingid);
+		TriggerRecordingUpdate();
+	}
+
+	catch(std::exception& ex) { return handle_stdexception(__func__, ex, PVR_ERROR::PVR_ERROR_FAILED); }
+	catch(...) { return handle_generalexception(__func__, PVR_ERROR::PVR_ERROR_FAILED); }
+
+	return PVR_ERROR::PVR_ERROR_NO_ERROR;
+}
+
+//-----------------------------------------------------------------------------
+// addon::DeleteTimer (CInstancePVRClient)
+//
+// Delete a timer on the backend
+//
+// Arguments:
+//
+//	timer			- The timer to delete
+//	forceDelete		- Set to true to delete a timer that is currently recording a program
+
+PVR_ERROR addon::DeleteTimer(kodi::addon::PVRTimer const& timer, bool /*forceDelete*/)
+{
+	try {
+
+		// The recording scheduler will stop a recording in progress once the timer is gone;
+		// whatever was recorded up until that point is kept
+		delete_timer(connectionpool::handle(m_connpool), timer.GetClientIndex());
+		TriggerTimerUpdate();
+	}
+
+	catch(std::exception& ex) { return handle_stdexception(__func__, ex, PVR_ERROR::PVR_ERROR_FAILED); }
+	catch(...) { return handle_generalexception(__func__, PVR_ERROR::PVR_ERROR_FAILED); }
+
+	return PVR_ERROR::PVR_ERROR_NO_ERROR;
+}
+
 //-----------------------------------------------------------------------------
 // addon::DemuxAbort (CInstancePVRClient)
 //
@@ -1556,7 +2486,9 @@ PVR_ERROR addon::DeleteChannel(kodi::addon::PVRChannel const& channel)
 
 void addon::DemuxAbort(void)
 {
-	try { if(m_pvrstream) m_pvrstream->demuxabort(); }
+	std::shared_ptr<pvrstream> stream = std::atomic_load(&m_pvrstream);
+
+	try { if(stream) stream->demuxabort(); }
 	catch(std::exception& ex) { return handle_stdexception(__func__, ex); }
 	catch(...) { return handle_generalexception(__func__); }
 }
@@ -1572,7 +2504,9 @@ void addon::DemuxAbort(void)
 
 void addon::DemuxFlush(void)
 {
-	try { if(m_pvrstream) m_pvrstream->demuxflush(); }
+	std::shared_ptr<pvrstream> stream = std::atomic_load(&m_pvrstream);
+
+	try { if(stream) stream->demuxflush(); }
 	catch(std::exception& ex) { return handle_stdexception(__func__, ex); } 
 	catch(...) { return handle_generalexception(__func__); }
 }
@@ -1588,15 +2522,20 @@ void addon::DemuxFlush(void)
 
 DEMUX_PACKET* addon::DemuxRead(void)
 {
-	// Prevent race condition with GetSignalStatus()
-	std::unique_lock<std::mutex> lock(m_pvrstream_lock);
-
-	if(!m_pvrstream) return nullptr;
+	std::shared_ptr<pvrstream>		stream;			// Stream being read from
 
 	try { 
 
+		// The stream lock is not held here, reads must not wait for a new stream to be created.
+		// The demultiplexer lock only prevents the stream from being retuned or closed during
+		// the read, the streams time out their reads and never hold on to it for long
+		std::unique_lock<std::mutex> demux(m_pvrstream_demuxlock);
+
+		stream = std::atomic_load(&m_pvrstream);
+		if(!stream) return nullptr;
+
 		// Use an inline lambda to provide the stream an std::function to use to invoke AllocateDemuxPacket()
-		DEMUX_PACKET* packet = m_pvrstream->demuxread([&](int size) -> DEMUX_PACKET* { return AllocateDemuxPacket(size); });
+		DEMUX_PACKET* packet = stream->demuxread([&](int size) -> DEMUX_PACKET* { return AllocateDemuxPacket(size); });
 
 		// Log a warning if a stream change packet was detected; this means the application isn't keeping up with the device
 		if((packet != nullptr) && (packet->iStreamId == DEMUX_SPECIALID_STREAMCHANGE))
@@ -1611,7 +2550,10 @@ DEMUX_PACKET* addon::DemuxRead(void)
 		log_error(__func__, ": read operation failed with exception: ", ex.what());
 		kodi::QueueFormattedNotification(QueueMsg::QUEUE_ERROR, "Unable to read from stream: %s", ex.what());
 
-		m_pvrstream.reset();				// Close the stream
+		// Close the stream, unless it has already been replaced by another thread
+		std::unique_lock<std::mutex> lock(m_pvrstream_lock);
+		if(stream && (std::atomic_load(&m_pvrstream) == stream)) reset_stream();
+
 		return nullptr;						// Return a null demultiplexer packet
 	}
 
@@ -1629,7 +2571,9 @@ DEMUX_PACKET* addon::DemuxRead(void)
 
 void addon::DemuxReset(void)
 {
-	try { if(m_pvrstream) m_pvrstream->demuxreset(); }
+	std::shared_ptr<pvrstream> stream = std::atomic_load(&m_pvrstream);
+
+	try { if(stream) stream->demuxreset(); }
 	catch(std::exception& ex) { return handle_stdexception(__func__, ex); }
 	catch(...) { return handle_generalexception(__func__); }
 }
@@ -1680,9 +2624,12 @@ PVR_ERROR addon::GetCapabilities(kodi::addon::PVRCapabilities& capabilities)
 	capabilities.SetSupportsRadio(true);
 	capabilities.SetSupportsChannelGroups(true);
 	capabilities.SetSupportsChannelSettings(true);
+	capabilities.SetSupportsChannelScan(true);
 	capabilities.SetHandlesInputStream(true);
 	capabilities.SetHandlesDemuxing(true);
 	capabilities.SetSupportsEPG(true);
+	capabilities.SetSupportsRecordings(true);
+	capabilities.SetSupportsTimers(true);
 
 	return PVR_ERROR::PVR_ERROR_NO_ERROR;
 }
@@ -1902,6 +2849,71 @@ PVR_ERROR addon::GetEPGForChannel(int /*channelUid*/, time_t /*start*/, time_t /
 	return PVR_ERROR::PVR_ERROR_NO_ERROR;
 }
 
+//-----------------------------------------------------------------------------
+// addon::GetRecordings (CInstancePVRClient)
+//
+// Request the list of all recordings from the backend
+//
+// Arguments:
+//
+//	deleted		- If set return deleted recordings
+//	results		- Recordings result set to be loaded
+
+PVR_ERROR addon::GetRecordings(bool deleted, kodi::addon::PVRRecordingsResultSet& results)
+{
+	// Deleted recordings are removed immediately, there is nothing to undelete
+	if(deleted) return PVR_ERROR::PVR_ERROR_NO_ERROR;
+
+	try {
+
+		// The duration of a recording in progress is only in the database once it has stopped
+		std::map<unsigned int, int> durations;
+		std::unique_lock<std::mutex> lock(m_recordings_lock);
+		for(auto const& iterator : m_recordings) durations.emplace(iterator.second.recordingid, iterator.second.writer->duration());
+		lock.unlock();
+
+		enumerate_recordings(connectionpool::handle(m_connpool), [&](struct recording const& item) -> void {
+
+			auto found = durations.find(item.id);
+
+			kodi::addon::PVRRecording recording;
+			recording.SetRecordingId(std::to_string(item.id));
+			recording.SetTitle(item.title);
+			recording.SetChannelName(item.channelname);
+			recording.SetChannelUid(static_cast<int>(item.channelid));
+			recording.SetChannelType(PVR_RECORDING_CHANNEL_TYPE_RADIO);
+			recording.SetRecordingTime(item.starttime);
+			recording.SetDuration((found != durations.end()) ? found->second : item.duration);
+
+			results.Add(recording);
+		});
+	}
+
+	catch(std::exception& ex) { return handle_stdexception(__func__, ex, PVR_ERROR::PVR_ERROR_FAILED); }
+	catch(...) { return handle_generalexception(__func__, PVR_ERROR::PVR_ERROR_FAILED); }
+
+	return PVR_ERROR::PVR_ERROR_NO_ERROR;
+}
+
+//-----------------------------------------------------------------------------
+// addon::GetRecordingsAmount (CInstancePVRClient)
+//
+// Get the total amount of recordings on the backend
+//
+// Arguments:
+//
+//	deleted		- If set return deleted recordings
+//	amount		- Set to the number of recordings
+
+PVR_ERROR addon::GetRecordingsAmount(bool deleted, int& amount)
+{
+	try { amount = (deleted) ? 0 : get_recording_count(connectionpool::handle(m_connpool)); }
+	catch(std::exception& ex) { return handle_stdexception(__func__, ex, PVR_ERROR::PVR_ERROR_FAILED); }
+	catch(...) { return handle_generalexception(__func__, PVR_ERROR::PVR_ERROR_FAILED); }
+
+	return PVR_ERROR::PVR_ERROR_NO_ERROR;
+}
+
 //-----------------------------------------------------------------------------
 // addon::GetSignalStatus (CInstancePVRClient)
 //
@@ -1914,28 +2926,27 @@ PVR_ERROR addon::GetEPGForChannel(int /*channelUid*/, time_t /*start*/, time_t /
 
 PVR_ERROR addon::GetSignalStatus(int /*channelUid*/, kodi::addon::PVRSignalStatus& signalStatus)
 {
-	// Prevent race condition with functions that modify m_pvrstream
-	std::unique_lock<std::mutex> lock(m_pvrstream_lock);
+	// Don't take m_pvrstream_lock here, DemuxRead() holds it for as long as the stream
+	// waits for data; the reference keeps the stream alive while the status is read
+	std::shared_ptr<pvrstream> stream = std::atomic_load(&m_pvrstream);
 
 	// Kodi may call this function before the stream is open, avoid the error log
-	if(!m_pvrstream) return PVR_ERROR::PVR_ERROR_NO_ERROR;
+	if(!stream) return PVR_ERROR::PVR_ERROR_NO_ERROR;
 
 	try {
 
-		int quality = 0;			// Quality as a percentage
-		int snr = 0;				// SNR as a percentage
+		// Retrieve the most recent status snapshot published by the stream instance
+		std::shared_ptr<struct signalstatus const> status = stream->status();
 
-		// Retrieve the quality metrics from the stream instance
-		m_pvrstream->signalquality(quality, snr);
-
-		signalStatus.SetAdapterName(m_pvrstream->devicename());
+		signalStatus.SetAdapterName(status->devicename);
 		signalStatus.SetAdapterStatus("Active");
-		signalStatus.SetServiceName(m_pvrstream->servicename());
+		signalStatus.SetServiceName(status->servicename);
 		signalStatus.SetProviderName("RTL-SDR");
-		signalStatus.SetMuxName(m_pvrstream->muxname());
+		signalStatus.SetMuxName(status->muxname);
 
-		signalStatus.SetSignal(quality * 655);		// Range: 0-65535
-		signalStatus.SetSNR(snr * 655);				// Range: 0-65535
+		signalStatus.SetSignal(status->quality * 655);		// Range: 0-65535
+		signalStatus.SetSNR(status->snr * 655);				// Range: 0-65535
+		signalStatus.SetUNC(status->unc);
 	}
 
 	catch(std::exception& ex) { return handle_stdexception(__func__, ex, PVR_ERROR::PVR_ERROR_FAILED); }
@@ -1955,10 +2966,11 @@ PVR_ERROR addon::GetSignalStatus(int /*channelUid*/, kodi::addon::PVRSignalStatu
 
 PVR_ERROR addon::GetStreamProperties(std::vector<kodi::addon::PVRStreamProperties>& properties)
 {
-	if(!m_pvrstream) return PVR_ERROR::PVR_ERROR_FAILED;
+	std::shared_ptr<pvrstream> stream = std::atomic_load(&m_pvrstream);
+	if(!stream) return PVR_ERROR::PVR_ERROR_FAILED;
 
 	// Enumerate the stream properties as specified by the PVR stream instance
-	m_pvrstream->enumproperties([&](struct streamprops const& props) -> void {
+	stream->enumproperties([&](struct streamprops const& props) -> void {
 
 		kodi::addon::PVRCodec codec = GetCodecByName(props.codec);
 		if(codec.GetCodecType() != PVR_CODEC_TYPE::PVR_CODEC_TYPE_UNKNOWN) {
@@ -1980,6 +2992,109 @@ PVR_ERROR addon::GetStreamProperties(std::vector<kodi::addon::PVRStreamPropertie
 	return PVR_ERROR::PVR_ERROR_NO_ERROR;
 }
 
+//-----------------------------------------------------------------------------
+// addon::GetStreamTimes (CInstancePVRClient)
+//
+// Get the stream times of the stream that's currently being read
+//
+// Arguments:
+//
+//	times		- Stream times to be set
+
+PVR_ERROR addon::GetStreamTimes(kodi::addon::PVRStreamTimes& times)
+{
+	std::shared_ptr<pvrstream> stream = std::atomic_load(&m_pvrstream);
+	double begin = 0.0, end = 0.0;
+
+	try { if(!stream || !stream->timerange(begin, end)) return PVR_ERROR::PVR_ERROR_NOT_IMPLEMENTED; }
+	catch(std::exception& ex) { return handle_stdexception(__func__, ex, PVR_ERROR::PVR_ERROR_FAILED); }
+	catch(...) { return handle_generalexception(__func__, PVR_ERROR::PVR_ERROR_FAILED); }
+
+	// The timeshift buffer time stamps are relative to the start of the stream
+	times.SetStartTime(0);
+	times.SetPTSStart(0);
+	times.SetPTSBegin(static_cast<int64_t>(begin));
+	times.SetPTSEnd(static_cast<int64_t>(end));
+
+	return PVR_ERROR::PVR_ERROR_NO_ERROR;
+}
+
+//-----------------------------------------------------------------------------
+// addon::GetTimers (CInstancePVRClient)
+//
+// Request the list of all timers from the backend
+//
+// Arguments:
+//
+//	results		- Timers result set to be loaded
+
+PVR_ERROR addon::GetTimers(kodi::addon::PVRTimersResultSet& results)
+{
+	try {
+
+		std::unique_lock<std::mutex> lock(m_recordings_lock);
+
+		enumerate_timers(connectionpool::handle(m_connpool), [&](struct timer const& item) -> void {
+
+			kodi::addon::PVRTimer timer;
+			timer.SetClientIndex(item.id);
+			timer.SetClientChannelUid(static_cast<int>(item.channelid));
+			timer.SetTitle(item.title);
+			timer.SetStartTime(item.starttime);
+			timer.SetEndTime(item.endtime);
+			timer.SetTimerType(TIMER_TYPE_ONESHOT);
+			timer.SetState((m_recordings.find(item.id) != m_recordings.end()) ? PVR_TIMER_STATE_RECORDING : PVR_TIMER_STATE_SCHEDULED);
+
+			results.Add(timer);
+		});
+	}
+
+	catch(std::exception& ex) { return handle_stdexception(__func__, ex, PVR_ERROR::PVR_ERROR_FAILED); }
+	catch(...) { return handle_generalexception(__func__, PVR_ERROR::PVR_ERROR_FAILED); }
+
+	return PVR_ERROR::PVR_ERROR_NO_ERROR;
+}
+
+//-----------------------------------------------------------------------------
+// addon::GetTimersAmount (CInstancePVRClient)
+//
+// Get the total amount of timers on the backend
+//
+// Arguments:
+//
+//	amount		- Set to the number of timers
+
+PVR_ERROR addon::GetTimersAmount(int& amount)
+{
+	try { amount = get_timer_count(connectionpool::handle(m_connpool)); }
+	catch(std::exception& ex) { return handle_stdexception(__func__, ex, PVR_ERROR::PVR_ERROR_FAILED); }
+	catch(...) { return handle_generalexception(__func__, PVR_ERROR::PVR_ERROR_FAILED); }
+
+	return PVR_ERROR::PVR_ERROR_NO_ERROR;
+}
+
+//-----------------------------------------------------------------------------
+// addon::GetTimerTypes (CInstancePVRClient)
+//
+// Get the timer types supported by the backend
+//
+// Arguments:
+//
+//	types		- Vector to receive the supported timer types
+
+PVR_ERROR addon::GetTimerTypes(std::vector<kodi::addon::PVRTimerType>& types)
+{
+	// One-shot manual timers are the only type supported, there is no EPG to base
+	// any repeating or series timers on
+	kodi::addon::PVRTimerType oneshot;
+	oneshot.SetId(TIMER_TYPE_ONESHOT);
+	oneshot.SetAttributes(PVR_TIMER_TYPE_IS_MANUAL | PVR_TIMER_TYPE_SUPPORTS_CHANNELS | PVR_TIMER_TYPE_SUPPORTS_START_TIME | PVR_TIMER_TYPE_SUPPORTS_END_TIME);
+	oneshot.SetDescription(kodi::addon::GetLocalizedString(30421));
+	types.emplace_back(std::move(oneshot));
+
+	return PVR_ERROR::PVR_ERROR_NO_ERROR;
+}
+
 //-----------------------------------------------------------------------------
 // addon::GetConnectionString (CInstancePVRClient)
 //
@@ -2013,7 +3128,9 @@ PVR_ERROR addon::GetConnectionString(std::string& connection)
 
 bool addon::IsRealTimeStream(void)
 {
-	try { return (m_pvrstream) ? m_pvrstream->realtime() : false; }
+	std::shared_ptr<pvrstream> stream = std::atomic_load(&m_pvrstream);
+
+	try { return (stream) ? stream->realtime() : false; }
 	catch(std::exception& ex) { return handle_stdexception(__func__, ex, false); }
 	catch(...) { return handle_generalexception(__func__, false); }
 }
@@ -2029,7 +3146,9 @@ bool addon::IsRealTimeStream(void)
 
 int64_t addon::LengthLiveStream(void)
 {
-	try { return (m_pvrstream) ? m_pvrstream->length() : -1; }
+	std::shared_ptr<pvrstream> stream = std::atomic_load(&m_pvrstream);
+
+	try { return (stream) ? stream->length() : -1; }
 	catch(std::exception& ex) { return handle_stdexception(__func__, ex, -1); }
 	catch(...) { return handle_generalexception(__func__, -1); }
 }
@@ -2089,7 +3208,7 @@ PVR_ERROR addon::OpenDialogChannelAdd(kodi::addon::PVRChannel const& /*channel*/
 	}
 
 	// TODO: see if there is a better way we can work with this
-	if(m_pvrstream) {
+	if(std::atomic_load(&m_pvrstream)) {
 
 		// TODO: This message is terrible
 		kodi::gui::dialogs::OK::ShowAndGetInput(kodi::addon::GetLocalizedString(30405), "Modifying PVR Radio channel settings requires "
@@ -2135,7 +3254,212 @@ PVR_ERROR addon::OpenDialogChannelAdd(kodi::addon::PVRChannel const& /*channel*/
 
 PVR_ERROR addon::OpenDialogChannelScan(void)
 {
-	return PVR_ERROR::PVR_ERROR_NOT_IMPLEMENTED;
+	std::vector<channelscanner::channel>	channels;		// Channels to be scanned
+	std::map<uint32_t, std::string>			channelnames;	// Named channels (DAB/WX)
+	std::vector<channelscanner::result>		results;		// Detected channels
+	size_t									added = 0;		// Number of channels added
+
+	// Create a copy of the current addon settings structure
+	struct settings settings = copy_settings();
+
+	try {
+
+		// Acquire a tuner device for the scan from the device pool; the scan runs at a lower priority
+		// than live streams and recordings and will be stopped if they need the tuner device back
+		std::unique_ptr<rtldevice> device;
+		try { device = create_device(settings, devicepriority::scan); }
+		catch(std::exception const&) {
+
+			bool active = false;
+			{
+				std::unique_lock<std::mutex> lock(m_pvrstream_lock);
+				active = static_cast<bool>(m_pvrstream);
+			}
+
+			// If there is an active stream it's holding the only available tuner device
+			if(!active) throw;
+
+			kodi::gui::dialogs::OK::ShowAndGetInput(kodi::addon::GetLocalizedString(30419), "Scanning for PVR Radio channels requires "
+				"an RTL-SDR tuner device that is not in use.", "", "Active playback of PVR Radio streams must be stopped before continuing.");
+
+			return PVR_ERROR::PVR_ERROR_NO_ERROR;
+		}
+
+		// Pull a database handle out of the connection pool
+		connectionpool::handle dbhandle(m_connpool);
+
+		// FM channels are on odd 200KHz intervals from 87.9MHz to 107.9MHz in North America and
+		// on 100KHz intervals from 87.5MHz to 108.0MHz everywhere else
+		bool const isnorthamerica = is_region_northamerica(settings);
+		uint32_t const fmlow = (isnorthamerica) ? 87900000 : 87500000;
+		uint32_t const fmhigh = (isnorthamerica) ? 107900000 : 108000000;
+		uint32_t const fmstep = (isnorthamerica) ? 200000 : 100000;
+		for(uint32_t frequency = fmlow; frequency <= fmhigh; frequency += fmstep) channels.push_back({ modulation::fm, frequency });
+
+		// DAB ensembles and Weather Radio channels come from the named channels in the database
+		auto add_namedchannels = [&](enum modulation modulation) -> void {
+
+			enumerate_namedchannels(dbhandle, modulation, [&](struct namedchannel const& item) -> void {
+
+				if((item.frequency == 0) || (item.name == nullptr)) return;
+
+				channels.push_back({ modulation, item.frequency });
+				channelnames[item.frequency] = item.name;
+			});
+		};
+
+		if(settings.dabradio_enable) add_namedchannels(modulation::dab);
+		if(settings.wxradio_enable) add_namedchannels(modulation::wx);
+
+		// Set up the tuner device properties
+		struct tunerprops tunerprops = {};
+		tunerprops.freqcorrection = settings.device_frequency_correction;
+
+		// Create the channel scanner instance and the progress dialog
+		std::unique_ptr<channelscanner> scanner = channelscanner::create(std::move(device), tunerprops);
+		std::unique_ptr<kodi::gui::dialogs::CProgress> progress(new kodi::gui::dialogs::CProgress());
+		progress->SetHeading(kodi::addon::GetLocalizedString(30419));
+		progress->SetLine(1, "Sweeping the radio bands for channels ...");
+		progress->SetCanCancel(true);
+		progress->ShowProgressBar(true);
+		progress->Open();
+
+		// Sweep the bands; the remainder of the progress bar is split between identifying
+		// the FM stations and scanning the DAB multiplexes
+		bool const scanmultiplexes = (settings.hdradio_enable || settings.dabradio_enable);
+		int const sweepshare = (scanmultiplexes) ? 40 : 60;
+		int const identifyshare = (scanmultiplexes) ? 30 : 40;
+		log_info(__func__, ": sweeping ", channels.size(), " channels");
+		if(!scanner->scan(channels, [&](int percent) -> bool { progress->SetPercentage((percent * sweepshare) / 100); return !progress->IsCanceled(); }, results))
+			return PVR_ERROR::PVR_ERROR_NO_ERROR;
+
+		log_info(__func__, ": sweep detected ", results.size(), " candidate channels");
+
+		// Identify the FM stations from their RDS data; all of the stations within each
+		// capture window are identified at the same time
+		struct fmprops fmprops = {};
+		fmprops.decoderds = true;
+		fmprops.isnorthamerica = isnorthamerica;
+		fmprops.downsamplequality = static_cast<int>(settings.fmradio_downsample_quality);
+
+		progress->SetLine(1, "Identifying FM radio stations ...");
+		if(!scanner->identify_stations(results, fmprops, 4000, [&](int percent) -> bool {
+			progress->SetPercentage(sweepshare + ((percent * identifyshare) / 100)); return !progress->IsCanceled(); }))
+			return PVR_ERROR::PVR_ERROR_NO_ERROR;
+
+		// FM stations where the sweep found HD Radio sidebands are also scanned as HD Radio multiplexes,
+		// the HD Radio decoder never needs to be started for any of the analog-only stations
+		if(settings.hdradio_enable) {
+
+			size_t const count = results.size();
+			for(size_t index = 0; index < count; index++) {
+
+				if((results[index].modulation != modulation::fm) || (!results[index].hybrid)) continue;
+
+				channelscanner::result hdresult = results[index];
+				hdresult.modulation = modulation::hd;
+				results.push_back(hdresult);
+			}
+		}
+
+		size_t const multiplexes = std::count_if(results.begin(), results.end(), [](channelscanner::result const& result) -> bool {
+			return (result.modulation == modulation::hd) || (result.modulation == modulation::dab); });
+		size_t multiplex = 0;
+
+		for(auto const& result : results) {
+
+			if(progress->IsCanceled()) break;
+
+			struct channelprops channelprops = {};
+			channelprops.frequency = result.frequency;
+			channelprops.modulation = result.modulation;
+			channelprops.autogain = true;
+
+			// Never overwrite a channel that the user has already added
+			if(channel_exists(dbhandle, channelprops)) continue;
+
+			log_info(__func__, ": detected channel ", result.frequency, " Hz (modulation ", static_cast<int>(result.modulation), ") at ", result.snr, " dB above noise floor");
+
+			// FM
+			if(result.modulation == modulation::fm) {
+
+				// Name the channel after the RDS station name if one was identified, otherwise
+				// use the frequency in megahertz (xxx.x format)
+				char name[64]{};
+				snprintf(name, std::extent<decltype(name)>::value, "%u.%u FM", result.frequency / 1000000, (result.frequency % 1000000) / 100000);
+				channelprops.name = (result.name.empty()) ? name : result.name;
+
+				if(add_channel(dbhandle, channelprops)) added++;
+			}
+
+			// HD Radio
+			else if(result.modulation == modulation::hd) {
+
+				char frequency[64]{};
+				snprintf(frequency, std::extent<decltype(frequency)>::value, "%u.%u", result.frequency / 1000000, (result.frequency % 1000000) / 100000);
+				progress->SetLine(1, std::string("Scanning HD Radio multiplex ").append(frequency).append(" ..."));
+				progress->SetPercentage(sweepshare + identifyshare + static_cast<int>(((100 - sweepshare - identifyshare) * multiplex++) / std::max(multiplexes, static_cast<size_t>(1))));
+
+				// Only add the multiplex if the multiplex scanner was able to find the subchannels
+				struct muxscanner::multiplex muxdata = {};
+				if(!scanner->scan_multiplex(modulation::hd, result.frequency, 10000, muxdata)) continue;
+
+				channelprops.name = (muxdata.name.empty()) ? kodi::addon::GetLocalizedString(30321).append(" ").append(frequency) : muxdata.name;
+
+				std::vector<struct subchannelprops> subchannels;
+				for(auto const& subchannel : muxdata.subchannels) subchannels.push_back({ subchannel.number, subchannel.name });
+				std::sort(subchannels.begin(), subchannels.end(), [](auto const& lhs, auto const& rhs) -> bool { return lhs.number < rhs.number; });
+
+				if(add_channel(dbhandle, channelprops, subchannels)) added++;
+			}
+
+			// Weather Radio
+			else if(result.modulation == modulation::wx) {
+
+				channelprops.name = channelnames[result.frequency];
+				if(add_channel(dbhandle, channelprops)) added++;
+			}
+
+			// DAB
+			else if(result.modulation == modulation::dab) {
+
+				std::string const& channelname = channelnames[result.frequency];
+				progress->SetLine(1, std::string("Scanning DAB ensemble ").append(channelname).append(" ..."));
+				progress->SetPercentage(sweepshare + identifyshare + static_cast<int>(((100 - sweepshare - identifyshare) * multiplex++) / std::max(multiplexes, static_cast<size_t>(1))));
+
+				// Only add the ensemble if the multiplex scanner was able to find the subchannels
+				struct muxscanner::multiplex muxdata = {};
+				if(!scanner->scan_multiplex(modulation::dab, result.frequency, 10000, muxdata)) continue;
+
+				channelprops.name = (muxdata.name.empty()) ? kodi::addon::GetLocalizedString(30322).append(" ").append(channelname) : muxdata.name;
+
+				std::vector<struct subchannelprops> subchannels;
+				for(auto const& subchannel : muxdata.subchannels) subchannels.push_back({ subchannel.number, subchannel.name });
+				std::sort(subchannels.begin(), subchannels.end(), [](auto const& lhs, auto const& rhs) -> bool { return lhs.number < rhs.number; });
+
+				if(add_channel(dbhandle, channelprops, subchannels)) added++;
+			}
+		}
+
+		progress.reset();					// Close the progress dialog
+
+		// Inform the user of the results of the channel scan
+		kodi::gui::dialogs::OK::ShowAndGetInput(kodi::addon::GetLocalizedString(30419), "Channel scan complete.", "",
+			std::to_string(added).append(" new channel(s) were added.").c_str());
+
+		if(added > 0) TriggerChannelGroupsUpdate();
+	}
+
+	catch(std::exception& ex) {
+
+		// Log the error and inform the user that the operation failed, do not return an error code
+		handle_stdexception(__func__, ex);
+		kodi::gui::dialogs::OK::ShowAndGetInput(kodi::addon::GetLocalizedString(30419), "An error occurred scanning for channels:", "", ex.what());
+	}
+
+	catch(...) { return handle_generalexception(__func__, PVR_ERROR::PVR_ERROR_FAILED); }
+
+	return PVR_ERROR::PVR_ERROR_NO_ERROR;
 }
 
 //-----------------------------------------------------------------------------
@@ -2179,7 +3503,7 @@ PVR_ERROR addon::OpenDialogChannelSettings(kodi::addon::PVRChannel const& channe
 			throw string_exception("Unable to retrieve properties for channel ", channel.GetChannelName().c_str());
 
 		// Create and initialize the dialog box against a new signal meter instance
-		std::unique_ptr<channelsettings> dialog = channelsettings::create(create_device(settings), tunerprops, channelprops, false);
+		std::unique_ptr<channelsettings> dialog = channelsettings::create(create_device(settings, devicepriority::scan), tunerprops, channelprops, false);
 		dialog->DoModal();
 
 		if(dialog->get_dialog_result()) {
@@ -2214,7 +3538,7 @@ PVR_ERROR addon::OpenDialogChannelSettings(kodi::addon::PVRChannel const& channe
 
 bool addon::OpenLiveStream(kodi::addon::PVRChannel const& channel)
 {
-	// Prevent race condition with GetSignalStatus()
+	// Prevent race condition with functions that modify or read from m_pvrstream
 	std::unique_lock<std::mutex> lock(m_pvrstream_lock);
 
 	// Create a copy of the current addon settings structure
@@ -2233,107 +3557,65 @@ bool addon::OpenLiveStream(kodi::addon::PVRChannel const& channel)
 		if(!get_channel_properties(connectionpool::handle(m_connpool), channelid.frequency(), channelid.modulation(), channelprops))
 			throw string_exception("channel ", channel.GetUniqueId(), " (", channel.GetChannelName().c_str(), ") was not found in the database");
 
-		// FM Radio
-		//
-		if(channelprops.modulation == modulation::fm) {
-
-			// Set up the FM digital signal processor properties
-			struct fmprops fmprops = {};
-			fmprops.decoderds = settings.fmradio_enable_rds;
-			fmprops.isnorthamerica = is_region_northamerica(settings);
-			fmprops.samplerate = settings.fmradio_sample_rate;
-			fmprops.downsamplequality = static_cast<int>(settings.fmradio_downsample_quality);
-			fmprops.outputrate = settings.fmradio_output_samplerate;
-			fmprops.outputgain = settings.fmradio_output_gain;
-
-			// Log information about the stream for diagnostic purposes
-			log_info(__func__, ": Creating fmstream for channel \"", channelprops.name, "\"");
-			log_info(__func__, ": tunerprops.freqcorrection = ", tunerprops.freqcorrection, " PPM");
-			log_info(__func__, ": fmprops.decoderds = ", (fmprops.decoderds) ? "true" : "false");
-			log_info(__func__, ": fmprops.isnorthamerica = ", (fmprops.isnorthamerica) ? "true" : "false");
-			log_info(__func__, ": fmrops.samplerate = ", fmprops.samplerate, " Hz");
-			log_info(__func__, ": fmprops.downsamplequality = ", downsample_quality_to_string(static_cast<enum downsample_quality>(fmprops.downsamplequality)));
-			log_info(__func__, ": fmprops.outputgain = ", fmprops.outputgain, " dB");
-			log_info(__func__, ": fmprops.outputrate = ", fmprops.outputrate, " Hz");
-			log_info(__func__, ": channelprops.frequency = ", channelprops.frequency, " Hz");
-			log_info(__func__, ": channelprops.autogain = ", (channelprops.autogain) ? "true" : "false");
-			log_info(__func__, ": channelprops.manualgain = ", channelprops.manualgain / 10, " dB");
-			log_info(__func__, ": channelprops.freqcorrection = ", channelprops.freqcorrection, " PPM");
-
-			// Create the FM Radio stream
-			m_pvrstream = fmstream::create(create_device(settings), tunerprops, channelprops, fmprops);
-		}
+		// If there is already an active stream, attempt to retune it to the new channel in place
+		if(m_pvrstream) {
 
-		// HD Radio
-		//
-		else if(channelprops.modulation == modulation::hd) {
-
-			// Set up the HD Radio digital signal processor properties
-			struct hdprops hdprops = {};
-			hdprops.outputgain = settings.hdradio_output_gain;
-
-			// Log information about the stream for diagnostic purposes
-			log_info(__func__, ": Creating hdstream for channel \"", channelprops.name, "\"");
-			log_info(__func__, ": subchannel = ", channelid.subchannel());
-			log_info(__func__, ": tunerprops.freqcorrection = ", tunerprops.freqcorrection, " PPM");
-			log_info(__func__, ": hdprops.outputgain = ", hdprops.outputgain, " dB");
-			log_info(__func__, ": channelprops.frequency = ", channelprops.frequency, " Hz");
-			log_info(__func__, ": channelprops.autogain = ", (channelprops.autogain) ? "true" : "false");
-			log_info(__func__, ": channelprops.manualgain = ", channelprops.manualgain / 10, " dB");
-			log_info(__func__, ": channelprops.freqcorrection = ", channelprops.freqcorrection, " PPM");
-
-			// Create the HD Radio stream
-			m_pvrstream = hdstream::create(create_device(settings), tunerprops, channelprops, hdprops, channelid.subchannel());
-		}
+			struct acquisitionprops acquisitionprops = {};
+			bool cacheacquisition = false;
+			bool retuned = false;
+			struct channelprops previous = m_pvrstream_channelprops;
 
-		// DAB
-		//
-		else if(channelprops.modulation == modulation::dab) {
-
-			// Set up the DAB digital signal processor properties
-			struct dabprops dabprops = {};
-			dabprops.outputgain = settings.dabradio_output_gain;
-
-			// Log information about the stream for diagnostic purposes
-			log_info(__func__, ": Creating dabstream for channel \"", channelprops.name, "\"");
-			log_info(__func__, ": subchannel = ", channelid.subchannel());
-			log_info(__func__, ": tunerprops.freqcorrection = ", tunerprops.freqcorrection, " PPM");
-			log_info(__func__, ": dabrops.outputgain = ", dabprops.outputgain, " dB");
-			log_info(__func__, ": channelprops.frequency = ", channelprops.frequency, " Hz");
-			log_info(__func__, ": channelprops.autogain = ", (channelprops.autogain) ? "true" : "false");
-			log_info(__func__, ": channelprops.manualgain = ", channelprops.manualgain / 10, " dB");
-			log_info(__func__, ": channelprops.freqcorrection = ", channelprops.freqcorrection, " PPM");
-
-			// Create the DAB stream
-			m_pvrstream = dabstream::create(create_device(settings), tunerprops, channelprops, dabprops, channelid.subchannel());
+			try {
+
+				// The stream can't be retuned while it's being read from
+				std::unique_lock<std::mutex> demux(m_pvrstream_demuxlock);
+
+				// Get the signal acquisition state for the previous channel prior to retuning
+				cacheacquisition = m_pvrstream->acquisition(acquisitionprops);
+
+				// Streams with a different modulation cannot be retuned and must be closed
+				retuned = m_pvrstream->retune(tunerprops, channelprops, channelid.subchannel());
+			}
+
+			// A stream that fails to retune (for example its device was taken by a recording) is
+			// of no further use; close it and create a new stream for the channel below
+			catch(std::exception& ex) { log_warning(__func__, ": unable to retune active stream: ", ex.what()); }
+			catch(...) { log_warning(__func__, ": unable to retune active stream"); }
+
+			if(!retuned) reset_stream();
+
+			if(cacheacquisition) update_channel_acquisition(connectionpool::handle(m_connpool), previous.frequency, previous.modulation, acquisitionprops);
+
+			if(retuned) {
+
+				log_info(__func__, ": Retuned active stream to channel \"", channelprops.name, "\"");
+				m_pvrstream_channelprops = channelprops;
+				return true;
+			}
 		}
 
-		// Weather Radio
-		//
-		else if(channelprops.modulation == modulation::wx) {
-
-			// Set up the FM digital signal processor properties
-			struct wxprops wxprops = {};
-			wxprops.samplerate = settings.wxradio_sample_rate;
-			wxprops.outputrate = settings.wxradio_output_samplerate;
-			wxprops.outputgain = settings.wxradio_output_gain;
-
-			// Log information about the stream for diagnostic purposes
-			log_info(__func__, ": Creating wxstream for channel \"", channelprops.name, "\"");
-			log_info(__func__, ": tunerprops.freqcorrection = ", tunerprops.freqcorrection, " PPM");
-			log_info(__func__, ": wxprops.samplerate = ", wxprops.samplerate, " Hz");
-			log_info(__func__, ": wxprops.outputgain = ", wxprops.outputgain, " dB");
-			log_info(__func__, ": wxprops.outputrate = ", wxprops.outputrate, " Hz");
-			log_info(__func__, ": channelprops.frequency = ", channelprops.frequency, " Hz");
-			log_info(__func__, ": channelprops.autogain = ", (channelprops.autogain) ? "true" : "false");
-			log_info(__func__, ": channelprops.manualgain = ", channelprops.manualgain / 10, " dB");
-			log_info(__func__, ": channelprops.freqcorrection = ", channelprops.freqcorrection, " PPM");
-
-			// Create the Weather Radio stream
-			m_pvrstream = wxstream::create(create_device(settings), tunerprops, channelprops, wxprops);
+		// Create the stream for the channel on a live priority device
+		std::unique_ptr<pvrstream> stream = create_stream(settings, channelprops, channelid.subchannel(), devicepriority::live);
+
+		// Wrap the stream in a timeshift buffer to allow it to be paused and seeked
+		if(settings.device_timeshift_memory > 0) {
+
+			// The disk buffer is optional, if the folder can't be created only the memory buffer is used
+			std::string diskfile;
+			if(settings.device_timeshift_disk > 0) {
+
+				std::string folder = UserPath() + "/timeshift";
+				if(kodi::vfs::DirectoryExists(folder) || kodi::vfs::CreateDirectory(folder)) diskfile = folder + "/timeshift.tmp";
+				else log_warning(__func__, ": unable to create timeshift buffer folder ", folder.c_str());
+			}
+
+			log_info(__func__, ": timeshift buffer = ", settings.device_timeshift_memory, " MiB memory, ", (diskfile.empty()) ? 0 : settings.device_timeshift_disk, " MiB disk");
+			stream = timeshiftstream::create(std::move(stream), static_cast<size_t>(settings.device_timeshift_memory) MiB,
+				static_cast<uint64_t>((diskfile.empty()) ? 0 : settings.device_timeshift_disk) MiB, diskfile.c_str());
 		}
 
-		else throw string_exception("channel ", channel.GetUniqueId(), " (", channel.GetChannelName().c_str(), ") has an unknown modulation type");
+		std::atomic_store(&m_pvrstream, std::shared_ptr<pvrstream>(std::move(stream)));
+		m_pvrstream_channelprops = channelprops;		// Retain the active stream channel properties
 	}
 
 	// Queue a notification for the user when a live stream cannot be opened, don't just silently log it
@@ -2348,6 +3630,67 @@ bool addon::OpenLiveStream(kodi::addon::PVRChannel const& channel)
 	return true;
 }
 
+//-----------------------------------------------------------------------------
+// addon::OpenRecordedStream (CInstancePVRClient)
+//
+// Open a stream to a recording on the backend
+//
+// Arguments:
+//
+//	recording	- Recording to be opened
+
+bool addon::OpenRecordedStream(kodi::addon::PVRRecording const& recording)
+{
+	// Prevent race condition with functions that modify or read from m_pvrstream
+	std::unique_lock<std::mutex> lock(m_pvrstream_lock);
+
+	try {
+
+		reset_stream();
+
+		unsigned int const recordingid = static_cast<unsigned int>(std::stoul(recording.GetRecordingId()));
+		std::string folder = recording_folder(recordingid);
+		log_info(__func__, ": Opening recording \"", recording.GetTitle().c_str(), "\" from ", folder.c_str());
+
+		// A recording is only still being written to if there is an active recorder for it
+		std::unique_lock<std::mutex> recordings_lock(m_recordings_lock);
+		bool const inprogress = std::any_of(m_recordings.begin(), m_recordings.end(), [&](auto const& item) -> bool {
+			return item.second.recordingid == recordingid; });
+		recordings_lock.unlock();
+
+		std::atomic_store(&m_pvrstream, std::shared_ptr<pvrstream>(recordingstream::create(folder.c_str(), recording.GetChannelName().c_str(), inprogress)));
+	}
+
+	// Queue a notification for the user when a recording cannot be opened, don't just silently log it
+	catch(std::exception& ex) {
+
+		kodi::QueueFormattedNotification(QueueMsg::QUEUE_ERROR, "Recording playback failed (%s).", ex.what());
+		return handle_stdexception(__func__, ex, false);
+	}
+
+	catch(...) { return handle_generalexception(__func__, false); }
+
+	return true;
+}
+
+//-----------------------------------------------------------------------------
+// addon::PauseStream (CInstancePVRClient)
+//
+// Notify the add-on that Kodi has paused or resumed the currently playing stream
+//
+// Arguments:
+//
+//	paused		- Flag indicating if the stream has been paused or resumed
+
+void addon::PauseStream(bool paused)
+{
+	std::shared_ptr<pvrstream> stream = std::atomic_load(&m_pvrstream);
+
+	try { if(stream) stream->pause(paused); }
+	catch(std::exception& ex) { return handle_stdexception(__func__, ex); }
+	catch(...) { return handle_generalexception(__func__); }
+}
+
 //-----------------------------------------------------------------------------
 // addon::ReadLiveStream (CInstancePVRClient)
 //
@@ -2395,11 +3738,61 @@ PVR_ERROR addon::RenameChannel(kodi::addon::PVRChannel const& channel)
 
 int64_t addon::SeekLiveStream(int64_t position, int whence)
 {
-	try { return (m_pvrstream) ? m_pvrstream->seek(position, whence) : -1; }
+	std::shared_ptr<pvrstream> stream = std::atomic_load(&m_pvrstream);
+
+	try { return (stream) ? stream->seek(position, whence) : -1; }
 	catch(std::exception& ex) { return handle_stdexception(__func__, ex, -1); }
 	catch(...) { return handle_generalexception(__func__, -1); }
 }
 
+//-----------------------------------------------------------------------------
+// addon::SeekTime (CInstancePVRClient)
+//
+// Seek the currently playing stream to a specific time
+//
+// Arguments:
+//
+//	time		- Time to seek to, in milliseconds
+//	backwards	- Flag indicating the direction of the seek
+//	startpts	- Receives the presentation time stamp at the new position
+
+bool addon::SeekTime(double time, bool backwards, double& startpts)
+{
+	std::shared_ptr<pvrstream> stream = std::atomic_load(&m_pvrstream);
+
+	try { return (stream) ? stream->seektime(time, backwards, startpts) : false; }
+	catch(std::exception& ex) { return handle_stdexception(__func__, ex, false); }
+	catch(...) { return handle_generalexception(__func__, false); }
+}
+
+//-----------------------------------------------------------------------------
+// addon::UpdateTimer (CInstancePVRClient)
+//
+// Update the timer information on the backend
+//
+// Arguments:
+//
+//	timer		- The timer to update
+
+PVR_ERROR addon::UpdateTimer(kodi::addon::PVRTimer const& timer)
+{
+	try {
+
+		if(timer.GetEndTime() <= timer.GetStartTime()) return PVR_ERROR::PVR_ERROR_INVALID_PARAMETERS;
+		if(timer.GetClientChannelUid() == PVR_TIMER_ANY_CHANNEL) return PVR_ERROR::PVR_ERROR_INVALID_PARAMETERS;
+
+		std::string title = timer.GetTitle();
+		update_timer(connectionpool::handle(m_connpool), { timer.GetClientIndex(), static_cast<unsigned int>(timer.GetClientChannelUid()), title.c_str(), 
+			timer.GetStartTime(), timer.GetEndTime() });
+		TriggerTimerUpdate();
+	}
+
+	catch(std::exception& ex) { return handle_stdexception(__func__, ex, PVR_ERROR::PVR_ERROR_FAILED); }
+	catch(...) { return handle_generalexception(__func__, PVR_ERROR::PVR_ERROR_FAILED); }
+
+	return PVR_ERROR::PVR_ERROR_NO_ERROR;
+}
+
 //---------------------------------------------------------------------------
 
 #pragma warning(pop)
@@ -25,14 +25,22 @@
 #pragma once
 
 #include <kodi/addon-instance/PVR.h>
+#include <map>
 #include <memory>
 #include <mutex>
+#include <set>
+#include <thread>
 
 #include "database.h"
+#include "dbtypes.h"
+#include "devicemanager.h"
 #include "props.h"
 #include "pvrstream.h"
 #include "pvrtypes.h"
+#include "recorder.h"
+#include "replaybuffer.h"
 #include "rtldevice.h"
+#include "scalar_condition.h"
 
 #pragma warning(push, 4)
 
@@ -71,11 +79,21 @@ public:
 	// CInstancePVRClient
 	//-------------------------------------------------------------------------
 
+	// AddTimer
+	//
+	// Add a timer on the backend
+	PVR_ERROR AddTimer(kodi::addon::PVRTimer const& timer) override;
+
 	// CallSettingsMenuHook
 	//
 	// Call one of the settings related menu hooks
 	PVR_ERROR CallSettingsMenuHook(kodi::addon::PVRMenuhook const& menuhook) override;
 
+	// CanPauseStream
+	//
+	// Check if the backend supports pausing the currently playing stream
+	bool CanPauseStream(void) override;
+
 	// CanSeekStream
 	//
 	// Check if the backend supports seeking for the currently playing stream
@@ -86,11 +104,26 @@ public:
 	// Close an open live stream
 	void CloseLiveStream(void) override;
 
+	// CloseRecordedStream
+	//
+	// Close an open stream from a recording
+	void CloseRecordedStream(void) override;
+
 	// DeleteChannel
 	//
 	// Deletes a channel from the backend
 	PVR_ERROR DeleteChannel(kodi::addon::PVRChannel const& channel) override;
 
+	// DeleteRecording
+	//
+	// Delete a recording on the backend
+	PVR_ERROR DeleteRecording(kodi::addon::PVRRecording const& recording) override;
+
+	// DeleteTimer
+	//
+	// Delete a timer on the backend
+	PVR_ERROR DeleteTimer(kodi::addon::PVRTimer const& timer, bool forceDelete) override;
+
 	// DemuxAbort
 	//
 	// Abort the demultiplexer thread in the add-on
@@ -161,6 +194,16 @@ public:
 	// Request the EPG for a channel from the backend
 	PVR_ERROR GetEPGForChannel(int channelUid, time_t start, time_t end, kodi::addon::PVREPGTagsResultSet& results) override;
 		
+	// GetRecordings
+	//
+	// Request the list of all recordings from the backend
+	PVR_ERROR GetRecordings(bool deleted, kodi::addon::PVRRecordingsResultSet& results) override;
+
+	// GetRecordingsAmount
+	//
+	// Get the total amount of recordings on the backend
+	PVR_ERROR GetRecordingsAmount(bool deleted, int& amount) override;
+
 	// GetSignalStatus
 	//
 	// Get the signal status of the stream that's currently open
@@ -170,6 +213,26 @@ public:
 	//
 	// Get the stream properties of the stream that's currently being read
 	PVR_ERROR GetStreamProperties(std::vector<kodi::addon::PVRStreamProperties>& properties) override;
+
+	// GetStreamTimes
+	//
+	// Get the stream times of the stream that's currently being read
+	PVR_ERROR GetStreamTimes(kodi::addon::PVRStreamTimes& times) override;
+
+	// GetTimers
+	//
+	// Request the list of all timers from the backend
+	PVR_ERROR GetTimers(kodi::addon::PVRTimersResultSet& results) override;
+
+	// GetTimersAmount
+	//
+	// Get the total amount of timers on the backend
+	PVR_ERROR GetTimersAmount(int& amount) override;
+
+	// GetTimerTypes
+	//
+	// Get the timer types supported by the backend
+	PVR_ERROR GetTimerTypes(std::vector<kodi::addon::PVRTimerType>& types) override;
 		
 	// GetConnectionString
 	//
@@ -205,7 +268,17 @@ public:
 	//
 	// Open a live stream on the backend
 	bool OpenLiveStream(kodi::addon::PVRChannel const& channel) override;
+
+	// OpenRecordedStream
+	//
+	// Open a stream to a recording on the backend
+	bool OpenRecordedStream(kodi::addon::PVRRecording const& recording) override;
 		
+	// PauseStream
+	//
+	// Notify the add-on that Kodi has paused or resumed the currently playing stream
+	void PauseStream(bool paused) override;
+
 	// ReadLiveStream
 	//
 	// Read from an open live stream
@@ -221,11 +294,33 @@ public:
 	// Seek in a live stream on a backend that supports timeshifting
 	int64_t SeekLiveStream(int64_t position, int whence) override;
 
+	// SeekTime
+	//
+	// Seek the currently playing stream to a specific time
+	bool SeekTime(double time, bool backwards, double& startpts) override;
+
+	// UpdateTimer
+	//
+	// Update the timer information on the backend
+	PVR_ERROR UpdateTimer(kodi::addon::PVRTimer const& timer) override;
+
 private:
 
 	addon(addon const&)=delete;
 	addon& operator=(addon const&)=delete;
 
+	//-------------------------------------------------------------------------
+	// Private Type Declarations
+
+	// activerecording_t
+	//
+	// Defines a recording that is in progress
+	struct activerecording_t {
+
+		unsigned int				recordingid;		// Recording identifier
+		std::unique_ptr<recorder>	writer;				// Recording writer instance
+	};
+
 	//-------------------------------------------------------------------------
 	// Private Member Functions
 
@@ -243,7 +338,16 @@ private:
 
 	// Device Helpers
 	//
-	std::unique_ptr<rtldevice> create_device(struct settings const& settings) const;
+	std::unique_ptr<rtldevice> create_device(struct settings const& settings, enum devicepriority priority) const;
+	std::vector<devicemanager::endpoint> enumerate_device_endpoints(struct settings const& settings) const;
+
+	// Recording Helpers
+	//
+	std::string recording_folder(unsigned int recordingid) const;
+	void recording_scheduler(scalar_condition<bool>& started);
+	struct activerecording_t start_recording(struct settings const& settings, struct timer const& timer);
+	void stop_recording(struct activerecording_t& recording);
+	void update_recordings(void);
 
 	// Exception Helpers
 	//
@@ -265,6 +369,7 @@ private:
 	void menuhook_clearchannels(void);
 	void menuhook_exportchannels(void);
 	void menuhook_importchannels(void);
+	void menuhook_savereplay(void);
 
 	// Regional Helpers
 	//
@@ -278,12 +383,28 @@ private:
 	static std::string downsample_quality_to_string(enum downsample_quality quality);
 	static std::string regioncode_to_string(enum regioncode code);
 
+	// Stream Helpers
+	//
+	std::unique_ptr<pvrstream> create_stream(struct settings const& settings, struct channelprops const& channelprops, uint32_t subchannel, enum devicepriority priority) const;
+	void prewarm_streams(void);
+	void reset_stream(void);
+
 	//-------------------------------------------------------------------------
 	// Member Variables
 
 	std::shared_ptr<connectionpool>	m_connpool;				// Database connection pool
-	std::unique_ptr<pvrstream>		m_pvrstream;			// Active PVR stream instance
+	std::shared_ptr<devicemanager>	m_devicemanager;		// Device instance manager
+	std::map<unsigned int, struct activerecording_t> m_recordings;	// Active recordings by timer
+	mutable std::mutex				m_recordings_lock;		// Synchronization object
+	std::thread						m_scheduler;			// Recording scheduler thread
+	std::set<unsigned int>			m_deferred_timers;		// Timers waiting to start (scheduler only)
+	scalar_condition<bool>			m_scheduler_stop{ false };	// Condition to stop the scheduler
+	std::shared_ptr<replaybuffer>	m_replaybuffer;			// Instant replay buffer
+	std::thread						m_prewarm;				// DSP state preparation thread
+	std::shared_ptr<pvrstream>		m_pvrstream;			// Active PVR stream instance
 	mutable std::mutex				m_pvrstream_lock;		// Synchronization object
+	mutable std::mutex				m_pvrstream_demuxlock;	// Demultiplexer synchronization object
+	struct channelprops				m_pvrstream_channelprops;	// Active PVR stream channel
 	struct settings					m_settings;				// Custom addon settings
 	mutable std::recursive_mutex	m_settings_lock;		// Synchronization object
 };
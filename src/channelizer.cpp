@@ -0,0 +1,294 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2020-2022 Michael G. Brehm
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#include "stdafx.h"
+#include "channelizer.h"
+
+#include <assert.h>
+#include <cmath>
+
+#include "fftwcache.h"
+#include "string_exception.h"
+
+#pragma warning(push, 4)
+
+// channelizer::TAPS_PER_PHASE (static)
+//
+// Number of prototype filter taps in each polyphase branch
+size_t const channelizer::TAPS_PER_PHASE = 24;
+
+//---------------------------------------------------------------------------
+// channelizer Constructor (private)
+//
+// Arguments:
+//
+//	samplerate	- Input sample rate in Hertz
+//	channels	- Number of channels to produce (FFT size)
+//	decimation	- Output decimation factor
+
+channelizer::channelizer(uint32_t samplerate, size_t channels, size_t decimation) : m_samplerate(samplerate),
+	m_channels(channels), m_decimation(decimation), m_taps(channels * TAPS_PER_PHASE), m_historypos(0),
+	m_fftin(nullptr), m_fftout(nullptr), m_plan(nullptr)
+{
+	if(samplerate == 0) throw std::invalid_argument("samplerate");
+	if(channels < 2) throw std::invalid_argument("channels");
+	if((decimation == 0) || (decimation > channels)) throw std::invalid_argument("decimation");
+
+	// Generate a Blackman-Harris windowed sinc prototype low-pass filter. The cutoff is set a bit
+	// beyond half of the channel spacing; the channel outputs are oversampled whenever the decimation
+	// is less than the number of channels so the transition band does not alias into the passband
+	double const cutoff = 0.625 / static_cast<double>(m_channels);
+	double const center = (m_taps - 1) / 2.0;
+	double sum = 0.0;
+
+	m_filter.resize(m_taps);
+	for(size_t index = 0; index < m_taps; index++) {
+
+		double const x = static_cast<double>(index) - center;
+		double const sinc = (x == 0.0) ? 2.0 * cutoff : std::sin(2.0 * K_PI * cutoff * x) / (K_PI * x);
+		double const phase = (2.0 * K_PI * index) / (m_taps - 1);
+		double const window = 0.35875 - 0.48829 * std::cos(phase) + 0.14128 * std::cos(2.0 * phase) - 0.01168 * std::cos(3.0 * phase);
+
+		m_filter[index] = static_cast<float>(sinc * window);
+		sum += sinc * window;
+	}
+
+	// Normalize the filter for unity gain in the passband
+	for(auto& tap : m_filter) tap = static_cast<float>(tap / sum);
+
+	// The delay lines are twice the length of the filter so that the most recent samples
+	// are always contiguous in memory regardless of the current position
+	m_historyi.resize(m_taps * 2);
+	m_historyq.resize(m_taps * 2);
+
+	// Generate the phase rotations used to bring each channel down to baseband
+	m_twiddle.resize(m_channels);
+	for(size_t index = 0; index < m_channels; index++) {
+
+		double const phase = (-2.0 * K_PI * index) / m_channels;
+		m_twiddle[index] = { static_cast<TYPEREAL>(std::cos(phase)), static_cast<TYPEREAL>(std::sin(phase)) };
+	}
+
+	// Allocate the FFT buffers and create the plan; the backward transform is used so that
+	// each output bin is the filtered signal at a positive multiple of the channel spacing
+	m_fftin = reinterpret_cast<fftwf_complex*>(fftwf_malloc(sizeof(fftwf_complex) * m_channels));
+	m_fftout = reinterpret_cast<fftwf_complex*>(fftwf_malloc(sizeof(fftwf_complex) * m_channels));
+	if((m_fftin == nullptr) || (m_fftout == nullptr)) {
+
+		if(m_fftin) fftwf_free(m_fftin);
+		if(m_fftout) fftwf_free(m_fftout);
+		throw string_exception(__func__, ": unable to allocate FFT buffers");
+	}
+
+	try { m_plan = fftwcache::get_plan(static_cast<int>(m_channels), m_fftin, m_fftout, FFTW_BACKWARD); }
+	catch(...) { fftwf_free(m_fftin); fftwf_free(m_fftout); throw; }
+
+	m_outputs.resize(m_channels);
+}
+
+//---------------------------------------------------------------------------
+// channelizer Destructor
+
+channelizer::~channelizer()
+{
+	if(m_fftin) fftwf_free(m_fftin);
+	if(m_fftout) fftwf_free(m_fftout);
+}
+
+//---------------------------------------------------------------------------
+// channelizer::channelindex
+//
+// Gets the index of the channel nearest to a frequency offset from center
+//
+// Arguments:
+//
+//	offset		- Frequency offset from the center frequency in Hertz
+
+size_t channelizer::channelindex(double offset) const
+{
+	long long const channel = std::llround(offset / channelspacing());
+	long long const channels = static_cast<long long>(m_channels);
+
+	// Negative offsets map onto the upper half of the FFT bins
+	return static_cast<size_t>(((channel % channels) + channels) % channels);
+}
+
+//---------------------------------------------------------------------------
+// channelizer::channeloffset
+//
+// Gets the frequency offset from center of a channel
+//
+// Arguments:
+//
+//	channel		- Channel index
+
+double channelizer::channeloffset(size_t channel) const
+{
+	assert(channel < m_channels);
+
+	// Channels in the upper half of the FFT bins are below the center frequency
+	long long index = static_cast<long long>(channel);
+	if(channel > (m_channels / 2)) index -= static_cast<long long>(m_channels);
+
+	return index * channelspacing();
+}
+
+//---------------------------------------------------------------------------
+// channelizer::channels
+//
+// Gets the number of channels produced by the channelizer
+//
+// Arguments:
+//
+//	NONE
+
+size_t channelizer::channels(void) const
+{
+	return m_channels;
+}
+
+//---------------------------------------------------------------------------
+// channelizer::channelspacing
+//
+// Gets the spacing between adjacent channels
+//
+// Arguments:
+//
+//	NONE
+
+double channelizer::channelspacing(void) const
+{
+	return static_cast<double>(m_samplerate) / m_channels;
+}
+
+//---------------------------------------------------------------------------
+// channelizer::create (static)
+//
+// Factory method, creates a new channelizer instance
+//
+// Arguments:
+//
+//	samplerate	- Input sample rate in Hertz
+//	channels	- Number of channels to produce (FFT size)
+//	decimation	- Output decimation factor
+
+std::unique_ptr<channelizer> channelizer::create(uint32_t samplerate, size_t channels, size_t decimation)
+{
+	return std::unique_ptr<channelizer>(new channelizer(samplerate, channels, decimation));
+}
+
+//---------------------------------------------------------------------------
+// channelizer::inputsamples
+//
+// Pipes input samples into the channelizer
+//
+// Arguments:
+//
+//	samples		- Pointer to the input samples
+//	length		- Length of the input samples, in bytes
+//	callback	- Callback to receive the output samples of each channel
+
+void channelizer::inputsamples(uint8_t const* samples, size_t length, callback const& callback)
+{
+	assert(samples != nullptr);
+
+	// Reset the channel output buffers; each input sample produces at most
+	// one output sample every m_decimation samples
+	size_t const count = length / 2;
+	for(auto& output : m_outputs) {
+
+		output.clear();
+		output.reserve((count / m_decimation) + 1);
+	}
+
+	for(size_t index = 0; index < count; index++) {
+
+		// Insert the sample into the delay line at the head position; the delay line is
+		// written backwards so that the newest sample is always at m_historypos
+		m_historypos = (m_historypos == 0) ? m_taps - 1 : m_historypos - 1;
+
+		// The I/Q samples are scaled to the range of -32767.0 through +32767.0 to match
+		// the range expected by the demodulator (32767.0 / 127.5) = 256.9960784313725
+		float const i = (static_cast<float>(samples[(index * 2)]) - 127.5f) * 256.9960784313725f;
+		float const q = (static_cast<float>(samples[(index * 2) + 1]) - 127.5f) * 256.9960784313725f;
+		m_historyi[m_historypos] = m_historyi[m_historypos + m_taps] = i;
+		m_historyq[m_historypos] = m_historyq[m_historypos + m_taps] = q;
+
+		m_clock = (m_clock + 1) % m_channels;
+		if(++m_inputphase < m_decimation) continue;
+		m_inputphase = 0;
+
+		// Apply the prototype filter to the delay line and fold the products into the
+		// polyphase branches to produce the FFT input
+		float const* historyi = &m_historyi[m_historypos];
+		float const* historyq = &m_historyq[m_historypos];
+		for(size_t branch = 0; branch < m_channels; branch++) {
+
+			float sumi = 0.0f, sumq = 0.0f;
+			for(size_t tap = branch; tap < m_taps; tap += m_channels) {
+
+				sumi += m_filter[tap] * historyi[tap];
+				sumq += m_filter[tap] * historyq[tap];
+			}
+
+			m_fftin[branch][0] = sumi;
+			m_fftin[branch][1] = sumq;
+		}
+
+		fftwf_execute_dft(m_plan, m_fftin, m_fftout);
+
+		// Rotate each channel down to baseband; the required rotation depends on the
+		// channel index and the position of the current sample relative to the FFT size
+		for(size_t channel = 0; channel < m_channels; channel++) {
+
+			TYPECPX const& twiddle = m_twiddle[(channel * m_clock) % m_channels];
+			TYPEREAL const re = static_cast<TYPEREAL>(m_fftout[channel][0]);
+			TYPEREAL const im = static_cast<TYPEREAL>(m_fftout[channel][1]);
+
+			m_outputs[channel].push_back({ (re * twiddle.re) - (im * twiddle.im), (re * twiddle.im) + (im * twiddle.re) });
+		}
+	}
+
+	// Hand each of the channel outputs to the caller
+	for(size_t channel = 0; channel < m_channels; channel++) {
+
+		if(!m_outputs[channel].empty()) callback(channel, m_outputs[channel].data(), m_outputs[channel].size());
+	}
+}
+
+//---------------------------------------------------------------------------
+// channelizer::outputrate
+//
+// Gets the output sample rate of each channel
+//
+// Arguments:
+//
+//	NONE
+
+double channelizer::outputrate(void) const
+{
+	return static_cast<double>(m_samplerate) / m_decimation;
+}
+
+//---------------------------------------------------------------------------
+
+#pragma warning(pop)
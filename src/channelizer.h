@@ -0,0 +1,136 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2020-2022 Michael G. Brehm
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#ifndef __CHANNELIZER_H_
+#define __CHANNELIZER_H_
+#pragma once
+
+#include <fftw3.h>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "fmdsp/demodulator.h"
+
+#pragma warning(push, 4)
+
+//---------------------------------------------------------------------------
+// Class channelizer
+//
+// Implements a uniform polyphase filter bank channelizer that splits a single
+// wideband I/Q capture into a number of equally spaced narrowband channels;
+// every channel is produced by the same inverse FFT, so the cost of extracting
+// all of the channels is roughly the cost of extracting one of them
+
+class channelizer
+{
+public:
+
+	// callback
+	//
+	// Callback function invoked with the output samples of a single channel; the
+	// callback is free to modify the samples in place
+	using callback = std::function<void(size_t channel, TYPECPX* samples, size_t count)>;
+
+	// Destructor
+	//
+	~channelizer();
+
+	//-----------------------------------------------------------------------
+	// Member Functions
+
+	// channelindex
+	//
+	// Gets the index of the channel nearest to a frequency offset from center
+	size_t channelindex(double offset) const;
+
+	// channeloffset
+	//
+	// Gets the frequency offset from center of a channel
+	double channeloffset(size_t channel) const;
+
+	// channels
+	//
+	// Gets the number of channels produced by the channelizer
+	size_t channels(void) const;
+
+	// channelspacing
+	//
+	// Gets the spacing between adjacent channels
+	double channelspacing(void) const;
+
+	// create (static)
+	//
+	// Factory method, creates a new channelizer instance
+	static std::unique_ptr<channelizer> create(uint32_t samplerate, size_t channels, size_t decimation);
+
+	// inputsamples
+	//
+	// Pipes input samples into the channelizer
+	void inputsamples(uint8_t const* samples, size_t length, callback const& callback);
+
+	// outputrate
+	//
+	// Gets the output sample rate of each channel
+	double outputrate(void) const;
+
+private:
+
+	channelizer(channelizer const&) = delete;
+	channelizer& operator=(channelizer const&) = delete;
+
+	// TAPS_PER_PHASE
+	//
+	// Number of prototype filter taps in each polyphase branch
+	static size_t const TAPS_PER_PHASE;
+
+	// Instance Constructor
+	//
+	channelizer(uint32_t samplerate, size_t channels, size_t decimation);
+
+	//-----------------------------------------------------------------------
+	// Member Variables
+
+	uint32_t const						m_samplerate;		// Input sample rate
+	size_t const						m_channels;			// Number of channels (FFT size)
+	size_t const						m_decimation;		// Output decimation factor
+	size_t const						m_taps;				// Prototype filter length
+
+	std::vector<float>					m_filter;			// Prototype filter coefficients
+	std::vector<float>					m_historyi;			// Delay line (I)
+	std::vector<float>					m_historyq;			// Delay line (Q)
+	size_t								m_historypos;		// Delay line position
+	size_t								m_inputphase = 0;	// Samples since last output
+	size_t								m_clock = 0;		// Input sample clock (mod channels)
+
+	std::vector<TYPECPX>				m_twiddle;			// Channel phase rotations
+	fftwf_complex*						m_fftin;			// FFT input buffer
+	fftwf_complex*						m_fftout;			// FFT output buffer
+	fftwf_plan							m_plan;				// FFT plan
+	std::vector<std::vector<TYPECPX>>	m_outputs;			// Channel output buffers
+};
+
+//-----------------------------------------------------------------------------
+
+#pragma warning(pop)
+
+#endif	// __CHANNELIZER_H_
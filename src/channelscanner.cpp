@@ -0,0 +1,790 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2020-2022 Michael G. Brehm
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#include "stdafx.h"
+#include "channelscanner.h"
+
+#include <algorithm>
+#include <assert.h>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <queue>
+#include <thread>
+
+#include "dabmuxscanner.h"
+#include "dabprobe.h"
+#include "fftwcache.h"
+#include "fmchannelbank.h"
+#include "hddsp/nrsc5.h"
+#include "hdmuxscanner.h"
+#include "rdsdecoder.h"
+#include "string_exception.h"
+
+#pragma warning(push, 4)
+
+// channelscanner::FFT_AVERAGES (static)
+//
+// Number of FFTs averaged into the power spectrum of each hop
+size_t const channelscanner::FFT_AVERAGES = 64;
+
+// channelscanner::FFT_SIZE (static)
+//
+// Number of bins in each FFT
+size_t const channelscanner::FFT_SIZE = 1024;
+
+// channelscanner::HD_SIDEBAND_FIRST (static)
+//
+// First (innermost) subcarrier of the HD Radio primary main sidebands
+int const channelscanner::HD_SIDEBAND_FIRST = NRSC5_PM_OUTER_FM - NRSC5_PM_WIDTH_FM;
+
+// channelscanner::HD_SIDEBAND_LAST (static)
+//
+// Last (outermost) subcarrier of the HD Radio primary main sidebands; this is
+// the distance of LB_START and UB_END from the center bin in hddsp/defines.h
+int const channelscanner::HD_SIDEBAND_LAST = NRSC5_PM_OUTER_FM;
+
+// channelscanner::HD_SUBCARRIER_SPACING (static)
+//
+// Spacing of the HD Radio OFDM subcarriers in Hertz
+double const channelscanner::HD_SUBCARRIER_SPACING = (static_cast<double>(NRSC5_SAMPLE_RATE_CU8) / NRSC5_DECIMATION_FM) / NRSC5_FFT_FM;
+
+// channelscanner::SAMPLE_RATE (static)
+//
+// Device sample rate used during a band sweep
+uint32_t const channelscanner::SAMPLE_RATE = (2400 KHz);
+
+// channelscanner::SETTLE_BYTES (static)
+//
+// Amount of data to discard after each retune
+size_t const channelscanner::SETTLE_BYTES = (32 KiB);
+
+// channelscanner::USABLE_BANDWIDTH (static)
+//
+// Portion of each hop with a flat enough response to be used
+uint32_t const channelscanner::USABLE_BANDWIDTH = (1920 KHz);
+
+//---------------------------------------------------------------------------
+// channelscanner Constructor (private)
+//
+// Arguments:
+//
+//	device			- RTL-SDR device instance
+//	tunerprops		- Tuner device properties
+
+channelscanner::channelscanner(std::unique_ptr<rtldevice> device, struct tunerprops const& tunerprops) :
+	m_device(std::move(device)), m_tunerprops(tunerprops), m_plan(nullptr)
+{
+	// Generate a Hann window for the FFT to reduce the leakage of strong carriers
+	m_window.resize(FFT_SIZE);
+	for(size_t index = 0; index < FFT_SIZE; index++)
+		m_window[index] = static_cast<float>(0.5 - 0.5 * std::cos((2.0 * 3.14159265358979323846 * index) / (FFT_SIZE - 1)));
+
+	// Get the shared FFT plan; the worker threads execute the plan against their own buffers, which
+	// are allocated with fftwf_malloc() and therefore have the same alignment as the plan expects
+	fftwf_complex* in = reinterpret_cast<fftwf_complex*>(fftwf_malloc(sizeof(fftwf_complex) * FFT_SIZE));
+	fftwf_complex* out = reinterpret_cast<fftwf_complex*>(fftwf_malloc(sizeof(fftwf_complex) * FFT_SIZE));
+	if((in != nullptr) && (out != nullptr)) {
+
+		try { m_plan = fftwcache::get_plan(static_cast<int>(FFT_SIZE), in, out, FFTW_FORWARD); }
+		catch(...) { fftwf_free(in); fftwf_free(out); throw; }
+	}
+
+	if(in) fftwf_free(in);
+	if(out) fftwf_free(out);
+
+	if(m_plan == nullptr) throw string_exception(__func__, ": unable to allocate FFT buffers");
+}
+
+//---------------------------------------------------------------------------
+// channelscanner Destructor
+
+channelscanner::~channelscanner()
+{
+	m_device.reset();
+}
+
+//---------------------------------------------------------------------------
+// channelscanner::channel_power (private, static)
+//
+// Measures the mean power over a range of frequencies within a hop
+//
+// Arguments:
+//
+//	hop			- Processed hop to measure the power from
+//	frequency	- Center frequency of the range to measure
+//	bandwidth	- Bandwidth of the range to measure
+
+float channelscanner::channel_power(struct hop_t const& hop, uint32_t frequency, uint32_t bandwidth)
+{
+	assert(hop.power.size() == FFT_SIZE);
+
+	double const binwidth = static_cast<double>(SAMPLE_RATE) / FFT_SIZE;
+	double const offset = static_cast<double>(frequency) - static_cast<double>(hop.frequency);
+
+	// Convert the range into power spectrum bins; bin FFT_SIZE / 2 is the center frequency
+	long long first = std::llround((offset - (bandwidth / 2.0)) / binwidth) + static_cast<long long>(FFT_SIZE / 2);
+	long long last = std::llround((offset + (bandwidth / 2.0)) / binwidth) + static_cast<long long>(FFT_SIZE / 2);
+	first = std::max(0LL, first);
+	last = std::min(static_cast<long long>(FFT_SIZE - 1), last);
+	if(last < first) return hop.noisefloor;
+
+	// Average the power in the linear domain before converting it back into decibels
+	double sum = 0.0;
+	for(long long index = first; index <= last; index++) sum += std::pow(10.0, hop.power[static_cast<size_t>(index)] / 10.0);
+
+	return static_cast<float>(10.0 * std::log10(sum / static_cast<double>(last - first + 1)));
+}
+
+//---------------------------------------------------------------------------
+// channelscanner::create (static)
+//
+// Factory method, creates a new channelscanner instance
+//
+// Arguments:
+//
+//	device			- RTL-SDR device instance
+//	tunerprops		- Tuner device properties
+
+std::unique_ptr<channelscanner> channelscanner::create(std::unique_ptr<rtldevice> device, struct tunerprops const& tunerprops)
+{
+	return std::unique_ptr<channelscanner>(new channelscanner(std::move(device), tunerprops));
+}
+
+//---------------------------------------------------------------------------
+// channelscanner::find_hop (private, static)
+//
+// Locates the hop that best covers a range of frequencies
+//
+// Arguments:
+//
+//	hops		- Processed hops
+//	frequency	- Center frequency of the range
+//	bandwidth	- Bandwidth of the range
+
+struct channelscanner::hop_t const* channelscanner::find_hop(std::vector<struct hop_t> const& hops, uint32_t frequency, uint32_t bandwidth)
+{
+	struct hop_t const* best = nullptr;
+	uint32_t bestdistance = 0;
+
+	for(auto const& hop : hops) {
+
+		if(hop.power.empty()) continue;
+
+		// The entire range must fit within the usable bandwidth of the hop
+		uint32_t distance = (frequency > hop.frequency) ? frequency - hop.frequency : hop.frequency - frequency;
+		if((distance + (bandwidth / 2)) > (USABLE_BANDWIDTH / 2)) continue;
+
+		// Prefer the hop where the range is nearest to the center
+		if((best == nullptr) || (distance < bestdistance)) { best = &hop; bestdistance = distance; }
+	}
+
+	return best;
+}
+
+//---------------------------------------------------------------------------
+// channelscanner::get_bandwidth (private, static)
+//
+// Gets the bandwidth of a channel for a modulation
+//
+// Arguments:
+//
+//	modulation	- Channel modulation
+
+uint32_t channelscanner::get_bandwidth(enum modulation modulation)
+{
+	switch(modulation) {
+
+		// Only the strongest part of the FM signal is measured, the full 200KHz
+		// would overlap with adjacent channels on a 100KHz raster
+		case modulation::fm: return (150 KHz);
+		case modulation::hd: return (150 KHz);
+
+		// DAB ensembles occupy 1.536MHz
+		case modulation::dab: return (1536 KHz);
+
+		// Weather Radio is narrowband FM on a 25KHz raster
+		case modulation::wx: return (12 KHz);
+	}
+
+	throw string_exception(__func__, ": unknown channel modulation");
+}
+
+//---------------------------------------------------------------------------
+// channelscanner::get_coverage (private, static)
+//
+// Gets the bandwidth that needs to be captured around a channel for a modulation
+//
+// Arguments:
+//
+//	modulation	- Channel modulation
+
+uint32_t channelscanner::get_coverage(enum modulation modulation)
+{
+	// FM channels need to include the HD Radio primary main sidebands and a little bit
+	// of the spectrum beyond them to determine if the channel is a hybrid carrier
+	if((modulation == modulation::fm) || (modulation == modulation::hd))
+		return static_cast<uint32_t>(2.0 * ((HD_SIDEBAND_LAST * HD_SUBCARRIER_SPACING) + (40 KHz)));
+
+	return get_bandwidth(modulation);
+}
+
+//---------------------------------------------------------------------------
+// channelscanner::identify_stations
+//
+// Identifies detected FM stations from their RDS data
+//
+// Arguments:
+//
+//	results		- Detected channels; FM channels receive the station identification
+//	fmprops		- FM digital signal processor properties
+//	dwellms		- Maximum amount of time to spend on each capture window
+//	progress	- Progress callback function
+
+bool channelscanner::identify_stations(std::vector<struct result>& results, struct fmprops const& fmprops, uint32_t dwellms, progresscallback const& progress)
+{
+	std::vector<size_t>			stations;			// Indexes of the FM stations
+
+	assert(m_device);
+
+	for(size_t index = 0; index < results.size(); index++) if(results[index].modulation == modulation::fm) stations.push_back(index);
+	if(stations.empty()) return true;
+
+	std::sort(stations.begin(), stations.end(), [&](size_t lhs, size_t rhs) -> bool { return results[lhs].frequency < results[rhs].frequency; });
+
+	// Group the stations into capture windows; the center frequency of each window is moved off
+	// of the FM raster to keep the stations away from the DC offset, leave room for that here
+	uint32_t const maxspan = fmchannelbank::maxbandwidth(SAMPLE_RATE) - (200 KHz);
+	std::vector<std::pair<size_t, size_t>> windows;
+	for(size_t first = 0; first < stations.size();) {
+
+		size_t last = first;
+		while(((last + 1) < stations.size()) && ((results[stations[last + 1]].frequency - results[stations[first]].frequency) <= maxspan)) last++;
+
+		windows.emplace_back(first, last);
+		first = last + 1;
+	}
+
+	// Initialize the device for the capture windows
+	m_device->set_frequency_correction(m_tunerprops.freqcorrection);
+	m_device->set_sample_rate(SAMPLE_RATE);
+	m_device->set_automatic_gain_control(true);
+	m_device->begin_stream();
+
+	std::vector<uint8_t> buffer(32 KiB);
+	for(size_t window = 0; window < windows.size(); window++) {
+
+		if(progress && !progress(static_cast<int>((window * 100) / windows.size()))) return false;
+
+		// Center the capture between 50KHz raster points nearest the middle of the window
+		uint32_t const low = results[stations[windows[window].first]].frequency;
+		uint32_t const high = results[stations[windows[window].second]].frequency;
+		uint32_t const centerfrequency = ((((low / 2) + (high / 2)) / (100 KHz)) * (100 KHz)) + (50 KHz);
+
+		std::vector<uint32_t> frequencies;
+		std::map<uint32_t, std::unique_ptr<rdsdecoder>> decoders;
+		for(size_t index = windows[window].first; index <= windows[window].second; index++) {
+
+			uint32_t const frequency = results[stations[index]].frequency;
+			frequencies.push_back(frequency);
+			decoders.emplace(frequency, std::unique_ptr<rdsdecoder>(new rdsdecoder(fmprops.isnorthamerica)));
+		}
+
+		// rds_callback_func (local)
+		//
+		// Receives the RDS group data for each of the channels
+		auto rds_callback_func = [&](uint32_t frequency, tRDS_GROUPS const& rdsgroup) -> void {
+
+			auto found = decoders.find(frequency);
+			if(found != decoders.end()) found->second->decode_rdsgroup(rdsgroup);
+		};
+
+		// is_identified (local)
+		//
+		// Determines if a station has been identified from the RDS data
+		auto is_identified = [&](rdsdecoder const& decoder) -> bool {
+
+			return (fmprops.isnorthamerica && decoder.has_rbds_callsign()) || decoder.has_ps_name();
+		};
+
+		// Only the RDS data is recovered from each of the channels, there is no audio callback
+		std::unique_ptr<fmchannelbank> channelbank = fmchannelbank::create(SAMPLE_RATE, centerfrequency, frequencies, fmprops, nullptr, rds_callback_func);
+
+		// Retune the device and discard the samples that were buffered before the retune
+		m_device->set_center_frequency(centerfrequency);
+		m_device->read(buffer.data(), std::min(buffer.size(), SETTLE_BYTES));
+
+		// Demodulate the window until every station has been identified or the dwell time expires
+		auto const deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(dwellms);
+		while(std::chrono::steady_clock::now() < deadline) {
+
+			size_t const count = m_device->read(buffer.data(), buffer.size());
+			if(count == 0) break;
+
+			channelbank->inputsamples(buffer.data(), count);
+
+			if(std::all_of(decoders.begin(), decoders.end(), [&](auto const& item) -> bool { return is_identified(*item.second); })) break;
+		}
+
+		// Apply whatever identification was recovered to the results
+		for(size_t index = windows[window].first; index <= windows[window].second; index++) {
+
+			struct result& result = results[stations[index]];
+			rdsdecoder const& decoder = *decoders[result.frequency];
+
+			result.pi = decoder.get_pi();
+			if(fmprops.isnorthamerica && decoder.has_rbds_callsign()) result.name = decoder.get_rbds_callsign();
+			else if(decoder.has_ps_name()) result.name = decoder.get_ps_name();
+		}
+	}
+
+	if(progress) progress(100);
+
+	return true;
+}
+
+//---------------------------------------------------------------------------
+// channelscanner::is_hybrid (private, static)
+//
+// Determines if an FM channel has HD Radio primary main sidebands
+//
+// Arguments:
+//
+//	hops		- Processed hops
+//	frequency	- FM channel center frequency
+
+bool channelscanner::is_hybrid(std::vector<struct hop_t> const& hops, uint32_t frequency)
+{
+	struct hop_t const* hop = find_hop(hops, frequency, get_coverage(modulation::fm));
+	if(hop == nullptr) return false;
+
+	// Each primary main sideband is split into an inner and an outer half to check that
+	// it's flat, the spectrum just beyond the sidebands is used as a local reference
+	uint32_t const inner = static_cast<uint32_t>(HD_SIDEBAND_FIRST * HD_SUBCARRIER_SPACING);
+	uint32_t const outer = static_cast<uint32_t>(HD_SIDEBAND_LAST * HD_SUBCARRIER_SPACING);
+	uint32_t const half = (outer - inner) / 2;
+
+	float sideband[2] = {};
+	for(int side = 0; side < 2; side++) {
+
+		// Lower sideband first, then the upper sideband
+		auto const offset = [&](uint32_t distance) -> uint32_t { return (side == 0) ? frequency - distance : frequency + distance; };
+
+		float const innerpower = channel_power(*hop, offset(inner + (half / 2)), half);
+		float const outerpower = channel_power(*hop, offset(outer - (half / 2)), half);
+		float const beyond = channel_power(*hop, offset(outer + (20 KHz)), (30 KHz));
+
+		// The OFDM sidebands are flat topped and have a sharp outer edge, unlike the skirts
+		// of the analog signal or an adjacent channel that would otherwise look similar
+		if(std::abs(innerpower - outerpower) > 4.0f) return false;
+		if((outerpower - beyond) < 4.0f) return false;
+
+		sideband[side] = channel_power(*hop, offset((inner + outer) / 2), outer - inner);
+		if((sideband[side] - hop->noisefloor) < 6.0f) return false;
+	}
+
+	// Hybrid carriers transmit both sidebands at the same level
+	return std::abs(sideband[0] - sideband[1]) <= 4.0f;
+}
+
+//---------------------------------------------------------------------------
+// channelscanner::probe_ensemble (private)
+//
+// Determines if there is a DAB ensemble on the current frequency
+//
+// Arguments:
+//
+//	samplerate	- Device sample rate
+
+bool channelscanner::probe_ensemble(uint32_t samplerate)
+{
+	assert(m_device);
+
+	std::unique_ptr<dabprobe> probe = dabprobe::create(samplerate);
+
+	// Discard the samples that were buffered before the retune
+	std::vector<uint8_t> samples(SETTLE_BYTES);
+	m_device->read(samples.data(), samples.size());
+
+	// Capture a little more than one transmission frame (~100ms) for the probe
+	samples.resize(probe->capturelength());
+	size_t read = 0;
+	while(read < samples.size()) {
+
+		size_t const count = m_device->read(&samples[read], samples.size() - read);
+		if(count == 0) return false;
+		read += count;
+	}
+
+	return probe->detect(samples.data(), samples.size());
+}
+
+//---------------------------------------------------------------------------
+// channelscanner::process_hop (private)
+//
+// Computes the averaged power spectrum of a captured hop
+//
+// Arguments:
+//
+//	hop			- Hop to be processed
+//	in			- FFT input buffer
+//	out			- FFT output buffer
+
+void channelscanner::process_hop(struct hop_t& hop, fftwf_complex* in, fftwf_complex* out) const
+{
+	std::vector<double> power(FFT_SIZE);
+
+	// Average the power spectra of each FFT_SIZE segment of the capture
+	size_t const segments = std::min(FFT_AVERAGES, hop.samples.size() / (FFT_SIZE * 2));
+	for(size_t segment = 0; segment < segments; segment++) {
+
+		uint8_t const* samples = &hop.samples[segment * FFT_SIZE * 2];
+		for(size_t index = 0; index < FFT_SIZE; index++) {
+
+			in[index][0] = ((static_cast<float>(samples[(index * 2)]) - 127.5f) / 127.5f) * m_window[index];
+			in[index][1] = ((static_cast<float>(samples[(index * 2) + 1]) - 127.5f) / 127.5f) * m_window[index];
+		}
+
+		fftwf_execute_dft(m_plan, in, out);
+
+		// Swap the halves of the FFT output so that the center frequency is in the middle
+		for(size_t index = 0; index < FFT_SIZE; index++) {
+
+			size_t const bin = (index + (FFT_SIZE / 2)) % FFT_SIZE;
+			power[bin] += (static_cast<double>(out[index][0]) * out[index][0]) + (static_cast<double>(out[index][1]) * out[index][1]);
+		}
+	}
+
+	hop.samples = std::vector<uint8_t>();			// Release the captured samples
+
+	// The center bins contain the DC offset spike of the device, replace them with the
+	// average of the surrounding bins so they do not appear to be a carrier
+	size_t const center = FFT_SIZE / 2;
+	double const dc = (power[center - 3] + power[center + 3]) / 2.0;
+	for(size_t index = center - 2; index <= center + 2; index++) power[index] = dc;
+
+	hop.power.resize(FFT_SIZE);
+	for(size_t index = 0; index < FFT_SIZE; index++)
+		hop.power[index] = static_cast<float>(10.0 * std::log10(std::max(power[index] / std::max(segments, static_cast<size_t>(1)), 1.0e-20)));
+
+	// Estimate the noise floor as a low percentile of the usable bins; a wideband signal like a DAB
+	// ensemble can occupy most of the hop, so the median would land inside of the signal
+	size_t const usablebins = (FFT_SIZE * USABLE_BANDWIDTH) / SAMPLE_RATE;
+	std::vector<float> usable(hop.power.begin() + (center - (usablebins / 2)), hop.power.begin() + (center + (usablebins / 2)));
+	std::nth_element(usable.begin(), usable.begin() + (usable.size() / 10), usable.end());
+	hop.noisefloor = usable[usable.size() / 10];
+}
+
+//---------------------------------------------------------------------------
+// channelscanner::scan
+//
+// Sweeps the specified channels and returns the detected candidates
+//
+// Arguments:
+//
+//	channels	- Channels to be scanned
+//	progress	- Callback to report progress and check for cancellation
+//	results		- On success, receives the detected candidate channels
+
+bool channelscanner::scan(std::vector<struct channel> const& channels, progresscallback const& progress, std::vector<struct result>& results)
+{
+	assert(m_device);
+
+	results.clear();
+	if(channels.empty()) return true;
+
+	// Generate the frequency ranges that need to be covered by the sweep in ascending order
+	std::vector<std::pair<uint32_t, uint32_t>> ranges;
+	for(auto const& channel : channels) {
+
+		uint32_t const halfwidth = get_coverage(channel.modulation) / 2;
+		ranges.emplace_back(channel.frequency - halfwidth, channel.frequency + halfwidth);
+	}
+	std::sort(ranges.begin(), ranges.end());
+
+	// Plan the hops; each hop is placed such that its usable bandwidth starts at the lowest
+	// range that has not yet been covered and consumes every range that it fully covers
+	std::vector<struct hop_t> hops;
+	size_t range = 0;
+	while(range < ranges.size()) {
+
+		struct hop_t hop = {};
+		hop.frequency = ranges[range].first + (USABLE_BANDWIDTH / 2);
+
+		size_t const first = range;
+		while((range < ranges.size()) && (ranges[range].second <= (hop.frequency + (USABLE_BANDWIDTH / 2)))) range++;
+		if(range == first) range++;
+
+		hops.emplace_back(std::move(hop));
+	}
+
+	// Initialize the device for the sweep
+	m_device->set_frequency_correction(m_tunerprops.freqcorrection);
+	m_device->set_sample_rate(SAMPLE_RATE);
+	m_device->set_automatic_gain_control(true);
+	m_device->begin_stream();
+
+	std::queue<size_t>			queue;				// Queue of captured hops
+	std::mutex					queuelock;			// Synchronization object
+	std::condition_variable		queuecv;			// Queue condition variable
+	bool						captured = false;	// Flag that all hops are captured
+	std::exception_ptr			exception;			// Exception from a worker thread
+
+	// hop_worker (local)
+	//
+	// Worker thread procedure used to process the captured hops
+	auto hop_worker = [&]() -> void {
+
+		fftwf_complex* in = reinterpret_cast<fftwf_complex*>(fftwf_malloc(sizeof(fftwf_complex) * FFT_SIZE));
+		fftwf_complex* out = reinterpret_cast<fftwf_complex*>(fftwf_malloc(sizeof(fftwf_complex) * FFT_SIZE));
+
+		try {
+
+			if((in == nullptr) || (out == nullptr)) throw string_exception(__func__, ": unable to allocate FFT buffers");
+
+			while(true) {
+
+				std::unique_lock<std::mutex> lock(queuelock);
+				queuecv.wait(lock, [&]() -> bool { return captured || !queue.empty(); });
+				if(queue.empty()) break;
+
+				size_t const index = queue.front();
+				queue.pop();
+				lock.unlock();
+
+				process_hop(hops[index], in, out);
+			}
+		}
+
+		catch(...) { std::unique_lock<std::mutex> lock(queuelock); exception = std::current_exception(); }
+
+		if(in) fftwf_free(in);
+		if(out) fftwf_free(out);
+	};
+
+	// Start the worker pool; at least one thread is always required and the capture
+	// thread needs to be left available to read from the device
+	std::vector<std::thread> workers;
+	size_t const workercount = std::max(1U, std::min(4U, std::thread::hardware_concurrency() - 1));
+	for(size_t index = 0; index < workercount; index++) workers.emplace_back(hop_worker);
+
+	bool cancelled = false;
+	std::vector<uint8_t> settle(SETTLE_BYTES);
+
+	try {
+
+		for(size_t index = 0; index < hops.size(); index++) {
+
+			// Report the progress of the sweep and check for cancellation
+			if(progress && !progress(static_cast<int>((index * 100) / hops.size()))) { cancelled = true; break; }
+
+			// Retune the device and discard the samples that were buffered before the retune
+			struct hop_t& hop = hops[index];
+			m_device->set_center_frequency(hop.frequency);
+			m_device->read(settle.data(), settle.size());
+
+			// Capture the samples for the hop and hand it off to the worker pool
+			hop.samples.resize(FFT_SIZE * FFT_AVERAGES * 2);
+			size_t read = 0;
+			while(read < hop.samples.size()) {
+
+				size_t const count = m_device->read(&hop.samples[read], hop.samples.size() - read);
+				if(count == 0) break;
+				read += count;
+			}
+			hop.samples.resize(read);
+
+			std::unique_lock<std::mutex> lock(queuelock);
+			queue.push(index);
+			queuecv.notify_one();
+		}
+	}
+
+	catch(...) { std::unique_lock<std::mutex> lock(queuelock); if(!exception) exception = std::current_exception(); }
+
+	// Wait for the worker pool to finish processing the captured hops
+	std::unique_lock<std::mutex> lock(queuelock);
+	if(cancelled || exception) queue = std::queue<size_t>();
+	captured = true;
+	queuecv.notify_all();
+	lock.unlock();
+
+	for(auto& worker : workers) worker.join();
+
+	if(exception) std::rethrow_exception(exception);
+	if(cancelled) return false;
+
+	// Measure each of the requested channels against the processed hops
+	for(auto const& channel : channels) {
+
+		uint32_t const bandwidth = get_bandwidth(channel.modulation);
+		struct hop_t const* hop = find_hop(hops, channel.frequency, bandwidth);
+		if(hop == nullptr) continue;
+
+		struct result result = {};
+		result.modulation = channel.modulation;
+		result.frequency = channel.frequency;
+		result.power = channel_power(*hop, channel.frequency, bandwidth);
+		result.snr = result.power - hop->noisefloor;
+
+		// DAB ensembles have a flat-topped OFDM spectrum; require a minimum signal level and
+		// that each quarter of the ensemble be within a few decibels of the others
+		if(channel.modulation == modulation::dab) {
+
+			if(result.snr < 6.0f) continue;
+
+			float minimum = result.power, maximum = result.power;
+			for(int quarter = 0; quarter < 4; quarter++) {
+
+				uint32_t const frequency = (channel.frequency - (bandwidth / 2)) + ((bandwidth / 8) * ((quarter * 2) + 1));
+				float const power = channel_power(*hop, frequency, bandwidth / 4);
+				minimum = std::min(minimum, power);
+				maximum = std::max(maximum, power);
+			}
+
+			if((maximum - minimum) > 6.0f) continue;
+		}
+
+		// Analog carriers need to stand well above the noise floor
+		else if(result.snr < 10.0f) continue;
+
+		results.push_back(result);
+	}
+
+	// An FM carrier is visible on the adjacent raster frequencies; only keep the candidates
+	// that are stronger than any other candidate of the same modulation within 150KHz
+	std::vector<struct result> candidates;
+	for(auto const& result : results) {
+
+		bool const peak = std::none_of(results.begin(), results.end(), [&](struct result const& other) -> bool {
+
+			if((other.modulation != result.modulation) || (other.frequency == result.frequency)) return false;
+			if((result.modulation != modulation::fm) && (result.modulation != modulation::hd)) return false;
+
+			uint32_t const distance = (other.frequency > result.frequency) ? other.frequency - result.frequency : result.frequency - other.frequency;
+			return (distance < (150 KHz)) && (other.power > result.power);
+		});
+
+		if(!peak) continue;
+
+		// Tag the FM carriers that also carry HD Radio sidebands
+		candidates.push_back(result);
+		if(result.modulation == modulation::fm) candidates.back().hybrid = is_hybrid(hops, result.frequency);
+	}
+
+	results.swap(candidates);
+	if(progress) progress(100);
+
+	return true;
+}
+
+//---------------------------------------------------------------------------
+// channelscanner::scan_multiplex
+//
+// Tunes a single multiplex channel and collects the multiplex properties
+//
+// Arguments:
+//
+//	modulation	- Multiplex modulation (HD or DAB)
+//	frequency	- Multiplex center frequency
+//	timeoutms	- Maximum amount of time to wait for the multiplex properties
+//	multiplex	- On success, receives the multiplex properties
+
+bool channelscanner::scan_multiplex(enum modulation modulation, uint32_t frequency, uint32_t timeoutms, struct muxscanner::multiplex& multiplex)
+{
+	std::unique_ptr<muxscanner>		scanner;			// Multiplex scanner instance
+	struct muxscanner::multiplex	muxdata = {};		// Most recent multiplex data
+	std::chrono::steady_clock::time_point changed;		// Time of the last change
+	std::mutex						lock;				// Synchronization object
+	std::condition_variable			cv;					// Multiplex condition variable
+
+	assert(m_device);
+
+	// mux_callback_func (local)
+	//
+	// Receives updated multiplex properties from the scanner
+	auto mux_callback_func = [&](struct muxscanner::multiplex const& data) -> void {
+
+		std::unique_lock<std::mutex> critsec(lock);
+		if((data.name != muxdata.name) || (data.subchannels.size() != muxdata.subchannels.size())) changed = std::chrono::steady_clock::now();
+		muxdata = data;
+		cv.notify_all();
+	};
+
+	// Use the same sample rates as the channel settings dialog for the multiplex scanners
+	uint32_t samplerate = 0;
+	if(modulation == modulation::hd) samplerate = NRSC5_SAMPLE_RATE_CU8;
+	else if(modulation == modulation::dab) samplerate = (2048 KHz);
+	else throw string_exception(__func__, ": modulation does not support multiplex scanning");
+
+	m_device->set_frequency_correction(m_tunerprops.freqcorrection);
+	samplerate = m_device->set_sample_rate(samplerate);
+	m_device->set_center_frequency(frequency);
+	m_device->set_automatic_gain_control(true);
+	m_device->begin_stream();
+
+	// DAB ensembles are probed with a short capture before starting the full multiplex scanner,
+	// which takes several seconds to give up on a channel without an ensemble
+	if((modulation == modulation::dab) && (!probe_ensemble(samplerate))) return false;
+
+	if(modulation == modulation::hd) scanner = hdmuxscanner::create(samplerate, frequency, mux_callback_func);
+	else scanner = dabmuxscanner::create(samplerate, mux_callback_func);
+
+	// Start a worker thread to pump data from the device into the multiplex scanner
+	std::exception_ptr exception;
+	std::thread worker([&]() -> void {
+
+		try { m_device->read_async([&](uint8_t const* buffer, size_t count) -> void { scanner->inputsamples(buffer, count); }, static_cast<uint32_t>(32 KiB)); }
+		catch(...) { exception = std::current_exception(); }
+	});
+
+	// Wait until the multiplex has been identified and the list of subchannels has stopped
+	// changing for a little while, or until the timeout has expired
+	auto const deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutms);
+	std::unique_lock<std::mutex> critsec(lock);
+	changed = std::chrono::steady_clock::now();
+	while(std::chrono::steady_clock::now() < deadline) {
+
+		bool const complete = muxdata.sync && !muxdata.name.empty() && !muxdata.subchannels.empty();
+		if(complete && ((std::chrono::steady_clock::now() - changed) >= std::chrono::seconds(2))) break;
+
+		cv.wait_until(critsec, std::min(deadline, std::chrono::steady_clock::now() + std::chrono::milliseconds(250)));
+	}
+
+	multiplex = muxdata;
+	critsec.unlock();
+
+	// Stop the device transfer and the multiplex scanner
+	m_device->cancel_async();
+	worker.join();
+	scanner.reset();
+
+	if(exception) std::rethrow_exception(exception);
+
+	return multiplex.sync && !multiplex.subchannels.empty();
+}
+
+//---------------------------------------------------------------------------
+
+#pragma warning(pop)
@@ -0,0 +1,219 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2020-2022 Michael G. Brehm
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#ifndef __CHANNELSCANNER_H_
+#define __CHANNELSCANNER_H_
+#pragma once
+
+#include <fftw3.h>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "muxscanner.h"
+#include "props.h"
+#include "rtldevice.h"
+
+#pragma warning(push, 4)
+
+//---------------------------------------------------------------------------
+// Class channelscanner
+//
+// Implements a band sweep channel scanner; the device is stepped across the
+// requested channels in wide hops and the averaged power spectrum of each hop
+// is computed on a pool of worker threads while the next hop is captured
+
+class channelscanner
+{
+public:
+
+	// channel
+	//
+	// Defines a channel to be scanned
+	struct channel {
+
+		enum modulation		modulation;			// Channel modulation
+		uint32_t			frequency;			// Channel center frequency
+	};
+
+	// result
+	//
+	// Defines a candidate channel detected by the scan
+	struct result {
+
+		enum modulation		modulation;			// Channel modulation
+		uint32_t			frequency;			// Channel center frequency
+		float				power;				// Channel power (dB)
+		float				snr;				// Channel power above noise floor (dB)
+		bool				hybrid;				// FM: HD Radio sidebands detected
+		uint16_t			pi;					// FM: RDS Program Identification
+		std::string			name;				// FM: RDS station name
+	};
+
+	// progresscallback
+	//
+	// Callback function invoked to report progress; return false to cancel
+	using progresscallback = std::function<bool(int percent)>;
+
+	// Destructor
+	//
+	~channelscanner();
+
+	//-----------------------------------------------------------------------
+	// Member Functions
+
+	// create (static)
+	//
+	// Factory method, creates a new channelscanner instance
+	static std::unique_ptr<channelscanner> create(std::unique_ptr<rtldevice> device, struct tunerprops const& tunerprops);
+
+	// identify_stations
+	//
+	// Identifies detected FM stations from their RDS data
+	bool identify_stations(std::vector<struct result>& results, struct fmprops const& fmprops, uint32_t dwellms, progresscallback const& progress);
+
+	// scan
+	//
+	// Sweeps the specified channels and returns the detected candidates
+	bool scan(std::vector<struct channel> const& channels, progresscallback const& progress, std::vector<struct result>& results);
+
+	// scan_multiplex
+	//
+	// Tunes a single multiplex channel and collects the multiplex properties
+	bool scan_multiplex(enum modulation modulation, uint32_t frequency, uint32_t timeoutms, struct muxscanner::multiplex& multiplex);
+
+private:
+
+	channelscanner(channelscanner const&) = delete;
+	channelscanner& operator=(channelscanner const&) = delete;
+
+	// FFT_AVERAGES
+	//
+	// Number of FFTs averaged into the power spectrum of each hop
+	static size_t const FFT_AVERAGES;
+
+	// FFT_SIZE
+	//
+	// Number of bins in each FFT
+	static size_t const FFT_SIZE;
+
+	// HD_SIDEBAND_FIRST
+	//
+	// First (innermost) subcarrier of the HD Radio primary main sidebands
+	static int const HD_SIDEBAND_FIRST;
+
+	// HD_SIDEBAND_LAST
+	//
+	// Last (outermost) subcarrier of the HD Radio primary main sidebands
+	static int const HD_SIDEBAND_LAST;
+
+	// HD_SUBCARRIER_SPACING
+	//
+	// Spacing of the HD Radio OFDM subcarriers in Hertz
+	static double const HD_SUBCARRIER_SPACING;
+
+	// SAMPLE_RATE
+	//
+	// Device sample rate used during a band sweep
+	static uint32_t const SAMPLE_RATE;
+
+	// SETTLE_BYTES
+	//
+	// Amount of data to discard after each retune
+	static size_t const SETTLE_BYTES;
+
+	// USABLE_BANDWIDTH
+	//
+	// Portion of each hop with a flat enough response to be used
+	static uint32_t const USABLE_BANDWIDTH;
+
+	// Instance Constructor
+	//
+	channelscanner(std::unique_ptr<rtldevice> device, struct tunerprops const& tunerprops);
+
+	//-----------------------------------------------------------------------
+	// Private Type Declarations
+
+	// hop_t
+	//
+	// Defines the state of a single band sweep hop
+	struct hop_t {
+
+		uint32_t					frequency;		// Hop center frequency
+		std::vector<uint8_t>		samples;		// Captured I/Q samples
+		std::vector<float>			power;			// Averaged power spectrum (dB)
+		float						noisefloor;		// Estimated noise floor (dB)
+	};
+
+	//-----------------------------------------------------------------------
+	// Private Member Functions
+
+	// channel_power
+	//
+	// Measures the mean power over a range of frequencies within a hop
+	static float channel_power(struct hop_t const& hop, uint32_t frequency, uint32_t bandwidth);
+
+	// find_hop
+	//
+	// Locates the hop that best covers a range of frequencies
+	static struct hop_t const* find_hop(std::vector<struct hop_t> const& hops, uint32_t frequency, uint32_t bandwidth);
+
+	// get_bandwidth (static)
+	//
+	// Gets the bandwidth of a channel for a modulation
+	static uint32_t get_bandwidth(enum modulation modulation);
+
+	// get_coverage (static)
+	//
+	// Gets the bandwidth that needs to be captured around a channel for a modulation
+	static uint32_t get_coverage(enum modulation modulation);
+
+	// is_hybrid (static)
+	//
+	// Determines if an FM channel has HD Radio primary main sidebands
+	static bool is_hybrid(std::vector<struct hop_t> const& hops, uint32_t frequency);
+
+	// probe_ensemble
+	//
+	// Determines if there is a DAB ensemble on the current frequency
+	bool probe_ensemble(uint32_t samplerate);
+
+	// process_hop
+	//
+	// Computes the averaged power spectrum of a captured hop
+	void process_hop(struct hop_t& hop, fftwf_complex* in, fftwf_complex* out) const;
+
+	//-----------------------------------------------------------------------
+	// Member Variables
+
+	std::unique_ptr<rtldevice>			m_device;		// RTL-SDR device instance
+	struct tunerprops const				m_tunerprops;	// Tuner device properties
+	std::vector<float>					m_window;		// FFT window function
+	fftwf_plan							m_plan;			// FFT plan
+};
+
+//-----------------------------------------------------------------------------
+
+#pragma warning(pop)
+
+#endif	// __CHANNELSCANNER_H_
@@ -23,12 +23,14 @@
 #include "stdafx.h"
 #include "channelsettings.h"
 
+#include <algorithm>
 #include <assert.h>
 #include <cmath>
 #include <glm/gtc/type_ptr.hpp>
 #include <kodi/General.h>
 #include <kodi/gui/controls/Label.h>
 #include <kodi/gui/dialogs/FileBrowser.h>
+#include <string.h>
 
 #include "dabmuxscanner.h"
 #include "hdmuxscanner.h"
@@ -96,13 +98,18 @@ static bool is_platform_opengles(void)
 //
 //	window		- Parent CWindow instance
 //	controlid	- Identifier of the control within the parent CWindow instance
+//	waterfall	- Flag to show a waterfall below the FFT plot
 
-channelsettings::fftcontrol::fftcontrol(kodi::gui::CWindow* window, int controlid) : 
+channelsettings::fftcontrol::fftcontrol(kodi::gui::CWindow* window, int controlid, bool waterfall) : 
 	renderingcontrol(window, controlid)
 {
+	// When the waterfall is shown it occupies the bottom 40% of the control
+	m_plotheight = (waterfall) ? ((m_height * 3) / 5) : m_height;
+	m_waterfallrows = m_height - m_plotheight;
+
 	// Store some handy floating point copies of the width and height for rendering
 	m_widthf = static_cast<GLfloat>(m_width);
-	m_heightf = static_cast<GLfloat>(m_height);
+	m_heightf = static_cast<GLfloat>(m_plotheight);
 
 	// Allocate the buffer to hold the scaled FFT data
 	m_fft = std::unique_ptr<glm::vec2[]>(new glm::vec2[m_width]);
@@ -111,10 +118,54 @@ channelsettings::fftcontrol::fftcontrol(kodi::gui::CWindow* window, int controli
 	m_fftlowcut = m_ffthighcut = -1;
 
 	// Create the model/view/projection matrix based on width and height
-	m_modelProjMat = glm::ortho(0.0f, m_widthf, m_heightf, 0.0f);
+	m_modelProjMat = glm::ortho(0.0f, m_widthf, static_cast<GLfloat>(m_height), 0.0f);
 
-	// Create the vertex buffer object
+	// Create the vertex buffer object; the FFT line strip needs six vertices for every point
+	// and the overlays need a small number more, reserve enough that the batch won't grow
 	glGenBuffers(1, &m_vertexVBO);
+	m_vertices.reserve((m_width * 6) + 256);
+
+	if(m_waterfallrows > 0) {
+
+		// Generate the waterfall palette, black through blue, cyan, yellow and red
+		m_waterfallpalette.resize(256 * 4);
+		for(size_t index = 0; index < 256; index++) {
+
+			float const level = static_cast<float>(index) / 255.0f;
+			float const r = std::min(std::max((level - 0.5f) * 4.0f, 0.0f), 1.0f);
+			float const g = std::min(std::max((level - 0.25f) * 4.0f, 0.0f), 1.0f) - std::min(std::max((level - 0.75f) * 4.0f, 0.0f), 1.0f);
+			float const b = std::min(level * 4.0f, 1.0f) - std::min(std::max((level - 0.5f) * 4.0f, 0.0f), 1.0f);
+
+			m_waterfallpalette[(index * 4) + 0] = static_cast<uint8_t>(r * 255.0f);
+			m_waterfallpalette[(index * 4) + 1] = static_cast<uint8_t>(g * 255.0f);
+			m_waterfallpalette[(index * 4) + 2] = static_cast<uint8_t>(b * 255.0f);
+			m_waterfallpalette[(index * 4) + 3] = 0xFF;
+		}
+
+		// The waterfall image is a ring of rows; a new row is written for each update and only
+		// that row needs to be uploaded into the texture when the control is rendered
+		m_waterfallimage.resize(m_width * m_waterfallrows * 4);
+		for(size_t index = 0; index < m_waterfallimage.size(); index += 4) 
+			memcpy(&m_waterfallimage[index], &m_waterfallpalette[0], 4);
+
+		m_waterfallshader = std::unique_ptr<waterfallshader>(new waterfallshader());
+
+		glGenTextures(1, &m_waterfalltexture);
+		glBindTexture(GL_TEXTURE_2D, m_waterfalltexture);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, static_cast<GLsizei>(m_width), static_cast<GLsizei>(m_waterfallrows), 0, GL_RGBA,
+			GL_UNSIGNED_BYTE, m_waterfallimage.data());
+		glBindTexture(GL_TEXTURE_2D, 0);
+
+		// The waterfall is always drawn as two quads, the vertex buffer never needs to grow
+		glGenBuffers(1, &m_waterfallVBO);
+		glBindBuffer(GL_ARRAY_BUFFER, m_waterfallVBO);
+		glBufferData(GL_ARRAY_BUFFER, sizeof(texvertex_t) * 12, nullptr, GL_DYNAMIC_DRAW);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+	}
 }
 
 //---------------------------------------------------------------------------
@@ -122,10 +173,136 @@ channelsettings::fftcontrol::fftcontrol(kodi::gui::CWindow* window, int controli
 
 channelsettings::fftcontrol::~fftcontrol()
 {
+	// Delete the waterfall texture and vertex buffer object
+	if(m_waterfalltexture != 0) glDeleteTextures(1, &m_waterfalltexture);
+	if(m_waterfallVBO != 0) glDeleteBuffers(1, &m_waterfallVBO);
+
 	// Delete the vertex buffer object
 	glDeleteBuffers(1, &m_vertexVBO);
 }
 
+//---------------------------------------------------------------------------
+// channelsettings::fftcontrol::add_line (private)
+//
+// Adds a line primitive to the batch
+//
+// Arguments:
+//
+//	color		- Color value to use when rendering
+//	vertices	- Line vertices
+
+void channelsettings::fftcontrol::add_line(glm::vec4 color, glm::vec2 const vertices[2])
+{
+	glm::vec2 p(vertices[1].x - vertices[0].x, vertices[1].y - vertices[0].y);
+	p = glm::normalize(p);
+
+	// Pre-calculate the required deltas for the line thickness
+#if defined(WIN32) && defined(HAS_ANGLE)
+	GLfloat const dx = (m_linewidthf);
+	GLfloat const dy = (m_lineheightf);
+#else
+	GLfloat const dx = (m_linewidthf / 2.0f);
+	GLfloat const dy = (m_lineheightf / 2.0f);
+#endif
+
+	glm::vec2 const p1(-p.y, p.x);
+	glm::vec2 const p2(p.y, -p.x);
+
+	glm::vec2 const rect[] = {
+
+		{ vertices[0].x + p1.x * dx, vertices[0].y + p1.y * dy },
+		{ vertices[0].x + p2.x * dx, vertices[0].y + p2.y * dy },
+		{ vertices[1].x + p1.x * dx, vertices[1].y + p1.y * dy },
+		{ vertices[1].x + p2.x * dx, vertices[1].y + p2.y * dy }
+	};
+
+	add_rect(color, rect);
+}
+
+//---------------------------------------------------------------------------
+// channelsettings::fftcontrol::add_line_strip (private)
+//
+// Adds a line strip primitive to the batch
+//
+// Arguments:
+//
+//	color		- Color value to use when rendering
+//	vertices	- Line strip vertices
+//	numvertices	- Number of line strip vertices
+
+void channelsettings::fftcontrol::add_line_strip(glm::vec4 color, glm::vec2 const vertices[], size_t numvertices)
+{
+	// Pre-calculate the required deltas for the line thickness
+#if defined(WIN32) && defined(HAS_ANGLE)
+	GLfloat const dx = (m_linewidthf);
+	GLfloat const dy = (m_lineheightf);
+#else
+	GLfloat const dx = (m_linewidthf / 2.0f);
+	GLfloat const dy = (m_lineheightf / 2.0f);
+#endif
+
+	// Each segment of the line strip is represented by a rectangle of two triangles
+	for(size_t index = 0; index + 1 < numvertices; index++)
+	{
+		glm::vec2 const& a = vertices[index];
+		glm::vec2 const& b = vertices[index + 1];
+
+		glm::vec2 p(b.x - a.x, b.y - a.y);
+		p = glm::normalize(p);
+
+		glm::vec2 const p1(-p.y, p.x);
+		glm::vec2 const p2(p.y, -p.x);
+
+		glm::vec2 const rect[] = {
+
+			{ a.x + p1.x * dx, a.y + p1.y * dy },
+			{ a.x + p2.x * dx, a.y + p2.y * dy },
+			{ b.x + p1.x * dx, b.y + p1.y * dy },
+			{ b.x + p2.x * dx, b.y + p2.y * dy }
+		};
+
+		add_rect(color, rect);
+	}
+}
+
+//---------------------------------------------------------------------------
+// channelsettings::fftcontrol::add_rect (private)
+//
+// Adds a rectangle primitive to the batch
+//
+// Arguments:
+//
+//	color		- Color value to use when rendering
+//	vertices	- Rectangle vertices, in triangle strip order
+
+void channelsettings::fftcontrol::add_rect(glm::vec4 color, glm::vec2 const vertices[4])
+{
+	// The batch is rendered as GL_TRIANGLES, split the rectangle into two triangles
+	m_vertices.push_back({ vertices[0], color });
+	m_vertices.push_back({ vertices[1], color });
+	m_vertices.push_back({ vertices[2], color });
+	m_vertices.push_back({ vertices[2], color });
+	m_vertices.push_back({ vertices[1], color });
+	m_vertices.push_back({ vertices[3], color });
+}
+
+//---------------------------------------------------------------------------
+// channelsettings::fftcontrol::add_triangle (private)
+//
+// Adds a triangle primitive to the batch
+//
+// Arguments:
+//
+//	color		- Color value to use when rendering
+//	vertices	- Triangle vertices
+
+void channelsettings::fftcontrol::add_triangle(glm::vec4 color, glm::vec2 const vertices[3])
+{
+	m_vertices.push_back({ vertices[0], color });
+	m_vertices.push_back({ vertices[1], color });
+	m_vertices.push_back({ vertices[2], color });
+}
+
 //---------------------------------------------------------------------------
 // channelsettings::fftcontrol::db_to_height (private)
 //
@@ -157,7 +334,7 @@ bool channelsettings::fftcontrol::dirty(void)
 //---------------------------------------------------------------------------
 // channelsettings::fftcontrol::height
 //
-// Retrieves the height of the control
+// Retrieves the height of the FFT plot within the control
 //
 // Arguments:
 //
@@ -165,7 +342,7 @@ bool channelsettings::fftcontrol::dirty(void)
 
 size_t channelsettings::fftcontrol::height(void) const
 {
-	return static_cast<size_t>(m_height);
+	return m_plotheight;
 }
 
 //---------------------------------------------------------------------------
@@ -183,350 +360,424 @@ void channelsettings::fftcontrol::render(void)
 	assert(m_shader.ShaderOK());
 	if(!m_shader.ShaderOK()) return;
 
-	// Enable blending
-	glEnable(GL_BLEND);
-	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-
-	// Enable the shader program
-	m_shader.EnableShader();
-
-	// Set the model/view/projection matrix
-	glUniformMatrix4fv(m_shader.uModelProjMatrix(), 1, GL_FALSE, glm::value_ptr(m_modelProjMat));
-
-	// Bind the vertex buffer object
-	glBindBuffer(GL_ARRAY_BUFFER, m_vertexVBO);
-
-	// Enable the vertex array
-	glEnableVertexAttribArray(m_shader.aPosition());
-
-	// Set the vertex attribute pointer type
-	glVertexAttribPointer(m_shader.aPosition(), 2, GL_FLOAT, GL_FALSE, sizeof(glm::vec2), BUFFER_OFFSET(offsetof(glm::vec2, x)));
+	// All of the primitives are collected into a single batch that is uploaded into the
+	// vertex buffer object and drawn at once
+	m_vertices.clear();
 
 #ifndef HAS_ANGLE
 	// Background
-	glm::vec2 backgroundrect[4] = { { 0.0f, 0.0f }, { 0.0f, m_heightf }, { m_widthf, 0.0f }, { m_widthf, m_heightf } };
-	render_rect(glm::vec3(0.0f, 0.0f, 0.0f), backgroundrect);
+	glm::vec2 const backgroundrect[4] = { { 0.0f, 0.0f }, { 0.0f, m_heightf }, { m_widthf, 0.0f }, { m_widthf, m_heightf } };
+	add_rect(glm::vec4(0.0f, 0.0f, 0.0f, 1.0f), backgroundrect);
 #endif
 
 	// 0dB level
 	GLfloat zerodb = db_to_height(0.0f);
-	glm::vec2 zerodbline[2] = { { 0.0f, zerodb }, { m_widthf, zerodb } };
-	render_line(glm::vec4(1.0f, 1.0f, 0.0f, 0.75f), zerodbline);
+	glm::vec2 const zerodbline[2] = { { 0.0f, zerodb }, { m_widthf, zerodb } };
+	add_line(glm::vec4(1.0f, 1.0f, 0.0f, 0.75f), zerodbline);
 
 	// -6dB increment levels
 	for(int index = -6; index >= static_cast<int>(channelsettings::FFT_MINDB); index -= 6) {
 
 		GLfloat y = db_to_height(static_cast<float>(index));
-		glm::vec2 dbline[2] = { { 0.0f, y }, { m_widthf, y } };
-		render_line(glm::vec4(1.0f, 1.0f, 1.0f, 0.2f), dbline);
+		glm::vec2 const dbline[2] = { { 0.0f, y }, { m_widthf, y } };
+		add_line(glm::vec4(1.0f, 1.0f, 1.0f, 0.2f), dbline);
 	}
 
+	std::unique_lock<std::mutex> lock(m_lock);
+
 	// Power range
-	glm::vec2 powerrect[4] = { { 0.0f, m_power }, { m_widthf, m_power }, { 0.0f, m_noise }, { m_widthf, m_noise } };
-	render_rect(glm::vec4(0.0f, 1.0f, 0.0f, 0.1f), powerrect);
-	glm::vec2 powerline[2] = { { 0.0f, m_power }, { m_widthf, m_power } };
-	render_line(glm::vec4(0.0f, 1.0f, 0.0f, 0.75f), powerline);
+	glm::vec2 const powerrect[4] = { { 0.0f, m_power }, { m_widthf, m_power }, { 0.0f, m_noise }, { m_widthf, m_noise } };
+	add_rect(glm::vec4(0.0f, 1.0f, 0.0f, 0.1f), powerrect);
+	glm::vec2 const powerline[2] = { { 0.0f, m_power }, { m_widthf, m_power } };
+	add_line(glm::vec4(0.0f, 1.0f, 0.0f, 0.75f), powerline);
 
 	// Noise range
-	glm::vec2 noiserect[4] = { { 0.0f, m_noise }, { m_widthf, m_noise }, { 0.0f, m_heightf }, { m_widthf, m_heightf } };
-	render_rect(glm::vec4(1.0f, 0.0f, 0.0f, 0.15f), noiserect);
-	glm::vec2 noiseline[2] = { { 0.0f, m_noise }, { m_width, m_noise } };
-	render_line(glm::vec4(1.0f, 0.0f, 0.0f, 0.75f), noiseline);
+	glm::vec2 const noiserect[4] = { { 0.0f, m_noise }, { m_widthf, m_noise }, { 0.0f, m_heightf }, { m_widthf, m_heightf } };
+	add_rect(glm::vec4(1.0f, 0.0f, 0.0f, 0.15f), noiserect);
+	glm::vec2 const noiseline[2] = { { 0.0f, m_noise }, { m_widthf, m_noise } };
+	add_line(glm::vec4(1.0f, 0.0f, 0.0f, 0.75f), noiseline);
 
 	// Center frequency
-	glm::vec2 centerline[2] = { { m_widthf / 2.0f, 0.0f }, { m_widthf / 2.0f, m_heightf } };
-	render_line(glm::vec4(1.0f, 1.0f, 0.0f, 0.75f), centerline);
+	glm::vec2 const centerline[2] = { { m_widthf / 2.0f, 0.0f }, { m_widthf / 2.0f, m_heightf } };
+	add_line(glm::vec4(1.0f, 1.0f, 0.0f, 0.75f), centerline);
 
 	// Low cut
-	glm::vec2 lowcutline[2] = { { static_cast<GLfloat>(m_fftlowcut), 0.0f }, { static_cast<GLfloat>(m_fftlowcut), m_heightf } };
-	render_line(glm::vec4(1.0f, 1.0f, 1.0f, 0.4f), lowcutline);
+	glm::vec2 const lowcutline[2] = { { static_cast<GLfloat>(m_fftlowcut), 0.0f }, { static_cast<GLfloat>(m_fftlowcut), m_heightf } };
+	add_line(glm::vec4(1.0f, 1.0f, 1.0f, 0.4f), lowcutline);
 
 	// High cut
-	glm::vec2 highcutline[2] = { { static_cast<GLfloat>(m_ffthighcut), 0.0f }, { static_cast<GLfloat>(m_ffthighcut), m_heightf } };
-	render_line(glm::vec4(1.0f, 1.0f, 1.0f, 0.4f), highcutline);
+	glm::vec2 const highcutline[2] = { { static_cast<GLfloat>(m_ffthighcut), 0.0f }, { static_cast<GLfloat>(m_ffthighcut), m_heightf } };
+	add_line(glm::vec4(1.0f, 1.0f, 1.0f, 0.4f), highcutline);
 
 	// FFT
-	glm::vec3 fftcolor(0.5f, 0.5f, 0.5f);
-	if(m_overload) fftcolor = glm::vec3(1.0f, 0.0f, 0.0f);
+	glm::vec4 fftcolor(0.5f, 0.5f, 0.5f, 1.0f);
+	if(m_overload) fftcolor = glm::vec4(1.0f, 0.0f, 0.0f, 1.0f);
 	else if(m_signallock) {
 
 		// If there is also a lock on the multiplex use a green line
-		if(m_muxlock) fftcolor = glm::vec3(0.2823f, 0.7333f, 0.0901f);	// Kelly Green (#4CBB17)
-		else fftcolor = glm::vec3(1.0f, 1.0f, 1.0f);
+		if(m_muxlock) fftcolor = glm::vec4(0.2823f, 0.7333f, 0.0901f, 1.0f);	// Kelly Green (#4CBB17)
+		else fftcolor = glm::vec4(1.0f, 1.0f, 1.0f, 1.0f);
 	}
 	
-	render_line_strip(fftcolor, m_fft.get(), m_width);
+	add_line_strip(fftcolor, m_fft.get(), m_width);
+
+	lock.unlock();
+
+	// Enable blending
+	glEnable(GL_BLEND);
+	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+	// Enable the shader program
+	m_shader.EnableShader();
+
+	// Set the model/view/projection matrix
+	glUniformMatrix4fv(m_shader.uModelProjMatrix(), 1, GL_FALSE, glm::value_ptr(m_modelProjMat));
 
+	// Bind the vertex buffer object
+	glBindBuffer(GL_ARRAY_BUFFER, m_vertexVBO);
+
+	// The vertex buffer object is only reallocated if the batch has outgrown it, otherwise
+	// the existing storage is updated in place
+	if(m_vertices.size() > m_vertexVBOsize) {
+
+		m_vertexVBOsize = m_vertices.capacity();
+		glBufferData(GL_ARRAY_BUFFER, sizeof(vertex_t) * m_vertexVBOsize, nullptr, GL_DYNAMIC_DRAW);
+	}
+
+	glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(vertex_t) * m_vertices.size(), m_vertices.data());
+
+	// Enable the vertex arrays
+	glEnableVertexAttribArray(m_shader.aPosition());
+	glEnableVertexAttribArray(m_shader.aColor());
+
+	// Set the vertex attribute pointer types
+	glVertexAttribPointer(m_shader.aPosition(), 2, GL_FLOAT, GL_FALSE, sizeof(vertex_t), BUFFER_OFFSET(offsetof(vertex_t, position)));
+	glVertexAttribPointer(m_shader.aColor(), 4, GL_FLOAT, GL_FALSE, sizeof(vertex_t), BUFFER_OFFSET(offsetof(vertex_t, color)));
+
+	// Draw the entire batch
+	glDrawArrays(GL_TRIANGLES, 0, static_cast<GLsizei>(m_vertices.size()));
+
+	glDisableVertexAttribArray(m_shader.aColor());		// Disable the vertex array
 	glDisableVertexAttribArray(m_shader.aPosition());	// Disable the vertex array
 	glBindBuffer(GL_ARRAY_BUFFER, 0);					// Unbind the VBO
 
 	m_shader.DisableShader();							// Disable the shader program
 	glDisable(GL_BLEND);								// Disable blending
 
+	// Waterfall
+	if(m_waterfallrows > 0) render_waterfall();
+
 	// Render state is clean until the next update from the meter instance
 	m_dirty = false;
 }
 
 //---------------------------------------------------------------------------
-// channelsettings::fftcontrol::render_line (private)
+// channelsettings::fftcontrol::render_waterfall (private)
 //
-// Renders a line primitive
+// Renders the waterfall below the FFT plot
 //
 // Arguments:
 //
-//	color		- Color value to use when rendering
-//	vertices	- Line vertices
+//	NONE
 
-void channelsettings::fftcontrol::render_line(glm::vec3 color, glm::vec2 vertices[2]) const
+void channelsettings::fftcontrol::render_waterfall(void)
 {
-	return render_line(glm::vec4(color, 1.0f), vertices);
+	assert(m_waterfallshader);
+	assert(m_waterfallrows > 0);
+
+	if(!m_waterfallshader->ShaderOK()) return;
+
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D, m_waterfalltexture);
+
+	// Upload only the rows that have been added since the last time the control was rendered
+	std::unique_lock<std::mutex> lock(m_lock);
+	for(; m_waterfallpending > 0; m_waterfallpending--) {
+
+		size_t const row = (m_waterfallhead + m_waterfallrows - m_waterfallpending) % m_waterfallrows;
+		glTexSubImage2D(GL_TEXTURE_2D, 0, 0, static_cast<GLint>(row), static_cast<GLsizei>(m_width), 1, GL_RGBA, GL_UNSIGNED_BYTE,
+			&m_waterfallimage[row * m_width * 4]);
+	}
+
+	size_t const head = m_waterfallhead;
+	lock.unlock();
+
+	// The most recent row is drawn at the top; the rows before the head in the texture are drawn
+	// first in reverse order, followed by the rows after the head also in reverse order
+	GLfloat const top = m_heightf;
+	GLfloat const split = m_heightf + static_cast<GLfloat>(head);
+	GLfloat const bottom = static_cast<GLfloat>(m_height);
+	GLfloat const v = static_cast<GLfloat>(head) / static_cast<GLfloat>(m_waterfallrows);
+
+	texvertex_t const vertices[12] = {
+
+		{ { 0.0f, top }, { 0.0f, v } }, { { 0.0f, split }, { 0.0f, 0.0f } }, { { m_widthf, top }, { 1.0f, v } },
+		{ { m_widthf, top }, { 1.0f, v } }, { { 0.0f, split }, { 0.0f, 0.0f } }, { { m_widthf, split }, { 1.0f, 0.0f } },
+		{ { 0.0f, split }, { 0.0f, 1.0f } }, { { 0.0f, bottom }, { 0.0f, v } }, { { m_widthf, split }, { 1.0f, 1.0f } },
+		{ { m_widthf, split }, { 1.0f, 1.0f } }, { { 0.0f, bottom }, { 0.0f, v } }, { { m_widthf, bottom }, { 1.0f, v } },
+	};
+
+	m_waterfallshader->EnableShader();
+
+	glUniformMatrix4fv(m_waterfallshader->uModelProjMatrix(), 1, GL_FALSE, glm::value_ptr(m_modelProjMat));
+	glUniform1i(m_waterfallshader->uTexture(), 0);
+
+	glBindBuffer(GL_ARRAY_BUFFER, m_waterfallVBO);
+	glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(vertices), &vertices[0]);
+
+	glEnableVertexAttribArray(m_waterfallshader->aPosition());
+	glEnableVertexAttribArray(m_waterfallshader->aTexCoord());
+	glVertexAttribPointer(m_waterfallshader->aPosition(), 2, GL_FLOAT, GL_FALSE, sizeof(texvertex_t), BUFFER_OFFSET(offsetof(texvertex_t, position)));
+	glVertexAttribPointer(m_waterfallshader->aTexCoord(), 2, GL_FLOAT, GL_FALSE, sizeof(texvertex_t), BUFFER_OFFSET(offsetof(texvertex_t, texcoord)));
+
+	glDrawArrays(GL_TRIANGLES, 0, 12);
+
+	glDisableVertexAttribArray(m_waterfallshader->aTexCoord());	// Disable the vertex array
+	glDisableVertexAttribArray(m_waterfallshader->aPosition());	// Disable the vertex array
+	glBindBuffer(GL_ARRAY_BUFFER, 0);							// Unbind the VBO
+	glBindTexture(GL_TEXTURE_2D, 0);							// Unbind the texture
+
+	m_waterfallshader->DisableShader();							// Disable the shader program
 }
 
 //---------------------------------------------------------------------------
-// channelsettings::fftcontrol::render_line (private)
+// channelsettings::fftcontrol::update
 //
-// Renders a line primitive
+// Updates the rendering control state and flags it as dirty
 //
 // Arguments:
 //
-//	color		- Color value to use when rendering
-//	vertices	- Line vertices
+//	status		- Signal meter status
+//	signallock	- Flag indicating a signal lock
+//	muxlock		- Flag indicating a multiplex lock
 
-void channelsettings::fftcontrol::render_line(glm::vec4 color, glm::vec2 vertices[2]) const
+void channelsettings::fftcontrol::update(struct signalmeter::signal_status const& status, bool signallock, bool muxlock)
 {
-	// Set the specific color value before drawing the line
-	glUniform4f(m_shader.uColor(), color.r, color.g, color.b, color.a);
+	std::unique_lock<std::mutex> lock(m_lock);
 
-	glm::vec2 p(vertices[1].x - vertices[0].x, vertices[1].y - vertices[0].y);
-	p = glm::normalize(p);
+	// Power and noise values are supplied as dB and need to be scaled to the viewport
+	m_power = db_to_height(status.power);
+	m_noise = db_to_height(status.noise);
 
-	// Pre-calculate the required deltas for the line thickness
-#if defined(WIN32) && defined(HAS_ANGLE)
-	GLfloat const dx = (m_linewidthf);
-	GLfloat const dy = (m_lineheightf);
-#else
-	GLfloat const dx = (m_linewidthf / 2.0f);
-	GLfloat const dy = (m_lineheightf / 2.0f);
-#endif
+	// The low and high cuts are provided as indexes into the plot data
+	m_fftlowcut = status.lowcut;
+	m_ffthighcut = status.highcut;
 
-	glm::vec2 const p1(-p.y, p.x);
-	glm::vec2 const p2(p.y, -p.x);
+	// The length of the fft data should match the width of the control, but watch for overrruns
+	assert(status.plotsize == m_width);
+	size_t length = std::min(status.plotsize, static_cast<size_t>(m_width));
+
+	// The FFT data merely needs to be converted into an X,Y vertex to be used by the renderer
+	for(size_t index = 0; index < length; index++) m_fft[index] = glm::vec2(static_cast<float>(index), 
+		static_cast<float>(status.plotdata[index]));
 
-	glm::vec2 strip[] = {
+	// The FFT line strip will be shown in a different color based on this information
+	m_overload = status.overload;
+	m_signallock = signallock;
+	m_muxlock = muxlock;
 
-		{ vertices[0].x + p1.x * dx, vertices[0].y + p1.y * dy },
-		{ vertices[0].x + p2.x * dx, vertices[0].y + p2.y * dy },
-		{ vertices[1].x + p1.x * dx, vertices[1].y + p1.y * dy },
-		{ vertices[1].x + p2.x * dx, vertices[1].y + p2.y * dy }
-	};
+	// In the event of an FFT data underrun, flat-line the remainder of the data points
+	if(m_width > status.plotsize) {
+
+		for(size_t index = length; index < m_width; index++) m_fft[index] = glm::vec2(static_cast<float>(index), m_heightf);
+	}
+
+	// Add a new row to the waterfall, the plot values run from zero at the maximum level
+	// through the plot height at the minimum level
+	if(m_waterfallrows > 0) {
+
+		uint8_t* row = &m_waterfallimage[m_waterfallhead * m_width * 4];
+		for(size_t index = 0; index < m_width; index++) {
 
-	glBufferData(GL_ARRAY_BUFFER, (sizeof(glm::vec2) * 4), &strip[0], GL_STATIC_DRAW);
-	glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+			size_t level = 0;
+			if(index < length) {
+
+				size_t const y = static_cast<size_t>(std::min(std::max(status.plotdata[index], 0), static_cast<int>(m_plotheight)));
+				level = ((m_plotheight - y) * 255) / m_plotheight;
+			}
+
+			memcpy(&row[index * 4], &m_waterfallpalette[level * 4], 4);
+		}
+
+		m_waterfallhead = (m_waterfallhead + 1) % m_waterfallrows;
+		m_waterfallpending = std::min(m_waterfallpending + 1, m_waterfallrows);
+	}
+
+	m_dirty = true;					// Scene needs to be re-rendered
 }
 
 //---------------------------------------------------------------------------
-// channelsettings::fftcontrol::render_line_strip (private)
+// channelsettings::fftcontrol::width
 //
-// Renders a line strip primitive
+// Retrieves the width of the control
 //
 // Arguments:
 //
-//	color		- Color value to use when rendering
-//	vertices	- Line strip vertices
-//	numvertices	- Number of line strip vertices
+//	NONE
 
-void channelsettings::fftcontrol::render_line_strip(glm::vec3 color, glm::vec2 vertices[], size_t numvertices) const
+size_t channelsettings::fftcontrol::width(void) const
 {
-	return render_line_strip(glm::vec4(color, 1.0f), vertices, numvertices);
+	return static_cast<size_t>(m_width);
 }
 
 //---------------------------------------------------------------------------
-// channelsettings::fftcontrol::render_line_strip (private)
-//
-// Renders a line strip primitive
+// channelsettings::fftshader Constructor
 //
 // Arguments:
 //
-//	color		- Color value to use when rendering
-//	vertices	- Line vertices
-//	numvertices	- Number of line strip vertices
+//	NONE
 
-void channelsettings::fftcontrol::render_line_strip(glm::vec4 color, glm::vec2 vertices[], size_t numvertices) const
+channelsettings::fftshader::fftshader()
 {
-	// Set the specific color value before drawing the line
-	glUniform4f(m_shader.uColor(), color.r, color.g, color.b, color.a);
-
-	// Each point in the line strip will be represented by six vertices in the triangle strip
-	std::unique_ptr<glm::vec2[]> strip(new glm::vec2[numvertices * 6]);
-	size_t strippos = 0;
+	// VERTEX SHADER
+	std::string const vertexshader(
+		R"(
+uniform mat4 u_modelViewProjectionMatrix;
 
-	// Pre-calculate the required deltas for the line thickness
-#if defined(WIN32) && defined(HAS_ANGLE)
-	GLfloat const dx = (m_linewidthf);
-	GLfloat const dy = (m_lineheightf);
+#ifdef GL_ES
+attribute vec2 a_position;
+attribute vec4 a_color;
+varying vec4 v_color;
 #else
-	GLfloat const dx = (m_linewidthf / 2.0f);
-	GLfloat const dy = (m_lineheightf / 2.0f);
+in vec2 a_position;
+in vec4 a_color;
+out vec4 v_color;
 #endif
 
-	for(size_t index = 0; index < numvertices - 1; index++)
-	{
-		glm::vec2 const& a = vertices[index];
-		glm::vec2 const& b = vertices[index + 1];
+void main()
+{
+  gl_Position = u_modelViewProjectionMatrix * vec4(a_position, 0.0, 1.0);
+  v_color = a_color;
+}
+		)");
 
-		glm::vec2 p(b.x - a.x, b.y - a.y);
-		p = glm::normalize(p);
+	// FRAGMENT SHADER
+	std::string const fragmentshader(
+		R"(
+#ifdef GL_ES
+precision mediump float;
+#else
+precision highp float;
+#endif
 
-		glm::vec2 const p1(-p.y, p.x);
-		glm::vec2 const p2(p.y, -p.x);
+#ifdef GL_ES
+varying vec4 v_color;
+#else
+in vec4 v_color;
+out vec4 FragColor;
+#endif
 
-		strip[strippos++] = a;
-		strip[strippos++] = b;
-		strip[strippos++] = glm::vec2(a.x + p1.x * dx, a.y + p1.y * dy);
-		strip[strippos++] = glm::vec2(a.x + p2.x * dx, a.y + p2.y * dy);
-		strip[strippos++] = glm::vec2(b.x + p1.x * dx, b.y + p1.y * dy);
-		strip[strippos++] = glm::vec2(b.x + p2.x * dx, b.y + p2.y * dy);
-	}
+void main()
+{
+#ifdef GL_ES
+  gl_FragColor = v_color;
+#else
+  FragColor = v_color;
+#endif
+}
+		)");
 
-	glBufferData(GL_ARRAY_BUFFER, (sizeof(glm::vec2) * strippos), strip.get(), GL_STATIC_DRAW);
-	glDrawArrays(GL_TRIANGLE_STRIP, 0, static_cast<GLsizei>(strippos));
+	// Compile and link the shader programs during construction
+	if(is_platform_opengles()) CompileAndLink("#version 100\n", vertexshader, "#version 100\n", fragmentshader);
+	else CompileAndLink("#version 150\n", vertexshader, "#version 150\n", fragmentshader);
 }
 
 //---------------------------------------------------------------------------
-// channelsettings::fftcontrol::render_rect (private)
+// channelsettings::fftshader::aColor (const)
 //
-// Renders a line primitive
+// Gets the location of the aColor shader variable
 //
 // Arguments:
 //
-//	color		- Color value to use when rendering
-//	vertices	- Rectangle vertices
+//	NONE
 
-void channelsettings::fftcontrol::render_rect(glm::vec3 color, glm::vec2 vertices[4]) const
+GLint channelsettings::fftshader::aColor(void) const
 {
-	return render_rect(glm::vec4(color, 1.0f), vertices);
+	assert(m_aColor != -1);
+	return m_aColor;
 }
 
 //---------------------------------------------------------------------------
-// channelsettings::fftcontrol::render_rect (private)
+// channelsettings::fftshader::aPosition (const)
 //
-// Renders a line primitive
+// Gets the location of the aPosition shader variable
 //
 // Arguments:
 //
-//	color		- Color value to use when rendering
-//	vertices	- Rectangle vertices
+//	NONE
 
-void channelsettings::fftcontrol::render_rect(glm::vec4 color, glm::vec2 vertices[4]) const
+GLint channelsettings::fftshader::aPosition(void) const
 {
-	// Set the specific color value before drawing the line
-	glUniform4f(m_shader.uColor(), color.r, color.g, color.b, color.a);
-
-	// Render the rectangle as a 4-vertex GL_TRIANGLE_STRIP primitive
-	glBufferData(GL_ARRAY_BUFFER, (sizeof(glm::vec2) * 4), &vertices[0], GL_STATIC_DRAW);
-	glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+	assert(m_aPosition != -1);
+	return m_aPosition;
 }
 
 //---------------------------------------------------------------------------
-// channelsettings::fftcontrol::render_triangle (private)
+// channelsettings::fftshader::OnCompiledAndLinked (CShaderProgram)
 //
-// Renders a line primitive
+// Invoked when the shader has been compiled and linked
 //
 // Arguments:
 //
-//	color		- Color value to use when rendering
-//	vertices	- Triangle vertices
+//	NONE
 
-void channelsettings::fftcontrol::render_triangle(glm::vec3 color, glm::vec2 vertices[3]) const
+void channelsettings::fftshader::OnCompiledAndLinked(void)
 {
-	return render_triangle(glm::vec4(color, 1.0f), vertices);
+	m_aColor = glGetAttribLocation(ProgramHandle(), "a_color");
+	m_aPosition = glGetAttribLocation(ProgramHandle(), "a_position");
+	m_uModelProjMatrix = glGetUniformLocation(ProgramHandle(), "u_modelViewProjectionMatrix");
 }
 
 //---------------------------------------------------------------------------
-// channelsettings::fftcontrol::render_triangle (private)
+// channelsettings::fftshader::OnDisabled (CShaderProgram)
 //
-// Renders a line primitive
+// Invoked when the shader has been disabled
 //
 // Arguments:
 //
-//	color		- Color value to use when rendering
-//	vertices	- Triangle vertices
+//	NONE
 
-void channelsettings::fftcontrol::render_triangle(glm::vec4 color, glm::vec2 vertices[3]) const
+void channelsettings::fftshader::OnDisabled(void)
 {
-	// Set the specific color value before drawing the line
-	glUniform4f(m_shader.uColor(), color.r, color.g, color.b, color.a);
-
-	// Render the triangle as a 3-vertex GL_TRIANGLES primitive
-	glBufferData(GL_ARRAY_BUFFER, (sizeof(glm::vec2) * 3), &vertices[0], GL_STATIC_DRAW);
-	glDrawArrays(GL_TRIANGLES, 0, 3);
 }
 
 //---------------------------------------------------------------------------
-// channelsettings::fftcontrol::update
+// channelsettings::fftshader::OnEnabled (CShaderProgram)
 //
-// Updates the rendering control state and flags it as dirty
+// Invoked when the shader has been enabled
 //
 // Arguments:
 //
-//	status		- Signal meter status
-//	signallock	- Flag indicating a signal lock
-//	muxlock		- Flag indicating a multiplex lock
+//	NONE
 
-void channelsettings::fftcontrol::update(struct signalmeter::signal_status const& status, bool signallock, bool muxlock)
+bool channelsettings::fftshader::OnEnabled(void)
 {
-	// Power and noise values are supplied as dB and need to be scaled to the viewport
-	m_power = db_to_height(status.power);
-	m_noise = db_to_height(status.noise);
-
-	// The low and high cuts are provided as indexes into the plot data
-	m_fftlowcut = status.lowcut;
-	m_ffthighcut = status.highcut;
-
-	// The length of the fft data should match the width of the control, but watch for overrruns
-	assert(status.plotsize == m_width);
-	size_t length = std::min(status.plotsize, static_cast<size_t>(m_width));
-
-	// The FFT data merely needs to be converted into an X,Y vertex to be used by the renderer
-	for(size_t index = 0; index < length; index++) m_fft[index] = glm::vec2(static_cast<float>(index), 
-		static_cast<float>(status.plotdata[index]));
-
-	// The FFT line strip will be shown in a different color based on this information
-	m_overload = status.overload;
-	m_signallock = signallock;
-	m_muxlock = muxlock;
-
-	// In the event of an FFT data underrun, flat-line the remainder of the data points
-	if(m_width > status.plotsize) {
-
-		for(size_t index = length; index < m_width; index++) m_fft[index] = glm::vec2(static_cast<float>(index), m_heightf);
-	}
-
-	m_dirty = true;					// Scene needs to be re-rendered
+	return true;
 }
 
 //---------------------------------------------------------------------------
-// channelsettings::fftcontrol::width
+// channelsettings::fftshader::uModelProjMatrix (const)
 //
-// Retrieves the width of the control
+// Gets the location of the aPosition shader variable
 //
 // Arguments:
 //
 //	NONE
 
-size_t channelsettings::fftcontrol::width(void) const
+GLint channelsettings::fftshader::uModelProjMatrix(void) const
 {
-	return static_cast<size_t>(m_width);
+	assert(m_uModelProjMatrix != -1);
+	return m_uModelProjMatrix;
 }
 
 //---------------------------------------------------------------------------
-// channelsettings::fftshader Constructor
+// channelsettings::waterfallshader Constructor
 //
 // Arguments:
 //
 //	NONE
 
-channelsettings::fftshader::fftshader()
+channelsettings::waterfallshader::waterfallshader()
 {
 	// VERTEX SHADER
 	std::string const vertexshader(
@@ -535,13 +786,18 @@ uniform mat4 u_modelViewProjectionMatrix;
 
 #ifdef GL_ES
 attribute vec2 a_position;
+attribute vec2 a_texcoord;
+varying vec2 v_texcoord;
 #else
 in vec2 a_position;
+in vec2 a_texcoord;
+out vec2 v_texcoord;
 #endif
 
 void main()
 {
   gl_Position = u_modelViewProjectionMatrix * vec4(a_position, 0.0, 1.0);
+  v_texcoord = a_texcoord;
 }
 		)");
 
@@ -554,18 +810,21 @@ precision mediump float;
 precision highp float;
 #endif
 
-uniform vec4 u_color;
+uniform sampler2D u_texture;
 
-#ifndef GL_ES
+#ifdef GL_ES
+varying vec2 v_texcoord;
+#else
+in vec2 v_texcoord;
 out vec4 FragColor;
 #endif
 
 void main()
 {
 #ifdef GL_ES
-  gl_FragColor = u_color;
+  gl_FragColor = texture2D(u_texture, v_texcoord);
 #else
-  FragColor = u_color;
+  FragColor = texture(u_texture, v_texcoord);
 #endif
 }
 		)");
@@ -576,7 +835,7 @@ void main()
 }
 
 //---------------------------------------------------------------------------
-// channelsettings::fftshader::aPosition (const)
+// channelsettings::waterfallshader::aPosition (const)
 //
 // Gets the location of the aPosition shader variable
 //
@@ -584,14 +843,29 @@ void main()
 //
 //	NONE
 
-GLint channelsettings::fftshader::aPosition(void) const
+GLint channelsettings::waterfallshader::aPosition(void) const
 {
 	assert(m_aPosition != -1);
 	return m_aPosition;
 }
 
 //---------------------------------------------------------------------------
-// channelsettings::fftshader::OnCompiledAndLinked (CShaderProgram)
+// channelsettings::waterfallshader::aTexCoord (const)
+//
+// Gets the location of the aTexCoord shader variable
+//
+// Arguments:
+//
+//	NONE
+
+GLint channelsettings::waterfallshader::aTexCoord(void) const
+{
+	assert(m_aTexCoord != -1);
+	return m_aTexCoord;
+}
+
+//---------------------------------------------------------------------------
+// channelsettings::waterfallshader::OnCompiledAndLinked (CShaderProgram)
 //
 // Invoked when the shader has been compiled and linked
 //
@@ -599,15 +873,16 @@ GLint channelsettings::fftshader::aPosition(void) const
 //
 //	NONE
 
-void channelsettings::fftshader::OnCompiledAndLinked(void)
+void channelsettings::waterfallshader::OnCompiledAndLinked(void)
 {
 	m_aPosition = glGetAttribLocation(ProgramHandle(), "a_position");
-	m_uColor = glGetUniformLocation(ProgramHandle(), "u_color");
+	m_aTexCoord = glGetAttribLocation(ProgramHandle(), "a_texcoord");
 	m_uModelProjMatrix = glGetUniformLocation(ProgramHandle(), "u_modelViewProjectionMatrix");
+	m_uTexture = glGetUniformLocation(ProgramHandle(), "u_texture");
 }
 
 //---------------------------------------------------------------------------
-// channelsettings::fftshader::OnDisabled (CShaderProgram)
+// channelsettings::waterfallshader::OnDisabled (CShaderProgram)
 //
 // Invoked when the shader has been disabled
 //
@@ -615,12 +890,12 @@ void channelsettings::fftshader::OnCompiledAndLinked(void)
 //
 //	NONE
 
-void channelsettings::fftshader::OnDisabled(void)
+void channelsettings::waterfallshader::OnDisabled(void)
 {
 }
 
 //---------------------------------------------------------------------------
-// channelsettings::fftshader::OnEnabled (CShaderProgram)
+// channelsettings::waterfallshader::OnEnabled (CShaderProgram)
 //
 // Invoked when the shader has been enabled
 //
@@ -628,39 +903,39 @@ void channelsettings::fftshader::OnDisabled(void)
 //
 //	NONE
 
-bool channelsettings::fftshader::OnEnabled(void)
+bool channelsettings::waterfallshader::OnEnabled(void)
 {
 	return true;
 }
 
 //---------------------------------------------------------------------------
-// channelsettings::fftshader::uColor (const)
+// channelsettings::waterfallshader::uModelProjMatrix (const)
 //
-// Gets the location of the uColor shader variable
+// Gets the location of the uModelProjMatrix shader variable
 //
 // Arguments:
 //
 //	NONE
 
-GLint channelsettings::fftshader::uColor(void) const
+GLint channelsettings::waterfallshader::uModelProjMatrix(void) const
 {
-	assert(m_uColor != -1);
-	return m_uColor;
+	assert(m_uModelProjMatrix != -1);
+	return m_uModelProjMatrix;
 }
 
 //---------------------------------------------------------------------------
-// channelsettings::fftshader::uModelProjMatrix (const)
+// channelsettings::waterfallshader::uTexture (const)
 //
-// Gets the location of the aPosition shader variable
+// Gets the location of the uTexture shader variable
 //
 // Arguments:
 //
 //	NONE
 
-GLint channelsettings::fftshader::uModelProjMatrix(void) const
+GLint channelsettings::waterfallshader::uTexture(void) const
 {
-	assert(m_uModelProjMatrix != -1);
-	return m_uModelProjMatrix;
+	assert(m_uTexture != -1);
+	return m_uTexture;
 }
 
 //---------------------------------------------------------------------------
@@ -748,9 +1023,7 @@ channelsettings::channelsettings(std::unique_ptr<rtldevice> device, struct tuner
 
 channelsettings::~channelsettings()
 {
-	m_stop = true;								// Signal worker thread to stop
-	if(m_device) m_device->cancel_async();		// Cancel any async read operations
-	if(m_worker.joinable()) m_worker.join();	// Wait for thread to exit
+	m_devicehub.reset();						// Stop the device transfer and consumers
 	m_device.reset();							// Release RTL-SDR device
 }
 
@@ -1024,41 +1297,6 @@ void channelsettings::update_gain(void)
 	else m_edit_signalgain->SetText("Auto");
 }
 
-//---------------------------------------------------------------------------
-// channelsettings::worker (private)
-//
-// Worker thread procedure used to pump data into the signal meter
-//
-// Arguments:
-//
-//	started		- Condition variable to set when thread has started
-
-void channelsettings::worker(scalar_condition<bool>& started)
-{
-	assert(m_device);
-	assert(m_signalmeter);
-
-	// read_callback_func (local)
-	//
-	// Asynchronous read callback function for the RTL-SDR device
-	auto read_callback_func = [&](uint8_t const* buffer, size_t count) -> void {
-
-		// Feed the signal meter, and optionally the multiplex scanner
-		m_signalmeter->inputsamples(buffer, count);
-		if(m_muxscanner) m_muxscanner->inputsamples(buffer, count);
-	};
-
-	// Begin streaming from the device and inform the caller that the thread is running
-	m_device->begin_stream();
-	started = true;
-
-	// Continuously read data from the device until cancel_async() has been called
-	try { m_device->read_async(read_callback_func, static_cast<uint32_t>(32 KiB)); }
-	catch(...) { m_worker_exception = std::current_exception(); }
-
-	m_stopped.store(true);					// Thread is stopped
-}
-
 //---------------------------------------------------------------------------
 // CWINDOW IMPLEMENTATION
 //---------------------------------------------------------------------------
@@ -1159,7 +1397,8 @@ bool channelsettings::OnInit(void)
 		m_radio_autogain = std::unique_ptr<CRadioButton>(new CRadioButton(this, CONTROL_RADIO_AUTOMATICGAIN));
 		m_slider_manualgain = std::unique_ptr<CSettingsSlider>(new CSettingsSlider(this, CONTROL_SLIDER_MANUALGAIN));
 		m_slider_correction = std::unique_ptr<CSettingsSlider>(new CSettingsSlider(this, CONTROL_SLIDER_CORRECTION));
-		m_render_signalmeter = std::unique_ptr<fftcontrol>(new fftcontrol(this, CONTROL_RENDER_SIGNALMETER));
+		m_render_signalmeter = std::unique_ptr<fftcontrol>(new fftcontrol(this, CONTROL_RENDER_SIGNALMETER,
+			kodi::addon::GetSettingBoolean("device_signalmeter_waterfall", false)));
 		m_edit_signalgain = std::unique_ptr<CEdit>(new CEdit(this, CONTROL_EDIT_METERGAIN));
 		m_edit_signalpower = std::unique_ptr<CEdit>(new CEdit(this, CONTROL_EDIT_METERPOWER));
 		m_edit_signalsnr = std::unique_ptr<CEdit>(new CEdit(this, CONTROL_EDIT_METERSNR));
@@ -1237,10 +1476,12 @@ bool channelsettings::OnInit(void)
 		else if(m_channelprops.modulation == modulation::dab) m_muxscanner = dabmuxscanner::create(m_signalprops.samplerate,
 			std::bind(&channelsettings::mux_data, this, std::placeholders::_1));
 
-		// Create a worker thread on which to pump data into the signal meter
-		scalar_condition<bool> started{ false };
-		m_worker = std::thread(&channelsettings::worker, this, std::ref(started));
-		started.wait_until_equals(true);
+		// Create the device hub and attach the signal meter and the multiplex scanner as independent
+		// consumers of the sample stream, a slow multiplex scanner will not stall the signal meter
+		m_devicehub = devicehub::create(*m_device);
+		m_devicehub->add_consumer([&](uint8_t const* buffer, size_t count) -> void { m_signalmeter->inputsamples(buffer, count); });
+		if(m_muxscanner) m_devicehub->add_consumer([&](uint8_t const* buffer, size_t count) -> void { m_muxscanner->inputsamples(buffer, count); });
+		m_devicehub->start();
 	}
 
 	catch(...) { return false; }
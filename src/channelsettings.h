@@ -41,6 +41,7 @@
 #include <thread>
 #include <utility>
 
+#include "devicehub.h"
 #include "muxscanner.h"
 #include "props.h"
 #include "renderingcontrol.h"
@@ -131,8 +132,8 @@ private:
 
 		// Member Functions
 		//
+		GLint	aColor(void) const;
 		GLint	aPosition(void) const;
-		GLint	uColor() const;
 		GLint	uModelProjMatrix(void) const;
 
 	private:
@@ -146,11 +147,46 @@ private:
 		void OnDisabled(void) override;
 		bool OnEnabled(void) override;
 
+		GLint		m_aColor = -1;				// Attribute location
 		GLint		m_aPosition = -1;			// Attribute location
-		GLint		m_uColor = -1;				// Attribute location
 		GLint		m_uModelProjMatrix = -1;	// Uniform location
 	};
 
+	// Class waterfallshader
+	//
+	// Implements the shader for the FFT rendering control waterfall
+	class waterfallshader : public kodi::gui::gl::CShaderProgram
+	{
+	public:
+
+		// Constructor
+		//
+		waterfallshader();
+
+		// Member Functions
+		//
+		GLint	aPosition(void) const;
+		GLint	aTexCoord(void) const;
+		GLint	uModelProjMatrix(void) const;
+		GLint	uTexture(void) const;
+
+	private:
+
+		waterfallshader(waterfallshader const&) = delete;
+		waterfallshader& operator=(waterfallshader const&) = delete;
+
+		// CShaderProgram overrides
+		//
+		void OnCompiledAndLinked(void) override;
+		void OnDisabled(void) override;
+		bool OnEnabled(void) override;
+
+		GLint		m_aPosition = -1;			// Attribute location
+		GLint		m_aTexCoord = -1;			// Attribute location
+		GLint		m_uModelProjMatrix = -1;	// Uniform location
+		GLint		m_uTexture = -1;			// Uniform location
+	};
+
 	// Class fftcontrol
 	//
 	// Implements the FFT rendering control
@@ -160,7 +196,7 @@ private:
 
 		// Constructor / Destructor
 		//
-		fftcontrol(kodi::gui::CWindow* window, int controlid);
+		fftcontrol(kodi::gui::CWindow* window, int controlid, bool waterfall);
 		~fftcontrol() override;
 
 		// Member Functions
@@ -174,31 +210,50 @@ private:
 		fftcontrol(fftcontrol const&) = delete;
 		fftcontrol& operator=(fftcontrol const&) = delete;
 
+		// vertex_t
+		//
+		// Defines a single vertex of the batched primitives
+		struct vertex_t {
+
+			glm::vec2			position;		// Vertex position
+			glm::vec4			color;			// Vertex color
+		};
+
+		// texvertex_t
+		//
+		// Defines a single vertex of the waterfall primitives
+		struct texvertex_t {
+
+			glm::vec2			position;		// Vertex position
+			glm::vec2			texcoord;		// Texture coordinate
+		};
+
 		// Private Member Functions
 		//
+		void add_line(glm::vec4 color, glm::vec2 const vertices[2]);
+		void add_line_strip(glm::vec4 color, glm::vec2 const vertices[], size_t numvertices);
+		void add_rect(glm::vec4 color, glm::vec2 const vertices[4]);
+		void add_triangle(glm::vec4 color, glm::vec2 const vertices[3]);
 		GLfloat db_to_height(float db) const;
-		void render_line(glm::vec3 color, glm::vec2 vertices[2]) const;
-		void render_line(glm::vec4 color, glm::vec2 vertices[2]) const;
-		void render_line_strip(glm::vec3 color, glm::vec2 vertices[], size_t numvertices) const;
-		void render_line_strip(glm::vec4 color, glm::vec2 vertices[], size_t numvertices) const;
-		void render_rect(glm::vec3 color, glm::vec2 vertices[4]) const;
-		void render_rect(glm::vec4 color, glm::vec2 vertices[4]) const;
-		void render_triangle(glm::vec3 color, glm::vec2 vertices[3]) const;
-		void render_triangle(glm::vec4 color, glm::vec2 vertices[3]) const;
+		void render_waterfall(void);
 
 		// renderingcontrol overrides
 		//
 		bool dirty(void) override;
 		void render(void) override;
 
+		size_t					m_plotheight;			// Height of the FFT plot
 		GLfloat					m_widthf;				// Width as GLfloat
-		GLfloat					m_heightf;				// Height as GLfloat
+		GLfloat					m_heightf;				// FFT plot height as GLfloat
 		GLfloat					m_linewidthf = 1.25f;	// Line width factor
 		GLfloat					m_lineheightf = 1.25f;	// Line height factor
 
 		fftshader				m_shader;				// Shader instance
 		GLuint					m_vertexVBO;			// Vertex buffer object
+		size_t					m_vertexVBOsize = 0;	// Vertex buffer object capacity
+		std::vector<vertex_t>	m_vertices;				// Batched primitive vertices
 		glm::mat4				m_modelProjMat;			// Model/Projection matrix
+		std::mutex				m_lock;					// Synchronization object
 
 		bool					m_dirty = false;		// Dirty flag
 		GLfloat					m_power = 0.0f;			// Power level
@@ -210,6 +265,15 @@ private:
 		std::unique_ptr<glm::vec2[]>	m_fft;			// FFT vertices
 		int								m_fftlowcut;	// FFT low cut index
 		int								m_ffthighcut;	// FFT high cut index
+
+		std::unique_ptr<waterfallshader>	m_waterfallshader;		// Waterfall shader instance
+		GLuint								m_waterfallVBO = 0;		// Waterfall vertex buffer object
+		GLuint								m_waterfalltexture = 0;	// Waterfall texture
+		size_t								m_waterfallrows = 0;	// Number of waterfall rows
+		std::vector<uint8_t>				m_waterfallimage;		// Waterfall image (RGBA rows)
+		std::vector<uint8_t>				m_waterfallpalette;		// Waterfall palette (RGBA)
+		size_t								m_waterfallhead = 0;	// Next waterfall row to write
+		size_t								m_waterfallpending = 0;	// Waterfall rows to upload
 	};
 
 	//-------------------------------------------------------------------------
@@ -267,16 +331,12 @@ private:
 	//
 	// Updates the state of the gain control
 	void update_gain(void);
-
-	// worker
-	//
-	// Worker thread procedure used to pump data into the signal meter
-	void worker(scalar_condition<bool>& started);
 		
 	//-------------------------------------------------------------------------
 	// Member Variables
 
 	std::unique_ptr<rtldevice>			m_device;				// Device instance
+	std::unique_ptr<devicehub>			m_devicehub;			// Device sample hub
 	struct tunerprops					m_tunerprops = {};		// Tuner properties
 	struct channelprops					m_channelprops = {};	// Channel properties
 	struct signalprops					m_signalprops = {};		// Signal properties
@@ -287,11 +347,6 @@ private:
 	std::unique_ptr<muxscanner>			m_muxscanner;			// Multiplex scanner instance
 	std::vector<int>					m_manualgains;			// Manual gain values
 	bool								m_result = false;		// Dialog result
-
-	std::thread							m_worker;				// Worker thread
-	std::exception_ptr					m_worker_exception;		// Exception on worker thread
-	scalar_condition<bool>				m_stop{ false };		// Condition to stop data transfer
-	std::atomic<bool>					m_stopped{ false };		// Data transfer stopped flag
 	
 	// CONTROLS
 	//
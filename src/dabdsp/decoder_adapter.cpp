@@ -34,8 +34,13 @@ DecoderAdapter::DecoderAdapter(ProgrammeHandlerInterface &mr, int16_t bitRate, A
 {
     if (dabModus == AudioServiceComponentType::DAB)
         decoder = std::make_unique<MP2Decoder>(this, false);
-    else if (dabModus == AudioServiceComponentType::DABPlus)
-        decoder = std::make_unique<SuperframeFilter>(this, true, false);
+    else if (dabModus == AudioServiceComponentType::DABPlus) {
+        // The encoded access units can be forwarded instead of decoded
+        bool encoded = myInterface.isEncodedAudioRequested();
+        decoder = std::make_unique<SuperframeFilter>(this, !encoded, false);
+        if (encoded)
+            decoder->AddUntouchedStreamConsumer(this);
+    }
     else
         throw std::runtime_error("DecoderAdapter: Unknown service component");
 
@@ -79,6 +84,7 @@ void DecoderAdapter::addtoFrame(uint8_t *v)
 void DecoderAdapter::FormatChange(const AUDIO_SERVICE_FORMAT& format)
 {
     audioFormat = format.GetSummary();
+    encodedSamplerate = static_cast<int>(format.samplerate_khz * 1000);
 }
 
 void DecoderAdapter::StartAudio(int samplerate, int channels, bool float32)
@@ -119,6 +125,15 @@ void DecoderAdapter::PutAudio(const uint8_t *data, size_t len)
         audioFormat);
 }
 
+void DecoderAdapter::ProcessUntouchedStream(const uint8_t *data, size_t len, size_t duration_ms)
+{
+    myInterface.onNewEncodedAudio(
+        std::vector<uint8_t>(data, data + len),
+        encodedSamplerate,
+        static_cast<int>(duration_ms),
+        audioFormat);
+}
+
 void DecoderAdapter::ProcessPAD(const uint8_t *xpad_data, size_t xpad_len, bool exact_xpad_len, const uint8_t *fpad_data)
 {
     padDecoder.Process(xpad_data, xpad_len, exact_xpad_len, fpad_data);
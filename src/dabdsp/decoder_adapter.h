@@ -38,7 +38,7 @@
 #include "dab_decoder.h"
 #include "dabplus_decoder.h"
 
-class DecoderAdapter: public DabProcessor, public SubchannelSinkObserver, public PADDecoderObserver
+class DecoderAdapter: public DabProcessor, public SubchannelSinkObserver, public PADDecoderObserver, public UntouchedStreamConsumer
 {
     public:
         DecoderAdapter(ProgrammeHandlerInterface& mr,
@@ -57,6 +57,9 @@ class DecoderAdapter: public DabProcessor, public SubchannelSinkObserver, public
         virtual void ACCFrameError(const unsigned char /* error*/);
         virtual void FECInfo(int /*total_corr_count*/, bool /*uncorr_errors*/);
 
+        // UntouchedStreamConsumer impl
+        virtual void ProcessUntouchedStream(const uint8_t* /*data*/, size_t /*len*/, size_t /*duration_ms*/);
+
         // PADDecoderObserver impl
         virtual void PADChangeDynamicLabel(const DL_STATE& dl);
         virtual void PADChangeSlide(const MOT_FILE& slide);
@@ -73,6 +76,7 @@ class DecoderAdapter: public DabProcessor, public SubchannelSinkObserver, public
         std::unique_ptr<FILE, FILEDeleter> dumpFile;
 
         int audioSamplerate = 0;
+        int encodedSamplerate = 0;
         int audioChannels = 0;
         std::string audioFormat;
 };
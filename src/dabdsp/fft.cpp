@@ -25,6 +25,10 @@
  *    along with SDR-J; if not, write to the Free Software
  *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  */
+// The plan cache must be included before fft.h, which includes fftw3.h inside namespace fft
+#ifndef KISSFFT
+#include    "../fftwcache.h"
+#endif
 #include    "fft.h"
 #include    <cstring>
 
@@ -35,15 +39,15 @@ Forward::Forward(int32_t fft_size)
 {
     vector = (DSPCOMPLEX *)FFTW_MALLOC(sizeof (DSPCOMPLEX) * fft_size);
     memset((void*)vector, 0, sizeof(DSPCOMPLEX) * fft_size);
-    plan  = FFTW_PLAN_DFT_1D(fft_size,
+    // Plans are shared process-wide and owned by the cache
+    plan  = fftwcache::get_plan(fft_size,
             reinterpret_cast<fftwf_complex*>(vector),
             reinterpret_cast<fftwf_complex*>(vector),
-            FFTW_FORWARD, FFTW_ESTIMATE);
+            FFTW_FORWARD);
 }
 
 Forward::~Forward()
 {
-    FFTW_DESTROY_PLAN(plan);
     FFTW_FREE(vector);
 }
 
@@ -54,7 +58,9 @@ DSPCOMPLEX* Forward::getVector()
 
 void Forward::do_FFT()
 {
-    FFTW_EXECUTE (plan);
+    fftwf_execute_dft(plan,
+            reinterpret_cast<fftwf_complex*>(vector),
+            reinterpret_cast<fftwf_complex*>(vector));
 }
 
 Backward::Backward(int32_t fft_size) :
@@ -64,15 +70,15 @@ Backward::Backward(int32_t fft_size) :
     for (int i = 0; i < fft_size; i ++) {
         vector [i] = 0;
     }
-    plan  = FFTW_PLAN_DFT_1D(fft_size,
+    // Plans are shared process-wide and owned by the cache
+    plan  = fftwcache::get_plan(fft_size,
             reinterpret_cast<fftwf_complex*>(vector),
             reinterpret_cast<fftwf_complex*>(vector),
-            FFTW_BACKWARD, FFTW_ESTIMATE);
+            FFTW_BACKWARD);
 }
 
 Backward::~Backward ()
 {
-    FFTW_DESTROY_PLAN(plan);
     FFTW_FREE(vector);
 }
 
@@ -83,7 +89,9 @@ DSPCOMPLEX* Backward::getVector()
 
 void Backward::do_IFFT()
 {
-    FFTW_EXECUTE(plan);
+    fftwf_execute_dft(plan,
+            reinterpret_cast<fftwf_complex*>(vector),
+            reinterpret_cast<fftwf_complex*>(vector));
 
     const DSPFLOAT factor = 1.0 / DSPFLOAT(fft_size);
 
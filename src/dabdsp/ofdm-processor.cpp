@@ -44,6 +44,7 @@
 //
 #define SEARCH_RANGE        (2 * 36)
 #define CORRELATION_LENGTH  24
+#define WARM_START_ATTEMPTS 10      // MB: Failed sync attempts before a warm start is abandoned
 
 /**
   * \brief OFDMProcessor
@@ -70,7 +71,6 @@ OFDMProcessor::OFDMProcessor(
     input(inputInterface),
     params(params),
     ficHandler(fic),
-    tiiDecoder(params, ri),
     T_null(params.T_null),
     T_u(params.T_u),
     T_s(params.T_s),
@@ -128,8 +128,13 @@ void OFDMProcessor::restart()
         threadHandle.join();
     }
 
-    coarseCorrector    = 0;
-    fineCorrector      = 0;
+    // MB: Apply the initial corrector values from the receiver options
+    std::unique_lock<std::mutex> lock(receiver_options_mutex);
+    coarseCorrector    = receiver_options.initialCoarseCorrector;
+    fineCorrector      = static_cast<int16_t>(receiver_options.initialFineCorrector);
+    lock.unlock();
+    warmStart          = ((coarseCorrector != 0) || (fineCorrector != 0));
+    warmStartAttempts  = 0;
     syncBufferIndex    = 0;
     sLevel             = 0;
     localPhase         = 0;
@@ -262,6 +267,13 @@ void OFDMProcessor::run()
         }
 notSynced:
         PROFILE(NotSynced);
+        // MB: If the receiver was warm started with known-good corrector values and
+        // still cannot synchronize, assume they are stale and revert to a cold start
+        if (warmStart && ++warmStartAttempts > WARM_START_ATTEMPTS) {
+            coarseCorrector = 0;
+            fineCorrector = 0;
+            warmStart = false;
+        }
         if (scanMode && ++attempts > 5) {
             radioInterface.onSignalPresence(false);
             scanMode  = false;
@@ -376,6 +388,7 @@ SyncOnPhase:
          * We read the missing samples in the ofdm buffer
          */
         radioInterface.onSyncChange(true);
+        warmStart = false;
         getSamples(&ofdmBuffer[ofdmBufferIndex],
                 T_u - ofdmBufferIndex,
                 coarseCorrector + fineCorrector);
@@ -469,7 +482,10 @@ SyncOnPhase:
         std::vector<DSPCOMPLEX> nullSymbol(T_null);
         getSamples(nullSymbol.data(), T_null, coarseCorrector + fineCorrector);
         if (rro.decodeTII) {
-            tiiDecoder.pushSymbols(nullSymbol, prs);
+            if (not tiiDecoder) {
+                tiiDecoder.reset(new TIIDecoder(params, radioInterface));
+            }
+            tiiDecoder->pushSymbols(nullSymbol, prs);
         }
 
         PROFILE(OnNewNull);
@@ -36,6 +36,7 @@
 #include "dab-constants.h"
 #include <thread>
 #include <atomic>
+#include <memory>
 #include <mutex>
 #include <vector>
 #include "phasereference.h"
@@ -78,7 +79,8 @@ class OFDMProcessor
         const DABParams& params;
         FicHandler& ficHandler;
         std::vector<float> impulseResponseBuffer;
-        TIIDecoder tiiDecoder;
+        // Only created once TII decoding has been requested via the receiver options
+        std::unique_ptr<TIIDecoder> tiiDecoder;
 
         std::atomic<bool> running = ATOMIC_VAR_INIT(false);
 
@@ -99,6 +101,8 @@ class OFDMProcessor
         int32_t lastValidCoarseCorrector = 0;
         int16_t fineCorrector = 0;
         int32_t coarseCorrector = 0;
+        bool warmStart = false;
+        int warmStartAttempts = 0;
 
         uint32_t ofdmBufferIndex = 0;
         PhaseReference phaseRef;
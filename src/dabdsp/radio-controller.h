@@ -151,6 +151,17 @@ class ProgrammeHandlerInterface {
          * used.  */
 		virtual void onNewAudio(std::vector<int16_t>&& audioData, int sampleRate, const std::string& mode) {}
 
+        /* (DAB+ only) Return true to receive the encoded audio access
+         * units through onNewEncodedAudio instead of decoded audio
+         * through onNewAudio. Queried when the programme is started. */
+		virtual bool isEncodedAudioRequested(void) { return false; }
+
+        /* (DAB+ only) A new encoded audio access unit is available.
+         * audioData is a LOAS/LATM frame that carries the AAC
+         * AudioSpecificConfig in-band; sampleRate is the output
+         * sample rate and durationMs the length of the access unit. */
+		virtual void onNewEncodedAudio(std::vector<uint8_t>&& audioData, int sampleRate, int durationMs, const std::string& mode) {}
+
         /* (DAB+ only) Reed-Solomon decoding error indicator, and
          * number of corrected errors.
          * The function will also be called in the absence of errors,
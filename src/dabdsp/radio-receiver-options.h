@@ -81,5 +81,11 @@ struct RadioReceiverOptions {
     // Which method to use for the freqsyncmethod used in the coarse corrector.
     // Has no effect when coarse corrector is disabled.
     FreqsyncMethod freqsyncMethod = FreqsyncMethod::PatternOfZeros;
+
+    // MB: Initial values for the fine and coarse frequency correctors. A previously
+    // known-good acquisition can be supplied here to accelerate lock; if the
+    // receiver cannot synchronize with these values it will revert to zero.
+    int initialFineCorrector = 0;
+    int initialCoarseCorrector = 0;
 };
 
@@ -109,6 +109,27 @@ bool operator==(const CombPattern& lhs, const CombPattern& rhs)
     return lhs.comb == rhs.comb and lhs.pattern == rhs.pattern;
 }
 
+// The comb/pattern lookup only depends on the TII pattern table, so it is built once per
+// process and shared by every decoder. Only carriers k = 1 + 2*comb + 48*b can ever match.
+static const cp_per_carrier_t& comb_patterns_per_carrier()
+{
+    static const cp_per_carrier_t table = []() -> cp_per_carrier_t {
+        cp_per_carrier_t cp_per_carrier;
+        for (int c = 0; c < 24; c++) {
+            for (int p = 0; p < 70; p++) {
+                for (int b = 0; b < 8; b++) {
+                    if (tii_pattern[p][b]) {
+                        cp_per_carrier[1 + 2*c + 48*b].emplace(c, p);
+                    }
+                }
+            }
+        }
+        return cp_per_carrier;
+    }();
+
+    return table;
+}
+
 std::vector<carrier_t> CombPattern::generateCarriers() const
 {
     std::vector<carrier_t> carriers;
@@ -143,6 +164,7 @@ float tii_measurement_t::getDelayKm(void) const
 TIIDecoder::TIIDecoder(const DABParams& params, RadioControllerInterface& ri) :
     m_radioInterface(ri),
     m_params(params),
+    m_cp_per_carrier(comb_patterns_per_carrier()),
     m_fft_null(params.T_u),
     m_fft_prs(params.T_u)
 {
@@ -151,18 +173,6 @@ TIIDecoder::TIIDecoder(const DABParams& params, RadioControllerInterface& ri) :
         return;
     }
 
-    for (int c = 0; c < 24; c++) {
-        for (int p = 0; p < 70; p++) {
-            for (carrier_t k = 0; k < 384; k++) {
-                for (int b = 0; b < 8; b++) {
-                    if (k == 1 + 2*c + 48*b and tii_pattern[p][b]) {
-                        m_cp_per_carrier[k].emplace(c, p);
-                    }
-                }
-            }
-        }
-    }
-
     m_thread = thread(&TIIDecoder::run, this);
 }
 
@@ -293,9 +303,10 @@ void TIIDecoder::run()
 
         unordered_map<CombPattern, int> cp_count;
         for (const carrier_t k : carriers) {
-            if (m_cp_per_carrier.count(k)) {
-                for (const auto& cps : m_cp_per_carrier[k]) {
-                    cp_count[cps]++;
+            const auto cps = m_cp_per_carrier.find(k);
+            if (cps != m_cp_per_carrier.end()) {
+                for (const auto& cp : cps->second) {
+                    cp_count[cp]++;
                 }
             }
         }
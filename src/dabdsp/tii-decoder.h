@@ -61,6 +61,9 @@ namespace std {
     };
 }
 
+using cp_per_carrier_t =
+    std::unordered_map<carrier_t, std::unordered_set<CombPattern> >;
+
 class TIIDecoder {
     public:
         TIIDecoder(const DABParams& params, RadioControllerInterface& ri);
@@ -82,8 +85,8 @@ class TIIDecoder {
         std::vector<complexf> m_null;
         std::vector<complexf> m_prs;
 
-        std::unordered_map<carrier_t, std::unordered_set<CombPattern> >
-            m_cp_per_carrier;
+        // Shared by all instances, see comb_patterns_per_carrier()
+        const cp_per_carrier_t& m_cp_per_carrier;
 
         enum class State { Idle, NullPrsReady, Abort };
 
@@ -0,0 +1,271 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2020-2022 Michael G. Brehm
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#include "stdafx.h"
+#include "dabprobe.h"
+
+#include <algorithm>
+#include <assert.h>
+#include <cmath>
+
+#include "dabdsp/phasetable.h"
+
+#include "fftwcache.h"
+#include "string_exception.h"
+
+#pragma warning(push, 4)
+
+// dabprobe::MAX_CARRIER_OFFSET (static)
+//
+// Maximum number of carriers to search either side of the expected position
+int const dabprobe::MAX_CARRIER_OFFSET = 16;
+
+// dabprobe::NULL_THRESHOLD (static)
+//
+// Minimum depth of the null symbol relative to the mean power (dB)
+float const dabprobe::NULL_THRESHOLD = 6.0f;
+
+// dabprobe::PRS_THRESHOLD (static)
+//
+// Minimum ratio of the phase reference correlation peak to the mean
+float const dabprobe::PRS_THRESHOLD = 6.0f;
+
+//---------------------------------------------------------------------------
+// dabprobe Constructor (private)
+//
+// Arguments:
+//
+//	samplerate		- Sample rate of the input data
+
+dabprobe::dabprobe(uint32_t samplerate) : m_params(1), m_fftin(nullptr), m_fftout(nullptr), m_forward(nullptr), m_backward(nullptr)
+{
+	// Only transmission mode I at the native DAB sample rate is supported
+	if(samplerate != (2048 KHz)) throw std::invalid_argument("samplerate");
+
+	size_t const fftsize = static_cast<size_t>(m_params.T_u);
+
+	// Generate the phase reference symbol carriers; carrier zero is not used and the
+	// negative carriers map onto the upper half of the FFT bins
+	PhaseTable phasetable(m_params.dabMode);
+	m_reference.resize(fftsize);
+	for(int carrier = 1; carrier <= (m_params.K / 2); carrier++) {
+
+		DSPFLOAT phi = phasetable.get_Phi(carrier);
+		m_reference[carrier] = DSPCOMPLEX(std::cos(phi), std::sin(phi));
+
+		phi = phasetable.get_Phi(-carrier);
+		m_reference[fftsize - carrier] = DSPCOMPLEX(std::cos(phi), std::sin(phi));
+	}
+
+	// Allocate the FFT buffers and create the forward and backward plans
+	m_fftin = reinterpret_cast<fftwf_complex*>(fftwf_malloc(sizeof(fftwf_complex) * fftsize));
+	m_fftout = reinterpret_cast<fftwf_complex*>(fftwf_malloc(sizeof(fftwf_complex) * fftsize));
+	if((m_fftin == nullptr) || (m_fftout == nullptr)) {
+
+		if(m_fftin) fftwf_free(m_fftin);
+		if(m_fftout) fftwf_free(m_fftout);
+		throw string_exception(__func__, ": unable to allocate FFT buffers");
+	}
+
+	try {
+
+		m_forward = fftwcache::get_plan(static_cast<int>(fftsize), m_fftin, m_fftout, FFTW_FORWARD);
+		m_backward = fftwcache::get_plan(static_cast<int>(fftsize), m_fftin, m_fftout, FFTW_BACKWARD);
+	}
+
+	catch(...) { fftwf_free(m_fftin); fftwf_free(m_fftout); throw; }
+}
+
+//---------------------------------------------------------------------------
+// dabprobe Destructor
+
+dabprobe::~dabprobe()
+{
+	if(m_fftin) fftwf_free(m_fftin);
+	if(m_fftout) fftwf_free(m_fftout);
+}
+
+//---------------------------------------------------------------------------
+// dabprobe::capturelength
+//
+// Gets the length of the capture required to detect an ensemble, in bytes
+//
+// Arguments:
+//
+//	NONE
+
+size_t dabprobe::capturelength(void) const
+{
+	// One full transmission frame guarantees a complete null symbol somewhere in the
+	// capture, the phase reference symbol that follows it must also be present
+	return static_cast<size_t>(m_params.T_F + m_params.T_null + m_params.T_s) * 2;
+}
+
+//---------------------------------------------------------------------------
+// dabprobe::correlate_prs (private)
+//
+// Correlates a symbol against the phase reference symbol
+//
+// Arguments:
+//
+//	samples		- Converted input samples
+//	offset		- Offset of the symbol within the input samples
+
+float dabprobe::correlate_prs(std::vector<DSPCOMPLEX> const& samples, size_t offset)
+{
+	size_t const fftsize = static_cast<size_t>(m_params.T_u);
+	assert(offset + fftsize <= samples.size());
+
+	// Transform the symbol into the frequency domain; any window that starts inside the
+	// cyclic prefix is a circular shift of the symbol, which the correlation tolerates
+	for(size_t index = 0; index < fftsize; index++) {
+
+		m_fftin[index][0] = samples[offset + index].real();
+		m_fftin[index][1] = samples[offset + index].imag();
+	}
+
+	fftwf_execute_dft(m_forward, m_fftin, m_fftout);
+	std::vector<DSPCOMPLEX> spectrum(fftsize);
+	for(size_t index = 0; index < fftsize; index++) spectrum[index] = DSPCOMPLEX(m_fftout[index][0], m_fftout[index][1]);
+
+	// The tuner may be off frequency by a few carriers, so the correlation is repeated
+	// with the reference shifted across the expected frequency error
+	float best = 0.0f;
+	for(int shift = -MAX_CARRIER_OFFSET; shift <= MAX_CARRIER_OFFSET; shift++) {
+
+		for(size_t index = 0; index < fftsize; index++) {
+
+			size_t const bin = (index + fftsize + shift) % fftsize;
+			DSPCOMPLEX const product = spectrum[bin] * std::conj(m_reference[index]);
+			m_fftin[index][0] = product.real();
+			m_fftin[index][1] = product.imag();
+		}
+
+		fftwf_execute_dft(m_backward, m_fftin, m_fftout);
+
+		// A phase reference symbol produces a sharp impulse; noise does not
+		float peak = 0.0f, sum = 0.0f;
+		for(size_t index = 0; index < fftsize; index++) {
+
+			float const magnitude = std::hypot(m_fftout[index][0], m_fftout[index][1]);
+			peak = std::max(peak, magnitude);
+			sum += magnitude;
+		}
+
+		if(sum > 0.0f) best = std::max(best, peak / (sum / fftsize));
+	}
+
+	return best;
+}
+
+//---------------------------------------------------------------------------
+// dabprobe::create (static)
+//
+// Factory method, creates a new dabprobe instance
+//
+// Arguments:
+//
+//	samplerate		- Sample rate of the input data
+
+std::unique_ptr<dabprobe> dabprobe::create(uint32_t samplerate)
+{
+	return std::unique_ptr<dabprobe>(new dabprobe(samplerate));
+}
+
+//---------------------------------------------------------------------------
+// dabprobe::detect
+//
+// Determines if a capture contains a DAB ensemble
+//
+// Arguments:
+//
+//	samples		- Pointer to the input samples
+//	length		- Length of the input samples, in bytes
+
+bool dabprobe::detect(uint8_t const* samples, size_t length)
+{
+	assert(samples != nullptr);
+
+	if(length < capturelength()) throw std::invalid_argument("length");
+
+	// Convert the I/Q samples into complex values centered on zero
+	size_t const count = length / 2;
+	m_samples.resize(count);
+	for(size_t index = 0; index < count; index++)
+		m_samples[index] = DSPCOMPLEX((samples[index * 2] - 127.5f) / 127.5f, (samples[(index * 2) + 1] - 127.5f) / 127.5f);
+
+	// An ensemble has a deep null symbol at the start of every transmission frame; this
+	// rejects empty channels and most other signals without any further work
+	size_t nulloffset = 0;
+	if(find_null(m_samples, nulloffset) < NULL_THRESHOLD) return false;
+
+	// Confirm the ensemble by correlating the phase reference symbol that follows the null,
+	// starting in the middle of the cyclic prefix to tolerate an imprecise null position
+	size_t const prsoffset = nulloffset + m_params.T_null + (m_params.guardLength / 2);
+	return correlate_prs(m_samples, prsoffset) >= PRS_THRESHOLD;
+}
+
+//---------------------------------------------------------------------------
+// dabprobe::find_null (private)
+//
+// Locates the null symbol within a capture
+//
+// Arguments:
+//
+//	samples		- Converted input samples
+//	offset		- Receives the offset of the null symbol
+
+float dabprobe::find_null(std::vector<DSPCOMPLEX> const& samples, size_t& offset) const
+{
+	size_t const window = static_cast<size_t>(m_params.T_null);
+	size_t const prslength = static_cast<size_t>(m_params.T_s);
+	assert(samples.size() >= window + prslength);
+
+	// The null symbol must be followed by a complete phase reference symbol
+	size_t const last = samples.size() - window - prslength;
+
+	double total = 0.0;
+	for(auto const& sample : samples) total += std::norm(sample);
+	if(total <= 0.0) return 0.0f;
+
+	// Slide a window the length of the null symbol across the capture and find
+	// the position with the least energy
+	double energy = 0.0;
+	for(size_t index = 0; index < window; index++) energy += std::norm(samples[index]);
+
+	double minenergy = energy;
+	offset = 0;
+	for(size_t index = 1; index <= last; index++) {
+
+		energy += std::norm(samples[index + window - 1]) - std::norm(samples[index - 1]);
+		if(energy < minenergy) { minenergy = energy; offset = index; }
+	}
+
+	// Report the depth of the null relative to the mean power of the capture
+	double const mean = total / samples.size();
+	double const nullpower = std::max(minenergy / window, mean * 1.0e-6);
+	return static_cast<float>(10.0 * std::log10(mean / nullpower));
+}
+
+//---------------------------------------------------------------------------
+
+#pragma warning(pop)
@@ -0,0 +1,123 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2020-2022 Michael G. Brehm
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#ifndef __DABPROBE_H_
+#define __DABPROBE_H_
+#pragma once
+
+#include <fftw3.h>
+#include <memory>
+#include <vector>
+
+#include "dabdsp/dab-constants.h"
+
+#pragma warning(push, 4)
+
+//---------------------------------------------------------------------------
+// Class dabprobe
+//
+// Implements a lightweight DAB ensemble presence detector; a short capture is
+// searched for the transmission frame null symbol and the phase reference
+// symbol that follows it is correlated against the known reference, which is
+// enough to tell a real ensemble apart from an empty channel without starting
+// a full receiver
+
+class dabprobe
+{
+public:
+
+	// Destructor
+	//
+	~dabprobe();
+
+	//-----------------------------------------------------------------------
+	// Member Functions
+
+	// capturelength
+	//
+	// Gets the length of the capture required to detect an ensemble, in bytes
+	size_t capturelength(void) const;
+
+	// create (static)
+	//
+	// Factory method, creates a new dabprobe instance
+	static std::unique_ptr<dabprobe> create(uint32_t samplerate);
+
+	// detect
+	//
+	// Determines if a capture contains a DAB ensemble
+	bool detect(uint8_t const* samples, size_t length);
+
+private:
+
+	dabprobe(dabprobe const&) = delete;
+	dabprobe& operator=(dabprobe const&) = delete;
+
+	// MAX_CARRIER_OFFSET
+	//
+	// Maximum number of carriers to search either side of the expected position
+	static int const MAX_CARRIER_OFFSET;
+
+	// NULL_THRESHOLD
+	//
+	// Minimum depth of the null symbol relative to the mean power (dB)
+	static float const NULL_THRESHOLD;
+
+	// PRS_THRESHOLD
+	//
+	// Minimum ratio of the phase reference correlation peak to the mean
+	static float const PRS_THRESHOLD;
+
+	// Instance Constructor
+	//
+	dabprobe(uint32_t samplerate);
+
+	//-----------------------------------------------------------------------
+	// Private Member Functions
+
+	// correlate_prs
+	//
+	// Correlates a symbol against the phase reference symbol
+	float correlate_prs(std::vector<DSPCOMPLEX> const& samples, size_t offset);
+
+	// find_null
+	//
+	// Locates the null symbol within a capture
+	float find_null(std::vector<DSPCOMPLEX> const& samples, size_t& offset) const;
+
+	//-----------------------------------------------------------------------
+	// Member Variables
+
+	DABParams const					m_params;		// DAB transmission mode parameters
+	std::vector<DSPCOMPLEX>			m_reference;	// Phase reference symbol carriers
+	std::vector<DSPCOMPLEX>			m_samples;		// Converted input samples
+	fftwf_complex*					m_fftin;		// FFT input buffer
+	fftwf_complex*					m_fftout;		// FFT output buffer
+	fftwf_plan						m_forward;		// Forward FFT plan
+	fftwf_plan						m_backward;		// Backward FFT plan
+};
+
+//-----------------------------------------------------------------------------
+
+#pragma warning(pop)
+
+#endif	// __DABPROBE_H_
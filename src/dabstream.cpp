@@ -23,6 +23,8 @@
 #include "stdafx.h"
 #include "dabstream.h"
 
+#include <algorithm>
+
 #include "string_exception.h"
 
 #pragma warning(push, 4)
@@ -70,8 +72,8 @@ int const dabstream::STREAM_ID_ID3TAG = 0;
 
 dabstream::dabstream(std::unique_ptr<rtldevice> device, struct tunerprops const& tunerprops,
 	struct channelprops const& channelprops, struct dabprops const& dabprops, uint32_t subchannel) : 
-	m_device(std::move(device)), m_ringbuffer(RING_BUFFER_SIZE), m_subchannel((subchannel > 0) ? subchannel : 1), 
-	m_pcmgain(powf(10.0f, dabprops.outputgain / 10.0f))
+	m_device(std::move(device)), m_ringbuffer(RING_BUFFER_SIZE), m_frequency(channelprops.frequency), m_subchannel((subchannel > 0) ? subchannel : 1), 
+	m_pcmgain(powf(10.0f, dabprops.outputgain / 10.0f)), m_passthrough(dabprops.passthrough), m_warmstart(channelprops.acquisition.valid)
 {
 	// Initialize the RTL-SDR device instance
 	m_device->set_frequency_correction(tunerprops.freqcorrection + channelprops.freqcorrection);
@@ -87,12 +89,21 @@ dabstream::dabstream(std::unique_ptr<rtldevice> device, struct tunerprops const&
 	InputInterface& inputinterface = *static_cast<InputInterface*>(this);
 	RadioReceiverOptions options = {};
 	options.disableCoarseCorrector = true;
+
+	// Warm start the frequency correctors with the last known-good acquisition state; if
+	// synchronization cannot be achieved with these values the receiver will discard them
+	if(m_warmstart) {
+
+		options.initialFineCorrector = channelprops.acquisition.dabfinecorrector;
+		options.initialCoarseCorrector = channelprops.acquisition.dabcoarsecorrector;
+	}
+
 	m_receiver = make_aligned<RadioReceiver>(controllerinterface, inputinterface, options, 1);
 
-	// Create the worker thread
-	scalar_condition<bool> started{ false };
-	m_worker = std::thread(&dabstream::worker, this, std::ref(started));
-	started.wait_until_equals(true);
+	// Begin streaming from the device via the receiver on the calling thread so that any failure
+	// is reported to the caller, then hand the device off to a worker thread for the transfer
+	m_receiver->restart(false);
+	m_worker = std::thread(&dabstream::worker, this);
 }
 
 //---------------------------------------------------------------------------
@@ -103,6 +114,46 @@ dabstream::~dabstream()
 	close();
 }
 
+//---------------------------------------------------------------------------
+// dabstream::acquisition
+//
+// Gets the signal acquisition state to be cached for the channel
+//
+// Arguments:
+//
+//	acquisitionprops	- Structure to receive the acquisition state
+
+bool dabstream::acquisition(struct acquisitionprops& acquisitionprops) const
+{
+	acquisitionprops = {};
+
+	// If sync was acquired, the last reported frequency correctors are known-good
+	if(m_synced.load()) {
+
+		acquisitionprops.valid = true;
+		acquisitionprops.dabfinecorrector = m_finecorrector.load();
+		acquisitionprops.dabcoarsecorrector = m_coarsecorrector.load();
+		return true;
+	}
+
+	// If a warm start was applied but sync never occurred, invalidate the cached state
+	return m_warmstart.load();
+}
+
+//---------------------------------------------------------------------------
+// dabstream::canpause
+//
+// Flag indicating if the stream can be paused
+//
+// Arguments:
+//
+//	NONE
+
+bool dabstream::canpause(void) const
+{
+	return false;
+}
+
 //---------------------------------------------------------------------------
 // dabstream::canseek
 //
@@ -194,6 +245,31 @@ void dabstream::demuxflush(void)
 
 DEMUX_PACKET* dabstream::demuxread(std::function<DEMUX_PACKET* (int)> const& allocator)
 {
+	// The receiver reports the signal metrics from its own threads, collect them into a snapshot
+	// from here so the addon never has to query the receiver while a read is in progress
+	publish_status([&](struct signalstatus& status) -> void {
+
+		// For signal quality, use the proportion of Fast Information Blocks that passed
+		// their CRC check since the last snapshot; nothing is received without sync
+		long fibs = m_fibs.load(), fiberrors = m_fiberrors.load();
+		long intervalfibs = fibs - m_statusfibs, intervalerrors = fiberrors - m_statusfiberrors;
+		m_statusfibs = fibs;
+		m_statusfiberrors = fiberrors;
+
+		if(m_sync.load() && (intervalfibs > 0)) status.quality = static_cast<int>(((intervalfibs - intervalerrors) * 100) / intervalfibs);
+
+		// For signal-to-noise ratio, use a linear scale from 0dB to 20dB
+		float snr = std::max(std::min(20.0f, m_snr.load()), 0.0f);
+		status.snr = static_cast<int>((snr * 100.0f) / 20.0f);
+
+		status.unc = m_uncorrected.load();
+		status.devicename = m_device->get_device_name();
+		status.servicename = "Digital Audio Broadcasting (DAB)";
+
+		std::unique_lock<std::mutex> lock(m_ensemblelabellock);
+		status.muxname = m_ensemblelabel;
+	});
+
 	std::unique_lock<std::mutex> lock(m_queuelock);
 
 	// Wait up to 50ms for there to be a packet available for processing
@@ -245,20 +321,6 @@ void dabstream::demuxreset(void)
 {
 }
 
-//---------------------------------------------------------------------------
-// dabstream::devicename
-//
-// Gets the device name associated with the stream
-//
-// Arguments:
-//
-//	NONE
-
-std::string dabstream::devicename(void) const
-{
-	return std::string(m_device->get_device_name());
-}
-
 //---------------------------------------------------------------------------
 // dabstream::enumproperties
 //
@@ -272,12 +334,16 @@ void dabstream::enumproperties(std::function<void(struct streamprops const& prop
 {
 	// AUDIO STREAM
 	//
+	// DAB+ audio that is passed through encoded is sent as LOAS/LATM, which carries the
+	// AAC configuration in-band and leaves the decoding up to Kodi
+	bool const encoded = m_audioencoded.load();
+
 	streamprops audio = {};
-	audio.codec = "pcm_s16le";
+	audio.codec = (encoded) ? "aac_latm" : "pcm_s16le";
 	audio.pid = m_audioid.load();
 	audio.channels = 2;
 	audio.samplerate = m_audiorate.load();
-	audio.bitspersample = 16;
+	audio.bitspersample = (encoded) ? 0 : 16;
 	callback(audio);
 }
 
@@ -296,17 +362,16 @@ long long dabstream::length(void) const
 }
 
 //---------------------------------------------------------------------------
-// dabstream::muxname
+// dabstream::pause
 //
-// Gets the mux name associated with the stream
+// Pauses or resumes the stream
 //
 // Arguments:
 //
-//	NONE
+//	paused		- Flag to pause or resume the stream
 
-std::string dabstream::muxname(void) const
+void dabstream::pause(bool /*paused*/)
 {
-	return "";
 }
 
 //---------------------------------------------------------------------------
@@ -323,6 +388,24 @@ long long dabstream::position(void) const
 	return -1;
 }
 
+//---------------------------------------------------------------------------
+// dabstream::prewarm (static)
+//
+// Builds the device-independent DAB demodulator state ahead of the first stream
+//
+// Arguments:
+//
+//	NONE
+
+void dabstream::prewarm(void)
+{
+	// Creating and discarding the transmission mode I transforms populates the FFT plan
+	// cache with the measured plans used by the OFDM processor
+	DABParams params(1);
+	fft::Forward forward(params.T_u);
+	fft::Backward backward(params.T_u);
+}
+
 //---------------------------------------------------------------------------
 // dabstream::read
 //
@@ -352,6 +435,74 @@ bool dabstream::realtime(void) const
 	return true;
 }
 
+//---------------------------------------------------------------------------
+// dabstream::retune
+//
+// Retunes the stream to a different channel without recreating it
+//
+// Arguments:
+//
+//	tunerprops		- Tuner device properties
+//	channelprops	- Channel properties
+//	subchannel		- DAB subchannel to decode/stream
+
+bool dabstream::retune(struct tunerprops const& tunerprops, struct channelprops const& channelprops, uint32_t subchannel)
+{
+	// The stream can only be retuned to another channel with the same modulation
+	if(channelprops.modulation != modulation::dab) return false;
+
+	// Adjust the RTL-SDR device instance; the sample rate does not change
+	m_device->set_frequency_correction(tunerprops.freqcorrection + channelprops.freqcorrection);
+	m_device->set_automatic_gain_control(channelprops.autogain);
+	if(channelprops.autogain == false) m_device->set_gain(channelprops.manualgain);
+
+	// A different subchannel in the same ensemble only requires selecting a different
+	// programme, otherwise the receiver needs to be restarted on the worker thread
+	bool const newfrequency = (channelprops.frequency != m_frequency);
+	if(newfrequency) m_device->set_center_frequency(channelprops.frequency);
+	m_frequency = channelprops.frequency;
+
+	m_subchannel.store((subchannel > 0) ? subchannel : 1);
+
+	if(newfrequency) {
+
+		m_warmstart.store(channelprops.acquisition.valid);
+		m_sync.store(false);
+		m_synced.store(false);
+		m_finecorrector.store(0);
+		m_coarsecorrector.store(0);
+		m_snr.store(0);
+
+		std::unique_lock<std::mutex> lock(m_ensemblelabellock);
+		m_ensemblelabel.clear();
+	}
+
+	// Discard any queued packets from the previous channel and push a
+	// DEMUX_SPECIALID_STREAMCHANGE packet into the new queue
+	std::unique_lock<std::mutex> queuelock(m_queuelock);
+	m_queue = demux_queue_t();
+	std::unique_ptr<demux_packet_t> packet = std::make_unique<demux_packet_t>();
+	packet->streamid = DEMUX_SPECIALID_STREAMCHANGE;
+	m_queue.emplace(std::move(packet));
+	m_dts = STREAM_TIME_BASE;
+	m_queuecv.notify_all();
+	queuelock.unlock();
+
+	// Queue the Retune event followed by a ServiceDetected event to locate the new
+	// subchannel in the services that are already known for the ensemble
+	std::unique_lock<std::mutex> eventslock(m_eventslock);
+	if(newfrequency) {
+
+		m_retunerestart = true;
+		m_retunefinecorrector = (channelprops.acquisition.valid) ? channelprops.acquisition.dabfinecorrector : 0;
+		m_retunecoarsecorrector = (channelprops.acquisition.valid) ? channelprops.acquisition.dabcoarsecorrector : 0;
+	}
+	m_events.emplace(eventid_t::Retune);
+	m_events.emplace(eventid_t::ServiceDetected);
+
+	return true;
+}
+
 //---------------------------------------------------------------------------
 // dabstream::seek
 //
@@ -368,31 +519,34 @@ long long dabstream::seek(long long /*position*/, int /*whence*/)
 }
 
 //---------------------------------------------------------------------------
-// dabstream::servicename
+// dabstream::seektime
 //
-// Gets the service name associated with the stream
+// Sets the stream pointer to a specific presentation time
 //
 // Arguments:
 //
-//	NONE
+//	time		- Presentation time to seek to, in milliseconds
+//	backwards	- Flag indicating the direction of the seek
+//	startpts	- Receives the presentation time stamp at the new position
 
-std::string dabstream::servicename(void) const
+bool dabstream::seektime(double /*time*/, bool /*backwards*/, double& /*startpts*/)
 {
-	return "";				// TODO
+	return false;
 }
 
 //---------------------------------------------------------------------------
-// dabstream::signalquality
+// dabstream::timerange
 //
-// Gets the signal quality as percentages
+// Gets the range of presentation times that can be seeked to
 //
 // Arguments:
 //
-//	NONE
+//	begin		- Receives the earliest presentation time stamp
+//	end			- Receives the latest presentation time stamp
 
-void dabstream::signalquality(int& quality, int& snr) const
+bool dabstream::timerange(double& /*begin*/, double& /*end*/) const
 {
-	quality = snr = 0;		// TODO
+	return false;
 }
 
 //---------------------------------------------------------------------------
@@ -402,9 +556,9 @@ void dabstream::signalquality(int& quality, int& snr) const
 //
 // Arguments:
 //
-//	started		- Condition variable to set when thread has started
+//	NONE
 
-void dabstream::worker(scalar_condition<bool>& started)
+void dabstream::worker(void)
 {
 	std::vector<Service>	servicelist;			// vector<> of current services
 	bool					foundsub = false;		// Flag indicating the desired subchannel was found
@@ -452,6 +606,36 @@ void dabstream::worker(scalar_condition<bool>& started)
 						throw string_exception("Input Failure");		// TODO: message
 						break;
 
+					// Retune
+					//
+					// The stream has been retuned to a different subchannel and/or ensemble
+					case eventid_t::Retune:
+
+						foundsub = false;					// Search for the new subchannel
+
+						eventslock.lock();
+						if(m_retunerestart) {
+
+							// Apply the warm start frequency correctors for the new ensemble
+							RadioReceiverOptions options = {};
+							options.disableCoarseCorrector = true;
+							options.initialFineCorrector = m_retunefinecorrector;
+							options.initialCoarseCorrector = m_retunecoarsecorrector;
+							m_retunerestart = false;
+							eventslock.unlock();
+
+							m_receiver->setReceiverOptions(options);
+
+							// Discard samples from the previous ensemble and restart the receiver; the
+							// device is already streaming so skip begin_stream() in InputInterface::restart()
+							m_ringbuffer.FlushRingBuffer();
+							m_restarting = true;
+							m_receiver->restart(false);
+							m_restarting = false;
+						}
+						else eventslock.unlock();
+						break;
+
 					// ServiceDetected
 					//
 					// A new service has been detected
@@ -464,7 +648,7 @@ void dabstream::worker(scalar_condition<bool>& started)
 						for (auto const& service : servicelist) {
 							for (auto const& component : m_receiver->getComponents(service)) {
 
-								if(component.subchannelId == static_cast<int16_t>(m_subchannel)) {
+								if(component.subchannelId == static_cast<int16_t>(m_subchannel.load())) {
 
 									// The desired subchannel has been found; begin audio playback
 									ProgrammeHandlerInterface& phi = *static_cast<ProgrammeHandlerInterface*>(this);
@@ -480,10 +664,6 @@ void dabstream::worker(scalar_condition<bool>& started)
 		}
 	};
 
-	// Begin streaming from the device via the receiver and inform the caller that the thread is running
-	m_receiver->restart(false);
-	started = true;
-
 	// Continuously read data from the device until cancel_async() has been called
 	// 40 KiB = ~1/100 of a second of data
 	try { m_device->read_async(read_callback_func, 40 KiB); }
@@ -567,11 +747,39 @@ bool dabstream::restart(void)
 	assert(m_device);
 
 	m_streamok.store(true);
-	m_device->begin_stream();
+	if(!m_restarting) m_device->begin_stream();
 
 	return true;
 }
 
+//---------------------------------------------------------------------------
+// dabstream::isEncodedAudioRequested (ProgrammeHandlerInterface)
+//
+// Determines if encoded audio should be provided instead of decoded audio
+//
+// Arguments:
+//
+//	NONE
+
+bool dabstream::isEncodedAudioRequested(void)
+{
+	return m_passthrough;
+}
+
+//---------------------------------------------------------------------------
+// dabstream::onAacErrors (ProgrammeHandlerInterface)
+//
+// Invoked when an AAC access unit could not be decoded
+//
+// Arguments:
+//
+//	aacErrors		- AAC decoder error code
+
+void dabstream::onAacErrors(int aacErrors)
+{
+	if(aacErrors != 0) ++m_uncorrected;
+}
+
 //---------------------------------------------------------------------------
 // dabstream::onNewAudio (ProgrammeHandlerInterface)
 //
@@ -598,11 +806,12 @@ void dabstream::onNewAudio(std::vector<int16_t>&& audioData, int sampleRate, std
 
 	std::unique_lock<std::mutex> lock(m_queuelock);
 
-	// Detect and handle a change in the audio output sample rate
-	if(sampleRate != m_audiorate) {
+	// Detect and handle a change in the audio output sample rate or format
+	if((sampleRate != m_audiorate) || (m_audioencoded)) {
 
 		m_audioid.fetch_add(1);				// Increment the audio stream id
 		m_audiorate.store(sampleRate);		// Change the sample rate
+		m_audioencoded.store(false);		// Change the format
 
 		// Queue a DEMUX_SPECIALID_STREAMCHANGE packet to inform of the stream change
 		std::unique_ptr<demux_packet_t> packet = std::make_unique<demux_packet_t>();
@@ -638,6 +847,69 @@ void dabstream::onNewAudio(std::vector<int16_t>&& audioData, int sampleRate, std
 	m_queuecv.notify_all();
 }
 
+//---------------------------------------------------------------------------
+// dabstream::onNewEncodedAudio (ProgrammeHandlerInterface)
+//
+// Invoked when a new encoded audio access unit is available
+//
+// Arguments:
+//
+//	audioData		- LOAS/LATM frame containing the access unit
+//	sampleRate		- Audio output sample rate
+//	durationMs		- Duration of the access unit in milliseconds
+//	mode			- Audio encoding mode information
+
+void dabstream::onNewEncodedAudio(std::vector<uint8_t>&& audioData, int sampleRate, int durationMs, std::string const& /*mode*/)
+{
+	if(audioData.size() == 0) return;
+
+	// The output gain cannot be applied to encoded audio, it's copied as-is
+	std::unique_ptr<uint8_t[]> data(new uint8_t[audioData.size()]);
+	memcpy(data.get(), audioData.data(), audioData.size());
+
+	std::unique_lock<std::mutex> lock(m_queuelock);
+
+	// Detect and handle a change in the audio output sample rate or format
+	if((sampleRate != m_audiorate) || (!m_audioencoded)) {
+
+		m_audioid.fetch_add(1);				// Increment the audio stream id
+		m_audiorate.store(sampleRate);		// Change the sample rate
+		m_audioencoded.store(true);			// Change the format
+
+		// Queue a DEMUX_SPECIALID_STREAMCHANGE packet to inform of the stream change
+		std::unique_ptr<demux_packet_t> packet = std::make_unique<demux_packet_t>();
+		packet->streamid = DEMUX_SPECIALID_STREAMCHANGE;
+		m_queue.emplace(std::move(packet));
+	}
+
+	// If the queue size has exceeded the maximum, the packets aren't being
+	// processed quickly enough by the demux read function
+	if(m_queue.size() >= MAX_PACKET_QUEUE) {
+
+		m_queue = demux_queue_t();		// Replace the queue<>
+
+		// Queue a DEMUX_SPECIALID_STREAMCHANGE packet into the new queue
+		std::unique_ptr<demux_packet_t> packet = std::make_unique<demux_packet_t>();
+		packet->streamid = DEMUX_SPECIALID_STREAMCHANGE;
+		m_queue.emplace(std::move(packet));
+
+		m_dts = STREAM_TIME_BASE;		// Reset DTS back to base time
+	}
+
+	// Generate and queue the demux audio packet
+	std::unique_ptr<demux_packet_t> packet = std::make_unique<demux_packet_t>();
+	packet->streamid = m_audioid.load();
+	packet->size = static_cast<int>(audioData.size());
+	packet->duration = (durationMs / 1000.0) * STREAM_TIME_BASE;
+	packet->dts = packet->pts = m_dts;
+	packet->data = std::move(data);
+
+	m_dts += packet->duration;
+
+	m_queue.emplace(std::move(packet));
+	m_queuecv.notify_all();
+}
+
 //---------------------------------------------------------------------------
 // dabstream::onNewDynamicLabel (ProgrammeHandlerInterface)
 //
@@ -671,6 +943,37 @@ void dabstream::onMOT(mot_file_t const& /*mot_file*/)
 	//
 }
 
+//---------------------------------------------------------------------------
+// dabstream::onRsErrors (ProgrammeHandlerInterface)
+//
+// Invoked with the Reed-Solomon error correction results of a superframe
+//
+// Arguments:
+//
+//	uncorrectedErrors	- Flag if there were errors that could not be corrected
+//	numCorrectedErrors	- Number of errors that were corrected
+
+void dabstream::onRsErrors(bool uncorrectedErrors, int /*numCorrectedErrors*/)
+{
+	if(uncorrectedErrors) ++m_uncorrected;
+}
+
+//---------------------------------------------------------------------------
+// dabstream::onFIBDecodeSuccess (RadioControllerInterface)
+//
+// Invoked when a Fast Information Block has been decoded
+//
+// Arguments:
+//
+//	crcCheckOk		- Flag if the FIB passed the CRC check
+//	fib				- Pointer to the FIB data
+
+void dabstream::onFIBDecodeSuccess(bool crcCheckOk, uint8_t const* /*fib*/)
+{
+	++m_fibs;
+	if(!crcCheckOk) ++m_fiberrors;
+}
+
 //---------------------------------------------------------------------------
 // dabstream::onFrequencyCorrectorChange (RadioControllerInterface)
 //
@@ -681,9 +984,16 @@ void dabstream::onMOT(mot_file_t const& /*mot_file*/)
 //	fine			- Fine frequency correction value
 //	coarse			- Coarse frequency correction value
 
-void dabstream::onFrequencyCorrectorChange(int /*fine*/, int /*coarse*/)
+void dabstream::onFrequencyCorrectorChange(int fine, int coarse)
 {
-	// TODO - This can be applied to the device real-time?
+	// The correction is applied by the OFDM processor in the DSP; it's not pushed to the
+	// device, only retained while synchronized to warm start the next stream on the channel
+	if(m_sync.load()) {
+
+		m_finecorrector.store(fine);
+		m_coarsecorrector.store(coarse);
+		m_synced.store(true);
+	}
 }
 
 //---------------------------------------------------------------------------
@@ -725,8 +1035,12 @@ void dabstream::onServiceDetected(uint32_t /*sId*/)
 //
 //	label		- New ensemble label
 
-void dabstream::onSetEnsembleLabel(DabLabel& /*label*/)
+void dabstream::onSetEnsembleLabel(DabLabel& label)
 {
+	// The ensemble label is reported as the multiplex name in the signal status
+	std::unique_lock<std::mutex> lock(m_ensemblelabellock);
+	m_ensemblelabel = label.utf8_label();
+
 	//
 	// TODO: This can probably be used to automatically generate
 	// a channel group
@@ -742,12 +1056,9 @@ void dabstream::onSetEnsembleLabel(DabLabel& /*label*/)
 //
 //	snr			- Signal-to-Noise Ratio, in dB
 
-void dabstream::onSNR(float /*snr*/)
+void dabstream::onSNR(float snr)
 {
-	//
-	// TODO: Figure out what an acceptable SNR is for DAB and provide
-	// the necessary event to change the signal quality metric
-	//
+	m_snr.store(snr);
 }
 
 //---------------------------------------------------------------------------
@@ -759,8 +1070,10 @@ void dabstream::onSNR(float /*snr*/)
 //
 //	isSync		- Synchronization flag
 
-void dabstream::onSyncChange(bool /*isSync*/)
+void dabstream::onSyncChange(bool isSync)
 {
+	m_sync.store(isSync);
+
 	//
 	// TODO: This might need to STREAMCHANGE, clear the demux queue,
 	// silence the audio, and maybe throw up a banner to the user
@@ -58,6 +58,16 @@ public:
 	//-----------------------------------------------------------------------
 	// Member Functions
 
+	// acquisition
+	//
+	// Gets the signal acquisition state to be cached for the channel
+	bool acquisition(struct acquisitionprops& acquisitionprops) const override;
+
+	// canpause
+	//
+	// Flag indicating if the stream can be paused
+	bool canpause(void) const override;
+
 	// canseek
 	//
 	// Flag indicating if the stream allows seek operations
@@ -94,11 +104,6 @@ public:
 	// Resets the demultiplexer
 	void demuxreset(void) override;
 
-	// devicename
-	//
-	// Gets the device name associated with the stream
-	std::string devicename(void) const override;
-
 	// enumproperties
 	//
 	// Enumerates the stream properties
@@ -109,16 +114,21 @@ public:
 	// Gets the length of the stream
 	long long length(void) const override;
 
-	// muxname
+	// pause
 	//
-	// Gets the mux name associated with the stream
-	std::string muxname(void) const override;
+	// Pauses or resumes the stream
+	void pause(bool paused) override;
 
 	// position
 	//
 	// Gets the current position of the stream
 	long long position(void) const override;
 
+	// prewarm (static)
+	//
+	// Builds the device-independent DAB demodulator state ahead of the first stream
+	static void prewarm(void);
+
 	// read
 	//
 	// Reads available data from the stream
@@ -129,20 +139,25 @@ public:
 	// Gets a flag indicating if the stream is real-time
 	bool realtime(void) const override;
 
+	// retune
+	//
+	// Retunes the stream to a different channel without recreating it
+	bool retune(struct tunerprops const& tunerprops, struct channelprops const& channelprops, uint32_t subchannel) override;
+
 	// seek
 	//
 	// Sets the stream pointer to a specific position
 	long long seek(long long position, int whence) override;
 
-	// servicename
+	// seektime
 	//
-	// Gets the service name associated with the stream
-	std::string servicename(void) const override;
+	// Sets the stream pointer to a specific presentation time
+	bool seektime(double time, bool backwards, double& startpts) override;
 
-	// signalquality
+	// timerange
 	//
-	// Gets the signal quality as percentages
-	void signalquality(int& quality, int& snr) const override;
+	// Gets the range of presentation times that can be seeked to
+	bool timerange(double& begin, double& end) const override;
 
 private:
 
@@ -211,6 +226,7 @@ private:
 	enum class eventid_t {
 
 		InputFailure,					// An input failure has occurred
+		Retune,							// The stream has been retuned
 		ServiceDetected,				// A new service has been detected
 	};
 
@@ -225,7 +241,7 @@ private:
 	// worker
 	//
 	// Worker thread procedure used to transfer and process data
-	void worker(scalar_condition<bool>& started);
+	void worker(void);
 
 	//-----------------------------------------------------------------------
 	// InputInterface Implementation
@@ -253,11 +269,26 @@ private:
 	//-----------------------------------------------------------------------
 	// ProgrammeHandlerInterface
 
+	// isEncodedAudioRequested
+	//
+	// Determines if encoded audio should be provided instead of decoded audio
+	bool isEncodedAudioRequested(void) override;
+
+	// onAacErrors
+	//
+	// Invoked when an AAC access unit could not be decoded
+	void onAacErrors(int aacErrors) override;
+
 	// onNewAudio
 	//
 	// Invoked when a new packet of audio data has been decoded
 	void onNewAudio(std::vector<int16_t>&& audioData, int sampleRate, const std::string& mode) override;
 
+	// onNewEncodedAudio
+	//
+	// Invoked when a new encoded audio access unit is available
+	void onNewEncodedAudio(std::vector<uint8_t>&& audioData, int sampleRate, int durationMs, const std::string& mode) override;
+
 	// onNewDynamicLabel
 	//
 	// Invoked when a new dynamic label has been decoded
@@ -268,9 +299,19 @@ private:
 	// Invoked when a new slide has been decoded
 	void onMOT(const mot_file_t& mot_file) override;
 
+	// onRsErrors
+	//
+	// Invoked with the Reed-Solomon error correction results of a superframe
+	void onRsErrors(bool uncorrectedErrors, int numCorrectedErrors) override;
+
 	//-----------------------------------------------------------------------
 	// RadioControllerInterface
 
+	// onFIBDecodeSuccess
+	//
+	// Invoked when a Fast Information Block has been decoded
+	void onFIBDecodeSuccess(bool crcCheckOk, const uint8_t* fib) override;
+
 	// onFrequencyCorrectorChange
 	//
 	// Invoked when the frequency correction has been changed
@@ -310,12 +351,41 @@ private:
 
 	// STREAM CONTROL
 	//
-	uint32_t const		m_subchannel;						// Ensemble subchannel number
+	uint32_t			m_frequency;						// Current ensemble frequency
+	std::atomic<uint32_t> m_subchannel;						// Ensemble subchannel number
 	float const			m_pcmgain;							// Output gain
+	bool const			m_passthrough;						// Flag to pass DAB+ audio through encoded
 	std::atomic<bool>	m_streamok{ true };					// "OK" flag for the stream
 	double				m_dts{ STREAM_TIME_BASE };			// Current decode time stamp
 	std::atomic<int>	m_audioid{ STREAM_ID_AUDIOBASE };	// Current audio stream id
 	std::atomic<int>	m_audiorate{ DEFAULT_AUDIO_RATE };	// Current audio output rate
+	std::atomic<bool>	m_audioencoded{ false };			// Current audio is encoded
+
+	// ACQUISITION
+	//
+	std::atomic<bool>	m_warmstart;						// Flag if cached acquisition was applied
+	std::atomic<bool>	m_sync{ false };					// Current signal sync state
+	std::atomic<bool>	m_synced{ false };					// Flag if signal sync was acquired
+	std::atomic<int>	m_finecorrector{ 0 };				// Last known-good fine corrector
+	std::atomic<int>	m_coarsecorrector{ 0 };				// Last known-good coarse corrector
+
+	// SIGNAL STATUS
+	//
+	std::atomic<float>	m_snr{ 0 };							// Current signal-to-noise ratio (dB)
+	std::atomic<long>	m_fibs{ 0 };						// Number of FIBs decoded
+	std::atomic<long>	m_fiberrors{ 0 };					// Number of FIBs that failed CRC
+	std::atomic<long>	m_uncorrected{ 0 };					// Number of uncorrectable audio frames
+	long				m_statusfibs = 0;					// FIBs decoded as of the last status
+	long				m_statusfiberrors = 0;				// FIB errors as of the last status
+	std::string			m_ensemblelabel;					// Current ensemble label
+	mutable std::mutex	m_ensemblelabellock;				// Synchronization object
+
+	// RETUNE
+	//
+	bool				m_retunerestart = false;			// Flag to restart the receiver
+	int					m_retunefinecorrector = 0;			// Fine corrector to apply on restart
+	int					m_retunecoarsecorrector = 0;		// Coarse corrector to apply on restart
+	bool				m_restarting = false;				// Flag if receiver is being restarted
 
 	// DEMUX QUEUE
 	//
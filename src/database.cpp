@@ -36,6 +36,7 @@
 
 static void bind_parameter(sqlite3_stmt* statement, int& paramindex, const char* value);
 static void bind_parameter(sqlite3_stmt* statement, int& paramindex, unsigned int value);
+static void bind_parameter(sqlite3_stmt* statement, int& paramindex, long long value);
 template<typename... _parameters> static int execute_non_query(sqlite3* instance, char const* sql, _parameters&&... parameters);
 template<typename... _parameters> static int execute_scalar_int(sqlite3* instance, char const* sql, _parameters&&... parameters);
 template<typename... _parameters> static std::string execute_scalar_string(sqlite3* instance, char const* sql, _parameters&&... parameters);
@@ -225,6 +226,49 @@ bool add_channel(sqlite3* instance, struct channelprops const& channelprops, std
 	return result;
 }
 
+//---------------------------------------------------------------------------
+// add_recording
+//
+// Adds a new recording to the database
+//
+// Arguments:
+//
+//	instance		- Database instance
+//	recording		- Recording information; the id is ignored
+
+unsigned int add_recording(sqlite3* instance, struct recording const& recording)
+{
+	if(instance == nullptr) throw std::invalid_argument("instance");
+
+	// id | channelid | channelname | title | starttime | duration
+	execute_non_query(instance, "insert into recording values(null, ?1, ?2, ?3, ?4, ?5)", recording.channelid,
+		(recording.channelname == nullptr) ? "" : recording.channelname, (recording.title == nullptr) ? "" : recording.title,
+		static_cast<long long>(recording.starttime), recording.duration);
+
+	return static_cast<unsigned int>(sqlite3_last_insert_rowid(instance));
+}
+
+//---------------------------------------------------------------------------
+// add_timer
+//
+// Adds a new recording timer to the database
+//
+// Arguments:
+//
+//	instance		- Database instance
+//	timer			- Timer information; the id is ignored
+
+unsigned int add_timer(sqlite3* instance, struct timer const& timer)
+{
+	if(instance == nullptr) throw std::invalid_argument("instance");
+
+	// id | channelid | title | starttime | endtime
+	execute_non_query(instance, "insert into timer values(null, ?1, ?2, ?3, ?4)", timer.channelid,
+		(timer.title == nullptr) ? "" : timer.title, static_cast<long long>(timer.starttime), static_cast<long long>(timer.endtime));
+
+	return static_cast<unsigned int>(sqlite3_last_insert_rowid(instance));
+}
+
 //---------------------------------------------------------------------------
 // bind_parameter (local)
 //
@@ -281,6 +325,23 @@ static void bind_parameter(sqlite3_stmt* statement, int& paramindex, unsigned in
 	if(result != SQLITE_OK) throw sqlite_exception(result);
 }
 
+//---------------------------------------------------------------------------
+// bind_parameter (local)
+//
+// Used by execute_non_query to bind a 64-bit integer parameter
+//
+// Arguments:
+//
+//	statement		- SQL statement instance
+//	paramindex		- Index of the parameter to bind; will be incremented
+//	value			- Value to bind as the parameter
+
+static void bind_parameter(sqlite3_stmt* statement, int& paramindex, long long value)
+{
+	int result = sqlite3_bind_int64(statement, paramindex++, static_cast<int64_t>(value));
+	if(result != SQLITE_OK) throw sqlite_exception(result);
+}
+
 //---------------------------------------------------------------------------
 // channel_exists
 //
@@ -312,6 +373,7 @@ void clear_channels(sqlite3* instance)
 {
 	if(instance == nullptr) throw std::invalid_argument("instance");
 
+	execute_non_query(instance, "delete from acquisition");
 	execute_non_query(instance, "delete from channel");
 }
 
@@ -353,6 +415,10 @@ void delete_channel(sqlite3* instance, uint32_t frequency, enum modulation modul
 		execute_non_query(instance, "delete from subchannel where frequency = ?1 and modulation = ?2",
 			frequency, static_cast<int>(modulation));
 
+		// Remove any cached acquisition state for the channel
+		execute_non_query(instance, "delete from acquisition where frequency = ?1 and modulation = ?2",
+			frequency, static_cast<int>(modulation));
+
 		// Remove the channel
 		execute_non_query(instance, "delete from channel where frequency = ?1 and modulation = ?2",
 			frequency, static_cast<int>(modulation));
@@ -365,6 +431,23 @@ void delete_channel(sqlite3* instance, uint32_t frequency, enum modulation modul
 	catch(...) { try_execute_non_query(instance, "rollback transaction"); throw; }
 }
 
+//---------------------------------------------------------------------------
+// delete_recording
+//
+// Deletes a recording from the database
+//
+// Arguments:
+//
+//	instance	- Database instance
+//	id			- Recording identifier
+
+void delete_recording(sqlite3* instance, unsigned int id)
+{
+	if(instance == nullptr) throw std::invalid_argument("instance");
+
+	execute_non_query(instance, "delete from recording where id = ?1", id);
+}
+
 //---------------------------------------------------------------------------
 // delete_subchannel
 //
@@ -406,6 +489,23 @@ void delete_subchannel(sqlite3* instance, uint32_t frequency, enum modulation mo
 	catch(...) { try_execute_non_query(instance, "rollback transaction"); throw; }
 }
 
+//---------------------------------------------------------------------------
+// delete_timer
+//
+// Deletes a recording timer from the database
+//
+// Arguments:
+//
+//	instance	- Database instance
+//	id			- Timer identifier
+
+void delete_timer(sqlite3* instance, unsigned int id)
+{
+	if(instance == nullptr) throw std::invalid_argument("instance");
+
+	execute_non_query(instance, "delete from timer where id = ?1", id);
+}
+
 //---------------------------------------------------------------------------
 // enumerate_dabradio_channels
 //
@@ -647,7 +747,10 @@ void enumerate_rawfiles(sqlite3* instance, enumerate_rawfiles_callback const& ca
 	if(instance == nullptr) throw std::invalid_argument("instance");
 
 	// path | name | samplerate
-	auto sql = "select path as path, name || ' (' || cast(samplerate as text) || ')' as name, samplerate as samplerate from rawfile order by name, samplerate asc";
+	//
+	// A sample rate of zero indicates that the rate is to be taken from the file metadata
+	auto sql = "select path as path, case when samplerate > 0 then name || ' (' || cast(samplerate as text) || ')' else name end as name, "
+		"samplerate as samplerate from rawfile order by name, samplerate asc";
 
 	result = sqlite3_prepare_v2(instance, sql, -1, &statement, nullptr);
 	if(result != SQLITE_OK) throw sqlite_exception(result, sqlite3_errmsg(instance));
@@ -672,6 +775,97 @@ void enumerate_rawfiles(sqlite3* instance, enumerate_rawfiles_callback const& ca
 	catch(...) { sqlite3_finalize(statement); throw; }
 }
 
+//---------------------------------------------------------------------------
+// enumerate_recordings
+//
+// Enumerates the recordings
+//
+// Arguments:
+//
+//	instance	- Database instance
+//	callback	- Callback function
+
+void enumerate_recordings(sqlite3* instance, enumerate_recordings_callback const& callback)
+{
+	sqlite3_stmt*				statement;			// SQL statement to execute
+	int							result;				// Result from SQLite function
+
+	if(instance == nullptr) throw std::invalid_argument("instance");
+
+	// id | channelid | channelname | title | starttime | duration
+	auto sql = "select id, channelid, channelname, title, starttime, duration from recording order by starttime asc";
+
+	result = sqlite3_prepare_v2(instance, sql, -1, &statement, nullptr);
+	if(result != SQLITE_OK) throw sqlite_exception(result, sqlite3_errmsg(instance));
+
+	try {
+
+		// Execute the query and iterate over all returned rows
+		while(sqlite3_step(statement) == SQLITE_ROW) {
+
+			struct recording item = {};
+
+			item.id = static_cast<unsigned int>(sqlite3_column_int64(statement, 0));
+			item.channelid = static_cast<unsigned int>(sqlite3_column_int64(statement, 1));
+			item.channelname = reinterpret_cast<char const*>(sqlite3_column_text(statement, 2));
+			item.title = reinterpret_cast<char const*>(sqlite3_column_text(statement, 3));
+			item.starttime = static_cast<time_t>(sqlite3_column_int64(statement, 4));
+			item.duration = sqlite3_column_int(statement, 5);
+
+			callback(item);						// Invoke caller-supplied callback
+		}
+
+		sqlite3_finalize(statement);			// Finalize the SQLite statement
+	}
+
+	catch(...) { sqlite3_finalize(statement); throw; }
+}
+
+//---------------------------------------------------------------------------
+// enumerate_timers
+//
+// Enumerates the recording timers
+//
+// Arguments:
+//
+//	instance	- Database instance
+//	callback	- Callback function
+
+void enumerate_timers(sqlite3* instance, enumerate_timers_callback const& callback)
+{
+	sqlite3_stmt*				statement;			// SQL statement to execute
+	int							result;				// Result from SQLite function
+
+	if(instance == nullptr) throw std::invalid_argument("instance");
+
+	// id | channelid | title | starttime | endtime
+	auto sql = "select id, channelid, title, starttime, endtime from timer order by starttime asc";
+
+	result = sqlite3_prepare_v2(instance, sql, -1, &statement, nullptr);
+	if(result != SQLITE_OK) throw sqlite_exception(result, sqlite3_errmsg(instance));
+
+	try {
+
+		// Execute the query and iterate over all returned rows
+		while(sqlite3_step(statement) == SQLITE_ROW) {
+
+			struct timer item = {};
+
+			item.id = static_cast<unsigned int>(sqlite3_column_int64(statement, 0));
+			item.channelid = static_cast<unsigned int>(sqlite3_column_int64(statement, 1));
+			item.title = reinterpret_cast<char const*>(sqlite3_column_text(statement, 2));
+			item.starttime = static_cast<time_t>(sqlite3_column_int64(statement, 3));
+			item.endtime = static_cast<time_t>(sqlite3_column_int64(statement, 4));
+
+			callback(item);						// Invoke caller-supplied callback
+		}
+
+		sqlite3_finalize(statement);			// Finalize the SQLite statement
+	}
+
+	catch(...) { sqlite3_finalize(statement); throw; }
+}
+
 //---------------------------------------------------------------------------
 // enumerate_wxradio_channels
 //
@@ -939,8 +1133,11 @@ bool get_channel_properties(sqlite3* instance, uint32_t frequency, enum modulati
 
 	if(instance == nullptr) throw std::invalid_argument("instance");
 
-	// name | autogain | manualgain | freqcorrection | logourl
-	auto sql = "select name, autogain, manualgain, freqcorrection, logourl from channel where frequency = ?1 and modulation = ?2";
+	// name | autogain | manualgain | freqcorrection | logourl | acquisition.frequency | dabfinecorrector | dabcoarsecorrector | hdcfo
+	auto sql = "select channel.name, channel.autogain, channel.manualgain, channel.freqcorrection, channel.logourl, acquisition.frequency, "
+		"acquisition.dabfinecorrector, acquisition.dabcoarsecorrector, acquisition.hdcfo from channel left outer join acquisition "
+		"on channel.frequency = acquisition.frequency and channel.modulation = acquisition.modulation "
+		"where channel.frequency = ?1 and channel.modulation = ?2";
 
 	result = sqlite3_prepare_v2(instance, sql, -1, &statement, nullptr);
 	if(result != SQLITE_OK) throw sqlite_exception(result, sqlite3_errmsg(instance));
@@ -968,6 +1165,16 @@ bool get_channel_properties(sqlite3* instance, uint32_t frequency, enum modulati
 			unsigned char const* logourl = sqlite3_column_text(statement, 4);
 			channelprops.logourl.assign((logourl == nullptr) ? "" : reinterpret_cast<char const*>(logourl));
 
+			// The acquisition state is only valid if a row was present in the joined table
+			channelprops.acquisition = {};
+			channelprops.acquisition.valid = (sqlite3_column_type(statement, 5) != SQLITE_NULL);
+			if(channelprops.acquisition.valid) {
+
+				channelprops.acquisition.dabfinecorrector = sqlite3_column_int(statement, 6);
+				channelprops.acquisition.dabcoarsecorrector = sqlite3_column_int(statement, 7);
+				channelprops.acquisition.hdcfo = sqlite3_column_int(statement, 8);
+			}
+
 			found = true;						// Channel was found in the database
 		}
 
@@ -1043,6 +1250,38 @@ bool get_channel_properties(sqlite3* instance, uint32_t frequency, enum modulati
 	return true;
 }
 
+//---------------------------------------------------------------------------
+// get_recording_count
+//
+// Gets the number of recordings in the database
+//
+// Arguments:
+//
+//	instance	- SQLite database instance
+
+int get_recording_count(sqlite3* instance)
+{
+	if(instance == nullptr) return 0;
+
+	return execute_scalar_int(instance, "select count(*) from recording");
+}
+
+//---------------------------------------------------------------------------
+// get_timer_count
+//
+// Gets the number of recording timers in the database
+//
+// Arguments:
+//
+//	instance	- SQLite database instance
+
+int get_timer_count(sqlite3* instance)
+{
+	if(instance == nullptr) return 0;
+
+	return execute_scalar_int(instance, "select count(*) from timer");
+}
+
 //---------------------------------------------------------------------------
 // has_rawfiles
 //
@@ -1325,6 +1564,44 @@ sqlite3* open_database(char const* connstring, int flags, bool initialize)
 				execute_non_query(instance, "pragma user_version = 3");
 				dbversion = 3;
 			}
+
+			// SCHEMA VERSION 3 -> VERSION 4
+			//
+			if(dbversion == 3) {
+
+				// table: acquisition
+				//
+				// frequency(pk) | modulation(pk) | dabfinecorrector | dabcoarsecorrector | hdcfo
+				execute_non_query(instance, "drop table if exists acquisition");
+				execute_non_query(instance, "create table acquisition(frequency integer not null, modulation integer not null, "
+					"dabfinecorrector integer not null, dabcoarsecorrector integer not null, hdcfo integer not null, "
+					"primary key(frequency, modulation))");
+
+				execute_non_query(instance, "pragma user_version = 4");
+				dbversion = 4;
+			}
+
+			// SCHEMA VERSION 4 -> VERSION 5
+			//
+			if(dbversion == 4) {
+
+				// table: timer
+				//
+				// id(pk) | channelid | title | starttime | endtime
+				execute_non_query(instance, "drop table if exists timer");
+				execute_non_query(instance, "create table timer(id integer primary key autoincrement, channelid integer not null, "
+					"title text not null, starttime integer not null, endtime integer not null)");
+
+				// table: recording
+				//
+				// id(pk) | channelid | channelname | title | starttime | duration
+				execute_non_query(instance, "drop table if exists recording");
+				execute_non_query(instance, "create table recording(id integer primary key autoincrement, channelid integer not null, "
+					"channelname text not null, title text not null, starttime integer not null, duration integer not null)");
+
+				execute_non_query(instance, "pragma user_version = 5");
+				dbversion = 5;
+			}
 		}
 	}
 
@@ -1459,6 +1736,73 @@ bool update_channel(sqlite3* instance, struct channelprops const& channelprops,
 	return result;
 }
 
+//---------------------------------------------------------------------------
+// update_channel_acquisition
+//
+// Updates the cached signal acquisition state of a channel in the database
+//
+// Arguments:
+//
+//	instance			- SQLite database instance
+//	frequency			- Channel frequency
+//	modulation			- Channel modulation
+//	acquisitionprops	- Updated acquisition state; removed if not valid
+
+void update_channel_acquisition(sqlite3* instance, uint32_t frequency, enum modulation modulation, struct acquisitionprops const& acquisitionprops)
+{
+	if(instance == nullptr) throw std::invalid_argument("instance");
+
+	// An invalid acquisition state removes any cached state for the channel
+	if(!acquisitionprops.valid) {
+
+		execute_non_query(instance, "delete from acquisition where frequency = ?1 and modulation = ?2", frequency, static_cast<int>(modulation));
+		return;
+	}
+
+	// Only cache acquisition state for channels that actually exist in the database
+	execute_non_query(instance, "insert into acquisition select ?1, ?2, ?3, ?4, ?5 where exists(select * from channel where frequency = ?1 and modulation = ?2) "
+		"on conflict(frequency, modulation) do update set dabfinecorrector = excluded.dabfinecorrector, dabcoarsecorrector = excluded.dabcoarsecorrector, "
+		"hdcfo = excluded.hdcfo", frequency, static_cast<int>(modulation), acquisitionprops.dabfinecorrector, acquisitionprops.dabcoarsecorrector,
+		acquisitionprops.hdcfo);
+}
+
+//---------------------------------------------------------------------------
+// update_recording_duration
+//
+// Updates the duration of a recording in the database
+//
+// Arguments:
+//
+//	instance	- SQLite database instance
+//	id			- Recording identifier
+//	duration	- Recording duration in seconds
+
+void update_recording_duration(sqlite3* instance, unsigned int id, int duration)
+{
+	if(instance == nullptr) throw std::invalid_argument("instance");
+
+	execute_non_query(instance, "update recording set duration = ?1 where id = ?2", duration, id);
+}
+
+//---------------------------------------------------------------------------
+// update_timer
+//
+// Updates a recording timer in the database
+//
+// Arguments:
+//
+//	instance	- SQLite database instance
+//	timer		- Updated recording timer
+
+void update_timer(sqlite3* instance, struct timer const& timer)
+{
+	if(instance == nullptr) throw std::invalid_argument("instance");
+
+	execute_non_query(instance, "update timer set channelid = ?1, title = ?2, starttime = ?3, endtime = ?4 where id = ?5",
+		timer.channelid, (timer.title == nullptr) ? "" : timer.title, static_cast<long long>(timer.starttime),
+		static_cast<long long>(timer.endtime), timer.id);
+}
+
 //---------------------------------------------------------------------------
 
 #pragma warning(pop)
@@ -55,6 +55,16 @@ using enumerate_namedchannels_callback = std::function<void(struct namedchannel
 // Callback function passed to enumerate_rawfiles
 using enumerate_rawfiles_callback = std::function<void(struct rawfile const& rawfile)>;
 
+// enumerate_recordings_callback
+//
+// Callback function passed to enumerate_recordings
+using enumerate_recordings_callback = std::function<void(struct recording const& recording)>;
+
+// enumerate_timers_callback
+//
+// Callback function passed to enumerate_timers
+using enumerate_timers_callback = std::function<void(struct timer const& timer)>;
+
 //---------------------------------------------------------------------------
 // connectionpool
 //
@@ -145,6 +155,16 @@ private:
 bool add_channel(sqlite3* instance, struct channelprops const& channelprops);
 bool add_channel(sqlite3* instance, struct channelprops const& channelprops, std::vector<struct subchannelprops> const& subchannelprops);
 
+// add_recording
+//
+// Adds a new recording to the database
+unsigned int add_recording(sqlite3* instance, struct recording const& recording);
+
+// add_timer
+//
+// Adds a new recording timer to the database
+unsigned int add_timer(sqlite3* instance, struct timer const& timer);
+
 // channel_exists
 //
 // Determines if a channel exists in the database
@@ -170,11 +190,21 @@ void delete_channel(sqlite3* instance, uint32_t frequency, enum modulation modul
 // Deletes a channel from the database
 void delete_channel(sqlite3* instance, uint32_t frequency, enum modulation modulation);
 
+// delete_recording
+//
+// Deletes a recording from the database
+void delete_recording(sqlite3* instance, unsigned int id);
+
 // delete_subchannel
 //
 // Deletes a subchannel from the database
 void delete_subchannel(sqlite3* instance, uint32_t frequency, enum modulation modulation, uint32_t number);
 
+// delete_timer
+//
+// Deletes a recording timer from the database
+void delete_timer(sqlite3* instance, unsigned int id);
+
 // enumerate_dabradio_channels
 //
 // Enumerates DAB channels
@@ -200,6 +230,16 @@ void enumerate_namedchannels(sqlite3* instance, enum modulation modulation, enum
 // Enumerates available raw files registered in the database
 void enumerate_rawfiles(sqlite3* instance, enumerate_rawfiles_callback const& callback);
 
+// enumerate_recordings
+//
+// Enumerates the recordings
+void enumerate_recordings(sqlite3* instance, enumerate_recordings_callback const& callback);
+
+// enumerate_timers
+//
+// Enumerates the recording timers
+void enumerate_timers(sqlite3* instance, enumerate_timers_callback const& callback);
+
 // enumerate_wxradio_channels
 //
 // Enumerates Weather Radio channels
@@ -222,6 +262,16 @@ bool get_channel_properties(sqlite3* instance, uint32_t frequency, enum modulati
 bool get_channel_properties(sqlite3* instance, uint32_t frequency, enum modulation modulation, struct channelprops& channelprops,
 	std::vector<struct subchannelprops>& subchannelprops);
 
+// get_recording_count
+//
+// Gets the number of recordings in the database
+int get_recording_count(sqlite3* instance);
+
+// get_timer_count
+//
+// Gets the number of recording timers in the database
+int get_timer_count(sqlite3* instance);
+
 // has_rawfiles
 //
 // Gets a flag indicating if there are raw input files available to use
@@ -254,6 +304,21 @@ bool try_execute_non_query(sqlite3* instance, char const* sql);
 bool update_channel(sqlite3* instance, struct channelprops const& channelprops);
 bool update_channel(sqlite3* instance, struct channelprops const& channelprops, std::vector<struct subchannelprops> const& subchannelprops);
 
+// update_channel_acquisition
+//
+// Updates the cached signal acquisition state of a channel in the database
+void update_channel_acquisition(sqlite3* instance, uint32_t frequency, enum modulation modulation, struct acquisitionprops const& acquisitionprops);
+
+// update_recording_duration
+//
+// Updates the duration of a recording in the database
+void update_recording_duration(sqlite3* instance, unsigned int id, int duration);
+
+// update_timer
+//
+// Updates a recording timer in the database
+void update_timer(sqlite3* instance, struct timer const& timer);
+
 //---------------------------------------------------------------------------
 
 #pragma warning(pop)
@@ -126,6 +126,31 @@ struct rawfile {
 	uint32_t		samplerate;
 };
 
+// recording
+//
+// Information about a single recording enumerated from the database
+struct recording {
+
+	unsigned int	id;
+	unsigned int	channelid;
+	char const*		channelname;
+	char const*		title;
+	time_t			starttime;
+	int				duration;
+};
+
+// timer
+//
+// Information about a single recording timer enumerated from the database
+struct timer {
+
+	unsigned int	id;
+	unsigned int	channelid;
+	char const*		title;
+	time_t			starttime;
+	time_t			endtime;
+};
+
 //---------------------------------------------------------------------------
 
 #pragma warning(pop)
@@ -0,0 +1,351 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2020-2022 Michael G. Brehm
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#include "stdafx.h"
+#include "devicehub.h"
+
+#include <algorithm>
+#include <assert.h>
+#include <string.h>
+
+#include "string_exception.h"
+
+#pragma warning(push, 4)
+
+// devicehub::DEFAULT_BLOCK_SIZE (static)
+//
+// Default size of each sample block, in bytes
+uint32_t const devicehub::DEFAULT_BLOCK_SIZE = (32 KiB);
+
+// devicehub::DEFAULT_MAX_BLOCKS (static)
+//
+// Default maximum number of sample blocks queued for a consumer
+size_t const devicehub::DEFAULT_MAX_BLOCKS = 64;
+
+//---------------------------------------------------------------------------
+// devicehub Constructor (private)
+//
+// Arguments:
+//
+//	device		- Device instance to read the samples from
+//	blocksize	- Size of each sample block, in bytes
+
+devicehub::devicehub(rtldevice const& device, uint32_t blocksize) : m_device(device), m_blocksize(blocksize),
+	m_blockpool(std::make_shared<blockpool_t>())
+{
+}
+
+//---------------------------------------------------------------------------
+// devicehub Destructor
+
+devicehub::~devicehub()
+{
+	stop();									// Stop the device transfer
+
+	// Stop all of the consumer threads; they cannot be running any callbacks
+	// after the hub has been destroyed
+	std::vector<std::shared_ptr<consumer_t>> consumers;
+	std::unique_lock<std::mutex> lock(m_lock);
+	consumers.swap(m_consumers);
+	lock.unlock();
+
+	for(auto const& consumer : consumers) stop_consumer(consumer);
+}
+
+//---------------------------------------------------------------------------
+// devicehub::add_consumer
+//
+// Adds a new consumer of the device sample stream
+//
+// Arguments:
+//
+//	callback	- Callback function to receive the sample blocks
+//	maxblocks	- Maximum number of sample blocks to queue for the consumer
+
+uint32_t devicehub::add_consumer(callback const& callback)
+{
+	return add_consumer(callback, DEFAULT_MAX_BLOCKS);
+}
+
+uint32_t devicehub::add_consumer(callback const& callback, size_t maxblocks)
+{
+	if(!callback) throw std::invalid_argument("callback");
+	if(maxblocks == 0) throw std::invalid_argument("maxblocks");
+
+	std::shared_ptr<consumer_t> consumer = std::make_shared<consumer_t>();
+	consumer->func = callback;
+	consumer->maxblocks = maxblocks;
+
+	std::unique_lock<std::mutex> lock(m_lock);
+
+	consumer->id = m_nextid++;
+	consumer->thread = std::thread(&devicehub::consumer_worker, consumer);
+	m_consumers.push_back(consumer);
+
+	return consumer->id;
+}
+
+//---------------------------------------------------------------------------
+// devicehub::consumer_worker (private, static)
+//
+// Worker thread procedure used to deliver sample blocks to a consumer
+//
+// Arguments:
+//
+//	consumer	- Consumer instance to be serviced
+
+void devicehub::consumer_worker(std::shared_ptr<consumer_t> consumer)
+{
+	assert(consumer);
+
+	while(true) {
+
+		std::shared_ptr<block_t const> block;
+
+		// Wait for a sample block to be queued or the consumer to be stopped
+		std::unique_lock<std::mutex> lock(consumer->lock);
+		consumer->cv.wait(lock, [&]() -> bool { return consumer->stop || !consumer->queue.empty(); });
+		if(consumer->stop) break;
+
+		block = std::move(consumer->queue.front());
+		consumer->queue.pop_front();
+		lock.unlock();
+
+		// A consumer that throws only loses the block it was processing
+		try { consumer->func(block->data.data(), block->count); }
+		catch(...) { consumer->dropped.fetch_add(1); }
+	}
+}
+
+//---------------------------------------------------------------------------
+// devicehub::create (static)
+//
+// Factory method, creates a new devicehub instance
+//
+// Arguments:
+//
+//	device		- Device instance to read the samples from
+//	blocksize	- Size of each sample block, in bytes
+
+std::unique_ptr<devicehub> devicehub::create(rtldevice const& device)
+{
+	return create(device, DEFAULT_BLOCK_SIZE);
+}
+
+std::unique_ptr<devicehub> devicehub::create(rtldevice const& device, uint32_t blocksize)
+{
+	return std::unique_ptr<devicehub>(new devicehub(device, blocksize));
+}
+
+//---------------------------------------------------------------------------
+// devicehub::dropped_blocks
+//
+// Gets the number of sample blocks dropped for a consumer
+//
+// Arguments:
+//
+//	consumerid	- Consumer identifier returned from add_consumer
+
+uint64_t devicehub::dropped_blocks(uint32_t consumerid) const
+{
+	std::unique_lock<std::mutex> lock(m_lock);
+
+	auto found = std::find_if(m_consumers.begin(), m_consumers.end(), [&](std::shared_ptr<consumer_t> const& consumer) -> bool {
+		return consumer->id == consumerid; });
+
+	return (found != m_consumers.end()) ? (*found)->dropped.load() : 0;
+}
+
+//---------------------------------------------------------------------------
+// devicehub::get_block (private)
+//
+// Gets a sample block from the pool and fills it with data
+//
+// Arguments:
+//
+//	buffer		- Buffer containing the sample data
+//	count		- Length of the sample data
+
+std::shared_ptr<devicehub::block_t const> devicehub::get_block(uint8_t const* buffer, size_t count)
+{
+	std::unique_ptr<block_t> block;
+
+	// Reuse a free block from the pool if one is available
+	std::unique_lock<std::mutex> lock(m_blockpool->lock);
+	if(!m_blockpool->free.empty()) {
+
+		block = std::move(m_blockpool->free.back());
+		m_blockpool->free.pop_back();
+	}
+	lock.unlock();
+
+	if(!block) block = std::unique_ptr<block_t>(new block_t());
+	if(block->data.size() < count) block->data.resize(std::max(count, static_cast<size_t>(m_blocksize)));
+
+	memcpy(block->data.data(), buffer, count);
+	block->count = count;
+
+	// The block is returned to the pool when the last consumer has released it
+	std::shared_ptr<blockpool_t> pool(m_blockpool);
+	return std::shared_ptr<block_t const>(block.release(), [pool](block_t const* released) -> void {
+
+		std::unique_lock<std::mutex> lock(pool->lock);
+		pool->free.emplace_back(const_cast<block_t*>(released));
+	});
+}
+
+//---------------------------------------------------------------------------
+// devicehub::remove_consumer
+//
+// Removes a consumer of the device sample stream
+//
+// Arguments:
+//
+//	consumerid	- Consumer identifier returned from add_consumer
+
+void devicehub::remove_consumer(uint32_t consumerid)
+{
+	std::shared_ptr<consumer_t> consumer;
+
+	std::unique_lock<std::mutex> lock(m_lock);
+
+	auto found = std::find_if(m_consumers.begin(), m_consumers.end(), [&](std::shared_ptr<consumer_t> const& consumer) -> bool {
+		return consumer->id == consumerid; });
+	if(found == m_consumers.end()) return;
+
+	consumer = *found;
+	m_consumers.erase(found);
+	lock.unlock();
+
+	stop_consumer(consumer);
+}
+
+//---------------------------------------------------------------------------
+// devicehub::start
+//
+// Starts streaming data from the device
+//
+// Arguments:
+//
+//	NONE
+
+void devicehub::start(void)
+{
+	if(m_worker.joinable()) throw string_exception(__func__, ": device transfer has already been started");
+
+	// Begin streaming from the device and create a worker thread on which to read the data
+	m_device.begin_stream();
+	m_stopped.store(false);
+	m_worker_exception = nullptr;
+	m_worker = std::thread(&devicehub::worker, this);
+}
+
+//---------------------------------------------------------------------------
+// devicehub::stop
+//
+// Stops streaming data from the device
+//
+// Arguments:
+//
+//	NONE
+
+void devicehub::stop(void)
+{
+	if(!m_worker.joinable()) return;
+
+	m_device.cancel_async();				// Cancel any async read operations
+	m_worker.join();						// Wait for thread to exit
+}
+
+//---------------------------------------------------------------------------
+// devicehub::stop_consumer (private, static)
+//
+// Stops the worker thread for a consumer
+//
+// Arguments:
+//
+//	consumer	- Consumer instance to be stopped
+
+void devicehub::stop_consumer(std::shared_ptr<consumer_t> const& consumer)
+{
+	assert(consumer);
+
+	std::unique_lock<std::mutex> lock(consumer->lock);
+	consumer->stop = true;
+	consumer->queue.clear();
+	consumer->cv.notify_all();
+	lock.unlock();
+
+	if(consumer->thread.joinable()) consumer->thread.join();
+}
+
+//---------------------------------------------------------------------------
+// devicehub::worker (private)
+//
+// Worker thread procedure used to read data from the device
+//
+// Arguments:
+//
+//	NONE
+
+void devicehub::worker(void)
+{
+	// read_callback_func (local)
+	//
+	// Asynchronous read callback function for the RTL-SDR device
+	auto read_callback_func = [&](uint8_t const* buffer, size_t count) -> void {
+
+		if((buffer == nullptr) || (count == 0)) return;
+
+		std::unique_lock<std::mutex> lock(m_lock);
+		if(m_consumers.empty()) return;
+
+		// Copy the samples into a single block that is shared by all of the consumers
+		std::shared_ptr<block_t const> block = get_block(buffer, count);
+
+		for(auto const& consumer : m_consumers) {
+
+			std::unique_lock<std::mutex> consumerlock(consumer->lock);
+
+			// If the consumer has fallen behind, discard the oldest queued block
+			// rather than blocking the device transfer
+			if(consumer->queue.size() >= consumer->maxblocks) {
+
+				consumer->queue.pop_front();
+				consumer->dropped.fetch_add(1);
+			}
+
+			consumer->queue.push_back(block);
+			consumer->cv.notify_one();
+		}
+	};
+
+	// Continuously read data from the device until cancel_async() has been called
+	try { m_device.read_async(read_callback_func, m_blocksize); }
+	catch(...) { m_worker_exception = std::current_exception(); }
+
+	m_stopped.store(true);					// Thread is stopped
+}
+
+//---------------------------------------------------------------------------
+
+#pragma warning(pop)
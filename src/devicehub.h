@@ -0,0 +1,196 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2020-2022 Michael G. Brehm
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#ifndef __DEVICEHUB_H_
+#define __DEVICEHUB_H_
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "rtldevice.h"
+
+#pragma warning(push, 4)
+
+//---------------------------------------------------------------------------
+// Class devicehub
+//
+// Owns the asynchronous sample stream of an RTL-SDR device and distributes
+// the sample blocks to any number of consumers; each consumer is serviced on
+// its own thread from its own bounded queue so a slow consumer cannot stall
+// the device transfer or any of the other consumers
+
+class devicehub
+{
+public:
+
+	// callback
+	//
+	// Callback function invoked to deliver a block of samples to a consumer
+	using callback = std::function<void(uint8_t const* buffer, size_t count)>;
+
+	// Destructor
+	//
+	~devicehub();
+
+	//-----------------------------------------------------------------------
+	// Member Functions
+
+	// add_consumer
+	//
+	// Adds a new consumer of the device sample stream
+	uint32_t add_consumer(callback const& callback);
+	uint32_t add_consumer(callback const& callback, size_t maxblocks);
+
+	// create (static)
+	//
+	// Factory method, creates a new devicehub instance
+	static std::unique_ptr<devicehub> create(rtldevice const& device);
+	static std::unique_ptr<devicehub> create(rtldevice const& device, uint32_t blocksize);
+
+	// dropped_blocks
+	//
+	// Gets the number of sample blocks dropped for a consumer
+	uint64_t dropped_blocks(uint32_t consumerid) const;
+
+	// remove_consumer
+	//
+	// Removes a consumer of the device sample stream
+	void remove_consumer(uint32_t consumerid);
+
+	// start
+	//
+	// Starts streaming data from the device
+	void start(void);
+
+	// stop
+	//
+	// Stops streaming data from the device
+	void stop(void);
+
+private:
+
+	devicehub(devicehub const&) = delete;
+	devicehub& operator=(devicehub const&) = delete;
+
+	// DEFAULT_BLOCK_SIZE
+	//
+	// Default size of each sample block, in bytes
+	static uint32_t const DEFAULT_BLOCK_SIZE;
+
+	// DEFAULT_MAX_BLOCKS
+	//
+	// Default maximum number of sample blocks queued for a consumer
+	static size_t const DEFAULT_MAX_BLOCKS;
+
+	// Instance Constructor
+	//
+	devicehub(rtldevice const& device, uint32_t blocksize);
+
+	//-----------------------------------------------------------------------
+	// Private Type Declarations
+
+	// block_t
+	//
+	// Defines a reference counted block of samples shared by the consumers
+	struct block_t {
+
+		std::vector<uint8_t>	data;			// Sample data
+		size_t					count;			// Length of the sample data
+	};
+
+	// blockpool_t
+	//
+	// Defines a pool of reusable sample block buffers
+	struct blockpool_t {
+
+		std::vector<std::unique_ptr<block_t>>	free;	// Free sample blocks
+		std::mutex								lock;	// Synchronization object
+	};
+
+	// consumer_t
+	//
+	// Defines the state of a single sample stream consumer
+	struct consumer_t {
+
+		uint32_t									id;					// Consumer identifier
+		callback									func;				// Consumer callback
+		size_t										maxblocks;			// Maximum queued blocks
+		std::deque<std::shared_ptr<block_t const>>	queue;				// Queued sample blocks
+		std::atomic<uint64_t>						dropped{ 0 };		// Dropped sample blocks
+		bool										stop = false;		// Flag to stop the thread
+		std::mutex									lock;				// Synchronization object
+		std::condition_variable						cv;					// Queue condition variable
+		std::thread									thread;				// Consumer thread
+	};
+
+	//-----------------------------------------------------------------------
+	// Private Member Functions
+
+	// consumer_worker
+	//
+	// Worker thread procedure used to deliver sample blocks to a consumer
+	static void consumer_worker(std::shared_ptr<consumer_t> consumer);
+
+	// get_block
+	//
+	// Gets a sample block from the pool and fills it with data
+	std::shared_ptr<block_t const> get_block(uint8_t const* buffer, size_t count);
+
+	// stop_consumer (static)
+	//
+	// Stops the worker thread for a consumer
+	static void stop_consumer(std::shared_ptr<consumer_t> const& consumer);
+
+	// worker
+	//
+	// Worker thread procedure used to read data from the device
+	void worker(void);
+
+	//-----------------------------------------------------------------------
+	// Member Variables
+
+	rtldevice const&							m_device;			// Device instance
+	uint32_t const								m_blocksize;		// Sample block size
+	std::shared_ptr<blockpool_t>				m_blockpool;		// Sample block pool
+
+	std::vector<std::shared_ptr<consumer_t>>	m_consumers;		// Sample stream consumers
+	uint32_t									m_nextid = 1;		// Next consumer identifier
+	mutable std::mutex							m_lock;				// Synchronization object
+
+	std::thread									m_worker;			// Device worker thread
+	std::exception_ptr							m_worker_exception;	// Exception on worker thread
+	std::atomic<bool>							m_stopped{ true };	// Data transfer stopped flag
+};
+
+//-----------------------------------------------------------------------------
+
+#pragma warning(pop)
+
+#endif	// __DEVICEHUB_H_
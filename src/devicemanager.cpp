@@ -0,0 +1,673 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2020-2022 Michael G. Brehm
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#include "stdafx.h"
+#include "devicemanager.h"
+
+#include <algorithm>
+#include <assert.h>
+
+#include "string_exception.h"
+
+#pragma warning(push, 4)
+
+// devicemanager::ACQUIRE_TIMEOUT (static)
+//
+// Amount of time to wait for a device to become available, in milliseconds
+uint32_t const devicemanager::ACQUIRE_TIMEOUT = 5000;
+
+// devicemanager::DEFAULT_IDLE_TIMEOUT (static)
+//
+// Default amount of time to keep an idle device open, in milliseconds
+uint32_t const devicemanager::DEFAULT_IDLE_TIMEOUT = 30000;
+
+//---------------------------------------------------------------------------
+// devicemanager Constructor (private)
+//
+// Arguments:
+//
+//	idletimeout		- Amount of time to keep an idle device open, in milliseconds
+
+devicemanager::devicemanager(uint32_t idletimeout) : m_idletimeout(idletimeout)
+{
+	m_waiters.fill(0);
+	m_worker = std::thread(&devicemanager::worker, this);
+}
+
+//---------------------------------------------------------------------------
+// devicemanager Destructor
+
+devicemanager::~devicemanager()
+{
+	std::unique_lock<std::mutex> lock(m_lock);
+	m_stop = true;								// Signal worker thread to stop
+	m_cv.notify_all();							// Wake up the worker thread
+	lock.unlock();								// Release the lock
+
+	if(m_worker.joinable()) m_worker.join();	// Wait for thread
+	clear();									// Close all idle devices
+}
+
+//---------------------------------------------------------------------------
+// devicemanager::acquire
+//
+// Acquires a device from the pool, waiting for one to become available
+//
+// Arguments:
+//
+//	priority	- Priority of the request
+
+std::unique_ptr<rtldevice> devicemanager::acquire(enum devicepriority priority)
+{
+	std::unique_ptr<rtldevice> device = acquire(priority, std::chrono::steady_clock::now() + std::chrono::milliseconds(ACQUIRE_TIMEOUT));
+	if(!device) throw string_exception(__func__, ": no RTL-SDR tuner devices are available");
+
+	return device;
+}
+
+//---------------------------------------------------------------------------
+// devicemanager::acquire (private)
+//
+// Acquires a device from the pool before the specified deadline
+//
+// Arguments:
+//
+//	priority	- Priority of the request
+//	deadline	- Time at which to give up waiting for a device
+
+std::unique_ptr<rtldevice> devicemanager::acquire(enum devicepriority priority, std::chrono::steady_clock::time_point deadline)
+{
+	std::shared_ptr<slot_t>		slot;				// Assigned endpoint slot
+	bool						preempted = false;	// Flag if a lease was preempted
+
+	size_t const level = static_cast<size_t>(priority);
+	assert(level < m_waiters.size());
+
+	std::unique_lock<std::mutex> lock(m_lock);
+	++m_waiters[level];
+
+	while(!m_stop) {
+
+		// Requests can only be satisfied if there are no higher priority requests waiting
+		bool const higherwaiting = std::any_of(m_waiters.begin() + level + 1, m_waiters.end(), [](size_t count) -> bool { return count > 0; });
+		if(!higherwaiting) {
+
+			// Prefer endpoints that have an idle open device, otherwise take any available endpoint
+			for(auto const& candidate : m_slots) {
+
+				if(candidate->leased) continue;
+				if((!slot) || (candidate->idle && !slot->idle)) slot = candidate;
+			}
+
+			if(slot) break;
+
+			// Live streams and recordings preempt the lowest priority lease that is below them; the
+			// lease is revoked, which stops the holder and returns the device to the pool right away.
+			// A live stream is never preempted, a recording has to wait for a tuner to become idle
+			if((priority >= devicepriority::live) && (!preempted)) {
+
+				std::shared_ptr<slot_t> victim;
+				for(auto const& candidate : m_slots) {
+
+					if((!candidate->leased) || (!candidate->lease) || (candidate->priority >= priority)) continue;
+					if(candidate->priority >= devicepriority::live) continue;
+					if((!victim) || (candidate->priority < victim->priority)) victim = candidate;
+				}
+
+				if(victim) {
+
+					std::shared_ptr<lease_t> lease = victim->lease;
+					preempted = true;
+
+					// Revoking the lease waits for the holder, it cannot be done with the lock held
+					lock.unlock();
+					revoke(victim, lease);
+					lock.lock();
+
+					continue;
+				}
+			}
+		}
+
+		if(m_cv.wait_until(lock, deadline) == std::cv_status::timeout) break;
+	}
+
+	--m_waiters[level];
+
+	// If no endpoint was available, let any lower priority waiters try again
+	if(!slot) { m_cv.notify_all(); return nullptr; }
+
+	// An idle device retains the settings and any buffered samples from its previous lease; the
+	// consumer always reconfigures the device and begin_stream() discards the stale samples
+	slot->leased = true;
+	slot->priority = priority;
+	std::unique_ptr<rtldevice> device = std::move(slot->idle);
+	lock.unlock();
+
+	// Create a new device instance for the endpoint if there was not an idle one available
+	if(!device) {
+
+		try { device = slot->create(); }
+		catch(...) {
+
+			lock.lock();
+			slot->leased = false;
+			m_cv.notify_all();
+			throw;
+		}
+	}
+
+	assert(device);
+
+	std::shared_ptr<lease_t> lease = std::make_shared<lease_t>();
+	lease->device = std::move(device);
+
+	lock.lock();
+	slot->lease = lease;
+	lock.unlock();
+
+	return std::unique_ptr<rtldevice>(new pooleddevice(shared_from_this(), slot, lease));
+}
+
+//---------------------------------------------------------------------------
+// devicemanager::clear
+//
+// Closes all idle device instances
+//
+// Arguments:
+//
+//	NONE
+
+void devicemanager::clear(void)
+{
+	std::vector<std::unique_ptr<rtldevice>>	idle;		// Idle devices to be closed
+
+	// Move the idle devices out under the lock, but close them without it
+	std::unique_lock<std::mutex> lock(m_lock);
+	for(auto const& slot : m_slots) if(slot->idle) idle.emplace_back(std::move(slot->idle));
+	lock.unlock();
+}
+
+//---------------------------------------------------------------------------
+// devicemanager::create (static)
+//
+// Factory method, creates a new devicemanager instance
+//
+// Arguments:
+//
+//	NONE
+
+std::shared_ptr<devicemanager> devicemanager::create(void)
+{
+	return create(DEFAULT_IDLE_TIMEOUT);
+}
+
+//---------------------------------------------------------------------------
+// devicemanager::create (static)
+//
+// Factory method, creates a new devicemanager instance
+//
+// Arguments:
+//
+//	idletimeout		- Amount of time to keep an idle device open, in milliseconds
+
+std::shared_ptr<devicemanager> devicemanager::create(uint32_t idletimeout)
+{
+	return std::shared_ptr<devicemanager>(new devicemanager(idletimeout));
+}
+
+//---------------------------------------------------------------------------
+// devicemanager::release (private)
+//
+// Releases a device instance back into the idle pool
+//
+// Arguments:
+//
+//	slot		- Endpoint slot the device was leased from
+//	device		- Device instance to be released
+//	faulted		- Flag indicating the device has faulted
+
+void devicemanager::release(std::shared_ptr<slot_t> const& slot, std::unique_ptr<rtldevice> device, bool faulted)
+{
+	std::unique_lock<std::mutex> lock(m_lock);
+
+	slot->leased = false;
+	slot->lease = nullptr;
+
+	// Devices that have faulted, belong to a removed endpoint, or are released while
+	// the manager is stopping are closed rather than returned to the pool
+	if((!faulted) && (!slot->removed) && (!m_stop)) {
+
+		slot->idle = std::move(device);
+		slot->expiration = std::chrono::steady_clock::now() + std::chrono::milliseconds(m_idletimeout);
+	}
+
+	m_cv.notify_all();
+	lock.unlock();
+
+	device.reset();
+}
+
+//---------------------------------------------------------------------------
+// devicemanager::revoke (private)
+//
+// Takes a leased device back from its holder and releases it into the pool
+//
+// Arguments:
+//
+//	slot		- Endpoint slot the device was leased from
+//	lease		- Device lease to be revoked
+
+void devicemanager::revoke(std::shared_ptr<slot_t> const& slot, std::shared_ptr<lease_t> const& lease)
+{
+	// Take the device away from the lease; any subsequent calls made by the holder will fail.  If
+	// the device is already gone the holder released it on its own
+	std::unique_lock<std::mutex> lock(lease->lock);
+	std::unique_ptr<rtldevice> device = std::move(lease->device);
+	lock.unlock();
+
+	if(!device) return;
+
+	// Cancel any asynchronous read operation and wait for all calls in progress to complete; the
+	// cancellation is repeated in case the holder was just about to start a new read operation
+	device->cancel_async();
+
+	lock.lock();
+	while(!lease->cv.wait_for(lock, std::chrono::milliseconds(100), [&]() -> bool { return lease->users == 0; })) {
+
+		lock.unlock();
+		device->cancel_async();
+		lock.lock();
+	}
+	lock.unlock();
+
+	release(slot, std::move(device), false);
+}
+
+//---------------------------------------------------------------------------
+// devicemanager::set_endpoints
+//
+// Sets the tuner device endpoints that make up the pool
+//
+// Arguments:
+//
+//	endpoints	- Tuner device endpoints, in order of preference
+
+void devicemanager::set_endpoints(std::vector<endpoint> const& endpoints)
+{
+	std::vector<std::shared_ptr<slot_t>>	slots;		// New endpoint slots
+	std::vector<std::unique_ptr<rtldevice>>	idle;		// Idle devices to be closed
+
+	std::unique_lock<std::mutex> lock(m_lock);
+
+	// Retain the existing slot for any endpoint that is still present so that leased
+	// and idle devices are preserved, otherwise create a new slot for the endpoint
+	for(auto const& endpoint : endpoints) {
+
+		auto found = std::find_if(m_slots.begin(), m_slots.end(), [&](auto const& slot) -> bool { return slot->key == endpoint.key; });
+		if(found != m_slots.end()) { slots.push_back(*found); m_slots.erase(found); }
+		else {
+
+			std::shared_ptr<slot_t> slot = std::make_shared<slot_t>();
+			slot->key = endpoint.key;
+			slot->create = endpoint.create;
+			slot->priority = devicepriority::background;
+			slots.push_back(std::move(slot));
+		}
+	}
+
+	// Any remaining slots have been removed; close their idle devices and flag any
+	// leased devices to be closed rather than returned to the pool
+	for(auto const& slot : m_slots) {
+
+		slot->removed = true;
+		if(slot->idle) idle.emplace_back(std::move(slot->idle));
+	}
+
+	m_slots.swap(slots);
+	m_cv.notify_all();
+	lock.unlock();
+}
+
+//---------------------------------------------------------------------------
+// devicemanager::try_acquire
+//
+// Acquires a device from the pool only if one is immediately available
+//
+// Arguments:
+//
+//	priority	- Priority of the request
+
+std::unique_ptr<rtldevice> devicemanager::try_acquire(enum devicepriority priority)
+{
+	return acquire(priority, std::chrono::steady_clock::now());
+}
+
+//---------------------------------------------------------------------------
+// devicemanager::worker (private)
+//
+// Worker thread procedure used to close expired idle devices
+//
+// Arguments:
+//
+//	NONE
+
+void devicemanager::worker(void)
+{
+	std::unique_lock<std::mutex> lock(m_lock);
+
+	while(!m_stop) {
+
+		// Wait until the next idle device expires, or indefinitely if there are none
+		std::shared_ptr<slot_t> next;
+		for(auto const& slot : m_slots) {
+
+			if(slot->idle && ((!next) || (slot->expiration < next->expiration))) next = slot;
+		}
+
+		if(next) m_cv.wait_until(lock, next->expiration);
+		else m_cv.wait(lock);
+
+		if(m_stop) break;
+
+		// Move any expired idle devices out of the pool
+		std::vector<std::unique_ptr<rtldevice>> expired;
+		auto now = std::chrono::steady_clock::now();
+		for(auto const& slot : m_slots) {
+
+			if(slot->idle && (slot->expiration <= now)) expired.emplace_back(std::move(slot->idle));
+		}
+
+		// Close the expired devices without holding the lock
+		lock.unlock();
+		expired.clear();
+		lock.lock();
+	}
+}
+
+//---------------------------------------------------------------------------
+// devicemanager::pooleddevice Constructor
+//
+// Arguments:
+//
+//	manager		- Parent devicemanager instance
+//	slot		- Endpoint slot the device was leased from
+//	lease		- Device lease
+
+devicemanager::pooleddevice::pooleddevice(std::shared_ptr<devicemanager> const& manager, std::shared_ptr<slot_t> const& slot,
+	std::shared_ptr<lease_t> const& lease) : m_manager(manager), m_slot(slot), m_lease(lease), m_name(lease->device->get_device_name())
+{
+	assert(m_lease && m_lease->device);
+}
+
+//---------------------------------------------------------------------------
+// devicemanager::pooleddevice Destructor
+
+devicemanager::pooleddevice::~pooleddevice()
+{
+	// If the lease was revoked the device has already been returned to the pool
+	std::unique_lock<std::mutex> lock(m_lease->lock);
+	std::unique_ptr<rtldevice> device = std::move(m_lease->device);
+	lock.unlock();
+
+	std::shared_ptr<devicemanager> manager = m_manager.lock();
+	if(device && manager) manager->release(m_slot, std::move(device), m_faulted.load());
+}
+
+//---------------------------------------------------------------------------
+// devicemanager::pooleddevice::begin_stream
+//
+// Starts streaming data from the device
+//
+// Arguments:
+//
+//	NONE
+
+void devicemanager::pooleddevice::begin_stream(void) const
+{
+	deviceref device(*m_lease);
+	try { device->begin_stream(); }
+	catch(...) { m_faulted.store(true); throw; }
+}
+
+//---------------------------------------------------------------------------
+// devicemanager::pooleddevice::cancel_async
+//
+// Cancels any pending asynchronous read operations from the device
+//
+// Arguments:
+//
+//	NONE
+
+void devicemanager::pooleddevice::cancel_async(void) const
+{
+	// A revoked lease has already had its asynchronous read operation canceled
+	std::unique_lock<std::mutex> lock(m_lease->lock);
+	if(!m_lease->device) return;
+
+	rtldevice* device = m_lease->device.get();
+	++m_lease->users;
+	lock.unlock();
+
+	device->cancel_async();
+
+	lock.lock();
+	if(--m_lease->users == 0) m_lease->cv.notify_all();
+}
+
+//---------------------------------------------------------------------------
+// devicemanager::pooleddevice::get_device_name
+//
+// Gets the name of the device
+//
+// Arguments:
+//
+//	NONE
+
+char const* devicemanager::pooleddevice::get_device_name(void) const
+{
+	return m_name.c_str();
+}
+
+//---------------------------------------------------------------------------
+// devicemanager::pooleddevice::get_valid_gains
+//
+// Gets the valid tuner gain values for the device
+//
+// Arguments:
+//
+//	dbs			- vector<> to retrieve the valid gain values
+
+void devicemanager::pooleddevice::get_valid_gains(std::vector<int>& dbs) const
+{
+	deviceref device(*m_lease);
+	device->get_valid_gains(dbs);
+}
+
+//---------------------------------------------------------------------------
+// devicemanager::pooleddevice::read
+//
+// Reads data from the device
+//
+// Arguments:
+//
+//	buffer		- Buffer to receive the data
+//	count		- Size of the destination buffer, specified in bytes
+
+size_t devicemanager::pooleddevice::read(uint8_t* buffer, size_t count) const
+{
+	deviceref device(*m_lease);
+	try { return device->read(buffer, count); }
+	catch(...) { m_faulted.store(true); throw; }
+}
+
+//---------------------------------------------------------------------------
+// devicemanager::pooleddevice::read_async
+//
+// Asynchronously reads data from the device
+//
+// Arguments:
+//
+//	callback		- Asynchronous read callback function
+//	bufferlength	- Output buffer length in bytes
+
+void devicemanager::pooleddevice::read_async(asynccallback const& callback, uint32_t bufferlength) const
+{
+	deviceref device(*m_lease);
+	try { device->read_async(callback, bufferlength); }
+	catch(...) { m_faulted.store(true); throw; }
+}
+
+//---------------------------------------------------------------------------
+// devicemanager::pooleddevice::set_automatic_gain_control
+//
+// Enables/disables the automatic gain control mode of the device
+//
+// Arguments:
+//
+//	enable		- Flag to enable/disable AGC
+
+void devicemanager::pooleddevice::set_automatic_gain_control(bool enable) const
+{
+	deviceref device(*m_lease);
+	device->set_automatic_gain_control(enable);
+}
+
+//---------------------------------------------------------------------------
+// devicemanager::pooleddevice::set_center_frequency
+//
+// Sets the center frequency of the device
+//
+// Arguments:
+//
+//	hz		- Frequency to set, specified in hertz
+
+uint32_t devicemanager::pooleddevice::set_center_frequency(uint32_t hz) const
+{
+	deviceref device(*m_lease);
+	return device->set_center_frequency(hz);
+}
+
+//---------------------------------------------------------------------------
+// devicemanager::pooleddevice::set_decimation
+//
+// Sets the frequency offset and decimation factor applied by the device
+//
+// Arguments:
+//
+//	offset		- Frequency offset to shift to zero, specified in hertz
+//	factor		- Requested decimation factor
+
+uint32_t devicemanager::pooleddevice::set_decimation(int offset, uint32_t factor) const
+{
+	deviceref device(*m_lease);
+	return device->set_decimation(offset, factor);
+}
+
+//---------------------------------------------------------------------------
+// devicemanager::pooleddevice::set_frequency_correction
+//
+// Sets the frequency correction of the device
+//
+// Arguments:
+//
+//	ppm		- Frequency correction to set, specified in parts per million
+
+int devicemanager::pooleddevice::set_frequency_correction(int ppm) const
+{
+	deviceref device(*m_lease);
+	return device->set_frequency_correction(ppm);
+}
+
+//---------------------------------------------------------------------------
+// devicemanager::pooleddevice::set_gain
+//
+// Sets the gain of the device
+//
+// Arguments:
+//
+//	db			- Gain to set, specified in tenths of a decibel
+
+int devicemanager::pooleddevice::set_gain(int db) const
+{
+	deviceref device(*m_lease);
+	return device->set_gain(db);
+}
+
+//---------------------------------------------------------------------------
+// devicemanager::pooleddevice::set_sample_rate
+//
+// Sets the sample rate of the device
+//
+// Arguments:
+//
+//	hz		- Sample rate to set, specified in hertz
+
+uint32_t devicemanager::pooleddevice::set_sample_rate(uint32_t hz) const
+{
+	deviceref device(*m_lease);
+	return device->set_sample_rate(hz);
+}
+
+//---------------------------------------------------------------------------
+// devicemanager::pooleddevice::set_test_mode
+//
+// Enables/disables the test mode of the device
+//
+// Arguments:
+//
+//	enable		- Flag to enable/disable test mode
+
+void devicemanager::pooleddevice::set_test_mode(bool enable) const
+{
+	deviceref device(*m_lease);
+	device->set_test_mode(enable);
+}
+
+//---------------------------------------------------------------------------
+// devicemanager::pooleddevice::deviceref Constructor
+//
+// Arguments:
+//
+//	lease		- Device lease
+
+devicemanager::pooleddevice::deviceref::deviceref(lease_t& lease) : m_lease(lease), m_device(nullptr)
+{
+	std::unique_lock<std::mutex> lock(m_lease.lock);
+	if(!m_lease.device) throw string_exception("the RTL-SDR tuner device was taken by a higher priority request");
+
+	m_device = m_lease.device.get();
+	++m_lease.users;
+}
+
+//---------------------------------------------------------------------------
+// devicemanager::pooleddevice::deviceref Destructor
+
+devicemanager::pooleddevice::deviceref::~deviceref()
+{
+	std::unique_lock<std::mutex> lock(m_lease.lock);
+	if(--m_lease.users == 0) m_lease.cv.notify_all();
+}
+
+//---------------------------------------------------------------------------
+
+#pragma warning(pop)
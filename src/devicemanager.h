@@ -0,0 +1,276 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2020-2022 Michael G. Brehm
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#ifndef __DEVICEMANAGER_H_
+#define __DEVICEMANAGER_H_
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "rtldevice.h"
+
+#pragma warning(push, 4)
+
+//---------------------------------------------------------------------------
+// devicepriority
+//
+// Defines the priority of a device request; a higher priority request is
+// always satisfied before a lower priority request.  Live streams and
+// recordings can take a tuner from a background job or a channel scan, but
+// a live stream is never taken away to start a recording
+
+enum class devicepriority {
+
+	background		= 0,		// Background jobs (metadata, EPG, etc)
+	scan			= 1,		// Channel scans and channel settings
+	live			= 2,		// Live streams
+	recording		= 3,		// Scheduled recordings
+};
+
+//---------------------------------------------------------------------------
+// Class devicemanager
+//
+// Manages a pool of RTL-SDR tuner devices; requests are assigned to any
+// available tuner by priority and recently used devices are kept open to
+// avoid the overhead of initializing the device on every channel change
+
+class devicemanager : public std::enable_shared_from_this<devicemanager>
+{
+public:
+
+	// createfunc
+	//
+	// Function used to create a new device instance for an endpoint
+	using createfunc = std::function<std::unique_ptr<rtldevice>(void)>;
+
+	// endpoint
+	//
+	// Defines a tuner device endpoint
+	struct endpoint {
+
+		std::string			key;			// Unique key for the endpoint
+		createfunc			create;			// Function to create the device
+	};
+
+	// Destructor
+	//
+	~devicemanager();
+
+	//-----------------------------------------------------------------------
+	// Member Functions
+
+	// acquire
+	//
+	// Acquires a device from the pool, waiting for one to become available
+	std::unique_ptr<rtldevice> acquire(enum devicepriority priority);
+
+	// clear
+	//
+	// Closes all idle device instances
+	void clear(void);
+
+	// create (static)
+	//
+	// Factory method, creates a new devicemanager instance
+	static std::shared_ptr<devicemanager> create(void);
+	static std::shared_ptr<devicemanager> create(uint32_t idletimeout);
+
+	// set_endpoints
+	//
+	// Sets the tuner device endpoints that make up the pool
+	void set_endpoints(std::vector<endpoint> const& endpoints);
+
+	// try_acquire
+	//
+	// Acquires a device from the pool only if one is immediately available
+	std::unique_ptr<rtldevice> try_acquire(enum devicepriority priority);
+
+private:
+
+	devicemanager(devicemanager const&) = delete;
+	devicemanager& operator=(devicemanager const&) = delete;
+
+	// ACQUIRE_TIMEOUT
+	//
+	// Amount of time to wait for a device to become available, in milliseconds
+	static uint32_t const ACQUIRE_TIMEOUT;
+
+	// DEFAULT_IDLE_TIMEOUT
+	//
+	// Default amount of time to keep an idle device open, in milliseconds
+	static uint32_t const DEFAULT_IDLE_TIMEOUT;
+
+	// Instance Constructor
+	//
+	devicemanager(uint32_t idletimeout);
+
+	//-----------------------------------------------------------------------
+	// Private Type Declarations
+
+	// lease_t
+	//
+	// Defines the state of a device lease; the device is taken back from the
+	// holder when the lease is revoked by a higher priority request
+	struct lease_t {
+
+		std::mutex									lock;				// Synchronization object
+		std::condition_variable						cv;					// Signals a change in users
+		std::unique_ptr<rtldevice>					device;				// Leased device instance
+		size_t										users = 0;			// Calls in progress
+	};
+
+	// slot_t
+	//
+	// Defines the state of a single tuner device endpoint
+	struct slot_t {
+
+		std::string									key;				// Endpoint key
+		createfunc									create;				// Device creation function
+		bool										removed = false;	// Endpoint was removed
+		bool										leased = false;		// Device is in use
+		enum devicepriority							priority;			// Priority of the lease
+		std::shared_ptr<lease_t>					lease;				// Active device lease
+		std::unique_ptr<rtldevice>					idle;				// Idle device instance
+		std::chrono::steady_clock::time_point		expiration;			// Idle expiration time
+	};
+
+	// pooleddevice
+	//
+	// Wraps an rtldevice instance, returning it to the manager on destruction
+	class pooleddevice : public rtldevice
+	{
+	public:
+
+		// Instance Constructor
+		//
+		pooleddevice(std::shared_ptr<devicemanager> const& manager, std::shared_ptr<slot_t> const& slot, std::shared_ptr<lease_t> const& lease);
+
+		// Destructor
+		//
+		~pooleddevice();
+
+		//-------------------------------------------------------------------
+		// Member Functions
+
+		void begin_stream(void) const override;
+		void cancel_async(void) const override;
+		char const* get_device_name(void) const override;
+		void get_valid_gains(std::vector<int>& dbs) const override;
+		size_t read(uint8_t* buffer, size_t count) const override;
+		void read_async(asynccallback const& callback, uint32_t bufferlength) const override;
+		void set_automatic_gain_control(bool enable) const override;
+		uint32_t set_center_frequency(uint32_t hz) const override;
+		uint32_t set_decimation(int offset, uint32_t factor) const override;
+		int set_frequency_correction(int ppm) const override;
+		int set_gain(int db) const override;
+		uint32_t set_sample_rate(uint32_t hz) const override;
+		void set_test_mode(bool enable) const override;
+
+	private:
+
+		pooleddevice(pooleddevice const&) = delete;
+		pooleddevice& operator=(pooleddevice const&) = delete;
+
+		//-------------------------------------------------------------------
+		// Private Type Declarations
+
+		// deviceref
+		//
+		// Holds a reference to the leased device for the duration of a call,
+		// throws if the lease has been revoked
+		class deviceref
+		{
+		public:
+
+			deviceref(lease_t& lease);
+			~deviceref();
+
+			rtldevice* operator->(void) const { return m_device; }
+
+		private:
+
+			deviceref(deviceref const&) = delete;
+			deviceref& operator=(deviceref const&) = delete;
+
+			lease_t&		m_lease;		// Device lease
+			rtldevice*		m_device;		// Leased device instance
+		};
+
+		//-------------------------------------------------------------------
+		// Member Variables
+
+		std::weak_ptr<devicemanager> const	m_manager;			// Parent manager instance
+		std::shared_ptr<slot_t> const		m_slot;				// Endpoint slot
+		std::shared_ptr<lease_t> const		m_lease;			// Device lease
+		std::string const					m_name;				// Device name
+		mutable std::atomic<bool>			m_faulted{ false };	// Device fault flag
+	};
+
+	//-----------------------------------------------------------------------
+	// Private Member Functions
+
+	// acquire
+	//
+	// Acquires a device from the pool before the specified deadline
+	std::unique_ptr<rtldevice> acquire(enum devicepriority priority, std::chrono::steady_clock::time_point deadline);
+
+	// release
+	//
+	// Releases a device instance back into the idle pool
+	void release(std::shared_ptr<slot_t> const& slot, std::unique_ptr<rtldevice> device, bool faulted);
+
+	// revoke
+	//
+	// Takes a leased device back from its holder and releases it into the pool
+	void revoke(std::shared_ptr<slot_t> const& slot, std::shared_ptr<lease_t> const& lease);
+
+	// worker
+	//
+	// Worker thread procedure used to close expired idle devices
+	void worker(void);
+
+	//-----------------------------------------------------------------------
+	// Member Variables
+
+	uint32_t const							m_idletimeout;		// Idle device timeout (ms)
+	std::vector<std::shared_ptr<slot_t>>	m_slots;			// Endpoint slots
+	std::array<size_t, 4>					m_waiters;			// Waiters by priority
+	mutable std::mutex						m_lock;				// Synchronization object
+	std::condition_variable					m_cv;				// Pool condition variable
+	bool									m_stop = false;		// Flag to stop the worker
+	std::thread								m_worker;			// Idle device worker thread
+};
+
+//-----------------------------------------------------------------------------
+
+#pragma warning(pop)
+
+#endif	// __DEVICEMANAGER_H_
@@ -0,0 +1,186 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2020-2022 Michael G. Brehm
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//-----------------------------------------------------------------------------
+
+
+#include "stdafx.h"
+#include "fftwcache.h"
+
+#include <assert.h>
+
+#include "string_exception.h"
+
+#pragma warning(push, 4)
+
+// fftwcache::PLANNER_FLAGS (static)
+//
+// Planner flags used to create every cached plan
+unsigned int const fftwcache::PLANNER_FLAGS = FFTW_MEASURE;
+
+// fftwcache::s_plans (static)
+//
+// Cached plans
+fftwcache::plan_map_t fftwcache::s_plans;
+
+// fftwcache::s_changed (static)
+//
+// Flag if the planner wisdom has changed since it was last saved
+bool fftwcache::s_changed = false;
+
+// fftwcache::s_lock (static)
+//
+// Synchronization object
+std::mutex fftwcache::s_lock;
+
+//---------------------------------------------------------------------------
+// fftwcache_get_plan
+//
+// C language wrapper around fftwcache::get_plan
+//
+// Arguments:
+//
+//	size		- Size of the transform
+//	in			- Input array the plan will be executed against
+//	out			- Output array the plan will be executed against
+//	sign		- Direction of the transform (FFTW_FORWARD or FFTW_BACKWARD)
+
+fftwf_plan fftwcache_get_plan(int size, fftwf_complex const* in, fftwf_complex const* out, int sign)
+{
+	// Exceptions cannot be allowed to propagate into C code
+	try { return fftwcache::get_plan(size, in, out, sign); }
+	catch(...) { return nullptr; }
+}
+
+//---------------------------------------------------------------------------
+// fftwcache::get_plan (static)
+//
+// Gets a shared plan for a one-dimensional complex transform
+//
+// Arguments:
+//
+//	size		- Size of the transform
+//	in			- Input array the plan will be executed against
+//	out			- Output array the plan will be executed against
+//	sign		- Direction of the transform (FFTW_FORWARD or FFTW_BACKWARD)
+
+fftwf_plan fftwcache::get_plan(int size, fftwf_complex const* in, fftwf_complex const* out, int sign)
+{
+	assert((in != nullptr) && (out != nullptr));
+
+	if(size <= 0) throw std::invalid_argument("size");
+	if((sign != FFTW_FORWARD) && (sign != FFTW_BACKWARD)) throw std::invalid_argument("sign");
+
+	// A shared plan can only be executed against arrays with the same placement and the same
+	// SIMD alignment as the arrays it was created against, so both are part of the key
+	bool const inplace = (in == out);
+	bool const aligned = (fftwf_alignment_of(const_cast<float*>(&in[0][0])) == 0) && (fftwf_alignment_of(const_cast<float*>(&out[0][0])) == 0);
+	key_t const key(size, sign, inplace, aligned);
+
+	std::unique_lock<std::mutex> lock(s_lock);
+
+	auto const found = s_plans.find(key);
+	if(found != s_plans.end()) return found->second;
+
+	// FFTW_MEASURE overwrites the arrays while planning, so the plan is always created against
+	// temporary arrays; a plan for unaligned arrays must not assume that they are SIMD aligned
+	fftwf_complex* planin = reinterpret_cast<fftwf_complex*>(fftwf_malloc(sizeof(fftwf_complex) * size));
+	fftwf_complex* planout = (inplace) ? planin : reinterpret_cast<fftwf_complex*>(fftwf_malloc(sizeof(fftwf_complex) * size));
+	if((planin == nullptr) || (planout == nullptr)) {
+
+		if(planin) fftwf_free(planin);
+		if(planout && !inplace) fftwf_free(planout);
+		throw string_exception(__func__, ": unable to allocate FFT buffers");
+	}
+
+	fftwf_plan plan = fftwf_plan_dft_1d(size, planin, planout, sign, PLANNER_FLAGS | ((aligned) ? 0 : FFTW_UNALIGNED));
+
+	fftwf_free(planin);
+	if(!inplace) fftwf_free(planout);
+
+	if(plan == nullptr) throw string_exception(__func__, ": unable to create FFT plan");
+
+	s_plans.emplace(key, plan);
+	s_changed = true;
+
+	return plan;
+}
+
+//---------------------------------------------------------------------------
+// fftwcache::load_wisdom (static)
+//
+// Imports previously measured planner wisdom from a file
+//
+// Arguments:
+//
+//	path		- Path to the wisdom file
+
+bool fftwcache::load_wisdom(char const* path)
+{
+	if(path == nullptr) throw std::invalid_argument("path");
+
+	std::unique_lock<std::mutex> lock(s_lock);
+	return (fftwf_import_wisdom_from_filename(path) != 0);
+}
+
+//---------------------------------------------------------------------------
+// fftwcache::release (static)
+//
+// Destroys all of the cached plans
+//
+// Arguments:
+//
+//	NONE
+
+void fftwcache::release(void)
+{
+	std::unique_lock<std::mutex> lock(s_lock);
+
+	for(auto const& iterator : s_plans) fftwf_destroy_plan(iterator.second);
+	s_plans.clear();
+}
+
+//---------------------------------------------------------------------------
+// fftwcache::save_wisdom (static)
+//
+// Exports the planner wisdom into a file if it has changed
+//
+// Arguments:
+//
+//	path		- Path to the wisdom file
+
+bool fftwcache::save_wisdom(char const* path)
+{
+	if(path == nullptr) throw std::invalid_argument("path");
+
+	std::unique_lock<std::mutex> lock(s_lock);
+
+	// Wisdom only accumulates when a new plan has been created
+	if(!s_changed) return true;
+
+	if(fftwf_export_wisdom_to_filename(path) == 0) return false;
+
+	s_changed = false;
+	return true;
+}
+
+//---------------------------------------------------------------------------
+
+#pragma warning(pop)
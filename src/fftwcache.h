@@ -0,0 +1,114 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2020-2022 Michael G. Brehm
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//-----------------------------------------------------------------------------
+
+
+#ifndef __FFTWCACHE_H_
+#define __FFTWCACHE_H_
+#pragma once
+
+#include <fftw3.h>
+#include <map>
+#include <mutex>
+#include <tuple>
+
+#pragma warning(push, 4)
+
+//---------------------------------------------------------------------------
+// Class fftwcache
+//
+// Implements a process-wide cache of FFTW plans; plans are keyed by the size,
+// direction, placement and alignment of the transform and are shared by every
+// caller, which must execute them against their own arrays with the new-array
+// execute functions.  The FFTW planner is not thread-safe, all access to it
+// is serialized here, including the import and export of planner wisdom
+
+class fftwcache
+{
+public:
+
+	//-----------------------------------------------------------------------
+	// Member Functions
+
+	// get_plan (static)
+	//
+	// Gets a shared plan for a one-dimensional complex transform
+	static fftwf_plan get_plan(int size, fftwf_complex const* in, fftwf_complex const* out, int sign);
+
+	// load_wisdom (static)
+	//
+	// Imports previously measured planner wisdom from a file
+	static bool load_wisdom(char const* path);
+
+	// release (static)
+	//
+	// Destroys all of the cached plans
+	static void release(void);
+
+	// save_wisdom (static)
+	//
+	// Exports the planner wisdom into a file if it has changed
+	static bool save_wisdom(char const* path);
+
+private:
+
+	fftwcache() = delete;
+	fftwcache(fftwcache const&) = delete;
+	fftwcache& operator=(fftwcache const&) = delete;
+
+	// PLANNER_FLAGS
+	//
+	// Planner flags used to create every cached plan
+	static unsigned int const PLANNER_FLAGS;
+
+	//-----------------------------------------------------------------------
+	// Private Type Declarations
+
+	// key_t
+	//
+	// Defines the key of a cached plan: size, sign, in-place, aligned
+	using key_t = std::tuple<int, int, bool, bool>;
+
+	// plan_map_t
+	//
+	// Defines the collection of cached plans
+	using plan_map_t = std::map<key_t, fftwf_plan>;
+
+	//-----------------------------------------------------------------------
+	// Member Variables
+
+	static plan_map_t				s_plans;		// Cached plans
+	static bool						s_changed;		// Flag if wisdom has changed
+	static std::mutex				s_lock;			// Synchronization object
+};
+
+//---------------------------------------------------------------------------
+// fftwcache_get_plan
+//
+// C language wrapper around fftwcache::get_plan
+
+extern "C" fftwf_plan fftwcache_get_plan(int size, fftwf_complex const* in, fftwf_complex const* out, int sign);
+
+//-----------------------------------------------------------------------------
+
+#pragma warning(pop)
+
+#endif	// __FFTWCACHE_H_
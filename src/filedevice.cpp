@@ -23,25 +23,49 @@
 #include "stdafx.h"
 #include "filedevice.h"
 
-#include <chrono>
+#include <algorithm>
+#include <ctype.h>
 #include <limits.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <thread>
 
+#ifndef _WINDOWS
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <rapidjson/document.h>
+#include <rapidjson/error/en.h>
+
+#include "iqconvert.h"
 #include "string_exception.h"
 
 #pragma warning(push, 4)
 
+// filedevice::MAX_PACING_LAG (static)
+//
+// Maximum time the consumer can fall behind before the pacing clock is reset
+std::chrono::milliseconds const filedevice::MAX_PACING_LAG(1000);
+
+// filedevice::VIEW_SIZE (static)
+//
+// Size of the memory mapped view of the file
+size_t const filedevice::VIEW_SIZE = (64 << 20);
+
 //---------------------------------------------------------------------------
 // filedevice Constructor (private)
 //
 // Arguments:
 //
 //	filename	- Target file name
-//	samplerate	- Target file sample rate
+//	samplerate	- Target file sample rate, or zero to use the file metadata
+//	realtime	- Flag to deliver the data at the sample rate
 
-filedevice::filedevice(char const* filename, uint32_t samplerate) : m_samplerate(samplerate)
+filedevice::filedevice(char const* filename, uint32_t samplerate, bool realtime) : m_samplerate(samplerate), m_realtime(realtime)
 {
 	if(filename == nullptr) throw std::invalid_argument("filename");
 
@@ -56,9 +80,85 @@ filedevice::filedevice(char const* filename, uint32_t samplerate) : m_samplerate
 	else throw std::invalid_argument("filename");
 #endif
 
-	// Attempt to open the target file in read-only binary mode
-	m_file = fopen(m_filename.c_str(), "rb");
-	if(m_file == nullptr) throw string_exception(__func__, ": fopen() failed");
+	uint32_t		metasamplerate = 0;			// Sample rate from the file metadata
+	bool			sigmf = false;				// Flag if the file is a SigMF recording
+
+	// SigMF recordings consist of a metadata file and a data file with the same base
+	// name; either of them can be registered, the data file is the one that gets mapped
+	for(auto const& extension : { std::string(".sigmf-meta"), std::string(".sigmf-data") }) {
+
+		if((m_filename.length() > extension.length()) &&
+			(m_filename.compare(m_filename.length() - extension.length(), extension.length(), extension) == 0)) {
+
+			std::string basename = m_filename.substr(0, m_filename.length() - extension.length());
+			read_sigmf(basename + ".sigmf-meta", m_format, metasamplerate, m_dataoffset);
+			m_filename = basename + ".sigmf-data";
+			sigmf = true;
+			break;
+		}
+	}
+
+#ifdef _WINDOWS
+	// Open the target file and create a read-only mapping of the entire file; views of
+	// the mapping are created on demand as the file is read
+	m_file = CreateFileA(m_filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if(m_file == INVALID_HANDLE_VALUE) throw string_exception(__func__, ": CreateFile() failed");
+
+	LARGE_INTEGER filesize = {};
+	if(!GetFileSizeEx(m_file, &filesize)) { CloseHandle(m_file); throw string_exception(__func__, ": GetFileSizeEx() failed"); }
+	m_filesize = static_cast<uint64_t>(filesize.QuadPart);
+
+	m_mapping = CreateFileMappingA(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if(m_mapping == nullptr) { CloseHandle(m_file); throw string_exception(__func__, ": CreateFileMapping() failed"); }
+
+	SYSTEM_INFO sysinfo = {};
+	GetSystemInfo(&sysinfo);
+	m_granularity = sysinfo.dwAllocationGranularity;
+#else
+	// Open the target file; views of the file are mapped on demand as the file is read
+	m_file = open(m_filename.c_str(), O_RDONLY);
+	if(m_file < 0) throw string_exception(__func__, ": open() failed");
+
+	struct stat filestat = {};
+	if(fstat(m_file, &filestat) != 0) { close(m_file); throw string_exception(__func__, ": fstat() failed"); }
+	m_filesize = static_cast<uint64_t>(filestat.st_size);
+
+	m_granularity = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+#endif
+
+	try {
+
+		// Files other than SigMF recordings may have a WAV header, otherwise the format
+		// of the samples is determined from the file extension
+		if(!sigmf) {
+
+			if(!read_wav(m_format, metasamplerate, m_dataoffset, m_datasize)) m_format = get_format(m_filename);
+		}
+
+		m_samplesize = get_samplesize(m_format);
+
+		// The sample data runs to the end of the file unless the header specified otherwise,
+		// any partial sample at the end of the data is ignored
+		if(m_dataoffset > m_filesize) m_dataoffset = m_filesize;
+		if(m_datasize == 0) m_datasize = m_filesize - m_dataoffset;
+		m_datasize -= (m_datasize % m_samplesize);
+
+		// The sample rate in the file metadata takes precedence over the registered rate
+		if(metasamplerate != 0) m_samplerate = metasamplerate;
+		if(m_samplerate == 0) throw std::invalid_argument("samplerate");
+	}
+
+	catch(...) {
+
+		unmap_view();
+#ifdef _WINDOWS
+		CloseHandle(m_mapping);
+		CloseHandle(m_file);
+#else
+		close(m_file);
+#endif
+		throw;
+	}
 }
 
 //---------------------------------------------------------------------------
@@ -66,8 +166,14 @@ filedevice::filedevice(char const* filename, uint32_t samplerate) : m_samplerate
 
 filedevice::~filedevice()
 {
-	if(m_file) fclose(m_file);
-	m_file = nullptr;
+	unmap_view();
+
+#ifdef _WINDOWS
+	if(m_mapping) CloseHandle(m_mapping);
+	if(m_file != INVALID_HANDLE_VALUE) CloseHandle(m_file);
+#else
+	if(m_file >= 0) close(m_file);
+#endif
 }
 
 //---------------------------------------------------------------------------
@@ -101,6 +207,28 @@ void filedevice::cancel_async(void) const
 	m_stopped.wait_until_equals(true);		// Wait for async to stop
 }
 
+//---------------------------------------------------------------------------
+// filedevice::convert (private)
+//
+// Converts samples from the file into unsigned 8-bit I/Q samples
+//
+// Arguments:
+//
+//	in			- Input samples in the file sample format
+//	out			- Output unsigned 8-bit I/Q samples
+//	samples		- Number of I/Q samples to convert
+
+void filedevice::convert(uint8_t const* in, uint8_t* out, size_t samples) const
+{
+	switch(m_format) {
+
+		case sampleformat::cu8: memcpy(out, in, samples * 2); break;
+		case sampleformat::cs8: convert_cs8_to_cu8(reinterpret_cast<int8_t const*>(in), out, samples * 2); break;
+		case sampleformat::cs16: convert_cs16_to_cu8(reinterpret_cast<int16_t const*>(in), out, samples * 2); break;
+		case sampleformat::cf32: convert_cf32_to_cu8(reinterpret_cast<float const*>(in), out, samples * 2); break;
+	}
+}
+
 //---------------------------------------------------------------------------
 // filedevice::create (static)
 //
@@ -109,11 +237,12 @@ void filedevice::cancel_async(void) const
 // Arguments:
 //
 //	filename	- Target file name
-//	samplerate	- Target file sample rate
+//	samplerate	- Target file sample rate, or zero to use the file metadata
+//	realtime	- Flag to deliver the data at the sample rate
 
-std::unique_ptr<filedevice> filedevice::create(char const* filename, uint32_t samplerate)
+std::unique_ptr<filedevice> filedevice::create(char const* filename, uint32_t samplerate, bool realtime)
 {
-	return std::unique_ptr<filedevice>(new filedevice(filename, samplerate));
+	return std::unique_ptr<filedevice>(new filedevice(filename, samplerate, realtime));
 }
 
 //---------------------------------------------------------------------------
@@ -130,6 +259,53 @@ char const* filedevice::get_device_name(void) const
 	return m_filename.c_str();
 }
 
+//---------------------------------------------------------------------------
+// filedevice::get_format (private, static)
+//
+// Gets the sample format of a raw file from the file extension
+//
+// Arguments:
+//
+//	filename	- Raw file name
+
+enum filedevice::sampleformat filedevice::get_format(std::string const& filename)
+{
+	size_t const dot = filename.find_last_of('.');
+	if(dot == std::string::npos) return sampleformat::cu8;
+
+	std::string extension = filename.substr(dot);
+	std::transform(extension.begin(), extension.end(), extension.begin(), [](char ch) -> char { return static_cast<char>(tolower(ch)); });
+
+	// These follow the naming conventions used by most of the SDR capture tools
+	if(extension == ".cs8") return sampleformat::cs8;
+	else if(extension == ".cs16") return sampleformat::cs16;
+	else if((extension == ".cf32") || (extension == ".cfile")) return sampleformat::cf32;
+
+	return sampleformat::cu8;
+}
+
+//---------------------------------------------------------------------------
+// filedevice::get_samplesize (private, static)
+//
+// Gets the size of a single I/Q sample in a sample format
+//
+// Arguments:
+//
+//	format		- Sample format
+
+size_t filedevice::get_samplesize(enum sampleformat format)
+{
+	switch(format) {
+
+		case sampleformat::cu8: return 2;
+		case sampleformat::cs8: return 2;
+		case sampleformat::cs16: return 4;
+		case sampleformat::cf32: return 8;
+	}
+
+	throw std::invalid_argument("format");
+}
+
 //---------------------------------------------------------------------------
 // filedevice::get_valid_gains
 //
@@ -143,6 +319,109 @@ void filedevice::get_valid_gains(std::vector<int>& /*dbs*/) const
 {
 }
 
+//---------------------------------------------------------------------------
+// filedevice::map_view (private)
+//
+// Maps the view of the file that contains the specified offset
+//
+// Arguments:
+//
+//	offset		- Offset within the file that must be mapped
+
+void filedevice::map_view(uint64_t offset) const
+{
+	assert(offset < m_filesize);
+	assert(m_granularity > 0);
+
+	unmap_view();
+
+	// Views have to start on a multiple of the allocation granularity
+	uint64_t const viewoffset = offset - (offset % m_granularity);
+	size_t const viewlength = static_cast<size_t>(std::min(static_cast<uint64_t>(VIEW_SIZE), m_filesize - viewoffset));
+
+#ifdef _WINDOWS
+	void* view = MapViewOfFile(m_mapping, FILE_MAP_READ, static_cast<DWORD>(viewoffset >> 32),
+		static_cast<DWORD>(viewoffset & 0xFFFFFFFF), viewlength);
+	if(view == nullptr) throw string_exception(__func__, ": MapViewOfFile() failed");
+#else
+	void* view = mmap(nullptr, viewlength, PROT_READ, MAP_PRIVATE, m_file, static_cast<off_t>(viewoffset));
+	if(view == MAP_FAILED) throw string_exception(__func__, ": mmap() failed");
+
+	// The file is always read front to back, let the kernel read ahead aggressively
+	madvise(view, viewlength, MADV_SEQUENTIAL);
+#endif
+
+	m_view = reinterpret_cast<uint8_t const*>(view);
+	m_viewoffset = viewoffset;
+	m_viewlength = viewlength;
+}
+
+//---------------------------------------------------------------------------
+// filedevice::next_block (private)
+//
+// Gets the next block of mapped data from the file
+//
+// Arguments:
+//
+//	data		- Receives a pointer to the mapped data
+//	maxcount	- Maximum number of bytes to return
+
+size_t filedevice::next_block(uint8_t const*& data, size_t maxcount) const
+{
+	if(m_position + m_samplesize > m_datasize) return 0;
+
+	// Map the next view of the file when the next sample is not entirely within the current one
+	uint64_t const offset = m_dataoffset + m_position;
+	if((m_view == nullptr) || (offset < m_viewoffset) || (offset + m_samplesize > m_viewoffset + m_viewlength)) map_view(offset);
+
+	// Blocks only contain whole samples and are never split across views, the last
+	// block of a view may be short
+	size_t const viewpos = static_cast<size_t>(offset - m_viewoffset);
+	size_t count = std::min(maxcount, m_viewlength - viewpos);
+	count = static_cast<size_t>(std::min(static_cast<uint64_t>(count), m_datasize - m_position));
+	count -= (count % m_samplesize);
+
+	data = m_view + viewpos;
+	m_position += count;
+
+	return count;
+}
+
+//---------------------------------------------------------------------------
+// filedevice::pace (private)
+//
+// Waits until a block of data is due according to the sample rate
+//
+// Arguments:
+//
+//	count		- Size of the block, specified in bytes
+
+void filedevice::pace(size_t count) const
+{
+	assert(m_samplerate != 0);
+
+	if((!m_realtime) || (count == 0)) return;
+
+	// The due time is calculated from the total amount of data delivered since the clock
+	// was started, so rounding errors and oversleeping do not accumulate
+	auto const now = std::chrono::steady_clock::now();
+	if(m_clockbytes == 0) m_clockstart = now;
+	m_clockbytes += count;
+
+	auto due = m_clockstart + std::chrono::microseconds(static_cast<int64_t>((m_clockbytes * 1000000.0) / (m_samplerate * 2.0)));
+
+	// If the consumer has fallen too far behind, restart the clock rather than trying
+	// to catch up by delivering the backlog in a burst
+	if(now > (due + MAX_PACING_LAG)) {
+
+		m_clockstart = now;
+		m_clockbytes = count;
+		due = m_clockstart + std::chrono::microseconds(static_cast<int64_t>((count * 1000000.0) / (m_samplerate * 2.0)));
+	}
+
+	std::this_thread::sleep_until(due);
+}
+
 //---------------------------------------------------------------------------
 // filedevice::read
 //
@@ -155,24 +434,23 @@ void filedevice::get_valid_gains(std::vector<int>& /*dbs*/) const
 
 size_t filedevice::read(uint8_t* buffer, size_t count) const
 {
-	assert(m_file != nullptr);
-	assert(m_samplerate != 0);
-
-	auto start = std::chrono::steady_clock::now();
+	assert(buffer != nullptr);
 
-	// Synchronously read the requested amount of data from the input file
-	size_t read = fread(buffer, sizeof(uint8_t), count, m_file);
+	size_t read = 0;
 
-	if(read > 0) {
+	// Convert the requested number of samples from the mapped views of the file
+	while(read + 2 <= count) {
 
-		// Determine how long this operation should take to execute to maintain sample rate
-		int duration = static_cast<int>(static_cast<double>(read) / ((m_samplerate * 2) / 1000000.0));
-		auto end = start + std::chrono::microseconds(duration);
+		uint8_t const* data = nullptr;
+		size_t cb = next_block(data, ((count - read) / 2) * m_samplesize);
+		if(cb == 0) break;
 
-		// Yield until the calculated duration has expired
-		while(std::chrono::steady_clock::now() < end) { std::this_thread::yield(); }
+		size_t const samples = cb / m_samplesize;
+		convert(data, &buffer[read], samples);
+		read += samples * 2;
 	}
 
+	pace(read);
 	return read;
 }
 
@@ -188,19 +466,34 @@ size_t filedevice::read(uint8_t* buffer, size_t count) const
 
 void filedevice::read_async(rtldevice::asynccallback const& callback, uint32_t bufferlength) const
 {
-	std::unique_ptr<uint8_t[]>	buffer(new uint8_t[bufferlength]);		// Input data buffer
+	std::unique_ptr<uint8_t[]>	buffer;			// Sample conversion buffer
+
+	// Unsigned 8-bit samples are delivered directly from the mapped view of the file
+	if(m_format != sampleformat::cu8) buffer.reset(new uint8_t[bufferlength]);
 
 	m_stop = false;
 	m_stopped = false;
+	m_clockbytes = 0;
 
 	try {
 
 		// Continuously read data from the device until the stop condition is set
 		while(m_stop.test(true) == false) {
 
-			// Try to read enough data to fill the input buffer
-			size_t cb = read(&buffer[0], bufferlength);
-			callback(&buffer[0], cb);
+			// The callback is handed the mapped data directly when no conversion is
+			// required; it only has to remain valid until the callback returns
+			uint8_t const* data = nullptr;
+			size_t cb = next_block(data, (bufferlength / 2) * m_samplesize);
+
+			// At the end of the file there is nothing more to deliver, wait for the stop
+			// condition rather than repeatedly invoking the callback with no data
+			if(cb == 0) { m_stop.wait_until_equals(true); break; }
+
+			size_t const samples = cb / m_samplesize;
+			if(buffer) { convert(data, &buffer[0], samples); data = &buffer[0]; }
+
+			pace(samples * 2);
+			callback(data, samples * 2);
 		}
 
 		m_stopped = true;							// Operation has been stopped
@@ -210,6 +503,140 @@ void filedevice::read_async(rtldevice::asynccallback const& callback, uint32_t b
 	catch(...) { m_stopped = true; throw; }
 }
 
+//---------------------------------------------------------------------------
+// filedevice::read_sigmf (private, static)
+//
+// Reads the metadata of a SigMF recording
+//
+// Arguments:
+//
+//	metafile	- SigMF metadata file name
+//	format		- Receives the sample format
+//	samplerate	- Receives the sample rate
+//	dataoffset	- Receives the offset of the samples in the data file
+
+void filedevice::read_sigmf(std::string const& metafile, enum sampleformat& format, uint32_t& samplerate, uint64_t& dataoffset)
+{
+	rapidjson::Document		document;			// SigMF metadata document
+	std::string				json;				// SigMF metadata text
+
+	// The metadata file is small, just read the whole thing into memory
+	FILE* file = fopen(metafile.c_str(), "rb");
+	if(file == nullptr) throw string_exception(__func__, ": unable to open SigMF metadata file ", metafile.c_str());
+
+	char buffer[4096];
+	size_t read = 0;
+	while((read = fread(buffer, 1, sizeof(buffer), file)) > 0) json.append(buffer, read);
+	fclose(file);
+
+	document.Parse(json.c_str());
+	if(document.HasParseError()) throw string_exception(__func__, ": SigMF metadata parse error - ",
+		rapidjson::GetParseError_En(document.GetParseError()));
+
+	if(!document.IsObject() || !document.HasMember("global") || !document["global"].IsObject())
+		throw string_exception(__func__, ": SigMF metadata does not contain a global object");
+
+	auto const& global = document["global"];
+
+	// core:datatype (required)
+	if(!global.HasMember("core:datatype") || !global["core:datatype"].IsString())
+		throw string_exception(__func__, ": SigMF metadata does not specify core:datatype");
+
+	std::string datatype(global["core:datatype"].GetString());
+	if(datatype == "cu8") format = sampleformat::cu8;
+	else if(datatype == "ci8") format = sampleformat::cs8;
+	else if(datatype == "ci16_le") format = sampleformat::cs16;
+	else if(datatype == "cf32_le") format = sampleformat::cf32;
+	else throw string_exception(__func__, ": unsupported SigMF datatype ", datatype.c_str());
+
+	// core:sample_rate (optional)
+	if(global.HasMember("core:sample_rate") && global["core:sample_rate"].IsNumber())
+		samplerate = static_cast<uint32_t>(global["core:sample_rate"].GetDouble());
+
+	// core:header_bytes (optional) is specified in the first capture segment
+	if(document.HasMember("captures") && document["captures"].IsArray() && !document["captures"].Empty()) {
+
+		auto const& capture = document["captures"][0];
+		if(capture.IsObject() && capture.HasMember("core:header_bytes") && capture["core:header_bytes"].IsUint64())
+			dataoffset = capture["core:header_bytes"].GetUint64();
+	}
+}
+
+//---------------------------------------------------------------------------
+// filedevice::read_wav (private)
+//
+// Reads the header of a WAV file
+//
+// Arguments:
+//
+//	format		- Receives the sample format
+//	samplerate	- Receives the sample rate
+//	dataoffset	- Receives the offset of the samples in the file
+//	datasize	- Receives the size of the samples in the file
+
+bool filedevice::read_wav(enum sampleformat& format, uint32_t& samplerate, uint64_t& dataoffset, uint64_t& datasize) const
+{
+	if(m_filesize < 12) return false;
+
+	// The header is always within the first view of the file
+	map_view(0);
+	uint8_t const* header = m_view;
+	uint64_t const length = m_viewlength;
+
+	if((memcmp(&header[0], "RIFF", 4) != 0) || (memcmp(&header[8], "WAVE", 4) != 0)) return false;
+
+	auto u16 = [&](uint64_t offset) -> uint16_t { return static_cast<uint16_t>(header[offset] | (header[offset + 1] << 8)); };
+	auto u32 = [&](uint64_t offset) -> uint32_t { return static_cast<uint32_t>(u16(offset) | (u16(offset + 2) << 16)); };
+
+	bool hasformat = false;
+	uint64_t offset = 12;
+
+	// Walk the RIFF chunks looking for the format and the data chunks
+	while(offset + 8 <= length) {
+
+		uint32_t const chunksize = u32(offset + 4);
+
+		if(memcmp(&header[offset], "fmt ", 4) == 0) {
+
+			if((chunksize < 16) || (offset + 8 + 16 > length)) throw string_exception(__func__, ": invalid WAV format chunk");
+
+			uint16_t tag = u16(offset + 8);
+			uint16_t const channels = u16(offset + 10);
+			uint16_t const bits = u16(offset + 22);
+
+			// WAVE_FORMAT_EXTENSIBLE carries the actual format tag in the sub-format GUID
+			if((tag == 0xFFFE) && (chunksize >= 40) && (offset + 8 + 26 <= length)) tag = u16(offset + 8 + 24);
+
+			if(channels != 2) throw string_exception(__func__, ": WAV file must contain two channels of I/Q samples");
+
+			if((tag == 1) && (bits == 8)) format = sampleformat::cu8;
+			else if((tag == 1) && (bits == 16)) format = sampleformat::cs16;
+			else if((tag == 3) && (bits == 32)) format = sampleformat::cf32;
+			else throw string_exception(__func__, ": unsupported WAV sample format");
+
+			samplerate = u32(offset + 12);
+			hasformat = true;
+		}
+
+		else if(memcmp(&header[offset], "data", 4) == 0) {
+
+			if(!hasformat) throw string_exception(__func__, ": WAV file has no format chunk");
+
+			// Recorders that are interrupted may leave the chunk size unset or too large,
+			// in which case the samples run to the end of the file
+			dataoffset = offset + 8;
+			datasize = std::min(static_cast<uint64_t>(chunksize), m_filesize - std::min(dataoffset, m_filesize));
+			if(chunksize == 0) datasize = m_filesize - std::min(dataoffset, m_filesize);
+
+			return true;
+		}
+
+		offset += 8 + chunksize + (chunksize & 1);
+	}
+
+	throw string_exception(__func__, ": WAV file has no data chunk");
+}
+
 //---------------------------------------------------------------------------
 // filedevice::set_automatic_gain_control
 //
@@ -237,6 +664,21 @@ uint32_t filedevice::set_center_frequency(uint32_t hz) const
 	return hz;
 }
 
+//---------------------------------------------------------------------------
+// filedevice::set_decimation
+//
+// Sets the frequency offset and decimation factor applied by the device
+//
+// Arguments:
+//
+//	offset		- Frequency offset to shift to zero, specified in hertz
+//	factor		- Requested decimation factor
+
+uint32_t filedevice::set_decimation(int /*offset*/, uint32_t /*factor*/) const
+{
+	return 1;				// Decimation is not supported
+}
+
 //---------------------------------------------------------------------------
 // filedevice::set_frequency_correction
 //
@@ -292,6 +734,30 @@ void filedevice::set_test_mode(bool /*enable*/) const
 {
 }
 
+//---------------------------------------------------------------------------
+// filedevice::unmap_view (private)
+//
+// Unmaps the current view of the file
+//
+// Arguments:
+//
+//	NONE
+
+void filedevice::unmap_view(void) const
+{
+	if(m_view == nullptr) return;
+
+#ifdef _WINDOWS
+	UnmapViewOfFile(m_view);
+#else
+	munmap(const_cast<uint8_t*>(m_view), m_viewlength);
+#endif
+
+	m_view = nullptr;
+	m_viewoffset = 0;
+	m_viewlength = 0;
+}
+
 //---------------------------------------------------------------------------
 
 #pragma warning(pop)
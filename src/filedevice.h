@@ -24,6 +24,7 @@
 #define __FILEDEVICE_H_
 #pragma once
 
+#include <chrono>
 #include <memory>
 #include <string>
 #include <vector>
@@ -39,7 +40,14 @@
 // Implements a dummy device that reads the I/Q samples from a file.  This is
 // only intended for debugging purposes as there is no control over the 
 // parameters like frequency, sample rate, etc; those will have been set at
-// the time when the file was captured
+// the time when the file was captured.  The file is memory mapped in windows
+// and delivered either at the captured sample rate or as fast as it can be
+// consumed, which allows a capture to be used as a throughput benchmark.
+//
+// In addition to raw unsigned 8-bit I/Q files, SigMF recordings and WAV files
+// are recognized from their metadata, and raw files named with a .cs8, .cs16,
+// or .cf32 extension are recognized by name; samples in other formats are
+// converted into unsigned 8-bit I/Q as they are read
 
 class filedevice : public rtldevice
 {
@@ -65,7 +73,7 @@ public:
 	// create (static)
 	//
 	// Factory method, creates a new filedevice instance
-	static std::unique_ptr<filedevice> create(char const* filename, uint32_t samplerate);
+	static std::unique_ptr<filedevice> create(char const* filename, uint32_t samplerate, bool realtime);
 
 	// get_device_name
 	//
@@ -97,6 +105,11 @@ public:
 	// Sets the center frequency of the device
 	uint32_t set_center_frequency(uint32_t hz) const override;
 
+	// set_decimation
+	//
+	// Sets the frequency offset and decimation factor applied by the device
+	uint32_t set_decimation(int offset, uint32_t factor) const override;
+
 	// set_frequency_correction
 	//
 	// Sets the frequency correction of the device
@@ -122,16 +135,109 @@ private:
 	filedevice(filedevice const&) = delete;
 	filedevice& operator=(filedevice const&) = delete;
 
+	// sampleformat
+	//
+	// Defines the format of the samples in the file
+	enum class sampleformat {
+
+		cu8,						// Unsigned 8-bit I/Q
+		cs8,						// Signed 8-bit I/Q
+		cs16,						// Signed 16-bit little endian I/Q
+		cf32,						// 32-bit little endian floating point I/Q
+	};
+
+	// MAX_PACING_LAG
+	//
+	// Maximum time the consumer can fall behind before the pacing clock is reset
+	static std::chrono::milliseconds const MAX_PACING_LAG;
+
+	// VIEW_SIZE
+	//
+	// Size of the memory mapped view of the file
+	static size_t const VIEW_SIZE;
+
 	// Instance Constructor
 	//
-	filedevice(char const* filename, uint32_t samplerate);
+	filedevice(char const* filename, uint32_t samplerate, bool realtime);
+
+	//-----------------------------------------------------------------------
+	// Private Member Functions
+
+	// convert
+	//
+	// Converts samples from the file into unsigned 8-bit I/Q samples
+	void convert(uint8_t const* in, uint8_t* out, size_t samples) const;
+
+	// get_format (static)
+	//
+	// Gets the sample format of a raw file from the file extension
+	static enum sampleformat get_format(std::string const& filename);
+
+	// get_samplesize (static)
+	//
+	// Gets the size of a single I/Q sample in a sample format
+	static size_t get_samplesize(enum sampleformat format);
+
+	// map_view
+	//
+	// Maps the view of the file that contains the specified offset
+	void map_view(uint64_t offset) const;
+
+	// next_block
+	//
+	// Gets the next block of mapped data from the file
+	size_t next_block(uint8_t const*& data, size_t maxcount) const;
+
+	// pace
+	//
+	// Waits until a block of data is due according to the sample rate
+	void pace(size_t count) const;
+
+	// read_sigmf (static)
+	//
+	// Reads the metadata of a SigMF recording
+	static void read_sigmf(std::string const& metafile, enum sampleformat& format, uint32_t& samplerate, uint64_t& dataoffset);
+
+	// read_wav
+	//
+	// Reads the header of a WAV file
+	bool read_wav(enum sampleformat& format, uint32_t& samplerate, uint64_t& dataoffset, uint64_t& datasize) const;
+
+	// unmap_view
+	//
+	// Unmaps the current view of the file
+	void unmap_view(void) const;
 
 	//-----------------------------------------------------------------------
 	// Member Variables
 
 	std::string				m_filename;						// File name
-	uint32_t const			m_samplerate;					// Sample rate
-	FILE*					m_file = nullptr;				// File handle
+	uint32_t				m_samplerate;					// Sample rate
+	bool const				m_realtime;						// Flag to pace at the sample rate
+	uint64_t				m_filesize = 0;					// File size
+	enum sampleformat		m_format = sampleformat::cu8;	// Sample format
+	size_t					m_samplesize = 2;				// Size of each I/Q sample
+	uint64_t				m_dataoffset = 0;				// Offset of the sample data
+	uint64_t				m_datasize = 0;					// Size of the sample data
+	size_t					m_granularity = 0;				// Mapping offset granularity
+#ifdef _WINDOWS
+	HANDLE					m_file = INVALID_HANDLE_VALUE;	// File handle
+	HANDLE					m_mapping = nullptr;			// File mapping handle
+#else
+	int						m_file = -1;					// File descriptor
+#endif
+
+	// MAPPED VIEW
+	//
+	mutable uint8_t const*	m_view = nullptr;				// Mapped view of the file
+	mutable uint64_t		m_viewoffset = 0;				// Offset of the mapped view
+	mutable size_t			m_viewlength = 0;				// Length of the mapped view
+	mutable uint64_t		m_position = 0;					// Current file position
+
+	// PACING
+	//
+	mutable std::chrono::steady_clock::time_point	m_clockstart;		// Pacing clock start
+	mutable uint64_t		m_clockbytes = 0;				// Bytes since clock start
 
 	// ASYNCHRONOUS SUPPORT
 	//
@@ -0,0 +1,578 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2020-2022 Michael G. Brehm
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#include "stdafx.h"
+#include "flacencoder.h"
+
+#include <algorithm>
+#include <assert.h>
+#include <cstdlib>
+#include <limits>
+#include <stdexcept>
+
+#pragma warning(push, 4)
+
+// flacencoder::MAX_BLOCK_SIZE (static)
+//
+// Maximum number of samples per channel that can be encoded in a frame
+size_t const flacencoder::MAX_BLOCK_SIZE = 4608;
+
+// flacencoder::MAX_FIXED_ORDER (static)
+//
+// Highest order fixed predictor to evaluate
+int const flacencoder::MAX_FIXED_ORDER = 4;
+
+// flacencoder::MAX_PARTITION_ORDER (static)
+//
+// Highest Rice partition order to evaluate
+int const flacencoder::MAX_PARTITION_ORDER = 8;
+
+// flacencoder::MAX_RICE_PARAMETER (static)
+//
+// Highest Rice parameter that can be coded without an escape
+int const flacencoder::MAX_RICE_PARAMETER = 14;
+
+//---------------------------------------------------------------------------
+// Class bitwriter (local)
+//
+// Appends most significant bit first bit fields to a byte vector
+
+class bitwriter
+{
+public:
+
+	// Instance Constructor
+	//
+	bitwriter(std::vector<uint8_t>& output) : m_output(output) {}
+
+	// flush
+	//
+	// Pads the final partial byte with zero bits
+	void flush(void)
+	{
+		if(m_count > 0) m_output.push_back(static_cast<uint8_t>(m_buffer << (8 - m_count)));
+		m_buffer = 0;
+		m_count = 0;
+	}
+
+	// write
+	//
+	// Writes the low order bits of a value
+	void write(uint32_t value, int bits)
+	{
+		assert((bits >= 0) && (bits <= 32));
+		if(bits == 0) return;
+
+		m_buffer = (m_buffer << bits) | (value & ((bits == 32) ? 0xFFFFFFFFU : ((1U << bits) - 1)));
+		m_count += bits;
+
+		while(m_count >= 8) {
+
+			m_count -= 8;
+			m_output.push_back(static_cast<uint8_t>(m_buffer >> m_count));
+		}
+
+		m_buffer &= (1U << m_count) - 1;
+	}
+
+	// write_rice
+	//
+	// Writes a Rice coded signed value
+	void write_rice(int32_t value, int parameter)
+	{
+		uint32_t const folded = (static_cast<uint32_t>(value) << 1) ^ static_cast<uint32_t>(value >> 31);
+
+		// The quotient is written in unary as that many zero bits followed by a one bit
+		uint32_t quotient = folded >> parameter;
+		while(quotient >= 32) { write(0, 32); quotient -= 32; }
+		write(1, static_cast<int>(quotient) + 1);
+
+		write(folded, parameter);
+	}
+
+private:
+
+	bitwriter(bitwriter const&) = delete;
+	bitwriter& operator=(bitwriter const&) = delete;
+
+	std::vector<uint8_t>&		m_output;				// Output byte vector
+	uint64_t					m_buffer = 0;			// Pending bits
+	int							m_count = 0;			// Number of pending bits
+};
+
+//---------------------------------------------------------------------------
+// crc8 (local)
+//
+// Calculates the FLAC frame header CRC-8 (polynomial 0x07)
+//
+// Arguments:
+//
+//	data		- Pointer to the data
+//	length		- Length of the data
+
+static uint8_t crc8(uint8_t const* data, size_t length)
+{
+	uint8_t crc = 0;
+
+	while(length--) {
+
+		crc ^= *data++;
+		for(int bit = 0; bit < 8; bit++) crc = static_cast<uint8_t>((crc & 0x80) ? ((crc << 1) ^ 0x07) : (crc << 1));
+	}
+
+	return crc;
+}
+
+//---------------------------------------------------------------------------
+// crc16 (local)
+//
+// Calculates the FLAC frame footer CRC-16 (polynomial 0x8005)
+//
+// Arguments:
+//
+//	data		- Pointer to the data
+//	length		- Length of the data
+
+static uint16_t crc16(uint8_t const* data, size_t length)
+{
+	uint16_t crc = 0;
+
+	while(length--) {
+
+		crc ^= static_cast<uint16_t>(*data++ << 8);
+		for(int bit = 0; bit < 8; bit++) crc = static_cast<uint16_t>((crc & 0x8000) ? ((crc << 1) ^ 0x8005) : (crc << 1));
+	}
+
+	return crc;
+}
+
+//---------------------------------------------------------------------------
+// fixed_residual (local)
+//
+// Calculates the residual of a fixed polynomial predictor at a single sample
+//
+// Arguments:
+//
+//	samples		- Pointer to the sample being predicted
+//	order		- Fixed predictor order
+
+inline int32_t fixed_residual(int32_t const* samples, int order)
+{
+	switch(order) {
+
+		case 0: return samples[0];
+		case 1: return samples[0] - samples[-1];
+		case 2: return samples[0] - (2 * samples[-1]) + samples[-2];
+		case 3: return samples[0] - (3 * samples[-1]) + (3 * samples[-2]) - samples[-3];
+		case 4: return samples[0] - (4 * samples[-1]) + (6 * samples[-2]) - (4 * samples[-3]) + samples[-4];
+	}
+
+	assert(false);
+	return 0;
+}
+
+//---------------------------------------------------------------------------
+// rice_bits (local)
+//
+// Calculates the length of a range of Rice coded residuals
+//
+// Arguments:
+//
+//	residual	- Pointer to the residuals
+//	count		- Number of residuals
+//	parameter	- Rice parameter
+
+static uint64_t rice_bits(int32_t const* residual, size_t count, int parameter)
+{
+	uint64_t bits = static_cast<uint64_t>(count) * static_cast<uint64_t>(parameter + 1);
+
+	for(size_t index = 0; index < count; index++) {
+
+		uint32_t const folded = (static_cast<uint32_t>(residual[index]) << 1) ^ static_cast<uint32_t>(residual[index] >> 31);
+		bits += folded >> parameter;
+	}
+
+	return bits;
+}
+
+//---------------------------------------------------------------------------
+// flacencoder Constructor (private)
+//
+// Arguments:
+//
+//	channels		- Number of interleaved channels
+//	samplerate		- Sample rate of the audio
+
+flacencoder::flacencoder(int channels, int samplerate) : m_channels(channels), m_samplerate(samplerate), m_samplenumber(0)
+{
+	if((channels < 1) || (channels > 8)) throw std::invalid_argument("channels");
+
+	// Sample rates above 65535Hz can only be expressed in the frame header in tens of Hertz
+	if((samplerate <= 0) || (samplerate > 655350) || ((samplerate > 65535) && ((samplerate % 10) != 0))) throw std::invalid_argument("samplerate");
+
+	// Stereo frames require two additional working channels for the mid and side signals
+	m_subframes.resize(static_cast<size_t>(channels + ((channels == 2) ? 2 : 0)));
+}
+
+//---------------------------------------------------------------------------
+// flacencoder Destructor
+
+flacencoder::~flacencoder()
+{
+}
+
+//---------------------------------------------------------------------------
+// flacencoder::analyze (private, static)
+//
+// Selects the smallest encoding for a single channel of samples
+//
+// Arguments:
+//
+//	subframe		- Subframe with the source samples to be analyzed
+
+void flacencoder::analyze(struct subframe_t& subframe)
+{
+	std::vector<int32_t> const& samples = subframe.samples;
+	size_t const blocksize = samples.size();
+	assert(blocksize > 0);
+
+	// Silence (or any other constant signal) only requires a single sample
+	if(std::all_of(samples.begin(), samples.end(), [&](int32_t sample) -> bool { return sample == samples[0]; })) {
+
+		subframe.type = subframetype::constant;
+		subframe.bits = 8 + static_cast<uint64_t>(subframe.bps);
+		return;
+	}
+
+	// Verbatim is the fallback for signals that can't be predicted at all
+	subframe.type = subframetype::verbatim;
+	subframe.bits = 8 + (static_cast<uint64_t>(subframe.bps) * blocksize);
+
+	// Choose the fixed predictor order with the smallest total absolute residual; all orders are
+	// compared over the same range of samples so that the warm-up samples don't skew the result
+	int const maxorder = std::min(MAX_FIXED_ORDER, static_cast<int>(blocksize) - 1);
+	uint64_t bestsum = std::numeric_limits<uint64_t>::max();
+	int order = 0;
+
+	for(int candidate = 0; candidate <= maxorder; candidate++) {
+
+		uint64_t sum = 0;
+		for(size_t index = static_cast<size_t>(maxorder); index < blocksize; index++)
+			sum += static_cast<uint64_t>(std::abs(static_cast<int64_t>(fixed_residual(&samples[index], candidate))));
+
+		if(sum < bestsum) { bestsum = sum; order = candidate; }
+	}
+
+	subframe.residual.resize(blocksize - static_cast<size_t>(order));
+	for(size_t index = static_cast<size_t>(order); index < blocksize; index++)
+		subframe.residual[index - order] = fixed_residual(&samples[index], order);
+
+	// Find the Rice partition order and parameters that produce the shortest residual
+	uint64_t bestbits = std::numeric_limits<uint64_t>::max();
+	std::vector<int> parameters;
+
+	for(int partitionorder = 0; partitionorder <= MAX_PARTITION_ORDER; partitionorder++) {
+
+		// The block has to divide evenly into the partitions and the first partition has
+		// to have at least one residual left after the predictor warm-up samples
+		size_t const partitions = static_cast<size_t>(1) << partitionorder;
+		if(((blocksize % partitions) != 0) || ((blocksize / partitions) <= static_cast<size_t>(order))) break;
+
+		size_t const partitionsize = blocksize / partitions;
+		uint64_t bits = 6;
+		parameters.resize(partitions);
+
+		int32_t const* residual = subframe.residual.data();
+		for(size_t partition = 0; partition < partitions; partition++) {
+
+			size_t const count = (partition == 0) ? partitionsize - static_cast<size_t>(order) : partitionsize;
+
+			// Estimate the Rice parameter from the mean folded residual and check either side of it
+			uint64_t sum = 0;
+			for(size_t index = 0; index < count; index++) sum += (static_cast<uint32_t>(residual[index]) << 1) ^ static_cast<uint32_t>(residual[index] >> 31);
+
+			int estimate = 0;
+			while((estimate < MAX_RICE_PARAMETER) && ((static_cast<uint64_t>(count) << (estimate + 1)) < sum)) estimate++;
+
+			uint64_t partitionbits = std::numeric_limits<uint64_t>::max();
+			for(int parameter = std::max(estimate - 1, 0); parameter <= std::min(estimate + 1, MAX_RICE_PARAMETER); parameter++) {
+
+				uint64_t const candidate = rice_bits(residual, count, parameter);
+				if(candidate < partitionbits) { partitionbits = candidate; parameters[partition] = parameter; }
+			}
+
+			bits += 4 + partitionbits;
+			residual += count;
+		}
+
+		if(bits < bestbits) {
+
+			bestbits = bits;
+			subframe.partitionorder = partitionorder;
+			subframe.parameters = parameters;
+		}
+	}
+
+	// Use the fixed predictor if it's smaller than the verbatim samples
+	uint64_t const fixedbits = 8 + (static_cast<uint64_t>(order) * static_cast<uint64_t>(subframe.bps)) + bestbits;
+	if(fixedbits < subframe.bits) {
+
+		subframe.type = subframetype::fixed;
+		subframe.order = order;
+		subframe.bits = fixedbits;
+	}
+}
+
+//---------------------------------------------------------------------------
+// flacencoder::create (static)
+//
+// Factory method, creates a new flacencoder instance
+//
+// Arguments:
+//
+//	channels		- Number of interleaved channels
+//	samplerate		- Sample rate of the audio
+
+std::unique_ptr<flacencoder> flacencoder::create(int channels, int samplerate)
+{
+	return std::unique_ptr<flacencoder>(new flacencoder(channels, samplerate));
+}
+
+//---------------------------------------------------------------------------
+// flacencoder::encode
+//
+// Encodes a block of interleaved samples into a single FLAC frame
+//
+// Arguments:
+//
+//	samples		- Pointer to the interleaved 16-bit samples
+//	count		- Number of samples per channel
+//	frame		- Receives the encoded frame
+
+void flacencoder::encode(int16_t const* samples, size_t count, std::vector<uint8_t>& frame)
+{
+	if(samples == nullptr) throw std::invalid_argument("samples");
+	if((count == 0) || (count > MAX_BLOCK_SIZE)) throw std::invalid_argument("count");
+
+	size_t const channels = static_cast<size_t>(m_channels);
+
+	// Deinterleave the samples into the working channels
+	for(size_t channel = 0; channel < channels; channel++) {
+
+		struct subframe_t& subframe = m_subframes[channel];
+		subframe.bps = 16;
+		subframe.samples.resize(count);
+		for(size_t index = 0; index < count; index++) subframe.samples[index] = samples[(index * channels) + channel];
+	}
+
+	// Independent channels are coded as the number of channels minus one
+	int assignment = m_channels - 1;
+	struct subframe_t* first = &m_subframes[0];
+	struct subframe_t* second = (m_channels == 2) ? &m_subframes[1] : nullptr;
+
+	for(size_t channel = 0; channel < channels; channel++) analyze(m_subframes[channel]);
+
+	// Stereo frames pick whichever of left/right, left/side, right/side or mid/side is smallest;
+	// the side channel requires one more bit per sample than the source channels
+	if(m_channels == 2) {
+
+		struct subframe_t& left = m_subframes[0];
+		struct subframe_t& right = m_subframes[1];
+		struct subframe_t& mid = m_subframes[2];
+		struct subframe_t& side = m_subframes[3];
+
+		mid.bps = 16;
+		side.bps = 17;
+		mid.samples.resize(count);
+		side.samples.resize(count);
+
+		for(size_t index = 0; index < count; index++) {
+
+			mid.samples[index] = (left.samples[index] + right.samples[index]) >> 1;
+			side.samples[index] = left.samples[index] - right.samples[index];
+		}
+
+		analyze(mid);
+		analyze(side);
+
+		uint64_t bits = left.bits + right.bits;
+		if(left.bits + side.bits < bits) { bits = left.bits + side.bits; assignment = 8; first = &left; second = &side; }
+		if(side.bits + right.bits < bits) { bits = side.bits + right.bits; assignment = 9; first = &side; second = &right; }
+		if(mid.bits + side.bits < bits) { bits = mid.bits + side.bits; assignment = 10; first = &mid; second = &side; }
+	}
+
+	frame.clear();
+	write_header(count, assignment, frame);
+
+	bitwriter writer(frame);
+
+	for(size_t channel = 0; channel < channels; channel++) {
+
+		struct subframe_t const& subframe = (channel == 0) ? *first : ((channel == 1) && second) ? *second : m_subframes[channel];
+
+		// Subframe header: zero padding bit, subframe type and no wasted bits
+		writer.write(0, 1);
+		writer.write(static_cast<uint32_t>(subframe.type) + static_cast<uint32_t>((subframe.type == subframetype::fixed) ? subframe.order : 0), 6);
+		writer.write(0, 1);
+
+		if(subframe.type == subframetype::constant) writer.write(static_cast<uint32_t>(subframe.samples[0]), subframe.bps);
+
+		else if(subframe.type == subframetype::verbatim) {
+
+			for(auto const& sample : subframe.samples) writer.write(static_cast<uint32_t>(sample), subframe.bps);
+		}
+
+		else {
+
+			// Warm-up samples for the predictor
+			for(int index = 0; index < subframe.order; index++) writer.write(static_cast<uint32_t>(subframe.samples[index]), subframe.bps);
+
+			// Residual: 4-bit Rice parameter coding method and the partition order
+			writer.write(0, 2);
+			writer.write(static_cast<uint32_t>(subframe.partitionorder), 4);
+
+			size_t const partitions = static_cast<size_t>(1) << subframe.partitionorder;
+			size_t const partitionsize = count / partitions;
+			int32_t const* residual = subframe.residual.data();
+
+			for(size_t partition = 0; partition < partitions; partition++) {
+
+				size_t const residuals = (partition == 0) ? partitionsize - static_cast<size_t>(subframe.order) : partitionsize;
+				int const parameter = subframe.parameters[partition];
+
+				writer.write(static_cast<uint32_t>(parameter), 4);
+				for(size_t index = 0; index < residuals; index++) writer.write_rice(*residual++, parameter);
+			}
+		}
+	}
+
+	// The frame is padded to a byte boundary and followed by the CRC-16 of the entire frame
+	writer.flush();
+
+	uint16_t const crc = crc16(frame.data(), frame.size());
+	frame.push_back(static_cast<uint8_t>(crc >> 8));
+	frame.push_back(static_cast<uint8_t>(crc & 0xFF));
+
+	m_samplenumber += count;
+}
+
+//---------------------------------------------------------------------------
+// flacencoder::reset
+//
+// Resets the encoder sample position
+//
+// Arguments:
+//
+//	NONE
+
+void flacencoder::reset(void)
+{
+	m_samplenumber = 0;
+}
+
+//---------------------------------------------------------------------------
+// flacencoder::write_header (private)
+//
+// Writes the frame header for the frame being encoded
+//
+// Arguments:
+//
+//	blocksize		- Number of samples per channel in the frame
+//	assignment		- Channel assignment code
+//	frame			- Frame to write the header into
+
+void flacencoder::write_header(size_t blocksize, int assignment, std::vector<uint8_t>& frame) const
+{
+	assert((blocksize > 0) && (blocksize <= 65536));
+
+	// Common block sizes have their own codes, anything else is appended to the header
+	int blocksizecode = (blocksize <= 256) ? 6 : 7;
+	switch(blocksize) {
+
+		case 192: blocksizecode = 1; break;
+		case 576: blocksizecode = 2; break;
+		case 1152: blocksizecode = 3; break;
+		case 2304: blocksizecode = 4; break;
+		case 4608: blocksizecode = 5; break;
+		case 256: blocksizecode = 8; break;
+		case 512: blocksizecode = 9; break;
+		case 1024: blocksizecode = 10; break;
+		case 2048: blocksizecode = 11; break;
+		case 4096: blocksizecode = 12; break;
+	}
+
+	// Common sample rates have their own codes, anything else is appended to the header
+	int sampleratecode = ((m_samplerate % 1000) == 0 && (m_samplerate / 1000) <= 255) ? 12 : (m_samplerate <= 65535) ? 13 : 14;
+	switch(m_samplerate) {
+
+		case 88200: sampleratecode = 1; break;
+		case 176400: sampleratecode = 2; break;
+		case 192000: sampleratecode = 3; break;
+		case 8000: sampleratecode = 4; break;
+		case 16000: sampleratecode = 5; break;
+		case 22050: sampleratecode = 6; break;
+		case 24000: sampleratecode = 7; break;
+		case 32000: sampleratecode = 8; break;
+		case 44100: sampleratecode = 9; break;
+		case 48000: sampleratecode = 10; break;
+		case 96000: sampleratecode = 11; break;
+	}
+
+	// Sync code with the variable block size strategy, the frames are identified by sample number
+	frame.push_back(0xFF);
+	frame.push_back(0xF9);
+	frame.push_back(static_cast<uint8_t>((blocksizecode << 4) | sampleratecode));
+	frame.push_back(static_cast<uint8_t>((assignment << 4) | (4 << 1)));		// 16 bits per sample
+
+	// The sample number is coded like an extended UTF-8 character of up to 36 bits
+	uint64_t const number = m_samplenumber & 0xFFFFFFFFFULL;
+	if(number < 0x80) frame.push_back(static_cast<uint8_t>(number));
+	else {
+
+		int bytes = 2;
+		while((bytes < 7) && (number >= (1ULL << ((5 * bytes) + 1)))) bytes++;
+
+		frame.push_back(static_cast<uint8_t>(((0xFF00 >> bytes) & 0xFF) | (number >> (6 * (bytes - 1)))));
+		for(int index = bytes - 2; index >= 0; index--) frame.push_back(static_cast<uint8_t>(0x80 | ((number >> (6 * index)) & 0x3F)));
+	}
+
+	if(blocksizecode == 6) frame.push_back(static_cast<uint8_t>(blocksize - 1));
+	else if(blocksizecode == 7) {
+
+		frame.push_back(static_cast<uint8_t>((blocksize - 1) >> 8));
+		frame.push_back(static_cast<uint8_t>((blocksize - 1) & 0xFF));
+	}
+
+	if(sampleratecode == 12) frame.push_back(static_cast<uint8_t>(m_samplerate / 1000));
+	else if(sampleratecode >= 13) {
+
+		int const value = (sampleratecode == 13) ? m_samplerate : (m_samplerate / 10);
+		frame.push_back(static_cast<uint8_t>(value >> 8));
+		frame.push_back(static_cast<uint8_t>(value & 0xFF));
+	}
+
+	frame.push_back(crc8(frame.data(), frame.size()));
+}
+
+//---------------------------------------------------------------------------
+
+#pragma warning(pop)
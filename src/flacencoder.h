@@ -0,0 +1,154 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2020-2022 Michael G. Brehm
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#ifndef __FLACENCODER_H_
+#define __FLACENCODER_H_
+#pragma once
+
+#include <memory>
+#include <stdint.h>
+#include <vector>
+
+#pragma warning(push, 4)
+
+//---------------------------------------------------------------------------
+// Class flacencoder
+//
+// Implements a minimal FLAC encoder for 16-bit PCM audio; each block of samples
+// is encoded as a single self-contained frame using the fixed predictors and
+// partitioned Rice coding, with the best stereo decorrelation chosen per frame.
+// No STREAMINFO block is generated, the frame headers carry everything that the
+// decoder needs to decode the frames
+
+class flacencoder
+{
+public:
+
+	// Destructor
+	//
+	~flacencoder();
+
+	//-----------------------------------------------------------------------
+	// Member Functions
+
+	// create (static)
+	//
+	// Factory method, creates a new flacencoder instance
+	static std::unique_ptr<flacencoder> create(int channels, int samplerate);
+
+	// encode
+	//
+	// Encodes a block of interleaved samples into a single FLAC frame
+	void encode(int16_t const* samples, size_t count, std::vector<uint8_t>& frame);
+
+	// reset
+	//
+	// Resets the encoder sample position
+	void reset(void);
+
+	//-----------------------------------------------------------------------
+	// Constants
+
+	// MAX_BLOCK_SIZE
+	//
+	// Maximum number of samples per channel that can be encoded in a frame
+	static size_t const MAX_BLOCK_SIZE;
+
+private:
+
+	flacencoder(flacencoder const&) = delete;
+	flacencoder& operator=(flacencoder const&) = delete;
+
+	// MAX_FIXED_ORDER
+	//
+	// Highest order fixed predictor to evaluate
+	static int const MAX_FIXED_ORDER;
+
+	// MAX_PARTITION_ORDER
+	//
+	// Highest Rice partition order to evaluate
+	static int const MAX_PARTITION_ORDER;
+
+	// MAX_RICE_PARAMETER
+	//
+	// Highest Rice parameter that can be coded without an escape
+	static int const MAX_RICE_PARAMETER;
+
+	// Instance Constructor
+	//
+	flacencoder(int channels, int samplerate);
+
+	//-----------------------------------------------------------------------
+	// Private Type Declarations
+
+	// subframetype
+	//
+	// Defines the type of an encoded subframe
+	enum class subframetype {
+
+		constant		= 0,		// Every sample has the same value
+		verbatim		= 1,		// Unencoded samples
+		fixed			= 8,		// Fixed polynomial predictor
+	};
+
+	// subframe_t
+	//
+	// Defines the encoding chosen for a single channel of a frame
+	struct subframe_t {
+
+		enum subframetype		type;				// Subframe type
+		int						order;				// Fixed predictor order
+		int						bps;				// Bits per sample
+		int						partitionorder;		// Rice partition order
+		std::vector<int>		parameters;			// Rice parameters for each partition
+		std::vector<int32_t>	samples;			// Source samples
+		std::vector<int32_t>	residual;			// Prediction residual
+		uint64_t				bits;				// Encoded length in bits
+	};
+
+	//-----------------------------------------------------------------------
+	// Private Member Functions
+
+	// analyze (static)
+	//
+	// Selects the smallest encoding for a single channel of samples
+	static void analyze(struct subframe_t& subframe);
+
+	// write_header
+	//
+	// Writes the frame header for the frame being encoded
+	void write_header(size_t blocksize, int assignment, std::vector<uint8_t>& frame) const;
+
+	//-----------------------------------------------------------------------
+	// Member Variables
+
+	int const						m_channels;			// Number of channels
+	int const						m_samplerate;		// Sample rate
+	uint64_t						m_samplenumber;		// Number of the next sample
+	std::vector<struct subframe_t>	m_subframes;		// Per-channel working state
+};
+
+//-----------------------------------------------------------------------------
+
+#pragma warning(pop)
+
+#endif	// __FLACENCODER_H_
@@ -0,0 +1,337 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2020-2022 Michael G. Brehm
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#include "stdafx.h"
+#include "fmchannelbank.h"
+
+#include <algorithm>
+#include <assert.h>
+#include <cmath>
+
+#include "string_exception.h"
+
+#pragma warning(push, 4)
+
+// fmchannelbank::CHANNEL_BANDWIDTH (static)
+//
+// Bandwidth of a single wideband FM channel
+uint32_t const fmchannelbank::CHANNEL_BANDWIDTH = 200000;
+
+//---------------------------------------------------------------------------
+// fmchannelbank Constructor (private)
+//
+// Arguments:
+//
+//	samplerate			- Device sample rate in Hertz
+//	centerfrequency		- Device center frequency in Hertz
+//	frequencies			- Frequencies of the channels to demodulate
+//	fmprops				- FM digital signal processor properties
+//	onaudio				- Callback to receive the demodulated audio
+//	onrds				- Callback to receive the RDS group data
+
+fmchannelbank::fmchannelbank(uint32_t samplerate, uint32_t centerfrequency, std::vector<uint32_t> const& frequencies,
+	struct fmprops const& fmprops, audiocallback const& onaudio, rdscallback const& onrds) : m_onaudio(onaudio), m_onrds(onrds)
+{
+	if(frequencies.empty()) throw std::invalid_argument("frequencies");
+
+	// Use an even number of channels with a spacing as close to the FM channel bandwidth as
+	// the sample rate allows and decimate by half of that; each channel is then oversampled by
+	// a factor of two, which leaves the demodulator room for the full multiplex signal
+	size_t const channels = std::max(static_cast<size_t>(2), static_cast<size_t>(std::lround(samplerate / (2.0 * CHANNEL_BANDWIDTH))) * 2);
+	m_channelizer = channelizer::create(samplerate, channels, channels / 2);
+
+	// Initialize the demodulator parameters
+	//
+	tDemodInfo demodinfo = {};
+	demodinfo.HiCutmax = 100000;
+	demodinfo.HiCut = 100000;
+	demodinfo.LowCut = -100000;
+	demodinfo.SquelchValue = -160;
+	demodinfo.WfmDownsampleQuality = static_cast<enum DownsampleQuality>(fmprops.downsamplequality);
+
+	uint32_t const maxoffset = maxbandwidth(samplerate) / 2;
+	for(auto const& frequency : frequencies) {
+
+		// Each channel must fall entirely within the usable bandwidth of the capture
+		double const offset = static_cast<double>(frequency) - static_cast<double>(centerfrequency);
+		if(std::abs(offset) > maxoffset) throw string_exception(__func__, ": channel frequency ", frequency, " is outside of the device bandwidth");
+
+		channel_t channel = {};
+		channel.frequency = frequency;
+		channel.samples = nullptr;
+		channel.index = m_channelizer->channelindex(offset);
+
+		// Create a wideband FM demodulator for the channel; any difference between the channel frequency
+		// and the center of the channelizer output is removed by the demodulator down converter
+		channel.demodulator = std::unique_ptr<CDemodulator>(new CDemodulator());
+		channel.demodulator->SetUSFmVersion(fmprops.isnorthamerica);
+		channel.demodulator->SetInputSampleRate(static_cast<TYPEREAL>(m_channelizer->outputrate()));
+		channel.demodulator->SetDemod(DEMOD_WFM, demodinfo);
+		channel.demodulator->SetDemodFreq(static_cast<TYPEREAL>(m_channelizer->channeloffset(channel.index) - offset));
+
+		m_channels.emplace_back(std::move(channel));
+	}
+
+	// The thread supplying the input samples also demodulates channels, only create
+	// enough workers to put the remaining cores to use
+	size_t const cores = std::max(1U, std::thread::hardware_concurrency());
+	size_t const workers = std::min(m_channels.size(), cores) - 1;
+	for(size_t index = 0; index < workers; index++) m_workers.emplace_back(&fmchannelbank::worker, this);
+}
+
+//---------------------------------------------------------------------------
+// fmchannelbank Destructor
+
+fmchannelbank::~fmchannelbank()
+{
+	std::unique_lock<std::mutex> lock(m_lock);
+	m_stop = true;
+	m_cv.notify_all();
+	lock.unlock();
+
+	for(auto& worker : m_workers) worker.join();
+}
+
+//---------------------------------------------------------------------------
+// fmchannelbank::create (static)
+//
+// Factory method, creates a new fmchannelbank instance
+//
+// Arguments:
+//
+//	samplerate			- Device sample rate in Hertz
+//	centerfrequency		- Device center frequency in Hertz
+//	frequencies			- Frequencies of the channels to demodulate
+//	fmprops				- FM digital signal processor properties
+//	onaudio				- Callback to receive the demodulated audio
+//	onrds				- Callback to receive the RDS group data
+
+std::unique_ptr<fmchannelbank> fmchannelbank::create(uint32_t samplerate, uint32_t centerfrequency, std::vector<uint32_t> const& frequencies,
+	struct fmprops const& fmprops, audiocallback const& onaudio, rdscallback const& onrds)
+{
+	return std::unique_ptr<fmchannelbank>(new fmchannelbank(samplerate, centerfrequency, frequencies, fmprops, onaudio, onrds));
+}
+
+//---------------------------------------------------------------------------
+// fmchannelbank::demodulate_channel (private)
+//
+// Demodulates the current channelizer output for a single channel
+//
+// Arguments:
+//
+//	channel		- Channel to be demodulated
+
+void fmchannelbank::demodulate_channel(channel_t& channel) const
+{
+	channel.audiocount = 0;
+	channel.rdsgroups.clear();
+
+	if((channel.samples == nullptr) || (channel.count == 0)) return;
+
+	// Without an audio callback only the RDS data needs to be recovered
+	if(m_onaudio) {
+
+		// The demodulator holds back partial input blocks, so the output may be as large
+		// as the input plus one additional input block
+		size_t const required = channel.count + channel.demodulator->GetInputBufferLimit();
+		if(channel.audio.size() < required) channel.audio.resize(required);
+
+		int const audiocount = channel.demodulator->ProcessData(static_cast<int>(channel.count), channel.samples, channel.audio.data());
+		if(audiocount > 0) channel.audiocount = static_cast<size_t>(audiocount);
+	}
+
+	else channel.demodulator->ProcessRdsData(static_cast<int>(channel.count), channel.samples);
+
+	// Collect any RDS group data that was recovered during demodulation
+	tRDS_GROUPS rdsgroup = {};
+	while(channel.demodulator->GetNextRdsGroupData(&rdsgroup)) channel.rdsgroups.push_back(rdsgroup);
+}
+
+//---------------------------------------------------------------------------
+// fmchannelbank::demodulate_channels (private)
+//
+// Demodulates channels until there are none left in the current batch
+//
+// Arguments:
+//
+//	NONE
+
+void fmchannelbank::demodulate_channels(void)
+{
+	try {
+
+		for(size_t index = m_next++; index < m_channels.size(); index = m_next++) demodulate_channel(m_channels[index]);
+	}
+
+	catch(...) {
+
+		std::unique_lock<std::mutex> lock(m_lock);
+		if(!m_exception) m_exception = std::current_exception();
+	}
+}
+
+//---------------------------------------------------------------------------
+// fmchannelbank::inputsamples
+//
+// Pipes input samples into the channel bank
+//
+// Arguments:
+//
+//	samples		- Pointer to the input samples
+//	length		- Length of the input samples, in bytes
+
+void fmchannelbank::inputsamples(uint8_t const* samples, size_t length)
+{
+	assert(m_channelizer);
+
+	// channel_callback_func (local)
+	//
+	// Receives the output from the channelizer and assigns it to the channels
+	auto channel_callback_func = [&](size_t index, TYPECPX* channelsamples, size_t count) -> void {
+
+		for(auto& channel : m_channels) {
+
+			if(channel.index != index) continue;
+
+			channel.samples = channelsamples;
+			channel.count = count;
+		}
+	};
+
+	for(auto& channel : m_channels) { channel.samples = nullptr; channel.count = 0; }
+	m_channelizer->inputsamples(samples, length, channel_callback_func);
+
+	// Demodulate the channels on this thread and any available worker threads; the
+	// channelizer output remains valid until the next call to inputsamples
+	std::unique_lock<std::mutex> lock(m_lock);
+	m_next = 0;
+	m_active = m_workers.size();
+	m_batch++;
+	m_cv.notify_all();
+	lock.unlock();
+
+	demodulate_channels();
+
+	lock.lock();
+	m_donecv.wait(lock, [&]() -> bool { return m_active == 0; });
+	if(m_exception) { std::exception_ptr exception = m_exception; m_exception = nullptr; std::rethrow_exception(exception); }
+	lock.unlock();
+
+	// Invoke the callbacks for each channel from this thread
+	for(auto const& channel : m_channels) {
+
+		if((channel.audiocount > 0) && m_onaudio) m_onaudio(channel.frequency, channel.audio.data(), channel.audiocount);
+		if(m_onrds) for(auto const& rdsgroup : channel.rdsgroups) m_onrds(channel.frequency, rdsgroup);
+	}
+}
+
+//---------------------------------------------------------------------------
+// fmchannelbank::maxbandwidth (static)
+//
+// Gets the maximum span of channel frequencies for a device sample rate
+//
+// Arguments:
+//
+//	samplerate	- Device sample rate in Hertz
+
+uint32_t fmchannelbank::maxbandwidth(uint32_t samplerate)
+{
+	// Channels need to be at least half a channel away from the edges of the capture
+	return (samplerate > CHANNEL_BANDWIDTH) ? samplerate - CHANNEL_BANDWIDTH : 0;
+}
+
+//---------------------------------------------------------------------------
+// fmchannelbank::outputrate
+//
+// Gets the sample rate of the demodulated audio
+//
+// Arguments:
+//
+//	NONE
+
+double fmchannelbank::outputrate(void) const
+{
+	assert(!m_channels.empty());
+	return static_cast<double>(m_channels.front().demodulator->GetOutputRate());
+}
+
+//---------------------------------------------------------------------------
+// fmchannelbank::signalquality
+//
+// Gets the signal quality of a channel as percentages
+//
+// Arguments:
+//
+//	frequency	- Channel frequency
+//	quality		- Receives the signal quality
+//	snr			- Receives the signal-to-noise ratio
+
+void fmchannelbank::signalquality(uint32_t frequency, int& quality, int& snr) const
+{
+	quality = snr = 0;
+
+	auto found = std::find_if(m_channels.begin(), m_channels.end(), [&](channel_t const& channel) -> bool { return channel.frequency == frequency; });
+	if(found == m_channels.end()) return;
+
+	TYPEREAL demodquality = 0;
+	TYPEREAL demodsnr = 0;
+
+	found->demodulator->GetSignalLevels(demodquality, demodsnr);
+
+	// Use the same nominal ranges as fmstream for wideband FM
+	quality = std::max(0, std::min(100, static_cast<int>(100.0 * (demodquality / 0.80))));
+	snr = std::max(0, std::min(100, static_cast<int>(100.0 * (demodsnr / 0.60))));
+}
+
+//---------------------------------------------------------------------------
+// fmchannelbank::worker (private)
+//
+// Worker thread procedure
+//
+// Arguments:
+//
+//	NONE
+
+void fmchannelbank::worker(void)
+{
+	uint64_t batch = 0;
+
+	std::unique_lock<std::mutex> lock(m_lock);
+	while(true) {
+
+		// Wait for a new batch of channels to be demodulated or a stop signal
+		m_cv.wait(lock, [&]() -> bool { return m_stop || (m_batch != batch); });
+		if(m_stop) break;
+
+		batch = m_batch;
+		lock.unlock();
+
+		demodulate_channels();
+
+		lock.lock();
+		if(--m_active == 0) m_donecv.notify_all();
+	}
+}
+
+//---------------------------------------------------------------------------
+
+#pragma warning(pop)
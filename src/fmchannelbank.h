@@ -0,0 +1,174 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2020-2022 Michael G. Brehm
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#ifndef __FMCHANNELBANK_H_
+#define __FMCHANNELBANK_H_
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "fmdsp/demodulator.h"
+
+#include "channelizer.h"
+#include "props.h"
+
+#pragma warning(push, 4)
+
+//---------------------------------------------------------------------------
+// Class fmchannelbank
+//
+// Demodulates several wideband FM channels from a single device capture; the
+// capture is split into 200KHz channels by a polyphase channelizer and each
+// requested channel is fed into its own demodulator instance. The demodulators
+// are run in parallel on a pool of worker threads, the callbacks are always
+// invoked on the thread that supplies the input samples. When no audio callback
+// is provided only the RDS data is recovered from each channel
+
+class fmchannelbank
+{
+public:
+
+	// audiocallback
+	//
+	// Callback function invoked with the demodulated stereo audio of a channel
+	using audiocallback = std::function<void(uint32_t frequency, TYPECPX const* samples, size_t count)>;
+
+	// rdscallback
+	//
+	// Callback function invoked with the RDS group data of a channel
+	using rdscallback = std::function<void(uint32_t frequency, tRDS_GROUPS const& group)>;
+
+	// Destructor
+	//
+	~fmchannelbank();
+
+	//-----------------------------------------------------------------------
+	// Member Functions
+
+	// create (static)
+	//
+	// Factory method, creates a new fmchannelbank instance
+	static std::unique_ptr<fmchannelbank> create(uint32_t samplerate, uint32_t centerfrequency, std::vector<uint32_t> const& frequencies,
+		struct fmprops const& fmprops, audiocallback const& onaudio, rdscallback const& onrds);
+
+	// inputsamples
+	//
+	// Pipes input samples into the channel bank
+	void inputsamples(uint8_t const* samples, size_t length);
+
+	// maxbandwidth (static)
+	//
+	// Gets the maximum span of channel frequencies for a device sample rate
+	static uint32_t maxbandwidth(uint32_t samplerate);
+
+	// outputrate
+	//
+	// Gets the sample rate of the demodulated audio
+	double outputrate(void) const;
+
+	// signalquality
+	//
+	// Gets the signal quality of a channel as percentages
+	void signalquality(uint32_t frequency, int& quality, int& snr) const;
+
+private:
+
+	fmchannelbank(fmchannelbank const&) = delete;
+	fmchannelbank& operator=(fmchannelbank const&) = delete;
+
+	// CHANNEL_BANDWIDTH
+	//
+	// Bandwidth of a single wideband FM channel
+	static uint32_t const CHANNEL_BANDWIDTH;
+
+	// Instance Constructor
+	//
+	fmchannelbank(uint32_t samplerate, uint32_t centerfrequency, std::vector<uint32_t> const& frequencies,
+		struct fmprops const& fmprops, audiocallback const& onaudio, rdscallback const& onrds);
+
+	//-----------------------------------------------------------------------
+	// Private Type Declarations
+
+	// channel_t
+	//
+	// Defines the state of a single demodulated channel
+	struct channel_t {
+
+		uint32_t						frequency;		// Channel frequency
+		size_t							index;			// Channelizer output index
+		std::unique_ptr<CDemodulator>	demodulator;	// Demodulator instance
+		std::vector<TYPECPX>			audio;			// Audio output buffer
+		size_t							audiocount;		// Audio output sample count
+		std::vector<tRDS_GROUPS>		rdsgroups;		// RDS group output
+		TYPECPX*						samples;		// Channelizer output samples
+		size_t							count;			// Channelizer output count
+	};
+
+	//-----------------------------------------------------------------------
+	// Private Member Functions
+
+	// demodulate_channel
+	//
+	// Demodulates the current channelizer output for a single channel
+	void demodulate_channel(channel_t& channel) const;
+
+	// demodulate_channels
+	//
+	// Demodulates channels until there are none left in the current batch
+	void demodulate_channels(void);
+
+	// worker
+	//
+	// Worker thread procedure
+	void worker(void);
+
+	//-----------------------------------------------------------------------
+	// Member Variables
+
+	std::unique_ptr<channelizer>		m_channelizer;	// Channelizer instance
+	std::vector<channel_t>				m_channels;		// Demodulated channels
+	audiocallback const					m_onaudio;		// Audio callback
+	rdscallback const					m_onrds;		// RDS callback
+
+	std::vector<std::thread>			m_workers;		// Worker threads
+	mutable std::mutex					m_lock;			// Synchronization object
+	std::condition_variable				m_cv;			// Batch started condition
+	std::condition_variable				m_donecv;		// Batch finished condition
+	uint64_t							m_batch = 0;	// Current batch number
+	size_t								m_active = 0;	// Number of active workers
+	std::atomic<size_t>					m_next{ 0 };	// Next channel to demodulate
+	std::exception_ptr					m_exception;	// Worker thread exception
+	bool								m_stop = false;	// Flag to stop the workers
+};
+
+//-----------------------------------------------------------------------------
+
+#pragma warning(pop)
+
+#endif	// __FMCHANNELBANK_H_
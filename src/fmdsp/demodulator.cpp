@@ -249,6 +249,28 @@ int ret = 0;
 	return ret;
 }
 
+// Added to recover RDS data without producing any audio
+void CDemodulator::ProcessRdsData(int InLength, TYPECPX* pInData)
+{
+#ifdef FMDSP_THREAD_SAFE
+	std::unique_lock<std::mutex> lock(m_Mutex);
+#endif
+
+	if((m_DemodMode != DEMOD_WFM) || (m_pWFmDemod == nullptr)) return;
+
+	for(int i=0; i<InLength; i++)
+	{	//place in demod buffer
+		m_pDemodInBuf[m_InBufPos++] = pInData[i];
+		if(m_InBufPos >= m_InBufLimit)
+		{	//when have enough samples, perform baseband tuning and decimation
+			int n = m_DownConvert.ProcessData(m_InBufPos, m_pDemodInBuf, m_pDemodInBuf);
+			MeasureSignalQuality(n, m_pDemodInBuf);
+			m_pWFmDemod->ProcessRdsData(n, m_pDemodInBuf);
+			m_InBufPos = 0;
+		}
+	}
+}
+
 // Added to provide a running signal quality calculations
 void CDemodulator::MeasureSignalQuality(int length, TYPECPX* pInData)
 {
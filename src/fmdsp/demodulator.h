@@ -83,6 +83,9 @@ public:
 	int ProcessData(int InLength, TYPECPX* pInData, TYPEREAL* pOutData);
 	int ProcessData(int InLength, TYPECPX* pInData, TYPECPX* pOutData);
 
+	// WFM only, recovers the RDS data without producing any audio
+	void ProcessRdsData(int InLength, TYPECPX* pInData);
+
 	void SetUSFmVersion(bool USFm){m_USFm = USFm;}
 	bool GetUSFmVersion(){return m_USFm;}
 
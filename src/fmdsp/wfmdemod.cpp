@@ -364,6 +364,65 @@ TYPEREAL LminusR;
 		}
         m_PilotLocked = false;
 	}
+	//recover any RDS data from the demodulated signal
+	DecodeRdsData(InLength);
+
+	//decimate by 2's down close to final audio rate
+	if(m_pDecBy2A)
+		InLength = m_pDecBy2A->DecBy2(InLength, pOutData, pOutData);
+	if(m_pDecBy2B)
+		InLength = m_pDecBy2B->DecBy2(InLength, pOutData, pOutData);
+	if(m_pDecBy2C)
+		InLength = m_pDecBy2C->DecBy2(InLength, pOutData, pOutData);
+
+	m_LPFilter.ProcessFilter( InLength, pOutData, pOutData);	//rolloff audio above 15KHz
+	ProcessDeemphasisFilter(InLength, pOutData, pOutData);		//50 or 75uSec de-emphasis one pole filter
+	m_NotchFilter.ProcessFilter( InLength, pOutData, pOutData);	//notch out 19KHz pilot
+	return InLength;
+}
+
+/////////////////////////////////////////////////////////////////////////////////
+//						Process WFM demod RDS only version
+// Process complex I/Q baseband data input by:
+// Perform wideband FM demod into a REAL data stream.
+// Perform REAL to complex filtering to make easier to shift and process signals
+//		within the demodulated FM signal.
+// Recover the RDS data groups without any of the pilot or audio processing; this
+//		is used when only the station identification is needed.
+//
+//		InLength == number of complex input samples in complex array pInData
+//		pInData == pointer to callers complex input array
+//	returns number of samples processed
+/////////////////////////////////////////////////////////////////////////////////
+int CWFmDemod::ProcessRdsData(int InLength, TYPECPX* pInData)
+{
+	for(int i=0; i<InLength; i++)
+	{
+		m_D0 = pInData[i];
+	#ifdef FMDSP_USE_DOUBLE_PRECISION
+		m_RawFm[i] = FMDEMOD_GAIN*MATAN2( (m_D1.re*m_D0.im - m_D0.re*m_D1.im), (m_D1.re*m_D0.re + m_D1.im*m_D0.im));
+	#else
+		m_RawFm[i] = FMDEMOD_GAIN*arctan2( (m_D1.re*m_D0.im - m_D0.re*m_D1.im), (m_D1.re*m_D0.re + m_D1.im*m_D0.im));
+	#endif
+
+		m_D1 = m_D0;
+	}
+
+	//create complex data from demodulator real data
+	m_HilbertFilter.ProcessFilter(InLength, m_RawFm, m_CpxRawFm);
+
+	DecodeRdsData(InLength);
+	return InLength;
+}
+
+/////////////////////////////////////////////////////////////////////////////////
+// Shift the 57KHz RDS signal in m_CpxRawFm to baseband and decimate its sample rate
+//		down, then recover the RDS data groups from it.
+//
+//		InLength == number of complex samples in m_CpxRawFm
+/////////////////////////////////////////////////////////////////////////////////
+void CWFmDemod::DecodeRdsData(int InLength)
+{
 	//translate 57KHz RDS signal to baseband and decimate RDS complex signal
 	int length = m_RdsDownConvert.ProcessData(InLength, m_CpxRawFm, m_RdsRaw);
 
@@ -416,19 +475,6 @@ TYPEREAL LminusR;
 		m_RdsLastSyncSlope = Slope;
 		m_RdsRaw[i].im = Data;
 	}
-
-	//decimate by 2's down close to final audio rate
-	if(m_pDecBy2A)
-		InLength = m_pDecBy2A->DecBy2(InLength, pOutData, pOutData);
-	if(m_pDecBy2B)
-		InLength = m_pDecBy2B->DecBy2(InLength, pOutData, pOutData);
-	if(m_pDecBy2C)
-		InLength = m_pDecBy2C->DecBy2(InLength, pOutData, pOutData);
-
-	m_LPFilter.ProcessFilter( InLength, pOutData, pOutData);	//rolloff audio above 15KHz
-	ProcessDeemphasisFilter(InLength, pOutData, pOutData);		//50 or 75uSec de-emphasis one pole filter
-	m_NotchFilter.ProcessFilter( InLength, pOutData, pOutData);	//notch out 19KHz pilot
-	return InLength;
 }
 
 /////////////////////////////////////////////////////////////////////////////////
@@ -56,6 +56,8 @@ public:
 	//overloaded functions for mono and stereo
 	int ProcessData(int InLength, TYPECPX* pInData, TYPECPX* pOutData);
 	int ProcessData(int InLength, TYPECPX* pInData, TYPEREAL* pOutData);
+	//RDS only, no audio output
+	int ProcessRdsData(int InLength, TYPECPX* pInData);
 	TYPEREAL GetDemodRate(){return m_OutRate;}
 
 	bool GetNextRdsGroupData(tRDS_GROUPS* pGroupData);
@@ -68,6 +70,7 @@ private:
 	void InitPilotPll( TYPEREAL SampleRate );
 	bool ProcessPilotPll( int InLength, TYPECPX* pInData );
 	void InitRds( TYPEREAL SampleRate );
+	void DecodeRdsData( int InLength );
 	void ProcessRdsPll( int InLength, TYPECPX* pInData, TYPEREAL* pOutData );
 	inline TYPEREAL arctan2(TYPEREAL y, TYPEREAL x);
 
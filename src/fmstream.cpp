@@ -37,6 +37,11 @@
 // Maximum number of queued sample sets from the device
 size_t const fmstream::MAX_SAMPLE_QUEUE = 200;		// ~2sec
 
+// fmstream::MIN_DECIMATED_RATE (static)
+//
+// Minimum sample rate to request from a device that can decimate; this keeps the wideband demodulator at its usual operating rate
+uint32_t const fmstream::MIN_DECIMATED_RATE = 400000;
+
 // fmstream::STREAM_ID_AUDIO
 //
 // Stream identifier for the audio output stream
@@ -73,8 +78,12 @@ fmstream::fmstream(std::unique_ptr<rtldevice> device, struct tunerprops const& t
 
 	// Initialize the RTL-SDR device instance
 	m_device->set_frequency_correction(tunerprops.freqcorrection + channelprops.freqcorrection);
-	uint32_t samplerate = m_device->set_sample_rate(fmprops.samplerate);
-	uint32_t frequency = m_device->set_center_frequency(channelprops.frequency + (samplerate / 4));		// DC offset
+	m_samplerate = m_device->set_sample_rate(fmprops.samplerate);
+	uint32_t frequency = m_device->set_center_frequency(channelprops.frequency + (m_samplerate / 4));		// DC offset
+
+	// A device that can decimate shifts the channel to zero and reduces the sample rate before
+	// the samples are transferred, which greatly reduces the bandwidth required for a remote device
+	m_decimation = m_device->set_decimation(static_cast<int>(channelprops.frequency) - static_cast<int>(frequency), m_samplerate / MIN_DECIMATED_RATE);
 
 	// Initialize the demodulator parameters
 	//
@@ -88,9 +97,9 @@ fmstream::fmstream(std::unique_ptr<rtldevice> device, struct tunerprops const& t
 	// Initialize the wideband FM demodulator
 	m_demodulator = std::unique_ptr<CDemodulator>(new CDemodulator());
 	m_demodulator->SetUSFmVersion(fmprops.isnorthamerica);
-	m_demodulator->SetInputSampleRate(static_cast<TYPEREAL>(samplerate));
+	m_demodulator->SetInputSampleRate(static_cast<TYPEREAL>(m_samplerate) / m_decimation);
 	m_demodulator->SetDemod(DEMOD_WFM, demodinfo);
-	m_demodulator->SetDemodFreq(static_cast<TYPEREAL>(frequency - channelprops.frequency));
+	m_demodulator->SetDemodFreq((m_decimation > 1) ? 0 : static_cast<TYPEREAL>(frequency - channelprops.frequency));
 
 	// Initialize the output resampler
 	m_resampler = std::unique_ptr<CFractResampler>(new CFractResampler());
@@ -100,10 +109,10 @@ fmstream::fmstream(std::unique_ptr<rtldevice> device, struct tunerprops const& t
 	m_device->set_automatic_gain_control(channelprops.autogain);
 	if(channelprops.autogain == false) m_device->set_gain(channelprops.manualgain);
 
-	// Create a worker thread on which to perform the transfer operations
-	scalar_condition<bool> started{ false };
-	m_worker = std::thread(&fmstream::transfer, this, std::ref(started));
-	started.wait_until_equals(true);
+	// Begin streaming from the device on the calling thread so that any failure is reported
+	// to the caller, then hand the device off to a worker thread for the transfer operations
+	m_device->begin_stream();
+	m_worker = std::thread(&fmstream::transfer, this);
 }
 
 //---------------------------------------------------------------------------
@@ -114,6 +123,35 @@ fmstream::~fmstream()
 	close();
 }
 
+//---------------------------------------------------------------------------
+// fmstream::acquisition
+//
+// Gets the signal acquisition state to be cached for the channel
+//
+// Arguments:
+//
+//	acquisitionprops	- Structure to receive the acquisition state
+
+bool fmstream::acquisition(struct acquisitionprops& /*acquisitionprops*/) const
+{
+	// Analog demodulation has no acquisition state that can be cached
+	return false;
+}
+
+//---------------------------------------------------------------------------
+// fmstream::canpause
+//
+// Flag indicating if the stream can be paused
+//
+// Arguments:
+//
+//	NONE
+
+bool fmstream::canpause(void) const
+{
+	return false;
+}
+
 //---------------------------------------------------------------------------
 // fmstream::canseek
 //
@@ -200,6 +238,26 @@ void fmstream::demuxflush(void)
 
 DEMUX_PACKET* fmstream::demuxread(std::function<DEMUX_PACKET*(int)> const& allocator)
 {
+	// The demodulator and RDS decoder are only accessed on this thread, publish the signal status
+	// from here rather than letting the addon query them while a read is in progress
+	publish_status([&](struct signalstatus& status) -> void {
+
+		TYPEREAL demodquality = 0;
+		TYPEREAL demodsnr = 0;
+		m_demodulator->GetSignalLevels(demodquality, demodsnr);
+
+		// For wideband FM, adjust the range such that 80% is nominal for
+		// signal quality and 60% is nominal for signal-to-noise; this 
+		// adjustment is based on observation and (perceived) output quality
+		status.quality = std::max(0, std::min(100, static_cast<int>(100.0 * (demodquality / 0.80))));
+		status.snr = std::max(0, std::min(100, static_cast<int>(100.0 * (demodsnr / 0.60))));
+
+		// If the callsign for the station is known, use that with an -FM suffix, otherwise use the default
+		status.devicename = m_device->get_device_name();
+		status.muxname = (m_rdsdecoder.has_rbds_callsign()) ? m_rdsdecoder.get_rbds_callsign() : m_muxname;
+		status.servicename = "Wideband FM radio";
+	});
+
 	// If there is an RDS UECP packet available, handle it before demodulating more audio
 	uecp_data_packet uecp_packet;
 	if(m_rdsdecoder.pop_uecp_data_packet(uecp_packet) && (!uecp_packet.empty())) {
@@ -222,9 +280,11 @@ DEMUX_PACKET* fmstream::demuxread(std::function<DEMUX_PACKET*(int)> const& alloc
 		}
 	}
 
-	// Wait for there to be a packet of samples available for processing
+	// Wait up to 100ms for there to be a packet of samples available for processing; the
+	// device should always be providing samples but the caller must not be blocked forever
 	std::unique_lock<std::mutex> lock(m_queuelock);
-	m_cv.wait(lock, [&]() -> bool { return ((m_queue.size() > 0) || m_stopped.load() == true); });
+	if(!m_cv.wait_for(lock, std::chrono::milliseconds(100), [&]() -> bool { return ((m_queue.size() > 0) || m_stopped.load() == true); }))
+		return allocator(0);
 
 	// If the worker thread was stopped, check for and re-throw any exception that occurred,
 	// otherwise assume it was stopped normally and return an empty demultiplexer packet
@@ -240,10 +300,21 @@ DEMUX_PACKET* fmstream::demuxread(std::function<DEMUX_PACKET*(int)> const& alloc
 	lock.unlock();
 
 	// If the packet of samples is null, the writer has indicated there was a problem
+	// or the stream has been retuned to a different channel
 	if(!samples) {
 
 		m_dts = STREAM_TIME_BASE;			// Reset the current decode time stamp
 
+		// Apply the new demodulator frequency and reset the RDS decoder after a retune
+		lock.lock();
+		if(m_retune) {
+
+			m_demodulator->SetDemodFreq(m_retunefreq);
+			m_rdsdecoder.reset();
+			m_retune = false;
+		}
+		lock.unlock();
+
 		// Create a STREAMCHANGE packet that has no data
 		DEMUX_PACKET* packet = allocator(0);
 		if(packet) packet->iStreamId = DEMUX_SPECIALID_STREAMCHANGE;
@@ -295,20 +366,6 @@ void fmstream::demuxreset(void)
 {
 }
 
-//---------------------------------------------------------------------------
-// fmstream::devicename
-//
-// Gets the device name associated with the stream
-//
-// Arguments:
-//
-//	NONE
-
-std::string fmstream::devicename(void) const
-{
-	return std::string(m_device->get_device_name());
-}
-
 //---------------------------------------------------------------------------
 // fmstream::enumproperties
 //
@@ -374,18 +431,16 @@ long long fmstream::length(void) const
 }
 
 //---------------------------------------------------------------------------
-// fmstream::muxname
+// fmstream::pause
 //
-// Gets the mux name associated with the stream
+// Pauses or resumes the stream
 //
 // Arguments:
 //
-//	NONE
+//	paused		- Flag to pause or resume the stream
 
-std::string fmstream::muxname(void) const
+void fmstream::pause(bool /*paused*/)
 {
-	// If the callsign for the station is known, use that with an -FM suffix, otherwise use the default
-	return (m_rdsdecoder.has_rbds_callsign()) ? m_rdsdecoder.get_rbds_callsign() : m_muxname;
 }
 
 //---------------------------------------------------------------------------
@@ -431,6 +486,44 @@ bool fmstream::realtime(void) const
 	return true;
 }
 
+//---------------------------------------------------------------------------
+// fmstream::retune
+//
+// Retunes the stream to a different channel without recreating it
+//
+// Arguments:
+//
+//	tunerprops		- Tuner device properties
+//	channelprops	- Channel properties
+//	subchannel		- Multiplex subchannel number (unused)
+
+bool fmstream::retune(struct tunerprops const& tunerprops, struct channelprops const& channelprops, uint32_t /*subchannel*/)
+{
+	// The stream can only be retuned to another channel with the same modulation
+	if(channelprops.modulation != modulation::fm) return false;
+
+	// Adjust the RTL-SDR device instance; the sample rate does not change
+	m_device->set_frequency_correction(tunerprops.freqcorrection + channelprops.freqcorrection);
+	uint32_t frequency = m_device->set_center_frequency(channelprops.frequency + (m_samplerate / 4));		// DC offset
+	if(m_decimation > 1) m_device->set_decimation(static_cast<int>(channelprops.frequency) - static_cast<int>(frequency), m_decimation);
+
+	m_device->set_automatic_gain_control(channelprops.autogain);
+	if(channelprops.autogain == false) m_device->set_gain(channelprops.manualgain);
+
+	m_muxname = generate_mux_name(channelprops);
+
+	// Discard any queued samples from the previous channel and push a resync packet (null)
+	// that will apply the new demodulator frequency on the demultiplexer thread
+	std::unique_lock<std::mutex> lock(m_queuelock);
+	m_retune = true;
+	m_retunefreq = (m_decimation > 1) ? 0 : static_cast<TYPEREAL>(frequency - channelprops.frequency);
+	m_queue = sample_queue_t();
+	m_queue.push(nullptr);
+	m_cv.notify_all();
+
+	return true;
+}
+
 //---------------------------------------------------------------------------
 // fmstream::seek
 //
@@ -447,40 +540,34 @@ long long fmstream::seek(long long /*position*/, int /*whence*/)
 }
 
 //---------------------------------------------------------------------------
-// fmstream::servicename
+// fmstream::seektime
 //
-// Gets the service name associated with the stream
+// Sets the stream pointer to a specific presentation time
 //
 // Arguments:
 //
-//	NONE
+//	time		- Presentation time to seek to, in milliseconds
+//	backwards	- Flag indicating the direction of the seek
+//	startpts	- Receives the presentation time stamp at the new position
 
-std::string fmstream::servicename(void) const
+bool fmstream::seektime(double /*time*/, bool /*backwards*/, double& /*startpts*/)
 {
-	return std::string("Wideband FM radio");
+	return false;
 }
 
 //---------------------------------------------------------------------------
-// fmstream::signalquality
+// fmstream::timerange
 //
-// Gets the signal quality as a percentage
+// Gets the range of presentation times that can be seeked to
 //
 // Arguments:
 //
-//	NONE
+//	begin		- Receives the earliest presentation time stamp
+//	end			- Receives the latest presentation time stamp
 
-void fmstream::signalquality(int& quality, int& snr) const
+bool fmstream::timerange(double& /*begin*/, double& /*end*/) const
 {
-	TYPEREAL demodquality = 0;
-	TYPEREAL demodsnr = 0;
-
-	m_demodulator->GetSignalLevels(demodquality, demodsnr);
-
-	// For wideband FM, adjust the range such that 80% is nominal for
-	// signal quality and 60% is nominal for signal-to-noise; this 
-	// adjustment is based on observation and (perceived) output quality
-	quality = std::max(0, std::min(100, static_cast<int>(100.0 * (demodquality / 0.80))));
-	snr = std::max(0, std::min(100, static_cast<int>(100.0 * (demodsnr / 0.60))));
+	return false;
 }
 
 //---------------------------------------------------------------------------
@@ -490,9 +577,9 @@ void fmstream::signalquality(int& quality, int& snr) const
 //
 // Arguments:
 //
-//	started		- Condition variable to set when thread has started
+//	NONE
 
-void fmstream::transfer(scalar_condition<bool>& started)
+void fmstream::transfer(void)
 {
 	assert(m_demodulator);
 	assert(m_device);
@@ -544,10 +631,6 @@ void fmstream::transfer(scalar_condition<bool>& started)
 		m_cv.notify_all();
 	};
 
-	// Begin streaming from the device and inform the caller that the thread is running
-	m_device->begin_stream();
-	started = true;
-
 	// Continuously read data from the device until cancel_async() has been called
 	try { m_device->read_async(read_callback_func, static_cast<uint32_t>(readsize)); }
 	catch(...) { m_worker_exception = std::current_exception(); }
@@ -58,6 +58,16 @@ public:
 	//-----------------------------------------------------------------------
 	// Member Functions
 
+	// acquisition
+	//
+	// Gets the signal acquisition state to be cached for the channel
+	bool acquisition(struct acquisitionprops& acquisitionprops) const override;
+
+	// canpause
+	//
+	// Flag indicating if the stream can be paused
+	bool canpause(void) const override;
+
 	// canseek
 	//
 	// Flag indicating if the stream allows seek operations
@@ -94,11 +104,6 @@ public:
 	// Resets the demultiplexer
 	void demuxreset(void) override;
 
-	// devicename
-	//
-	// Gets the device name associated with the stream
-	std::string devicename(void) const override;
-
 	// enumproperties
 	//
 	// Enumerates the stream properties
@@ -109,10 +114,10 @@ public:
 	// Gets the length of the stream
 	long long length(void) const override;
 
-	// muxname
+	// pause
 	//
-	// Gets the mux name associated with the stream
-	std::string muxname(void) const override;
+	// Pauses or resumes the stream
+	void pause(bool paused) override;
 
 	// position
 	//
@@ -129,20 +134,25 @@ public:
 	// Gets a flag indicating if the stream is real-time
 	bool realtime(void) const override;
 
+	// retune
+	//
+	// Retunes the stream to a different channel without recreating it
+	bool retune(struct tunerprops const& tunerprops, struct channelprops const& channelprops, uint32_t subchannel) override;
+
 	// seek
 	//
 	// Sets the stream pointer to a specific position
 	long long seek(long long position, int whence) override;
 
-	// servicename
+	// seektime
 	//
-	// Gets the service name associated with the stream
-	std::string servicename(void) const override;
+	// Sets the stream pointer to a specific presentation time
+	bool seektime(double time, bool backwards, double& startpts) override;
 
-	// signalquality
+	// timerange
 	//
-	// Gets the signal quality as percentages
-	void signalquality(int& quality, int& snr) const override;
+	// Gets the range of presentation times that can be seeked to
+	bool timerange(double& begin, double& end) const override;
 
 private:
 
@@ -154,6 +164,11 @@ private:
 	// Maximum number of queued sample sets from device
 	static size_t const MAX_SAMPLE_QUEUE;
 
+	// MIN_DECIMATED_RATE
+	//
+	// Minimum sample rate to request from a device that can decimate
+	static uint32_t const MIN_DECIMATED_RATE;
+
 	// STREAM_ID_AUDIO
 	//
 	// Stream identifier for the audio output stream
@@ -193,7 +208,7 @@ private:
 	// transfer
 	//
 	// Worker thread procedure used to transfer data into the ring buffer
-	void transfer(scalar_condition<bool>& started);
+	void transfer(void);
 
 	//-----------------------------------------------------------------------
 	// Member Variables
@@ -204,10 +219,17 @@ private:
 	bool const							m_decoderds;				// Flag to send decoded RDS data
 	rdsdecoder							m_rdsdecoder;				// RDS decoder instance
 
-	std::string	const					m_muxname;					// Default mux name for the stream
+	std::string							m_muxname;					// Default mux name for the stream
 	uint32_t const						m_pcmsamplerate;			// Output sample rate
 	TYPEREAL const						m_pcmgain;					// Output gain
 	double								m_dts{ STREAM_TIME_BASE };	// Current decode time stamp
+	uint32_t							m_samplerate = 0;			// Device sample rate
+	uint32_t							m_decimation = 1;			// Device decimation factor
+
+	// RETUNE
+	//
+	bool								m_retune = false;			// Flag to apply a retune operation
+	TYPEREAL							m_retunefreq = 0;			// Retuned demodulator frequency
 
 	// STREAM CONTROL
 	//
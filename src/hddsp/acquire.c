@@ -25,7 +25,7 @@
 #include "input.h"
 
 #define FILTER_DELAY 15
-#define DECIMATION_FACTOR_FM 2
+#define DECIMATION_FACTOR_FM NRSC5_DECIMATION_FM
 #define DECIMATION_FACTOR_AM 32
 
 static float filter_taps_fm[] = {
@@ -192,7 +192,7 @@ void acquire_process(acquire_t *st)
             }
             temp_phase = CMPLXFDIVF(temp_phase, cabsf(temp_phase));
 
-            fftwf_execute((st->mode == NRSC5_MODE_FM) ? st->fft_plan_fm : st->fft_plan_am);
+            fftwf_execute_dft((st->mode == NRSC5_MODE_FM) ? st->fft_plan_fm : st->fft_plan_am, (fftwf_complex*)st->fftin, (fftwf_complex*)st->fftout);
             fftshift(st->fftout, st->fft);
 
             float x = st->fftcp * (i - (float) (ACQUIRE_SYMBOLS - 1) / 2);
@@ -252,7 +252,7 @@ void acquire_process(acquire_t *st)
         }
 		st->phase = CMPLXFDIVF(st->phase, cabsf(st->phase));
 
-        fftwf_execute((st->mode == NRSC5_MODE_FM) ? st->fft_plan_fm : st->fft_plan_am);
+        fftwf_execute_dft((st->mode == NRSC5_MODE_FM) ? st->fft_plan_fm : st->fft_plan_am, (fftwf_complex*)st->fftin, (fftwf_complex*)st->fftout);
         fftshift(st->fftout, st->fft);
         sync_push(&st->input->sync, st->fftout);
     }
@@ -299,7 +299,7 @@ void acquire_reset(acquire_t *st)
     st->cfo = 0;
 }
 
-void acquire_init(acquire_t *st, input_t *input)
+int acquire_init(acquire_t *st, input_t *input)
 {
     int i;
 
@@ -313,8 +313,8 @@ void acquire_init(acquire_t *st, input_t *input)
     st->filter_fm = firdecim_q15_create(filter_taps_fm, sizeof(filter_taps_fm) / sizeof(filter_taps_fm[0]));
     st->filter_am = firdecim_q15_create(filter_taps_am, sizeof(filter_taps_am) / sizeof(filter_taps_am[0]));
 
-    st->fft_plan_fm = fftwf_plan_dft_1d(FFT_FM, (fftwf_complex*)st->fftin, (fftwf_complex*)st->fftout, FFTW_FORWARD, 0);
-    st->fft_plan_am = fftwf_plan_dft_1d(FFT_AM, (fftwf_complex*)st->fftin, (fftwf_complex*)st->fftout, FFTW_FORWARD, 0);
+    st->fft_plan_fm = fftwcache_get_plan(FFT_FM, (fftwf_complex*)st->fftin, (fftwf_complex*)st->fftout, FFTW_FORWARD);
+    st->fft_plan_am = fftwcache_get_plan(FFT_AM, (fftwf_complex*)st->fftin, (fftwf_complex*)st->fftout, FFTW_FORWARD);
 
     for (i = 0; i < FFTCP_FM; ++i)
     {
@@ -341,6 +341,9 @@ void acquire_init(acquire_t *st, input_t *input)
     st->shape = st->shape_fm;
 
     acquire_reset(st);
+
+    // The plan cache returns NULL if a plan could not be created
+    return (st->fft_plan_fm && st->fft_plan_am) ? 0 : 1;
 }
 
 void acquire_set_mode(acquire_t *st, int mode)
@@ -367,6 +370,4 @@ void acquire_free(acquire_t *st)
 {
     firdecim_q15_free(st->filter_fm);
     firdecim_q15_free(st->filter_am);
-    fftwf_destroy_plan(st->fft_plan_fm);
-    fftwf_destroy_plan(st->fft_plan_am);
 }
@@ -35,6 +35,9 @@ void acquire_process(acquire_t *st);
 void acquire_cfo_adjust(acquire_t *st, int cfo);
 unsigned int acquire_push(acquire_t *st, cint16_t *buf, unsigned int length);
 void acquire_reset(acquire_t *st);
-void acquire_init(acquire_t *st, struct input_t *input);
+int acquire_init(acquire_t *st, struct input_t *input);
 void acquire_set_mode(acquire_t *st, int mode);
 void acquire_free(acquire_t *st);
+
+// Shared FFTW plans are provided by the host application's plan cache (fftwcache.cpp)
+fftwf_plan fftwcache_get_plan(int size, const fftwf_complex *in, const fftwf_complex *out, int sign);
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "config.h"
+#include "nrsc5.h"
 
 #include <stdio.h>
 #include <stdint.h>
@@ -13,9 +14,9 @@
 #endif
 
 // Sample rate before decimation
-#define SAMPLE_RATE 1488375
+#define SAMPLE_RATE NRSC5_SAMPLE_RATE_CU8
 // FFT length in samples
-#define FFT_FM 2048
+#define FFT_FM NRSC5_FFT_FM
 #define FFT_AM 256
 // cyclic preflex length in samples
 #define CP_FM 112
@@ -27,9 +28,9 @@
 // symbols processed by each invocation of acquire_process
 #define ACQUIRE_SYMBOLS (BLKSZ * 2)
 // index of first lower sideband subcarrier
-#define LB_START ((FFT_FM / 2) - 546)
+#define LB_START ((FFT_FM / 2) - NRSC5_PM_OUTER_FM)
 // index of last upper sideband subcarrier
-#define UB_END ((FFT_FM / 2) + 546)
+#define UB_END ((FFT_FM / 2) + NRSC5_PM_OUTER_FM)
 // index of AM carrier
 #define CENTER_AM (FFT_AM / 2)
 // indexes of AM subcarriers
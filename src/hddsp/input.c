@@ -80,7 +80,7 @@ static void measure_snr(input_t *st, uint8_t *buf, uint32_t len)
     {
         for (i = 0; i < SNR_FFT_LEN; i++)
             st->snr_fft_in[i] = CMPLXFMULF(CMPLXF(U8_F(buf[(i+j) * 2]), U8_F(buf[(i+j) * 2 + 1])), pow(sinf(M_PI*i/(SNR_FFT_LEN-1)), 2));
-        fftwf_execute(st->snr_fft);
+        fftwf_execute_dft(st->snr_fft, (fftwf_complex*)st->snr_fft_in, (fftwf_complex*)st->snr_fft_out);
         fftshift(st->snr_fft_out, SNR_FFT_LEN);
 
         for (i = 0; i < SNR_FFT_LEN; i++)
@@ -246,7 +246,7 @@ void input_reset(input_t *st)
     sync_reset(&st->sync);
 }
 
-void input_init(input_t *st, nrsc5_t *radio, output_t *output)
+int input_init(input_t *st, nrsc5_t *radio, output_t *output)
 {
     st->radio = radio;
     st->output = output;
@@ -256,14 +256,17 @@ void input_init(input_t *st, nrsc5_t *radio, output_t *output)
 
     for (int i = 0; i < AM_DECIM_STAGES; i++)
         st->decim[i] = firdecim_q15_create(decim_taps, sizeof(decim_taps) / sizeof(decim_taps[0]));
-    st->snr_fft = fftwf_plan_dft_1d(SNR_FFT_LEN, (fftwf_complex*)(st->snr_fft_in), (fftwf_complex*)st->snr_fft_out, FFTW_FORWARD, 0);
+    st->snr_fft = fftwcache_get_plan(SNR_FFT_LEN, (fftwf_complex*)(st->snr_fft_in), (fftwf_complex*)st->snr_fft_out, FFTW_FORWARD);
 
-    acquire_init(&st->acq, st);
+    int result = acquire_init(&st->acq, st);
     decode_init(&st->decode, st);
     frame_init(&st->frame, st);
     sync_init(&st->sync, st);
 
     input_reset(st);
+
+    // Initialization is always completed so that input_free() can be called on failure
+    return (st->snr_fft && result == 0) ? 0 : 1;
 }
 
 void input_set_mode(input_t *st)
@@ -279,8 +282,6 @@ void input_free(input_t *st)
 
     for (int i = 0; i < AM_DECIM_STAGES; i++)
         firdecim_q15_free(st->decim[i]);
-    fftwf_destroy_plan(st->snr_fft);
-    fftwf_cleanup();
 }
 
 void input_set_sync_state(input_t *st, unsigned int new_state)
@@ -52,7 +52,7 @@ typedef struct input_t
     sync_t sync;
 } input_t;
 
-void input_init(input_t *st, nrsc5_t *radio, output_t *output);
+int input_init(input_t *st, nrsc5_t *radio, output_t *output);
 void input_set_mode(input_t *st);
 void input_reset(input_t *st);
 void input_free(input_t *st);
@@ -10,14 +10,14 @@
 #define NRSC5_API
 #endif
 
-static void nrsc5_init(nrsc5_t *st)
+static int nrsc5_init(nrsc5_t *st)
 {
     st->closed = 0;
     st->mode = NRSC5_MODE_FM;
     st->callback = NULL;
 
     output_init(&st->output, st);
-    input_init(&st->input, st, &st->output);
+    return input_init(&st->input, st, &st->output);
 }
 
 
@@ -96,7 +96,16 @@ static nrsc5_t *nrsc5_alloc()
 NRSC5_API int nrsc5_open_pipe(nrsc5_t **result)
 {
     nrsc5_t *st = nrsc5_alloc();
-    nrsc5_init(st);
+    *result = NULL;
+
+    if (!st)
+        return 1;
+
+    if (nrsc5_init(st) != 0)
+    {
+        nrsc5_close(st);
+        return 1;
+    }
 
     *result = st;
     return 0;
@@ -114,6 +123,12 @@ NRSC5_API void nrsc5_close(nrsc5_t *st)
     free(st);
 }
 
+NRSC5_API void nrsc5_reset(nrsc5_t *st)
+{
+    input_reset(&st->input);
+    output_reset(&st->output);
+}
+
 NRSC5_API int nrsc5_set_mode(nrsc5_t *st, int mode)
 {
     if (mode == NRSC5_MODE_FM || mode == NRSC5_MODE_AM)
@@ -125,6 +140,16 @@ NRSC5_API int nrsc5_set_mode(nrsc5_t *st, int mode)
     return 1;
 }
 
+NRSC5_API void nrsc5_get_cfo(nrsc5_t *st, int *cfo)
+{
+    *cfo = st->input.acq.cfo;
+}
+
+NRSC5_API void nrsc5_set_cfo(nrsc5_t *st, int cfo)
+{
+    acquire_cfo_adjust(&st->input.acq, cfo - st->input.acq.cfo);
+}
+
 NRSC5_API void nrsc5_set_callback(nrsc5_t *st, nrsc5_callback_t callback, void *opaque)
 {
     st->callback = callback;
@@ -31,6 +31,12 @@ extern "C" {
 #define NRSC5_SCAN_END   107.9e6
 #define NRSC5_SCAN_SKIP    0.2e6
 
+#define NRSC5_SAMPLE_RATE_CU8  1488375  /**< Input sample rate (before decimation) */
+#define NRSC5_DECIMATION_FM    2        /**< Decimation applied ahead of the FM FFT */
+#define NRSC5_FFT_FM           2048     /**< FM OFDM FFT length */
+#define NRSC5_PM_OUTER_FM      546      /**< Outermost primary main subcarrier */
+#define NRSC5_PM_WIDTH_FM      190      /**< Primary main sideband width (10 partitions of 19 subcarriers) */
+
 #define NRSC5_MIME_PRIMARY_IMAGE    0xBE4B7536
 #define NRSC5_MIME_STATION_LOGO     0xD9C72536
 #define NRSC5_MIME_NAVTEQ           0x2D42AC3E
@@ -403,6 +409,16 @@ int nrsc5_open_pipe(nrsc5_t **st );
  */
 void nrsc5_close(nrsc5_t *);
 
+/**
+ * Resets an nrsc5 session, typically after the input has been retuned.
+ * @param[in] st  pointer to an `nrsc5_t` session object
+ * @return Nothing is returned.
+ *
+ * All acquisition, synchronization and decoder state is discarded; the
+ * mode and callback function are retained.
+ */
+void nrsc5_reset(nrsc5_t *st);
+
 /**
  * Set the session mode to AM or FM.
  * @param[in] st  pointer to an `nrsc5_t` session object
@@ -412,6 +428,26 @@ void nrsc5_close(nrsc5_t *);
  */
 int nrsc5_set_mode(nrsc5_t *, int mode);
 
+/**
+ * Get the current carrier frequency offset.
+ * @param[in] st  pointer to an `nrsc5_t` session object
+ * @param[out] cfo  carrier frequency offset, in FFT bins
+ * @return Nothing is returned.
+ *
+ */
+void nrsc5_get_cfo(nrsc5_t *st, int *cfo);
+
+/**
+ * Set the carrier frequency offset, typically from a previous acquisition.
+ * @param[in] st  pointer to an `nrsc5_t` session object
+ * @param[in] cfo  carrier frequency offset, in FFT bins
+ * @return Nothing is returned.
+ *
+ * The offset is only used as a starting point; normal acquisition and
+ * synchronization will continue to adjust it.
+ */
+void nrsc5_set_cfo(nrsc5_t *st, int cfo);
+
 /**
  * Establish a callback function.
  *
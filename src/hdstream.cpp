@@ -69,8 +69,8 @@ int const hdstream::STREAM_ID_ID3TAG = 2;
 
 hdstream::hdstream(std::unique_ptr<rtldevice> device, struct tunerprops const& tunerprops,
 	struct channelprops const& channelprops, struct hdprops const& hdprops, uint32_t subchannel) :
-	m_device(std::move(device)), m_subchannel((subchannel > 0) ? subchannel : 1),
-	m_muxname(""), m_pcmgain(powf(10.0f, hdprops.outputgain / 10.0f))
+	m_device(std::move(device)), m_frequency(channelprops.frequency), m_subchannel((subchannel > 0) ? subchannel : 1),
+	m_muxname(""), m_pcmgain(powf(10.0f, hdprops.outputgain / 10.0f)), m_warmstart(channelprops.acquisition.valid)
 {
 	// Initialize the RTL-SDR device instance
 	m_device->set_frequency_correction(tunerprops.freqcorrection + channelprops.freqcorrection);
@@ -82,14 +82,24 @@ hdstream::hdstream(std::unique_ptr<rtldevice> device, struct tunerprops const& t
 	if(channelprops.autogain == false) m_device->set_gain(channelprops.manualgain);
 
 	// Initialize the HD Radio demodulator
-	nrsc5_open_pipe(&m_nrsc5);
+	if(nrsc5_open_pipe(&m_nrsc5) != 0) throw string_exception(__func__, ": unable to initialize the HD Radio demodulator");
 	nrsc5_set_mode(m_nrsc5, NRSC5_MODE_FM);
 	nrsc5_set_callback(m_nrsc5, nrsc5_callback, this);
 
-	// Create a worker thread on which to perform demodulation
-	scalar_condition<bool> started{ false };
-	m_worker = std::thread(&hdstream::worker, this, std::ref(started));
-	started.wait_until_equals(true);
+	// Warm start the demodulator with the last known-good carrier frequency offset, this
+	// is only a starting point and normal acquisition will continue to adjust it as needed
+	if(m_warmstart) nrsc5_set_cfo(m_nrsc5, channelprops.acquisition.hdcfo);
+
+	// Begin streaming from the device on the calling thread so that any failure is reported
+	// to the caller, then hand the device off to a worker thread for demodulation.  The
+	// destructor won't run if the constructor throws, NRSC5 has to be closed here
+	try {
+
+		m_device->begin_stream();
+		m_worker = std::thread(&hdstream::worker, this);
+	}
+
+	catch(...) { nrsc5_close(m_nrsc5); m_nrsc5 = nullptr; throw; }
 }
 
 //---------------------------------------------------------------------------
@@ -100,6 +110,45 @@ hdstream::~hdstream()
 	close();
 }
 
+//---------------------------------------------------------------------------
+// hdstream::acquisition
+//
+// Gets the signal acquisition state to be cached for the channel
+//
+// Arguments:
+//
+//	acquisitionprops	- Structure to receive the acquisition state
+
+bool hdstream::acquisition(struct acquisitionprops& acquisitionprops) const
+{
+	acquisitionprops = {};
+
+	// If sync was acquired, the last measured carrier frequency offset is known-good
+	if(m_synced.load()) {
+
+		acquisitionprops.valid = true;
+		acquisitionprops.hdcfo = m_cfo.load();
+		return true;
+	}
+
+	// If a warm start was applied but sync never occurred, invalidate the cached state
+	return m_warmstart.load();
+}
+
+//---------------------------------------------------------------------------
+// hdstream::canpause
+//
+// Flag indicating if the stream can be paused
+//
+// Arguments:
+//
+//	NONE
+
+bool hdstream::canpause(void) const
+{
+	return false;
+}
+
 //---------------------------------------------------------------------------
 // hdstream::canseek
 //
@@ -191,6 +240,29 @@ void hdstream::demuxflush(void)
 
 DEMUX_PACKET* hdstream::demuxread(std::function<DEMUX_PACKET*(int)> const& allocator)
 {
+	// Publish the signal status for the addon from the demultiplexer thread
+	publish_status([&](struct signalstatus& status) -> void {
+
+		// For signal quality, use the NRSC5 Bit Error Rate (BER). A BER of zero
+		// implies ideal signal quality. I have no idea what the BER tolerance
+		// is for decoding HD Radio, but from observation a BER with a value
+		// higher than 0.1 is effectively undecodable so let's call that zero
+		float ber = m_ber.load();
+		ber = std::min(std::max(ber, 0.0f), 0.1f) * 100.0f;
+		status.quality = static_cast<int>(((ber - 100.0f) * 100.0f) / -100.0f);
+
+		// For signal-to-noise ratio, use the NRSC5 Modulation Error Ratio (MER).
+		// A MER of 14 is apparently the ideal for HD Radio, so for now use
+		// a linear scale from (0...13) to define the SNR percentage
+		float mer = m_mer.load();
+		mer = std::max(std::min(13.0f, mer), 0.0f);
+		status.snr = static_cast<int>((mer * 100.0f) / 13.0f);
+
+		status.devicename = m_device->get_device_name();
+		status.muxname = m_muxname;
+		status.servicename = "Hybrid Digital (HD) Radio";
+	});
+
 	// Wait up to 100ms for there to be a packet available for processing, don't use
 	// an unconditional wait here; unlike analog radio there may not be data until
 	// the digitial signal has been synchronized
@@ -243,20 +315,6 @@ void hdstream::demuxreset(void)
 {
 }
 
-//---------------------------------------------------------------------------
-// hdstream::devicename
-//
-// Gets the device name associated with the stream
-//
-// Arguments:
-//
-//	NONE
-
-std::string hdstream::devicename(void) const
-{
-	return std::string(m_device->get_device_name());
-}
-
 //---------------------------------------------------------------------------
 // hdstream::enumproperties
 //
@@ -302,20 +360,6 @@ long long hdstream::length(void) const
 	return -1;
 }
 
-//---------------------------------------------------------------------------
-// hdstream::muxname
-//
-// Gets the mux name associated with the stream
-//
-// Arguments:
-//
-//	NONE
-
-std::string hdstream::muxname(void) const
-{
-	return m_muxname;
-}
-
 //---------------------------------------------------------------------------
 // hdstream::nrsc5_callback (private, static)
 //
@@ -392,6 +436,22 @@ void hdstream::nrsc5_callback(nrsc5_event_t const* event)
 		// Store the higher of the two values instead of the mean, some HD radio stations
 		// are allowed to transmit one sideband at a higher power than the other
 		m_mer.store(std::max(event->mer.lower, event->mer.upper));
+
+		// MER is only reported while synchronized, refresh the carrier frequency offset
+		int cfo = 0;
+		nrsc5_get_cfo(m_nrsc5, &cfo);
+		m_cfo.store(cfo);
+	}
+
+	// NRSC5_EVENT_SYNC
+	//
+	// Signal synchronization has been acquired
+	else if(event->event == NRSC5_EVENT_SYNC) {
+
+		int cfo = 0;
+		nrsc5_get_cfo(m_nrsc5, &cfo);
+		m_cfo.store(cfo);
+		m_synced.store(true);
 	}
 
 #ifdef KODI_HAS_ID3
@@ -486,6 +546,19 @@ void hdstream::nrsc5_callback(nrsc5_event_t const* event)
 	}
 }
 
+//---------------------------------------------------------------------------
+// hdstream::pause
+//
+// Pauses or resumes the stream
+//
+// Arguments:
+//
+//	paused		- Flag to pause or resume the stream
+
+void hdstream::pause(bool /*paused*/)
+{
+}
+
 //---------------------------------------------------------------------------
 // hdstream::position
 //
@@ -500,6 +573,23 @@ long long hdstream::position(void) const
 	return -1;
 }
 
+//---------------------------------------------------------------------------
+// hdstream::prewarm (static)
+//
+// Builds the device-independent HD Radio demodulator state ahead of the first stream
+//
+// Arguments:
+//
+//	NONE
+
+void hdstream::prewarm(void)
+{
+	// Creating and discarding an instance populates the FFT plan cache with the measured
+	// plans for every transform NRSC5 uses, subsequent instances get them from the cache
+	nrsc5_t* nrsc5 = nullptr;
+	if(nrsc5_open_pipe(&nrsc5) == 0) nrsc5_close(nrsc5);
+}
+
 //---------------------------------------------------------------------------
 // hdstream::read
 //
@@ -529,6 +619,62 @@ bool hdstream::realtime(void) const
 	return true;
 }
 
+//---------------------------------------------------------------------------
+// hdstream::retune
+//
+// Retunes the stream to a different channel without recreating it
+//
+// Arguments:
+//
+//	tunerprops		- Tuner device properties
+//	channelprops	- Channel properties
+//	subchannel		- Multiplex subchannel number
+
+bool hdstream::retune(struct tunerprops const& tunerprops, struct channelprops const& channelprops, uint32_t subchannel)
+{
+	// The stream can only be retuned to another channel with the same modulation
+	if(channelprops.modulation != modulation::hd) return false;
+
+	// Adjust the RTL-SDR device instance; the sample rate does not change
+	m_device->set_frequency_correction(tunerprops.freqcorrection + channelprops.freqcorrection);
+	m_device->set_automatic_gain_control(channelprops.autogain);
+	if(channelprops.autogain == false) m_device->set_gain(channelprops.manualgain);
+
+	// A different subchannel on the same frequency only requires changing the audio
+	// program filter, otherwise the demodulator needs to be reset on the worker thread
+	bool const newfrequency = (channelprops.frequency != m_frequency);
+	if(newfrequency) m_device->set_center_frequency(channelprops.frequency);
+	m_frequency = channelprops.frequency;
+
+	std::unique_lock<std::mutex> lock(m_queuelock);
+
+	if(newfrequency) {
+
+		m_warmstart.store(channelprops.acquisition.valid);
+		m_synced.store(false);
+		m_cfo.store(0);
+		m_mer.store(0);
+		m_ber.store(0);
+
+		m_retunecfo = channelprops.acquisition.hdcfo;
+		m_retune = true;
+	}
+
+	m_subchannel = (subchannel > 0) ? subchannel : 1;
+
+	// Discard any queued packets from the previous channel and push a
+	// DEMUX_SPECIALID_STREAMCHANGE packet into the new queue
+	m_queue = demux_queue_t();
+	std::unique_ptr<demux_packet_t> packet = std::make_unique<demux_packet_t>();
+	packet->streamid = DEMUX_SPECIALID_STREAMCHANGE;
+	m_queue.emplace(std::move(packet));
+
+	m_dts = STREAM_TIME_BASE;				// Reset the decode time stamp
+	m_cv.notify_all();						// Notify queue was updated
+
+	return true;
+}
+
 //---------------------------------------------------------------------------
 // hdstream::seek
 //
@@ -545,44 +691,34 @@ long long hdstream::seek(long long /*position*/, int /*whence*/)
 }
 
 //---------------------------------------------------------------------------
-// hdstream::servicename
+// hdstream::seektime
 //
-// Gets the service name associated with the stream
+// Sets the stream pointer to a specific presentation time
 //
 // Arguments:
 //
-//	NONE
+//	time		- Presentation time to seek to, in milliseconds
+//	backwards	- Flag indicating the direction of the seek
+//	startpts	- Receives the presentation time stamp at the new position
 
-std::string hdstream::servicename(void) const
+bool hdstream::seektime(double /*time*/, bool /*backwards*/, double& /*startpts*/)
 {
-	return std::string("Hybrid Digital (HD) Radio");
+	return false;
 }
 
 //---------------------------------------------------------------------------
-// hdstream::signalquality
+// hdstream::timerange
 //
-// Gets the signal quality as percentages
+// Gets the range of presentation times that can be seeked to
 //
 // Arguments:
 //
-//	NONE
+//	begin		- Receives the earliest presentation time stamp
+//	end			- Receives the latest presentation time stamp
 
-void hdstream::signalquality(int& quality, int& snr) const
+bool hdstream::timerange(double& /*begin*/, double& /*end*/) const
 {
-	// For signal quality, use the NRSC5 Bit Error Rate (BER). A BER of zero
-	// implies ideal signal quality. I have no idea what the BER tolerance
-	// is for decoding HD Radio, but from observation a BER with a value
-	// higher than 0.1 is effectively undecodable so let's call that zero
-	float ber = m_ber.load();
-	ber = std::min(std::max(ber, 0.0f), 0.1f) * 100.0f;
-	quality = static_cast<int>(((ber - 100.0f) * 100.0f) / -100.0f);
-
-	// For signal-to-noise ratio, use the NRSC5 Modulation Error Ratio (MER).
-	// A MER of 14 is apparently the ideal for HD Radio, so for now use
-	// a linear scale from (0...13) to define the SNR percentage
-	float mer = m_mer.load();
-	mer = std::max(std::min(13.0f, mer), 0.0f);
-	snr = static_cast<int>((mer * 100.0f) / 13.0f);
+	return false;
 }
 
 //---------------------------------------------------------------------------
@@ -592,9 +728,9 @@ void hdstream::signalquality(int& quality, int& snr) const
 //
 // Arguments:
 //
-//	started		- Condition variable to set when thread has started
+//	NONE
 
-void hdstream::worker(scalar_condition<bool>& started)
+void hdstream::worker(void)
 {
 	assert(m_device);
 	assert(m_nrsc5);
@@ -604,14 +740,23 @@ void hdstream::worker(scalar_condition<bool>& started)
 	// Asynchronous read callback function for the RTL-SDR device
 	auto read_callback_func = [&](uint8_t const* buffer, size_t count) -> void {
 
+		// If the stream was retuned to a different frequency, reset the demodulator and
+		// apply the carrier frequency offset from the new channel's cached acquisition
+		std::unique_lock<std::mutex> lock(m_queuelock);
+		if(m_retune) {
+
+			nrsc5_reset(m_nrsc5);
+			if(m_warmstart.load()) nrsc5_set_cfo(m_nrsc5, m_retunecfo);
+
+			m_lots.clear();
+			m_retune = false;
+		}
+		lock.unlock();
+
 		// Pipe the samples into NRSC5, it will invoke the necessary callback(s)
 		nrsc5_pipe_samples_cu8(m_nrsc5, const_cast<uint8_t*>(buffer), static_cast<unsigned int>(count));
 	};
 
-	// Begin streaming from the device and inform the caller that the thread is running
-	m_device->begin_stream();
-	started = true;
-
 	// Continuously read data from the device until cancel_async() has been called
 	// 32 KiB = ~1/100 of a second of data
 	try { m_device->read_async(read_callback_func, 32 KiB); }
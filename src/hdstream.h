@@ -57,6 +57,16 @@ public:
 	//-----------------------------------------------------------------------
 	// Member Functions
 
+	// acquisition
+	//
+	// Gets the signal acquisition state to be cached for the channel
+	bool acquisition(struct acquisitionprops& acquisitionprops) const override;
+
+	// canpause
+	//
+	// Flag indicating if the stream can be paused
+	bool canpause(void) const override;
+
 	// canseek
 	//
 	// Flag indicating if the stream allows seek operations
@@ -93,11 +103,6 @@ public:
 	// Resets the demultiplexer
 	void demuxreset(void) override;
 
-	// devicename
-	//
-	// Gets the device name associated with the stream
-	std::string devicename(void) const override;
-
 	// enumproperties
 	//
 	// Enumerates the stream properties
@@ -108,16 +113,21 @@ public:
 	// Gets the length of the stream
 	long long length(void) const override;
 
-	// muxname
+	// pause
 	//
-	// Gets the mux name associated with the stream
-	std::string muxname(void) const override;
+	// Pauses or resumes the stream
+	void pause(bool paused) override;
 
 	// position
 	//
 	// Gets the current position of the stream
 	long long position(void) const override;
 
+	// prewarm (static)
+	//
+	// Builds the device-independent HD Radio demodulator state ahead of the first stream
+	static void prewarm(void);
+
 	// read
 	//
 	// Reads available data from the stream
@@ -128,20 +138,25 @@ public:
 	// Gets a flag indicating if the stream is real-time
 	bool realtime(void) const override;
 
+	// retune
+	//
+	// Retunes the stream to a different channel without recreating it
+	bool retune(struct tunerprops const& tunerprops, struct channelprops const& channelprops, uint32_t subchannel) override;
+
 	// seek
 	//
 	// Sets the stream pointer to a specific position
 	long long seek(long long position, int whence) override;
 
-	// servicename
+	// seektime
 	//
-	// Gets the service name associated with the stream
-	std::string servicename(void) const override;
+	// Sets the stream pointer to a specific presentation time
+	bool seektime(double time, bool backwards, double& startpts) override;
 
-	// signalquality
+	// timerange
 	//
-	// Gets the signal quality as percentages
-	void signalquality(int& quality, int& snr) const override;
+	// Gets the range of presentation times that can be seeked to
+	bool timerange(double& begin, double& end) const override;
 
 private:
 
@@ -225,7 +240,7 @@ private:
 	// worker
 	//
 	// Worker thread procedure used to transfer data from the device
-	void worker(scalar_condition<bool>& started);
+	void worker(void);
 
 	//-----------------------------------------------------------------------
 	// Member Variables
@@ -233,7 +248,8 @@ private:
 	std::unique_ptr<rtldevice>			m_device;					// RTL-SDR device instance
 	nrsc5_t*							m_nrsc5;					// NRSC5 demodulator handle
 
-	uint32_t const						m_subchannel;				// Multiplex subchannel number
+	uint32_t							m_frequency;				// Current channel frequency
+	uint32_t							m_subchannel;				// Multiplex subchannel number
 	std::string							m_muxname;					// Generated mux name
 	float const							m_pcmgain;					// Output gain
 	double								m_dts{ STREAM_TIME_BASE };	// Current decode time stamp
@@ -241,6 +257,17 @@ private:
 	std::atomic<float>					m_ber{ 0 };					// Current bit erorr rate
 	lot_map_t							m_lots;						// Cached LOT item data
 
+	// ACQUISITION
+	//
+	std::atomic<bool>					m_warmstart;				// Flag if cached acquisition was applied
+	std::atomic<bool>					m_synced{ false };			// Flag if signal sync was acquired
+	std::atomic<int>					m_cfo{ 0 };					// Last known-good carrier freq offset
+
+	// RETUNE
+	//
+	bool								m_retune = false;			// Flag to reset the demodulator
+	int									m_retunecfo = 0;			// Carrier freq offset to apply on reset
+
 	// STREAM CONTROL
 	//
 	demux_queue_t						m_queue;					// queue<> of demux objects
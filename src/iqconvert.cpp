@@ -0,0 +1,180 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2020-2022 Michael G. Brehm
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#include "stdafx.h"
+#include "iqconvert.h"
+
+#include <assert.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#define IQCONVERT_SSE2
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define IQCONVERT_NEON
+#include <arm_neon.h>
+#endif
+
+#pragma warning(push, 4)
+
+//---------------------------------------------------------------------------
+// convert_cf32_to_cu8
+//
+// Converts 32-bit floating point I/Q components in the range [-1.0, 1.0]
+//
+// Arguments:
+//
+//	in		- Input components
+//	out		- Output components
+//	count	- Number of components to convert
+
+void convert_cf32_to_cu8(float const* in, uint8_t* out, size_t count)
+{
+	assert((in != nullptr) && (out != nullptr));
+
+	size_t index = 0;
+
+	// Scale [-1.0, 1.0] onto [0.5, 255.5] and truncate, which rounds the in-range values;
+	// out-of-range and NaN values are clamped before the conversion to integer since
+	// SSE2 converts them into INT_MIN, NEON conversion saturates them on its own
+#if defined(IQCONVERT_SSE2)
+	__m128 const scale = _mm_set1_ps(127.5f);
+	__m128 const bias = _mm_set1_ps(128.0f);
+	__m128 const zero = _mm_setzero_ps();
+	__m128 const limit = _mm_set1_ps(255.0f);
+
+	for(; index + 16 <= count; index += 16) {
+
+		__m128i a = _mm_cvttps_epi32(_mm_min_ps(_mm_max_ps(_mm_add_ps(_mm_mul_ps(_mm_loadu_ps(&in[index]), scale), bias), zero), limit));
+		__m128i b = _mm_cvttps_epi32(_mm_min_ps(_mm_max_ps(_mm_add_ps(_mm_mul_ps(_mm_loadu_ps(&in[index + 4]), scale), bias), zero), limit));
+		__m128i c = _mm_cvttps_epi32(_mm_min_ps(_mm_max_ps(_mm_add_ps(_mm_mul_ps(_mm_loadu_ps(&in[index + 8]), scale), bias), zero), limit));
+		__m128i d = _mm_cvttps_epi32(_mm_min_ps(_mm_max_ps(_mm_add_ps(_mm_mul_ps(_mm_loadu_ps(&in[index + 12]), scale), bias), zero), limit));
+
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(&out[index]), _mm_packus_epi16(_mm_packs_epi32(a, b), _mm_packs_epi32(c, d)));
+	}
+#elif defined(IQCONVERT_NEON)
+	float32x4_t const scale = vdupq_n_f32(127.5f);
+	float32x4_t const bias = vdupq_n_f32(128.0f);
+
+	for(; index + 8 <= count; index += 8) {
+
+		int32x4_t a = vcvtq_s32_f32(vmlaq_f32(bias, vld1q_f32(&in[index]), scale));
+		int32x4_t b = vcvtq_s32_f32(vmlaq_f32(bias, vld1q_f32(&in[index + 4]), scale));
+
+		vst1_u8(&out[index], vqmovun_s16(vcombine_s16(vqmovn_s32(a), vqmovn_s32(b))));
+	}
+#endif
+
+	for(; index < count; index++) {
+
+		float value = (in[index] * 127.5f) + 128.0f;
+		value = (value > 0.0f) ? ((value < 255.0f) ? value : 255.0f) : 0.0f;
+		out[index] = static_cast<uint8_t>(value);
+	}
+}
+
+//---------------------------------------------------------------------------
+// convert_cs16_to_cu8
+//
+// Converts signed 16-bit I/Q components
+//
+// Arguments:
+//
+//	in		- Input components
+//	out		- Output components
+//	count	- Number of components to convert
+
+void convert_cs16_to_cu8(int16_t const* in, uint8_t* out, size_t count)
+{
+	assert((in != nullptr) && (out != nullptr));
+
+	size_t index = 0;
+
+	// Keep the rounded upper 8 bits of each component and move zero to 128; the rounding
+	// addition saturates so that full scale positive values do not wrap
+#if defined(IQCONVERT_SSE2)
+	__m128i const round = _mm_set1_epi16(128);
+	__m128i const flip = _mm_set1_epi8(static_cast<char>(0x80));
+
+	for(; index + 16 <= count; index += 16) {
+
+		__m128i a = _mm_srai_epi16(_mm_adds_epi16(_mm_loadu_si128(reinterpret_cast<__m128i const*>(&in[index])), round), 8);
+		__m128i b = _mm_srai_epi16(_mm_adds_epi16(_mm_loadu_si128(reinterpret_cast<__m128i const*>(&in[index + 8])), round), 8);
+
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(&out[index]), _mm_xor_si128(_mm_packs_epi16(a, b), flip));
+	}
+#elif defined(IQCONVERT_NEON)
+	int16x8_t const round = vdupq_n_s16(128);
+	uint8x16_t const flip = vdupq_n_u8(0x80);
+
+	for(; index + 16 <= count; index += 16) {
+
+		int8x8_t a = vqshrn_n_s16(vqaddq_s16(vld1q_s16(&in[index]), round), 8);
+		int8x8_t b = vqshrn_n_s16(vqaddq_s16(vld1q_s16(&in[index + 8]), round), 8);
+
+		vst1q_u8(&out[index], veorq_u8(vreinterpretq_u8_s8(vcombine_s8(a, b)), flip));
+	}
+#endif
+
+	for(; index < count; index++) {
+
+		int value = (in[index] < 32767 - 128) ? in[index] + 128 : 32767;
+		out[index] = static_cast<uint8_t>((value >> 8) + 128);
+	}
+}
+
+//---------------------------------------------------------------------------
+// convert_cs8_to_cu8
+//
+// Converts signed 8-bit I/Q components
+//
+// Arguments:
+//
+//	in		- Input components
+//	out		- Output components
+//	count	- Number of components to convert
+
+void convert_cs8_to_cu8(int8_t const* in, uint8_t* out, size_t count)
+{
+	assert((in != nullptr) && (out != nullptr));
+
+	size_t index = 0;
+
+	// Flipping the sign bit moves zero from 0 to 128
+#if defined(IQCONVERT_SSE2)
+	__m128i const flip = _mm_set1_epi8(static_cast<char>(0x80));
+
+	for(; index + 16 <= count; index += 16)
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(&out[index]),
+			_mm_xor_si128(_mm_loadu_si128(reinterpret_cast<__m128i const*>(&in[index])), flip));
+#elif defined(IQCONVERT_NEON)
+	uint8x16_t const flip = vdupq_n_u8(0x80);
+
+	for(; index + 16 <= count; index += 16)
+		vst1q_u8(&out[index], veorq_u8(vreinterpretq_u8_s8(vld1q_s8(&in[index])), flip));
+#endif
+
+	for(; index < count; index++) out[index] = static_cast<uint8_t>(in[index]) ^ 0x80;
+}
+
+//---------------------------------------------------------------------------
+
+#pragma warning(pop)
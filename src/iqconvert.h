@@ -0,0 +1,59 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2020-2022 Michael G. Brehm
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#ifndef __IQCONVERT_H_
+#define __IQCONVERT_H_
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#pragma warning(push, 4)
+
+//---------------------------------------------------------------------------
+// FUNCTIONS
+//
+// Each of the conversion functions converts interleaved I/Q components into the
+// unsigned 8-bit interleaved I/Q format used as the input to the demodulators;
+// the count is the number of components (bytes of output), not I/Q pairs
+//---------------------------------------------------------------------------
+
+// convert_cf32_to_cu8
+//
+// Converts 32-bit floating point I/Q components in the range [-1.0, 1.0]
+void convert_cf32_to_cu8(float const* in, uint8_t* out, size_t count);
+
+// convert_cs16_to_cu8
+//
+// Converts signed 16-bit I/Q components
+void convert_cs16_to_cu8(int16_t const* in, uint8_t* out, size_t count);
+
+// convert_cs8_to_cu8
+//
+// Converts signed 8-bit I/Q components
+void convert_cs8_to_cu8(int8_t const* in, uint8_t* out, size_t count);
+
+//-----------------------------------------------------------------------------
+
+#pragma warning(pop)
+
+#endif	// __IQCONVERT_H_
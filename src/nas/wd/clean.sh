@@ -2,4 +2,5 @@
 
 #remove link
 rm -rf /usr/bin/rtl_tcp 2> /dev/null
+rm -rf /usr/bin/rtl_tcpx 2> /dev/null
 rm -rf /var/www/rtl_tcp > /dev/null
@@ -4,4 +4,5 @@ path=$1
 
 #create link
 ln -s $path/bin/rtl_tcp /usr/bin/rtl_tcp
+ln -s $path/bin/rtl_tcpx /usr/bin/rtl_tcpx
 ln -s $path /var/www
@@ -1,4 +1,8 @@
 #!/bin/sh
 
-#start daemon
-rtl_tcp -a 0.0.0.0 > /dev/null 2>&1 &
+#start daemon; prefer the extended server when it has been installed
+if [ -x /usr/bin/rtl_tcpx ]; then
+  rtl_tcpx -a 0.0.0.0 > /dev/null 2>&1 &
+else
+  rtl_tcp -a 0.0.0.0 > /dev/null 2>&1 &
+fi
@@ -1,4 +1,5 @@
 #!/bin/sh
 
 #stop daemon
-killall rtl_tcp
+killall rtl_tcpx 2> /dev/null
+killall rtl_tcp 2> /dev/null
@@ -31,6 +31,17 @@
 
 enum class modulation;
 
+// acquisitionprops
+//
+// Defines the last known-good signal acquisition state for a channel
+struct acquisitionprops {
+
+	bool			valid;					// Flag indicating the acquisition state is valid
+	int				dabfinecorrector;		// DAB fine frequency corrector (Hz)
+	int				dabcoarsecorrector;		// DAB coarse frequency corrector (Hz)
+	int				hdcfo;					// HD Radio carrier frequency offset (FFT bins)
+};
+
 // channelprops
 //
 // Defines properties for a radio channel
@@ -43,6 +54,7 @@ struct channelprops {
 	bool				autogain;			// Flag indicating if automatic gain should be used
 	int					manualgain;			// Manual gain value as 10*dB (i.e. 32.8dB = 328)
 	int					freqcorrection;		// Frequency correction for this channel
+	struct acquisitionprops	acquisition;	// Last known-good acquisition state
 };
 
 // dabprops
@@ -51,6 +63,7 @@ struct channelprops {
 struct dabprops {
 
 	float			outputgain;			// Output gain in Decibels
+	bool			passthrough;		// Flag to pass DAB+ audio through encoded
 };
 
 // fmprops
@@ -120,6 +133,19 @@ struct signalprops {
 	bool			filter;				// Flag to filter the signal
 };
 
+// signalstatus
+//
+// Defines a snapshot of the signal status of a stream
+struct signalstatus {
+
+	int				quality;			// Signal quality as a percentage
+	int				snr;				// Signal-to-noise ratio as a percentage
+	long			unc;				// Uncorrectable block count
+	std::string		devicename;			// Device name
+	std::string		muxname;			// Multiplex name
+	std::string		servicename;		// Service name
+};
+
 // streamprops
 //
 // Defines stream-specific properties
@@ -26,7 +26,9 @@
 
 #include <kodi/addon-instance/PVR.h>
 
+#include <chrono>
 #include <functional>
+#include <memory>
 #include <string>
 
 #include "props.h"
@@ -44,12 +46,22 @@ public:
 
 	// Constructor / Destructor
 	//
-	pvrstream() {}
+	pvrstream() : m_status(std::make_shared<struct signalstatus>()) {}
 	virtual ~pvrstream() {}
 
 	//-----------------------------------------------------------------------
 	// Member Functions
 
+	// acquisition
+	//
+	// Gets the signal acquisition state to be cached for the channel
+	virtual bool acquisition(struct acquisitionprops& acquisitionprops) const = 0;
+
+	// canpause
+	//
+	// Flag indicating if the stream can be paused
+	virtual bool canpause(void) const = 0;
+
 	// canseek
 	//
 	// Flag indicating if the stream allows seek operations
@@ -80,11 +92,6 @@ public:
 	// Resets the demultiplexer
 	virtual void demuxreset(void) = 0;
 
-	// devicename
-	//
-	// Gets the device name associated with the stream
-	virtual std::string devicename(void) const = 0;
-
 	// enumproperties
 	//
 	// Enumerates the stream properties
@@ -95,10 +102,10 @@ public:
 	// Gets the length of the stream
 	virtual long long length(void) const = 0;
 
-	// muxname
+	// pause
 	//
-	// Gets the mux name associated with the stream
-	virtual std::string muxname(void) const = 0;
+	// Pauses or resumes the stream
+	virtual void pause(bool paused) = 0;
 
 	// position
 	//
@@ -115,25 +122,64 @@ public:
 	// Gets a flag indicating if the stream is real-time
 	virtual bool realtime(void) const = 0;
 
+	// retune
+	//
+	// Retunes the stream to a different channel without recreating it
+	virtual bool retune(struct tunerprops const& tunerprops, struct channelprops const& channelprops, uint32_t subchannel) = 0;
+
 	// seek
 	//
 	// Sets the stream pointer to a specific position
 	virtual long long seek(long long position, int whence) = 0;
 
-	// servicename
+	// seektime
+	//
+	// Sets the stream pointer to a specific presentation time
+	virtual bool seektime(double time, bool backwards, double& startpts) = 0;
+
+	// status
 	//
-	// Gets the service name associated with the stream
-	virtual std::string servicename(void) const = 0;
+	// Gets the most recently published signal status of the stream
+	virtual std::shared_ptr<struct signalstatus const> status(void) const
+	{
+		// The snapshot is swapped atomically by the publishing thread; this never waits on the
+		// stream itself so it's safe to call while another thread is blocked in demuxread()
+		return std::atomic_load(&m_status);
+	}
 
-	// signalquality
+	// timerange
 	//
-	// Gets the signal quality as percentages
-	virtual void signalquality(int& quality, int& snr) const = 0;
+	// Gets the range of presentation times that can be seeked to
+	virtual bool timerange(double& begin, double& end) const = 0;
+
+protected:
+
+	// publish_status
+	//
+	// Publishes a new signal status snapshot; the callback that generates it is only
+	// invoked once the previous snapshot is more than 500 milliseconds old
+	void publish_status(std::function<void(struct signalstatus& status)> const& callback, bool force = false)
+	{
+		std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+		if((!force) && (now < m_statusnext)) return;
+
+		std::shared_ptr<struct signalstatus> status = std::make_shared<struct signalstatus>();
+		callback(*status);
+
+		std::atomic_store(&m_status, std::shared_ptr<struct signalstatus const>(std::move(status)));
+		m_statusnext = now + std::chrono::milliseconds(500);
+	}
 
 private:
 
 	pvrstream(pvrstream const&) = delete;
 	pvrstream& operator=(pvrstream const&) = delete;
+
+	//-----------------------------------------------------------------------
+	// Member Variables
+
+	std::shared_ptr<struct signalstatus const>	m_status;		// Published signal status
+	std::chrono::steady_clock::time_point		m_statusnext;	// Next status publication time
 };
 
 //-----------------------------------------------------------------------------
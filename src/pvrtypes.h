@@ -38,6 +38,12 @@
 static int const MENUHOOK_SETTING_IMPORTCHANNELS = 10;
 static int const MENUHOOK_SETTING_EXPORTCHANNELS = 11;
 static int const MENUHOOK_SETTING_CLEARCHANNELS = 12;
+static int const MENUHOOK_SETTING_SAVEREPLAY = 13;
+
+// TIMER_TYPE_XXXXXX
+//
+// Timer type identifiers
+static unsigned int const TIMER_TYPE_ONESHOT = 1;
 
 //---------------------------------------------------------------------------
 // DATA TYPES
@@ -81,16 +87,51 @@ struct settings {
 	// The index of a USB connected device
 	int device_connection_usb_index;
 
+	// device_connection_usb_all
+	//
+	// Flag to use all connected USB devices as a tuner pool
+	bool device_connection_usb_all;
+
 	// device_connection_tcp_host
 	//
 	// The IP address of the rtl_tcp host to connect to
 	std::string device_connection_tcp_host;
 
+	// device_connection_tcp_additional
+	//
+	// Additional rtl_tcp host:port endpoints to use as a tuner pool
+	std::string device_connection_tcp_additional;
+
 	// device_frequency_correction
 	//
 	// Frequency correction calibration value for the device
 	int device_frequency_correction;
 
+	// device_record_iq
+	//
+	// Flag to record the raw I/Q samples of live streams
+	bool device_record_iq;
+
+	// device_replay_seconds
+	//
+	// Length of the instant replay buffer, zero to disable
+	int device_replay_seconds;
+
+	// device_timeshift_memory
+	//
+	// Size of the timeshift memory buffer in MiB, zero to disable timeshift
+	int device_timeshift_memory;
+
+	// device_timeshift_disk
+	//
+	// Size of the timeshift disk buffer in MiB, zero to disable
+	int device_timeshift_disk;
+
+	// device_rawfile_maxspeed
+	//
+	// Flag to replay raw I/Q files as fast as they can be processed
+	bool device_rawfile_maxspeed;
+
 	// device_connection_tcp_port
 	//
 	// The port number of the rtl_tcp host to connect to
@@ -156,6 +197,11 @@ struct settings {
 	// Specifies the output gain for the DAB DSP
 	float dabradio_output_gain;
 
+	// dabradio_passthrough
+	//
+	// Flag to pass DAB+ audio through to Kodi without decoding it
+	bool dabradio_passthrough;
+
 	// wxradio_enable
 	//
 	// Enables the WX DSP
@@ -129,6 +129,7 @@ void rdsdecoder::decode_basictuning(tRDS_GROUPS const& rdsgroup)
 
 		// Reset the segment accumulator back to zero
 		m_ps_ready = 0x00;
+		m_ps_valid = true;
 	}
 }
 
@@ -632,6 +633,44 @@ void rdsdecoder::decode_slowlabellingcodes(tRDS_GROUPS const& rdsgroup)
 	}
 }
 
+//---------------------------------------------------------------------------
+// rdsdecoder::get_pi
+//
+// Retrieves the Program Identification (PI) code if present
+//
+// Arguments:
+//
+//	NONE
+
+uint16_t rdsdecoder::get_pi(void) const
+{
+	return (m_isrbds) ? m_rbds_pi : m_pi;
+}
+
+//---------------------------------------------------------------------------
+// rdsdecoder::get_ps_name
+//
+// Retrieves the Program Service (PS) name if present
+//
+// Arguments:
+//
+//	NONE
+
+std::string rdsdecoder::get_ps_name(void) const
+{
+	if(!m_ps_valid) return std::string();
+
+	// The PS name is space padded to 8 characters, trim any padding and NULLs
+	std::string name = std::string(m_ps_data.begin(), m_ps_data.end());
+	auto trimpos = name.find('\0');
+	if(trimpos != std::string::npos) name.erase(trimpos);
+
+	name.erase(name.find_last_not_of(' ') + 1);
+	name.erase(0, name.find_first_not_of(' '));
+
+	return name;
+}
+
 //---------------------------------------------------------------------------
 // rdsdecoder::get_rdbs_callsign
 //
@@ -655,6 +694,20 @@ std::string rdsdecoder::get_rbds_callsign(void) const
 	return callsign + "-FM";
 }
 
+//---------------------------------------------------------------------------
+// rdsdecoder::has_ps_name
+//
+// Flag indicating that the Program Service (PS) name has been decoded
+//
+// Arguments:
+//
+//	NONE
+
+bool rdsdecoder::has_ps_name(void) const
+{
+	return m_ps_valid;
+}
+
 //---------------------------------------------------------------------------
 // rdsdecoder::has_radiotextplus
 //
@@ -721,6 +774,42 @@ bool rdsdecoder::pop_uecp_data_packet(uecp_data_packet& packet)
 	return true;
 }
 
+//---------------------------------------------------------------------------
+// rdsdecoder::reset
+//
+// Resets the decoder state
+//
+// Arguments:
+//
+//	NONE
+
+void rdsdecoder::reset(void)
+{
+	m_uecp_packets = uecp_packet_queue();
+
+	m_pi = 0x0000;
+	m_pty = 0x00;
+
+	m_ps_ready = 0x00;
+	m_ps_valid = false;
+	m_ps_data.fill(0x00);
+
+	m_rt_init = false;
+	m_rt_ready = 0x0000;
+	m_rt_ab = 0x00;
+	m_rt_data.fill(0x00);
+
+	m_oda_rtplus = false;
+	m_oda_rdstmc = false;
+
+	m_rtplus_group = 0x00;
+	m_rtplus_group_ab = 0x00;
+
+	m_rbds_pi = 0x0000;
+	m_rbds_nationalcode.clear();
+	m_rbds_callsign.fill(0x00);
+}
+
 //---------------------------------------------------------------------------
 
 #pragma warning(pop)
@@ -59,11 +59,26 @@ public:
 	// Decodes the next RDS group
 	void decode_rdsgroup(tRDS_GROUPS const& rdsgroup);
 
+	// get_pi
+	//
+	// Retrieves the Program Identification (PI) code if present
+	uint16_t get_pi(void) const;
+
+	// get_ps_name
+	//
+	// Retrieves the Program Service (PS) name if present
+	std::string get_ps_name(void) const;
+
 	// get_rdbs_callsign
 	//
 	// Retrieves the RBDS call sign if present
 	std::string get_rbds_callsign(void) const;
 	
+	// has_ps_name
+	//
+	// Flag indicating that the Program Service (PS) name has been decoded
+	bool has_ps_name(void) const;
+
 	// has_radiotextplus
 	//
 	// Flag indicating that the RadioText+ (RT+) ODA is present
@@ -84,6 +99,11 @@ public:
 	// Pops the topmost UECP data packet from the queue
 	bool pop_uecp_data_packet(uecp_data_packet& frame);
 
+	// reset
+	//
+	// Resets the decoder state
+	void reset(void);
+
 private:
 
 	rdsdecoder(rdsdecoder const&) = delete;
@@ -157,6 +177,7 @@ private:
 	// GROUP 0 - BASIC TUNING AND SWITCHING INFORMATION
 	//
 	uint8_t						m_ps_ready = 0x00;			// PS name ready indicator
+	bool						m_ps_valid = false;			// PS name valid indicator
 	std::array<char, 8>			m_ps_data;					// Program Service name
 
 	// GROUP 2 - RADIOTEXT
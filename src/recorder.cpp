@@ -0,0 +1,441 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2020-2022 Michael G. Brehm
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#include "stdafx.h"
+#include "recorder.h"
+
+#include <algorithm>
+#include <assert.h>
+#include <string.h>
+
+#include "string_exception.h"
+
+#pragma warning(push, 4)
+
+// recorder::INDEX_INTERVAL (static)
+//
+// Minimum distance between the seek points in the index
+double const recorder::INDEX_INTERVAL = 1.0 * STREAM_TIME_BASE;
+
+// recorder::SEGMENT_DURATION (static)
+//
+// Duration of the audio written into each segment file
+double const recorder::SEGMENT_DURATION = 600.0 * STREAM_TIME_BASE;
+
+// recorder::SEGMENT_SIZE (static)
+//
+// Maximum length of a segment file
+uint32_t const recorder::SEGMENT_SIZE = (256 MiB);
+
+//---------------------------------------------------------------------------
+// recorder Constructor (private)
+//
+// Arguments:
+//
+//	stream		- Underlying PVR stream instance
+//	folder		- Folder in which to write the recording files
+
+recorder::recorder(std::unique_ptr<pvrstream> stream, char const* folder) : m_stream(std::move(stream)), m_folder((folder) ? folder : "")
+{
+	if(!m_stream) throw std::invalid_argument("stream");
+	if(folder == nullptr) throw std::invalid_argument("folder");
+
+	std::string const indexpath = recording_indexpath(m_folder);
+	m_index = fopen(indexpath.c_str(), "wb");
+	if(m_index == nullptr) throw string_exception(__func__, ": unable to create index file ", indexpath.c_str());
+
+	try {
+
+		// The first segment starts with the properties of the streams as they are right now,
+		// flush it immediately so that the recording can be opened for playback right away
+		update_properties();
+		open_segment();
+		fflush(m_segment);
+	}
+
+	catch(...) {
+
+		if(m_segment != nullptr) fclose(m_segment);
+		fclose(m_index);
+		throw;
+	}
+
+	// Create a worker thread on which to perform the transfer operations
+	scalar_condition<bool> started{ false };
+	m_worker = std::thread(&recorder::transfer, this, std::ref(started));
+	started.wait_until_equals(true);
+}
+
+//---------------------------------------------------------------------------
+// recorder Destructor
+
+recorder::~recorder()
+{
+	try { stop(); }
+	catch(...) { /* DO NOTHING */ }
+}
+
+//---------------------------------------------------------------------------
+// recorder::create (static)
+//
+// Factory method, creates a new recorder instance
+//
+// Arguments:
+//
+//	stream		- Underlying PVR stream instance
+//	folder		- Folder in which to write the recording files
+
+std::unique_ptr<recorder> recorder::create(std::unique_ptr<pvrstream> stream, char const* folder)
+{
+	return std::unique_ptr<recorder>(new recorder(std::move(stream), folder));
+}
+
+//---------------------------------------------------------------------------
+// recorder::duration
+//
+// Gets the duration of the recorded audio, in seconds
+//
+// Arguments:
+//
+//	NONE
+
+int recorder::duration(void) const
+{
+	return static_cast<int>(m_duration.load());
+}
+
+//---------------------------------------------------------------------------
+// recorder::open_segment (private)
+//
+// Opens the next segment file
+//
+// Arguments:
+//
+//	NONE
+
+void recorder::open_segment(void)
+{
+	if(m_segment != nullptr) {
+
+		fclose(m_segment);
+		m_segment = nullptr;
+		m_segmentnumber++;
+	}
+
+	std::string const path = recording_segmentpath(m_folder, m_segmentnumber);
+	m_segment = fopen(path.c_str(), "wb");
+	if(m_segment == nullptr) throw string_exception(__func__, ": unable to create segment file ", path.c_str());
+
+	m_segmentoffset = 0;
+	m_segmentpts = m_pts;
+	m_indexed = false;
+
+	// Every segment starts with the stream properties so that it can be decoded on its own
+	write_properties();
+}
+
+//---------------------------------------------------------------------------
+// recorder::remove (static)
+//
+// Deletes the index and segment files of a recording; the folder itself
+// is left for the caller to remove
+//
+// Arguments:
+//
+//	folder		- Recording folder
+
+void recorder::remove(char const* folder)
+{
+	if(folder == nullptr) throw std::invalid_argument("folder");
+
+	std::string const path(folder);
+
+	::remove(recording_indexpath(path).c_str());
+	for(uint32_t segment = 0; ::remove(recording_segmentpath(path, segment).c_str()) == 0; segment++);
+}
+
+//---------------------------------------------------------------------------
+// recorder::stop
+//
+// Stops the recording and completes the files
+//
+// Arguments:
+//
+//	NONE
+
+void recorder::stop(void)
+{
+	// The worker thread has to be stopped before the underlying stream is closed, the
+	// underlying demultiplexer is not safe to use once the stream has been closed; reads
+	// from the underlying streams time out if there is nothing available
+	m_stop = true;								// Signal worker thread to stop
+	if(m_worker.joinable()) m_worker.join();	// Wait for thread
+	m_stream->close();							// Close the underlying stream
+
+	// Report any exception that stopped the recording before it was asked to stop
+	if(m_worker_exception) {
+
+		std::exception_ptr ex = m_worker_exception;
+		m_worker_exception = nullptr;
+		std::rethrow_exception(ex);
+	}
+}
+
+//---------------------------------------------------------------------------
+// recorder::stopped
+//
+// Flag indicating if the recording has stopped
+//
+// Arguments:
+//
+//	NONE
+
+bool recorder::stopped(void) const
+{
+	return m_stopped.load();
+}
+
+//---------------------------------------------------------------------------
+// recorder::transfer (private)
+//
+// Worker thread procedure used to transfer packets into the recording
+//
+// Arguments:
+//
+//	started		- Condition variable to set when thread has started
+
+void recorder::transfer(scalar_condition<bool>& started)
+{
+	DEMUX_PACKET				packet = {};			// Packet returned by the allocator
+	std::vector<uint8_t>		data;					// Packet data buffer
+
+	// allocator (local)
+	//
+	// Demultiplexer packet allocator that reuses a single packet and data buffer
+	auto allocator = [&](int size) -> DEMUX_PACKET* {
+
+		data.resize(static_cast<size_t>(std::max(size, 0)));
+
+		packet = DEMUX_PACKET();
+		packet.pData = data.data();
+		packet.iSize = size;
+		packet.iStreamId = -1;
+		packet.pts = packet.dts = STREAM_NOPTS_VALUE;
+
+		return &packet;
+	};
+
+	started = true;
+
+	try {
+
+		while(m_stop.test(false)) {
+
+			DEMUX_PACKET const* demuxpacket = m_stream->demuxread(allocator);
+
+			// Stream changes are recorded so that playback switches formats at the same point
+			if((demuxpacket != nullptr) && (demuxpacket->iStreamId == DEMUX_SPECIALID_STREAMCHANGE)) {
+
+				update_properties();
+				write_properties();
+			}
+
+			else if((demuxpacket != nullptr) && (demuxpacket->iSize > 0)) write_packet(demuxpacket);
+
+			else m_stop.wait_until_equals(true, 10);
+		}
+	}
+
+	// Exceptions thrown after stop() has been called are not reported
+	catch(...) { if(m_stop.test(false)) m_worker_exception = std::current_exception(); }
+
+	// Mark the end of the recording with a final seek point so that the end time is exact
+	try {
+
+		write_record(RECORD_STREAMID_END, nullptr, 0, 0.0);
+		write_index();
+	}
+
+	catch(...) { /* DO NOTHING */ }
+
+	fclose(m_segment);
+	fclose(m_index);
+	m_segment = m_index = nullptr;
+
+	m_stopped.store(true);
+}
+
+//---------------------------------------------------------------------------
+// recorder::update_properties (private)
+//
+// Updates the recorded stream properties from the underlying stream
+//
+// Arguments:
+//
+//	NONE
+
+void recorder::update_properties(void)
+{
+	std::vector<struct stream_t> streams;
+
+	m_stream->enumproperties([&](struct streamprops const& props) -> void {
+
+		struct stream_t stream = {};
+		char const* codec = props.codec;
+
+		stream.props.pid = props.pid;
+		stream.props.channels = props.channels;
+		stream.props.samplerate = props.samplerate;
+		stream.props.bitspersample = props.bitspersample;
+
+		// PCM audio is compressed losslessly, everything else is recorded as it is
+		if((strcmp(props.codec, "pcm_s16le") == 0) && (props.channels >= 1) && (props.channels <= 8)) {
+
+			stream.encoder = flacencoder::create(props.channels, props.samplerate);
+			codec = "flac";
+		}
+
+		strncpy(stream.props.codec, codec, std::extent<decltype(stream.props.codec)>::value - 1);
+		streams.push_back(std::move(stream));
+	});
+
+	m_streams = std::move(streams);
+}
+
+//---------------------------------------------------------------------------
+// recorder::write_index (private)
+//
+// Writes a seek point for the current position into the index
+//
+// Arguments:
+//
+//	NONE
+
+void recorder::write_index(void)
+{
+	// The segment is flushed first so that a seek point never refers to data that isn't on disk yet
+	fflush(m_segment);
+
+	struct recordindex const entry = { m_pts, m_segmentnumber, m_segmentoffset, m_propsoffset, 0 };
+	if(fwrite(&entry, sizeof(entry), 1, m_index) != 1) throw string_exception(__func__, ": unable to write to index file");
+	fflush(m_index);
+
+	m_indexpts = m_pts;
+	m_indexed = true;
+}
+
+//---------------------------------------------------------------------------
+// recorder::write_packet (private)
+//
+// Writes a demultiplexer packet into the recording
+//
+// Arguments:
+//
+//	packet		- Demultiplexer packet to be written
+
+void recorder::write_packet(DEMUX_PACKET const* packet)
+{
+	assert(packet != nullptr);
+
+	size_t const size = static_cast<size_t>(std::max(packet->iSize, 0));
+
+	// Only packets with a duration (audio) can start a segment or be used as a seek point
+	if(packet->duration > 0.0) {
+
+		if(((m_pts - m_segmentpts) >= SEGMENT_DURATION) || (m_segmentoffset >= SEGMENT_SIZE)) open_segment();
+		if((!m_indexed) || ((m_pts - m_indexpts) >= INDEX_INTERVAL)) write_index();
+	}
+
+	auto found = std::find_if(m_streams.begin(), m_streams.end(), [&](struct stream_t const& stream) -> bool {
+		return stream.props.pid == packet->iStreamId; });
+
+	if((found == m_streams.end()) || (!found->encoder)) {
+
+		write_record(packet->iStreamId, packet->pData, size, packet->duration);
+		return;
+	}
+
+	// PCM audio is split into FLAC frames of no more than the maximum block size,
+	// the duration of the packet is divided proportionally among the frames
+	size_t const channels = static_cast<size_t>(found->props.channels);
+	size_t const total = size / (sizeof(int16_t) * channels);
+	int16_t const* samples = reinterpret_cast<int16_t const*>(packet->pData);
+
+	for(size_t offset = 0; offset < total;) {
+
+		size_t const count = std::min(total - offset, flacencoder::MAX_BLOCK_SIZE);
+		found->encoder->encode(&samples[offset * channels], count, m_frame);
+		write_record(packet->iStreamId, m_frame.data(), m_frame.size(), (packet->duration * count) / total);
+
+		offset += count;
+	}
+}
+
+//---------------------------------------------------------------------------
+// recorder::write_properties (private)
+//
+// Writes the stream properties record into the current segment
+//
+// Arguments:
+//
+//	NONE
+
+void recorder::write_properties(void)
+{
+	std::vector<struct recordstream> props;
+	for(auto const& stream : m_streams) props.push_back(stream.props);
+
+	m_propsoffset = m_segmentoffset;
+	write_record(DEMUX_SPECIALID_STREAMCHANGE, reinterpret_cast<uint8_t const*>(props.data()), props.size() * sizeof(struct recordstream), 0.0);
+}
+
+//---------------------------------------------------------------------------
+// recorder::write_record (private)
+//
+// Writes a single record into the current segment
+//
+// Arguments:
+//
+//	streamid	- Demultiplexer stream identifier
+//	data		- Record data
+//	size		- Length of the record data
+//	duration	- Duration of the record data
+
+void recorder::write_record(int32_t streamid, uint8_t const* data, size_t size, double duration)
+{
+	assert((data != nullptr) || (size == 0));
+
+	struct recordheader const header = { streamid, static_cast<uint32_t>(size), m_pts, duration };
+	if((fwrite(&header, sizeof(header), 1, m_segment) != 1) || ((size > 0) && (fwrite(data, 1, size, m_segment) != size)))
+		throw string_exception(__func__, ": unable to write to segment file");
+
+	m_segmentoffset += static_cast<uint32_t>(sizeof(header) + size);
+
+	// The underlying streams reset their time stamps when they change formats; restamp each
+	// record onto a continuous timeline so that the seek points can be located by time
+	if(duration > 0.0) m_pts += duration;
+	m_duration.store((m_pts - STREAM_TIME_BASE) / STREAM_TIME_BASE);
+}
+
+//---------------------------------------------------------------------------
+
+#pragma warning(pop)
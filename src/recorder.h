@@ -0,0 +1,194 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2020-2022 Michael G. Brehm
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#ifndef __RECORDER_H_
+#define __RECORDER_H_
+#pragma once
+
+#include <atomic>
+#include <exception>
+#include <memory>
+#include <stdio.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "flacencoder.h"
+#include "pvrstream.h"
+#include "recordingformat.h"
+#include "scalar_condition.h"
+
+#pragma warning(push, 4)
+
+//---------------------------------------------------------------------------
+// Class recorder
+//
+// Implements the writer for a single recording.  A dedicated worker thread
+// reads the demultiplexer packets from a PVR stream that owns its own tuner,
+// PCM audio is compressed into FLAC frames and everything else is passed
+// through unchanged, and the packets are written into the segment files of
+// the recording along with a seek index roughly once a second
+
+class recorder
+{
+public:
+
+	// Destructor
+	//
+	~recorder();
+
+	//-----------------------------------------------------------------------
+	// Member Functions
+
+	// create (static)
+	//
+	// Factory method, creates a new recorder instance
+	static std::unique_ptr<recorder> create(std::unique_ptr<pvrstream> stream, char const* folder);
+
+	// duration
+	//
+	// Gets the duration of the recorded audio, in seconds
+	int duration(void) const;
+
+	// remove (static)
+	//
+	// Deletes the index and segment files of a recording
+	static void remove(char const* folder);
+
+	// stop
+	//
+	// Stops the recording and completes the files
+	void stop(void);
+
+	// stopped
+	//
+	// Flag indicating if the recording has stopped
+	bool stopped(void) const;
+
+private:
+
+	recorder(recorder const&) = delete;
+	recorder& operator=(recorder const&) = delete;
+
+	// INDEX_INTERVAL
+	//
+	// Minimum distance between the seek points in the index
+	static double const INDEX_INTERVAL;
+
+	// SEGMENT_DURATION
+	//
+	// Duration of the audio written into each segment file
+	static double const SEGMENT_DURATION;
+
+	// SEGMENT_SIZE
+	//
+	// Maximum length of a segment file
+	static uint32_t const SEGMENT_SIZE;
+
+	// Instance Constructor
+	//
+	recorder(std::unique_ptr<pvrstream> stream, char const* folder);
+
+	//-----------------------------------------------------------------------
+	// Private Type Declarations
+
+	// stream_t
+	//
+	// Defines the state of a single recorded stream
+	struct stream_t {
+
+		struct recordstream				props;			// Recorded stream properties
+		std::unique_ptr<flacencoder>	encoder;		// FLAC encoder for PCM audio
+	};
+
+	//-----------------------------------------------------------------------
+	// Private Member Functions
+
+	// open_segment
+	//
+	// Opens the next segment file
+	void open_segment(void);
+
+	// transfer
+	//
+	// Worker thread procedure used to transfer packets into the recording
+	void transfer(scalar_condition<bool>& started);
+
+	// update_properties
+	//
+	// Updates the recorded stream properties from the underlying stream
+	void update_properties(void);
+
+	// write_index
+	//
+	// Writes a seek point for the current position into the index
+	void write_index(void);
+
+	// write_packet
+	//
+	// Writes a demultiplexer packet into the recording
+	void write_packet(DEMUX_PACKET const* packet);
+
+	// write_properties
+	//
+	// Writes the stream properties record into the current segment
+	void write_properties(void);
+
+	// write_record
+	//
+	// Writes a single record into the current segment
+	void write_record(int32_t streamid, uint8_t const* data, size_t size, double duration);
+
+	//-----------------------------------------------------------------------
+	// Member Variables
+
+	std::unique_ptr<pvrstream>			m_stream;					// Underlying PVR stream
+	std::string const					m_folder;					// Recording folder
+
+	// RECORDING
+	//
+	FILE*								m_index = nullptr;			// Index file handle
+	FILE*								m_segment = nullptr;		// Segment file handle
+	uint32_t							m_segmentnumber = 0;		// Current segment number
+	uint32_t							m_segmentoffset = 0;		// Current segment offset
+	double								m_segmentpts = 0;			// Time stamp at segment start
+	uint32_t							m_propsoffset = 0;			// Offset of the properties record
+	double								m_indexpts = 0;				// Time stamp of the last seek point
+	bool								m_indexed = false;			// Flag if segment has a seek point
+	double								m_pts{ STREAM_TIME_BASE };	// Next restamped time stamp
+	std::atomic<double>					m_duration{ 0 };			// Duration of the recording
+	std::vector<struct stream_t>		m_streams;					// Recorded streams
+	std::vector<uint8_t>				m_frame;					// Encoded frame buffer
+
+	// STREAM CONTROL
+	//
+	std::thread							m_worker;					// Data transfer thread
+	std::exception_ptr					m_worker_exception;			// Exception on worker thread
+	scalar_condition<bool>				m_stop{ false };			// Condition to stop data transfer
+	std::atomic<bool>					m_stopped{ false };			// Data transfer stopped flag
+};
+
+//-----------------------------------------------------------------------------
+
+#pragma warning(pop)
+
+#endif	// __RECORDER_H_
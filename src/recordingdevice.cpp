@@ -0,0 +1,555 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2020-2022 Michael G. Brehm
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#include "stdafx.h"
+#include "recordingdevice.h"
+
+#include <algorithm>
+#include <assert.h>
+#include <ctime>
+#include <stdio.h>
+#include <string.h>
+#include <thread>
+
+#include <rapidjson/stringbuffer.h>
+#include <rapidjson/prettywriter.h>
+
+#include "string_exception.h"
+
+#pragma warning(push, 4)
+
+// recordingdevice::BUFFER_COUNT (static)
+//
+// Number of buffers in the recording buffer pool
+size_t const recordingdevice::BUFFER_COUNT = 8;
+
+// recordingdevice::BUFFER_SIZE (static)
+//
+// Size of each buffer in the recording buffer pool
+size_t const recordingdevice::BUFFER_SIZE = (4 << 20);
+
+//---------------------------------------------------------------------------
+// recordingdevice Constructor (private)
+//
+// Arguments:
+//
+//	device		- Device instance to be decorated
+//	folder		- Folder in which to create the recordings
+
+recordingdevice::recordingdevice(std::unique_ptr<rtldevice> device, char const* folder) : m_device(std::move(device)), m_folder((folder) ? folder : "")
+{
+	if(!m_device) throw std::invalid_argument("device");
+	if(m_folder.empty()) throw std::invalid_argument("folder");
+}
+
+//---------------------------------------------------------------------------
+// recordingdevice Destructor
+
+recordingdevice::~recordingdevice()
+{
+}
+
+//---------------------------------------------------------------------------
+// recordingdevice::add_capture (private)
+//
+// Adds a capture segment to the recording at the current position
+//
+// Arguments:
+//
+//	NONE
+
+void recordingdevice::add_capture(void) const
+{
+	std::unique_lock<std::mutex> lock(m_lock);
+
+	if(!m_recording.load()) return;
+
+	// When decimating the samples are centered on the decimation offset rather than
+	// on the tuner center frequency
+	uint32_t const frequency = (m_decimation > 1) ? static_cast<uint32_t>(static_cast<int64_t>(m_frequency) + m_offset) : m_frequency;
+	uint64_t const sample = m_samples.load();
+
+	// Retuning usually changes both the tuner frequency and the decimation offset;
+	// collapse those into a single capture segment
+	if((!m_captures.empty()) && (m_captures.back().first == sample)) m_captures.back().second = frequency;
+	else if(m_captures.empty() || (m_captures.back().second != frequency)) m_captures.emplace_back(sample, frequency);
+}
+
+//---------------------------------------------------------------------------
+// recordingdevice::begin_stream
+//
+// Starts streaming data from the device
+//
+// Arguments:
+//
+//	NONE
+
+void recordingdevice::begin_stream(void) const
+{
+	m_device->begin_stream();
+}
+
+//---------------------------------------------------------------------------
+// recordingdevice::cancel_async
+//
+// Cancels any pending asynchronous read operations from the device
+//
+// Arguments:
+//
+//	NONE
+
+void recordingdevice::cancel_async(void) const
+{
+	m_device->cancel_async();
+}
+
+//---------------------------------------------------------------------------
+// recordingdevice::create (static)
+//
+// Factory method, creates a new recordingdevice instance
+//
+// Arguments:
+//
+//	device		- Device instance to be decorated
+//	folder		- Folder in which to create the recordings
+
+std::unique_ptr<recordingdevice> recordingdevice::create(std::unique_ptr<rtldevice> device, char const* folder)
+{
+	return std::unique_ptr<recordingdevice>(new recordingdevice(std::move(device), folder));
+}
+
+//---------------------------------------------------------------------------
+// recordingdevice::get_device_name
+//
+// Gets the name of the device
+//
+// Arguments:
+//
+//	NONE
+
+char const* recordingdevice::get_device_name(void) const
+{
+	return m_device->get_device_name();
+}
+
+//---------------------------------------------------------------------------
+// recordingdevice::get_valid_gains
+//
+// Gets the valid tuner gain values for the device
+//
+// Arguments:
+//
+//	dbs			- vector<> to retrieve the valid gain values
+
+void recordingdevice::get_valid_gains(std::vector<int>& dbs) const
+{
+	m_device->get_valid_gains(dbs);
+}
+
+//---------------------------------------------------------------------------
+// recordingdevice::read
+//
+// Reads data from the device
+//
+// Arguments:
+//
+//	buffer		- Buffer to receive the data
+//	count		- Size of the destination buffer, specified in bytes
+
+size_t recordingdevice::read(uint8_t* buffer, size_t count) const
+{
+	return m_device->read(buffer, count);
+}
+
+//---------------------------------------------------------------------------
+// recordingdevice::read_async
+//
+// Asynchronously reads data from the device
+//
+// Arguments:
+//
+//	callback		- Asynchronous read callback function
+//	bufferlength	- Output buffer length in bytes
+
+void recordingdevice::read_async(rtldevice::asynccallback const& callback, uint32_t bufferlength) const
+{
+	// Generate the recording file names from the current UTC time and frequency
+	time_t now = time(nullptr);
+	struct tm utc = {};
+#ifdef _WINDOWS
+	gmtime_s(&utc, &now);
+#else
+	gmtime_r(&now, &utc);
+#endif
+
+	char timestamp[32] = {};
+	char datetime[32] = {};
+	strftime(timestamp, sizeof(timestamp), "%Y%m%d-%H%M%S", &utc);
+	strftime(datetime, sizeof(datetime), "%Y-%m-%dT%H:%M:%SZ", &utc);
+
+	std::string basename(m_folder);
+	if((basename.back() != '/') && (basename.back() != '\\')) basename.push_back('/');
+	basename.append(timestamp).append("-").append(std::to_string(m_frequency));
+
+	// If the recording cannot be created, the stream is more important than the recording
+	FILE* file = fopen((basename + ".sigmf-data").c_str(), "wb");
+	if(file == nullptr) return m_device->read_async(callback, bufferlength);
+
+	// The buffers are far larger than any stdio buffer, write them straight through
+	setvbuf(file, nullptr, _IONBF, 0);
+
+	// Reset the recording state and the buffer pool
+	{
+		std::unique_lock<std::mutex> lock(m_lock);
+
+		m_buffers.resize(BUFFER_COUNT);
+		m_free.clear();
+		m_filled.clear();
+		for(size_t index = 0; index < BUFFER_COUNT; index++) {
+
+			if(!m_buffers[index].data) m_buffers[index].data.reset(new uint8_t[BUFFER_SIZE]);
+			m_buffers[index].length = 0;
+			m_free.push_back(index);
+		}
+
+		m_current = SIZE_MAX;
+		m_stop = m_failed = false;
+		m_samples.store(0);
+		m_captures.clear();
+		m_gaps.clear();
+		m_recordrate = m_samplerate / std::max(m_decimation, 1U);
+		m_recording.store(true);
+	}
+
+	add_capture();
+
+	std::thread writerthread(&recordingdevice::writer, this, file);
+
+	// Stops the writer thread and flushes what is left of the recording
+	auto finish = [&]() -> void {
+
+		{
+			std::unique_lock<std::mutex> lock(m_lock);
+
+			m_recording.store(false);
+
+			// The device has stopped calling back, the partially filled buffer can be
+			// handed over to the writer as the last one
+			if(m_current != SIZE_MAX) { m_filled.push_back(m_current); m_current = SIZE_MAX; }
+			m_stop = true;
+		}
+
+		m_cv.notify_all();
+		writerthread.join();
+		fclose(file);
+
+		write_metadata(basename + ".sigmf-meta", datetime);
+	};
+
+	try {
+
+		m_device->read_async([&](uint8_t const* buffer, size_t count) -> void {
+
+			record(buffer, count);
+			callback(buffer, count);
+
+		}, bufferlength);
+	}
+
+	catch(...) { finish(); throw; }
+
+	finish();
+}
+
+//---------------------------------------------------------------------------
+// recordingdevice::record (private)
+//
+// Copies a block of samples into the recording buffer pool
+//
+// Arguments:
+//
+//	buffer		- Block of samples to be recorded
+//	count		- Size of the block, specified in bytes
+
+void recordingdevice::record(uint8_t const* buffer, size_t count) const
+{
+	assert(buffer != nullptr);
+
+	// The lock is only taken when a buffer has been filled or another one is needed,
+	// which is only once every few megabytes while the writer is keeping up
+	while(count > 0) {
+
+		if(m_current == SIZE_MAX) {
+
+			std::unique_lock<std::mutex> lock(m_lock);
+
+			// If there are no free buffers the writer has fallen behind; drop the rest of
+			// this block from the recording and note the gap
+			if(m_free.empty() || m_failed) {
+
+				uint64_t const sample = m_samples.load();
+				if((!m_gaps.empty()) && (m_gaps.back().first == sample)) m_gaps.back().second += count / 2;
+				else m_gaps.emplace_back(sample, count / 2);
+
+				return;
+			}
+
+			m_current = m_free.front();
+			m_free.pop_front();
+		}
+
+		struct buffer_t& current = m_buffers[m_current];
+
+		size_t const cb = std::min(count, BUFFER_SIZE - current.length);
+		memcpy(&current.data[current.length], buffer, cb);
+		current.length += cb;
+		m_samples.fetch_add(cb / 2);
+
+		buffer += cb;
+		count -= cb;
+
+		// Hand a filled buffer over to the writer thread
+		if(current.length == BUFFER_SIZE) {
+
+			std::unique_lock<std::mutex> lock(m_lock);
+			m_filled.push_back(m_current);
+			m_current = SIZE_MAX;
+			m_cv.notify_all();
+		}
+	}
+}
+
+//---------------------------------------------------------------------------
+// recordingdevice::set_automatic_gain_control
+//
+// Enables/disables the automatic gain control mode of the device
+//
+// Arguments:
+//
+//	enable		- Flag to enable/disable test mode
+
+void recordingdevice::set_automatic_gain_control(bool enable) const
+{
+	m_device->set_automatic_gain_control(enable);
+}
+
+//---------------------------------------------------------------------------
+// recordingdevice::set_center_frequency
+//
+// Sets the center frequency of the device
+//
+// Arguments:
+//
+//	hz		- Frequency to set, specified in hertz
+
+uint32_t recordingdevice::set_center_frequency(uint32_t hz) const
+{
+	m_frequency = m_device->set_center_frequency(hz);
+	add_capture();
+
+	return m_frequency;
+}
+
+//---------------------------------------------------------------------------
+// recordingdevice::set_decimation
+//
+// Sets the frequency offset and decimation factor applied by the device
+//
+// Arguments:
+//
+//	offset		- Frequency offset to shift to zero, specified in hertz
+//	factor		- Requested decimation factor
+
+uint32_t recordingdevice::set_decimation(int offset, uint32_t factor) const
+{
+	m_decimation = m_device->set_decimation(offset, factor);
+	m_offset = offset;
+	add_capture();
+
+	return m_decimation;
+}
+
+//---------------------------------------------------------------------------
+// recordingdevice::set_frequency_correction
+//
+// Sets the frequency correction of the device
+//
+// Arguments:
+//
+//	ppm		- Frequency correction to set, specified in parts per million
+
+int recordingdevice::set_frequency_correction(int ppm) const
+{
+	return m_device->set_frequency_correction(ppm);
+}
+
+//---------------------------------------------------------------------------
+// recordingdevice::set_gain
+//
+// Sets the gain of the device
+//
+// Arguments:
+//
+//	db			- Gain to set, specified in tenths of a decibel
+
+int recordingdevice::set_gain(int db) const
+{
+	return m_device->set_gain(db);
+}
+
+//---------------------------------------------------------------------------
+// recordingdevice::set_sample_rate
+//
+// Sets the sample rate of the device
+//
+// Arguments:
+//
+//	hz		- Sample rate to set, specified in hertz
+
+uint32_t recordingdevice::set_sample_rate(uint32_t hz) const
+{
+	// Changing the sample rate also resets any decimation applied by the device
+	m_samplerate = m_device->set_sample_rate(hz);
+	m_decimation = 1;
+
+	return m_samplerate;
+}
+
+//---------------------------------------------------------------------------
+// recordingdevice::set_test_mode
+//
+// Enables/disables the test mode of the device
+//
+// Arguments:
+//
+//	enable		- Flag to enable/disable test mode
+
+void recordingdevice::set_test_mode(bool enable) const
+{
+	m_device->set_test_mode(enable);
+}
+
+//---------------------------------------------------------------------------
+// recordingdevice::write_metadata (private)
+//
+// Writes the SigMF metadata file for the recording
+//
+// Arguments:
+//
+//	metafile	- SigMF metadata file name
+//	datetime	- ISO 8601 recording start time
+
+void recordingdevice::write_metadata(std::string const& metafile, std::string const& datetime) const
+{
+	rapidjson::StringBuffer								sb;			// JSON string buffer
+	rapidjson::PrettyWriter<rapidjson::StringBuffer>	writer(sb);	// JSON writer
+
+	std::unique_lock<std::mutex> lock(m_lock);
+
+	writer.StartObject();
+
+	writer.Key("global");
+	writer.StartObject();
+	writer.Key("core:datatype"); writer.String("cu8");
+	writer.Key("core:sample_rate"); writer.Double(static_cast<double>(m_recordrate));
+	writer.Key("core:version"); writer.String("1.0.0");
+	writer.Key("core:recorder"); writer.String("pvr.rtlradio");
+	writer.Key("core:hw"); writer.String(m_device->get_device_name());
+	writer.EndObject();
+
+	writer.Key("captures");
+	writer.StartArray();
+	for(auto const& capture : m_captures) {
+
+		writer.StartObject();
+		writer.Key("core:sample_start"); writer.Uint64(capture.first);
+		writer.Key("core:frequency"); writer.Double(static_cast<double>(capture.second));
+		if(capture.first == 0) { writer.Key("core:datetime"); writer.String(datetime.c_str()); }
+		writer.EndObject();
+	}
+	writer.EndArray();
+
+	// Samples dropped from the recording are noted as annotations at the point where
+	// the discontinuity occurs in the recorded samples
+	writer.Key("annotations");
+	writer.StartArray();
+	for(auto const& gap : m_gaps) {
+
+		std::string comment = std::to_string(gap.second) + " samples dropped from the recording";
+
+		writer.StartObject();
+		writer.Key("core:sample_start"); writer.Uint64(gap.first);
+		writer.Key("core:sample_count"); writer.Uint64(0);
+		writer.Key("core:comment"); writer.String(comment.c_str());
+		writer.EndObject();
+	}
+	writer.EndArray();
+
+	writer.EndObject();
+
+	FILE* file = fopen(metafile.c_str(), "wb");
+	if(file == nullptr) return;
+
+	fwrite(sb.GetString(), 1, sb.GetSize(), file);
+	fclose(file);
+}
+
+//---------------------------------------------------------------------------
+// recordingdevice::writer (private)
+//
+// Writes filled buffers from the recording buffer pool into the data file
+//
+// Arguments:
+//
+//	file		- Recording data file
+
+void recordingdevice::writer(FILE* file) const
+{
+	assert(file != nullptr);
+
+	std::unique_lock<std::mutex> lock(m_lock);
+
+	while(true) {
+
+		m_cv.wait(lock, [&]() -> bool { return m_stop || !m_filled.empty(); });
+		if(m_filled.empty()) break;				// Only stop once everything is written
+
+		size_t const index = m_filled.front();
+		m_filled.pop_front();
+
+		// Write the buffer without holding the lock so the device callback can continue
+		// to fill the other buffers in the pool
+		lock.unlock();
+		struct buffer_t& buffer = m_buffers[index];
+		bool const failed = (fwrite(&buffer.data[0], 1, buffer.length, file) != buffer.length);
+		buffer.length = 0;
+		lock.lock();
+
+		// A failed write (disk full, for example) ends the recording but not the stream
+		if(failed) m_failed = true;
+		m_free.push_back(index);
+	}
+}
+
+//---------------------------------------------------------------------------
+
+#pragma warning(pop)
@@ -0,0 +1,229 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2020-2022 Michael G. Brehm
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#ifndef __RECORDINGDEVICE_H_
+#define __RECORDINGDEVICE_H_
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "rtldevice.h"
+
+#pragma warning(push, 4)
+
+//---------------------------------------------------------------------------
+// Class recordingdevice
+//
+// Implements a device decorator that records the raw I/Q samples delivered by
+// an asynchronous read into a SigMF recording that can be replayed with the
+// file device.  The samples are copied into a small pool of large buffers on
+// the device callback thread and written to disk by a dedicated thread; if the
+// disk cannot keep up the samples are dropped from the recording rather than
+// ever stalling the device, and the gap is noted in the recording metadata
+
+class recordingdevice : public rtldevice
+{
+public:
+
+	// Destructor
+	//
+	virtual ~recordingdevice();
+
+	//-----------------------------------------------------------------------
+	// Member Functions
+
+	// begin_stream
+	//
+	// Starts streaming data from the device
+	void begin_stream(void) const override;
+
+	// cancel_async
+	//
+	// Cancels any pending asynchronous read operations from the device
+	void cancel_async(void) const override;
+
+	// create (static)
+	//
+	// Factory method, creates a new recordingdevice instance
+	static std::unique_ptr<recordingdevice> create(std::unique_ptr<rtldevice> device, char const* folder);
+
+	// get_device_name
+	//
+	// Gets the name of the device
+	char const* get_device_name(void) const override;
+
+	// get_valid_gains
+	//
+	// Gets the valid tuner gain values for the device
+	void get_valid_gains(std::vector<int>& dbs) const override;
+
+	// read
+	//
+	// Reads data from the device
+	size_t read(uint8_t* buffer, size_t count) const override;
+
+	// read_async
+	//
+	// Asynchronously reads data from the device
+	void read_async(rtldevice::asynccallback const& callback, uint32_t bufferlength) const override;
+
+	// set_automatic_gain_control
+	//
+	// Enables/disables the automatic gain control of the device
+	void set_automatic_gain_control(bool enable) const override;
+
+	// set_center_frequency
+	//
+	// Sets the center frequency of the device
+	uint32_t set_center_frequency(uint32_t hz) const override;
+
+	// set_decimation
+	//
+	// Sets the frequency offset and decimation factor applied by the device
+	uint32_t set_decimation(int offset, uint32_t factor) const override;
+
+	// set_frequency_correction
+	//
+	// Sets the frequency correction of the device
+	int set_frequency_correction(int ppm) const override;
+
+	// set_gain
+	//
+	// Sets the gain value of the device
+	int set_gain(int db) const override;
+
+	// set_sample_rate
+	//
+	// Sets the sample rate of the device
+	uint32_t set_sample_rate(uint32_t hz) const override;
+
+	// set_test_mode
+	//
+	// Enables/disables the test mode of the device
+	void set_test_mode(bool enable) const override;
+
+private:
+
+	recordingdevice(recordingdevice const&) = delete;
+	recordingdevice& operator=(recordingdevice const&) = delete;
+
+	// BUFFER_COUNT
+	//
+	// Number of buffers in the recording buffer pool
+	static size_t const BUFFER_COUNT;
+
+	// BUFFER_SIZE
+	//
+	// Size of each buffer in the recording buffer pool
+	static size_t const BUFFER_SIZE;
+
+	// Instance Constructor
+	//
+	recordingdevice(std::unique_ptr<rtldevice> device, char const* folder);
+
+	//-----------------------------------------------------------------------
+	// Private Type Declarations
+
+	// buffer_t
+	//
+	// Defines a single buffer in the recording buffer pool
+	struct buffer_t {
+
+		std::unique_ptr<uint8_t[]>	data;			// Buffer data
+		size_t						length;			// Length of the buffer data
+	};
+
+	// capture_t
+	//
+	// Defines a SigMF capture segment (sample index, center frequency)
+	using capture_t = std::pair<uint64_t, uint32_t>;
+
+	// gap_t
+	//
+	// Defines a gap in the recording (sample index, dropped sample count)
+	using gap_t = std::pair<uint64_t, uint64_t>;
+
+	//-----------------------------------------------------------------------
+	// Private Member Functions
+
+	// add_capture
+	//
+	// Adds a capture segment to the recording at the current position
+	void add_capture(void) const;
+
+	// record
+	//
+	// Copies a block of samples into the recording buffer pool
+	void record(uint8_t const* buffer, size_t count) const;
+
+	// write_metadata
+	//
+	// Writes the SigMF metadata file for the recording
+	void write_metadata(std::string const& metafile, std::string const& datetime) const;
+
+	// writer
+	//
+	// Writes filled buffers from the recording buffer pool into the data file
+	void writer(FILE* file) const;
+
+	//-----------------------------------------------------------------------
+	// Member Variables
+
+	std::unique_ptr<rtldevice>		m_device;				// Decorated device instance
+	std::string const				m_folder;				// Recording folder
+	mutable uint32_t				m_frequency = 0;		// Current center frequency
+	mutable uint32_t				m_samplerate = 0;		// Current sample rate
+	mutable uint32_t				m_decimation = 1;		// Current decimation factor
+	mutable int						m_offset = 0;			// Current decimation offset
+	mutable uint32_t				m_recordrate = 0;		// Recording sample rate
+
+	// RECORDING BUFFER POOL
+	//
+	mutable std::vector<struct buffer_t>	m_buffers;		// Recording buffers
+	mutable std::deque<size_t>		m_free;					// Free buffer indexes
+	mutable std::deque<size_t>		m_filled;				// Filled buffer indexes
+	mutable size_t					m_current = SIZE_MAX;	// Buffer being filled
+	mutable bool					m_stop = false;			// Flag to stop the writer
+	mutable bool					m_failed = false;		// Flag if a write failed
+	mutable std::condition_variable	m_cv;					// Writer condition variable
+
+	// RECORDING STATE
+	//
+	mutable std::mutex				m_lock;					// Synchronization object
+	mutable std::atomic<uint64_t>	m_samples{ 0 };			// Samples recorded so far
+	mutable std::atomic<bool>		m_recording{ false };	// Flag if recording is active
+	mutable std::vector<capture_t>	m_captures;				// Capture segments
+	mutable std::vector<gap_t>		m_gaps;					// Recording gaps
+};
+
+//-----------------------------------------------------------------------------
+
+#pragma warning(pop)
+
+#endif	// __RECORDINGDEVICE_H_
@@ -0,0 +1,127 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2020-2022 Michael G. Brehm
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#ifndef __RECORDINGFORMAT_H_
+#define __RECORDINGFORMAT_H_
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string>
+#include <type_traits>
+
+#pragma warning(push, 4)
+
+//---------------------------------------------------------------------------
+// RECORDING FORMAT
+//
+// A recording is a folder that contains a series of numbered segment files and
+// a single index file.  Each segment is a sequence of records that hold one
+// demultiplexer packet each, the first record of every segment describes the
+// streams so that each segment can be decoded on its own.  The index file is
+// an array of seek points into the segments.  The structures are written in
+// the native byte order since the files are only read back by this addon
+//---------------------------------------------------------------------------
+
+// RECORD_STREAMID_END
+//
+// Stream identifier of the record that marks the end of a completed recording
+static int32_t const RECORD_STREAMID_END = -1;
+
+#pragma pack(push, 1)
+
+// recordheader
+//
+// Defines the header of a single record in a segment file; stream property
+// records use DEMUX_SPECIALID_STREAMCHANGE as the stream identifier and are
+// followed by an array of recordstream structures
+struct recordheader {
+
+	int32_t				streamid;			// Demultiplexer stream identifier
+	uint32_t			size;				// Length of the record data
+	double				pts;				// Presentation time stamp
+	double				duration;			// Packet duration
+};
+
+// recordindex
+//
+// Defines a single seek point in the index file
+struct recordindex {
+
+	double				pts;				// Presentation time stamp
+	uint32_t			segment;			// Segment number
+	uint32_t			offset;				// Offset of the record in the segment
+	uint32_t			propsoffset;		// Offset of the stream properties in effect
+	uint32_t			reserved;			// Reserved for future use
+};
+
+// recordstream
+//
+// Defines the properties of a single recorded stream
+struct recordstream {
+
+	char				codec[16];			// Stream codec name
+	int32_t				pid;				// Stream PID
+	int32_t				channels;			// Stream number of channels
+	int32_t				samplerate;			// Stream sample rate
+	int32_t				bitspersample;		// Stream bits per sample
+};
+
+#pragma pack(pop)
+
+//---------------------------------------------------------------------------
+// recording_indexpath
+//
+// Generates the path to the index file of a recording
+//
+// Arguments:
+//
+//	folder		- Recording folder
+
+inline std::string recording_indexpath(std::string const& folder)
+{
+	return folder + "/index.rec";
+}
+
+//---------------------------------------------------------------------------
+// recording_segmentpath
+//
+// Generates the path to a segment file of a recording
+//
+// Arguments:
+//
+//	folder		- Recording folder
+//	segment		- Segment number
+
+inline std::string recording_segmentpath(std::string const& folder, uint32_t segment)
+{
+	char filename[32] = {};
+	snprintf(filename, std::extent<decltype(filename)>::value, "/segment-%04u.rec", segment);
+
+	return folder + filename;
+}
+
+//---------------------------------------------------------------------------
+
+#pragma warning(pop)
+
+#endif	// __RECORDINGFORMAT_H_
@@ -0,0 +1,573 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2020-2022 Michael G. Brehm
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#include "stdafx.h"
+#include "recordingstream.h"
+
+#include <algorithm>
+#include <memory.h>
+
+#include "string_exception.h"
+
+#pragma warning(push, 4)
+
+//---------------------------------------------------------------------------
+// recordingstream Constructor (private)
+//
+// Arguments:
+//
+//	folder		- Recording folder
+//	name		- Recording service name
+//	inprogress	- Flag indicating the recording is still being written
+
+recordingstream::recordingstream(char const* folder, char const* name, bool inprogress) : m_folder((folder) ? folder : ""),
+	m_name((name) ? name : ""), m_inprogress(inprogress)
+{
+	if(folder == nullptr) throw std::invalid_argument("folder");
+
+	std::string const indexpath = recording_indexpath(m_folder);
+	m_indexfile = fopen(indexpath.c_str(), "rb");
+	if(m_indexfile == nullptr) throw string_exception(__func__, ": unable to open index file ", indexpath.c_str());
+
+	// The first record of the first segment describes the streams at the start of the recording
+	struct recordheader header = {};
+	if((!open_segment(0)) || (!read_record(header, m_data)) || (header.streamid != DEMUX_SPECIALID_STREAMCHANGE)) {
+
+		close();
+		throw string_exception(__func__, ": recording in folder ", folder, " is not valid");
+	}
+
+	update_properties(m_data);
+	update_index();
+
+	// The signal status of a recording never changes, it only identifies the channel
+	publish_status([&](struct signalstatus& status) -> void { status.servicename = m_name; }, true);
+}
+
+//---------------------------------------------------------------------------
+// recordingstream Destructor
+
+recordingstream::~recordingstream()
+{
+	close();
+}
+
+//---------------------------------------------------------------------------
+// recordingstream::acquisition
+//
+// Gets the signal acquisition state to be cached for the channel
+//
+// Arguments:
+//
+//	acquisitionprops	- Structure to receive the acquisition state
+
+bool recordingstream::acquisition(struct acquisitionprops& /*acquisitionprops*/) const
+{
+	return false;
+}
+
+//---------------------------------------------------------------------------
+// recordingstream::canpause
+//
+// Flag indicating if the stream can be paused
+//
+// Arguments:
+//
+//	NONE
+
+bool recordingstream::canpause(void) const
+{
+	return true;
+}
+
+//---------------------------------------------------------------------------
+// recordingstream::canseek
+//
+// Flag indicating if the stream allows seek operations
+//
+// Arguments:
+//
+//	NONE
+
+bool recordingstream::canseek(void) const
+{
+	return true;
+}
+
+//---------------------------------------------------------------------------
+// recordingstream::close
+//
+// Closes the stream
+//
+// Arguments:
+//
+//	NONE
+
+void recordingstream::close(void)
+{
+	std::unique_lock<std::mutex> lock(m_lock);
+
+	if(m_segment != nullptr) fclose(m_segment);
+	if(m_indexfile != nullptr) fclose(m_indexfile);
+
+	m_segment = m_indexfile = nullptr;
+	m_ended = true;
+}
+
+//---------------------------------------------------------------------------
+// recordingstream::create (static)
+//
+// Factory method, creates a new recordingstream instance
+//
+// Arguments:
+//
+//	folder		- Recording folder
+//	name		- Recording service name
+//	inprogress	- Flag indicating the recording is still being written
+
+std::unique_ptr<recordingstream> recordingstream::create(char const* folder, char const* name, bool inprogress)
+{
+	return std::unique_ptr<recordingstream>(new recordingstream(folder, name, inprogress));
+}
+
+//---------------------------------------------------------------------------
+// recordingstream::demuxabort
+//
+// Aborts the demultiplexer
+//
+// Arguments:
+//
+//	NONE
+
+void recordingstream::demuxabort(void)
+{
+}
+
+//---------------------------------------------------------------------------
+// recordingstream::demuxflush
+//
+// Flushes the demultiplexer
+//
+// Arguments:
+//
+//	NONE
+
+void recordingstream::demuxflush(void)
+{
+}
+
+//---------------------------------------------------------------------------
+// recordingstream::demuxread
+//
+// Reads the next packet from the demultiplexer
+//
+// Arguments:
+//
+//	allocator		- DemuxPacket allocation function
+
+DEMUX_PACKET* recordingstream::demuxread(std::function<DEMUX_PACKET*(int)> const& allocator)
+{
+	struct recordheader			header = {};		// Current record header
+
+	std::unique_lock<std::mutex> lock(m_lock);
+
+	// A seek into a different set of stream properties has to be announced first
+	if(m_streamchange) {
+
+		m_streamchange = false;
+
+		DEMUX_PACKET* packet = allocator(0);
+		if(packet != nullptr) packet->iStreamId = DEMUX_SPECIALID_STREAMCHANGE;
+
+		return packet;
+	}
+
+	// A null packet tells Kodi that the end of the recording has been reached
+	if(m_ended) return nullptr;
+
+	while(true) {
+
+		if(!read_record(header, m_data)) {
+
+			// The next segment is only created once the current one is complete; if it doesn't
+			// exist yet the recording is still in progress and the next record isn't written yet.
+			// A recording that isn't being written and has no END record was never completed
+			// properly (the process was terminated), the last complete record is its end
+			FILE* next = fopen(recording_segmentpath(m_folder, m_segmentnumber + 1).c_str(), "rb");
+			if(next == nullptr) {
+
+				if(m_inprogress) return allocator(0);
+
+				m_ended = true;
+				return nullptr;
+			}
+
+			// The end of the current segment may have been written after the read was attempted
+			if(!read_record(header, m_data)) {
+
+				fclose(m_segment);
+				m_segment = next;
+				m_segmentnumber++;
+				m_offset = 0;
+				continue;
+			}
+
+			fclose(next);
+		}
+
+		if(header.streamid == RECORD_STREAMID_END) { m_ended = true; return nullptr; }
+
+		// Every segment repeats the stream properties, only actual changes are passed on
+		if(header.streamid == DEMUX_SPECIALID_STREAMCHANGE) {
+
+			if(!update_properties(m_data)) continue;
+
+			DEMUX_PACKET* packet = allocator(0);
+			if(packet != nullptr) packet->iStreamId = DEMUX_SPECIALID_STREAMCHANGE;
+
+			return packet;
+		}
+
+		break;
+	}
+
+	// Allocate and initialize the DEMUX_PACKET
+	DEMUX_PACKET* packet = allocator(static_cast<int>(header.size));
+	if(packet != nullptr) {
+
+		packet->iStreamId = header.streamid;
+		packet->iSize = static_cast<int>(header.size);
+		packet->duration = header.duration;
+		packet->dts = packet->pts = header.pts;
+		if(header.size > 0) memcpy(packet->pData, m_data.data(), header.size);
+	}
+
+	return packet;
+}
+
+//---------------------------------------------------------------------------
+// recordingstream::demuxreset
+//
+// Resets the demultiplexer
+//
+// Arguments:
+//
+//	NONE
+
+void recordingstream::demuxreset(void)
+{
+}
+
+//---------------------------------------------------------------------------
+// recordingstream::enumproperties
+//
+// Enumerates the stream properties
+//
+// Arguments:
+//
+//	callback		- Callback to invoke for each stream
+
+void recordingstream::enumproperties(std::function<void(struct streamprops const& props)> const& callback)
+{
+	std::unique_lock<std::mutex> lock(m_lock);
+
+	for(auto const& stream : m_streams) {
+
+		struct streamprops props = {};
+		props.codec = stream.codec;
+		props.pid = stream.pid;
+		props.channels = stream.channels;
+		props.samplerate = stream.samplerate;
+		props.bitspersample = stream.bitspersample;
+
+		callback(props);
+	}
+}
+
+//---------------------------------------------------------------------------
+// recordingstream::length
+//
+// Gets the length of the stream; or -1 if stream is real-time
+//
+// Arguments:
+//
+//	NONE
+
+long long recordingstream::length(void) const
+{
+	return -1;
+}
+
+//---------------------------------------------------------------------------
+// recordingstream::open_segment (private)
+//
+// Opens a segment file for reading
+//
+// Arguments:
+//
+//	segment		- Segment number to be opened
+
+bool recordingstream::open_segment(uint32_t segment)
+{
+	if((m_segment != nullptr) && (segment == m_segmentnumber)) return true;
+
+	FILE* file = fopen(recording_segmentpath(m_folder, segment).c_str(), "rb");
+	if(file == nullptr) return false;
+
+	if(m_segment != nullptr) fclose(m_segment);
+
+	m_segment = file;
+	m_segmentnumber = segment;
+	m_offset = 0;
+
+	return true;
+}
+
+//---------------------------------------------------------------------------
+// recordingstream::pause
+//
+// Pauses or resumes the stream
+//
+// Arguments:
+//
+//	paused		- Flag indicating if the stream is being paused or resumed
+
+void recordingstream::pause(bool /*paused*/)
+{
+	// Packets are only read from the recording on demand, nothing needs to be done
+}
+
+//---------------------------------------------------------------------------
+// recordingstream::position
+//
+// Gets the current position of the stream
+//
+// Arguments:
+//
+//	NONE
+
+long long recordingstream::position(void) const
+{
+	return -1;
+}
+
+//---------------------------------------------------------------------------
+// recordingstream::read
+//
+// Reads available data from the stream
+//
+// Arguments:
+//
+//	buffer		- Buffer to receive the stream data
+//	count		- Size of the destination buffer in bytes
+
+size_t recordingstream::read(uint8_t* /*buffer*/, size_t /*count*/)
+{
+	return 0;
+}
+
+//---------------------------------------------------------------------------
+// recordingstream::read_record (private)
+//
+// Reads the next complete record from the current segment
+//
+// Arguments:
+//
+//	header		- Receives the record header
+//	data		- Receives the record data
+
+bool recordingstream::read_record(struct recordheader& header, std::vector<uint8_t>& data)
+{
+	if(m_segment == nullptr) return false;
+
+	// A record that has only been partially written is read again from the start next time
+	clearerr(m_segment);
+	if(fseek(m_segment, static_cast<long>(m_offset), SEEK_SET) != 0) return false;
+
+	if(fread(&header, sizeof(header), 1, m_segment) != 1) return false;
+
+	data.resize(header.size);
+	if((header.size > 0) && (fread(data.data(), 1, header.size, m_segment) != header.size)) return false;
+
+	m_offset += static_cast<uint32_t>(sizeof(header) + header.size);
+
+	return true;
+}
+
+//---------------------------------------------------------------------------
+// recordingstream::realtime
+//
+// Gets a flag indicating if the stream is real-time
+//
+// Arguments:
+//
+//	NONE
+
+bool recordingstream::realtime(void) const
+{
+	return false;
+}
+
+//---------------------------------------------------------------------------
+// recordingstream::retune
+//
+// Retunes the stream to a different channel without recreating it
+//
+// Arguments:
+//
+//	tunerprops		- Tuner device properties
+//	channelprops	- Channel properties for the new channel
+//	subchannel		- Subchannel number for the new channel
+
+bool recordingstream::retune(struct tunerprops const& /*tunerprops*/, struct channelprops const& /*channelprops*/, uint32_t /*subchannel*/)
+{
+	return false;
+}
+
+//---------------------------------------------------------------------------
+// recordingstream::seek
+//
+// Sets the stream pointer to a specific position
+//
+// Arguments:
+//
+//	position	- Delta within the stream to seek, relative to whence
+//	whence		- Starting position from which to apply the delta
+
+long long recordingstream::seek(long long /*position*/, int /*whence*/)
+{
+	return -1;
+}
+
+//---------------------------------------------------------------------------
+// recordingstream::seektime
+//
+// Sets the stream pointer to a specific presentation time
+//
+// Arguments:
+//
+//	time		- Presentation time to seek to, in milliseconds
+//	backwards	- Flag indicating the direction of the seek
+//	startpts	- Receives the presentation time stamp at the new position
+
+bool recordingstream::seektime(double time, bool backwards, double& startpts)
+{
+	struct recordheader			header = {};		// Stream properties record header
+
+	std::unique_lock<std::mutex> lock(m_lock);
+
+	update_index();
+	if(m_index.empty()) return false;
+
+	// The seek points are in time stamp order, so the nearest one can be found with a binary search
+	double const target = time * (STREAM_TIME_BASE / 1000);
+	auto found = std::lower_bound(m_index.begin(), m_index.end(), target, [](struct recordindex const& entry, double pts) -> bool {
+		return entry.pts < pts; });
+
+	// When seeking backwards, move to the seek point before the target time rather than the one after it
+	if(backwards && (found != m_index.begin()) && ((found == m_index.end()) || (found->pts > target))) --found;
+	if(found == m_index.end()) --found;
+
+	if(!open_segment(found->segment)) return false;
+
+	// Load the stream properties that are in effect at the seek point and announce them if they changed
+	m_offset = found->propsoffset;
+	if(read_record(header, m_data) && (header.streamid == DEMUX_SPECIALID_STREAMCHANGE) && update_properties(m_data)) m_streamchange = true;
+
+	m_offset = found->offset;
+	m_ended = false;
+	startpts = found->pts;
+
+	return true;
+}
+
+//---------------------------------------------------------------------------
+// recordingstream::timerange
+//
+// Gets the range of presentation times that can be seeked to
+//
+// Arguments:
+//
+//	begin		- Receives the earliest presentation time stamp
+//	end			- Receives the latest presentation time stamp
+
+bool recordingstream::timerange(double& begin, double& end) const
+{
+	std::unique_lock<std::mutex> lock(m_lock);
+
+	update_index();
+	if(m_index.empty()) return false;
+
+	begin = m_index.front().pts;
+	end = m_index.back().pts;
+
+	return true;
+}
+
+//---------------------------------------------------------------------------
+// recordingstream::update_index (private)
+//
+// Reads any seek points that have been added to the index
+//
+// Arguments:
+//
+//	NONE
+
+void recordingstream::update_index(void) const
+{
+	struct recordindex			entry = {};			// Seek point read from the index
+
+	if(m_indexfile == nullptr) return;
+
+	// A seek point that has only been partially written is read again from the start next time
+	clearerr(m_indexfile);
+	if(fseek(m_indexfile, static_cast<long>(m_index.size() * sizeof(struct recordindex)), SEEK_SET) != 0) return;
+
+	while(fread(&entry, sizeof(entry), 1, m_indexfile) == 1) m_index.push_back(entry);
+}
+
+//---------------------------------------------------------------------------
+// recordingstream::update_properties (private)
+//
+// Updates the stream properties from a stream properties record
+//
+// Arguments:
+//
+//	data		- Stream properties record data
+
+bool recordingstream::update_properties(std::vector<uint8_t> const& data)
+{
+	std::vector<struct recordstream> streams(data.size() / sizeof(struct recordstream));
+	if(!streams.empty()) memcpy(streams.data(), data.data(), streams.size() * sizeof(struct recordstream));
+
+	for(auto& stream : streams) stream.codec[std::extent<decltype(stream.codec)>::value - 1] = '\0';
+
+	// Only report a change if the properties are actually different
+	if((streams.size() == m_streams.size()) && (memcmp(streams.data(), m_streams.data(), streams.size() * sizeof(struct recordstream)) == 0)) return false;
+
+	m_streams = std::move(streams);
+	return true;
+}
+
+//---------------------------------------------------------------------------
+
+#pragma warning(pop)
@@ -0,0 +1,206 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2020-2022 Michael G. Brehm
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#ifndef __RECORDINGSTREAM_H_
+#define __RECORDINGSTREAM_H_
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+#include "pvrstream.h"
+#include "recordingformat.h"
+
+#pragma warning(push, 4)
+
+//---------------------------------------------------------------------------
+// Class recordingstream
+//
+// Implements a PVR stream that plays back a recording; the recording can
+// still be in progress, in which case the stream follows the end of the
+// recording as it is written
+
+class recordingstream : public pvrstream
+{
+public:
+
+	// Destructor
+	//
+	virtual ~recordingstream();
+
+	//-----------------------------------------------------------------------
+	// Member Functions
+
+	// acquisition
+	//
+	// Gets the signal acquisition state to be cached for the channel
+	bool acquisition(struct acquisitionprops& acquisitionprops) const override;
+
+	// canpause
+	//
+	// Flag indicating if the stream can be paused
+	bool canpause(void) const override;
+
+	// canseek
+	//
+	// Flag indicating if the stream allows seek operations
+	bool canseek(void) const override;
+
+	// close
+	//
+	// Closes the stream
+	void close(void) override;
+
+	// create (static)
+	//
+	// Factory method, creates a new recordingstream instance
+	static std::unique_ptr<recordingstream> create(char const* folder, char const* name, bool inprogress);
+
+	// demuxabort
+	//
+	// Aborts the demultiplexer
+	void demuxabort(void) override;
+
+	// demuxflush
+	//
+	// Flushes the demultiplexer
+	void demuxflush(void) override;
+
+	// demuxread
+	//
+	// Reads the next packet from the demultiplexer
+	DEMUX_PACKET* demuxread(std::function<DEMUX_PACKET*(int)> const& allocator) override;
+
+	// demuxreset
+	//
+	// Resets the demultiplexer
+	void demuxreset(void) override;
+
+	// enumproperties
+	//
+	// Enumerates the stream properties
+	void enumproperties(std::function<void(struct streamprops const& props)> const& callback) override;
+
+	// length
+	//
+	// Gets the length of the stream
+	long long length(void) const override;
+
+	// pause
+	//
+	// Pauses or resumes the stream
+	void pause(bool paused) override;
+
+	// position
+	//
+	// Gets the current position of the stream
+	long long position(void) const override;
+
+	// read
+	//
+	// Reads available data from the stream
+	size_t read(uint8_t* buffer, size_t count) override;
+
+	// realtime
+	//
+	// Gets a flag indicating if the stream is real-time
+	bool realtime(void) const override;
+
+	// retune
+	//
+	// Retunes the stream to a different channel without recreating it
+	bool retune(struct tunerprops const& tunerprops, struct channelprops const& channelprops, uint32_t subchannel) override;
+
+	// seek
+	//
+	// Sets the stream pointer to a specific position
+	long long seek(long long position, int whence) override;
+
+	// seektime
+	//
+	// Sets the stream pointer to a specific presentation time
+	bool seektime(double time, bool backwards, double& startpts) override;
+
+	// timerange
+	//
+	// Gets the range of presentation times that can be seeked to
+	bool timerange(double& begin, double& end) const override;
+
+private:
+
+	recordingstream(recordingstream const&) = delete;
+	recordingstream& operator=(recordingstream const&) = delete;
+
+	// Instance Constructor
+	//
+	recordingstream(char const* folder, char const* name, bool inprogress);
+
+	//-----------------------------------------------------------------------
+	// Private Member Functions
+
+	// open_segment
+	//
+	// Opens a segment file for reading
+	bool open_segment(uint32_t segment);
+
+	// read_record
+	//
+	// Reads the next complete record from the current segment
+	bool read_record(struct recordheader& header, std::vector<uint8_t>& data);
+
+	// update_index
+	//
+	// Reads any seek points that have been added to the index
+	void update_index(void) const;
+
+	// update_properties
+	//
+	// Updates the stream properties from a stream properties record
+	bool update_properties(std::vector<uint8_t> const& data);
+
+	//-----------------------------------------------------------------------
+	// Member Variables
+
+	std::string const						m_folder;				// Recording folder
+	std::string const						m_name;					// Recording service name
+	bool const								m_inprogress;			// Recording is being written
+
+	FILE*									m_segment = nullptr;	// Segment file handle
+	uint32_t								m_segmentnumber = 0;	// Current segment number
+	uint32_t								m_offset = 0;			// Current segment offset
+	FILE*									m_indexfile = nullptr;	// Index file handle
+	mutable std::vector<struct recordindex>	m_index;				// Index seek points
+	std::vector<struct recordstream>		m_streams;				// Stream properties
+	std::vector<uint8_t>					m_data;					// Record data buffer
+	bool									m_streamchange = false;	// Flag to send stream change
+	bool									m_ended = false;		// Flag if end was reached
+	mutable std::mutex						m_lock;					// Synchronization object
+};
+
+//-----------------------------------------------------------------------------
+
+#pragma warning(pop)
+
+#endif	// __RECORDINGSTREAM_H_
@@ -0,0 +1,582 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2020-2022 Michael G. Brehm
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#include "stdafx.h"
+#include "replaybuffer.h"
+
+#include <algorithm>
+#include <assert.h>
+#include <ctime>
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+#ifndef _WINDOWS
+#include <sys/mman.h>
+#endif
+
+#include <rapidjson/stringbuffer.h>
+#include <rapidjson/prettywriter.h>
+
+#include "string_exception.h"
+
+#pragma warning(push, 4)
+
+//---------------------------------------------------------------------------
+// replaybuffer Constructor (private)
+//
+// Arguments:
+//
+//	NONE
+
+replaybuffer::replaybuffer()
+{
+}
+
+//---------------------------------------------------------------------------
+// replaybuffer Destructor
+
+replaybuffer::~replaybuffer()
+{
+}
+
+//---------------------------------------------------------------------------
+// replaybuffer::attach
+//
+// Attaches the replay buffer to a device instance
+//
+// Arguments:
+//
+//	device		- Device instance to attach to
+//	seconds		- Length of the replay, in seconds
+
+std::unique_ptr<rtldevice> replaybuffer::attach(std::unique_ptr<rtldevice> device, uint32_t seconds)
+{
+	if(!device) throw std::invalid_argument("device");
+	if(seconds == 0) throw std::invalid_argument("seconds");
+
+	return std::unique_ptr<rtldevice>(new replaydevice(shared_from_this(), std::move(device), seconds));
+}
+
+//---------------------------------------------------------------------------
+// replaybuffer::create (static)
+//
+// Factory method, creates a new replaybuffer instance
+//
+// Arguments:
+//
+//	NONE
+
+std::shared_ptr<replaybuffer> replaybuffer::create(void)
+{
+	return std::shared_ptr<replaybuffer>(new replaybuffer());
+}
+
+//---------------------------------------------------------------------------
+// replaybuffer::reset (private)
+//
+// Publishes a new ring for a new stream of samples
+//
+// Arguments:
+//
+//	samplerate	- Sample rate of the stream
+//	frequency	- Center frequency of the stream
+//	seconds		- Length of the replay, in seconds
+//	devicename	- Name of the device
+
+std::shared_ptr<replaybuffer::ring_t> replaybuffer::reset(uint32_t samplerate, uint32_t frequency, uint32_t seconds, char const* devicename)
+{
+	// The ring holds whole I/Q samples; a previous ring is released when the last device
+	// writing to it and the last save() copying from it let go of their references
+	std::shared_ptr<ring_t> ring = std::make_shared<ring_t>(static_cast<size_t>(samplerate) * 2 * seconds, samplerate, frequency, devicename);
+	std::atomic_store(&m_ring, ring);
+
+	return ring;
+}
+
+//---------------------------------------------------------------------------
+// replaybuffer::retune (private, static)
+//
+// Marks the current position of a ring as the start of a new frequency
+//
+// Arguments:
+//
+//	ring		- Ring to be retuned
+//	frequency	- New center frequency of the stream
+
+void replaybuffer::retune(ring_t& ring, uint32_t frequency)
+{
+	ring.tuned.store(ring.head.load());
+	ring.frequency.store(frequency);
+}
+
+//---------------------------------------------------------------------------
+// replaybuffer::save
+//
+// Saves the contents of the replay buffer as a SigMF recording
+//
+// Arguments:
+//
+//	folder		- Folder in which to create the recording
+//	filename	- Receives the base file name of the recording
+
+uint64_t replaybuffer::save(char const* folder, std::string& filename) const
+{
+	std::vector<uint8_t>	samples;			// Samples copied out of the ring
+
+	if(folder == nullptr) throw std::invalid_argument("folder");
+
+	// Pin the current ring; it remains valid even if a new stream replaces it
+	std::shared_ptr<ring_t> const ring = std::atomic_load(&m_ring);
+	if((!ring) || (ring->data == nullptr) || (ring->size == 0)) return 0;
+
+	size_t const size = ring->size;
+	uint32_t const frequency = ring->frequency.load();
+
+	// Copy everything in the ring since the last retune; the oldest bytes may be
+	// overwritten by the device callback while they are being copied
+	uint64_t const head = ring->head.load(std::memory_order_acquire);
+	uint64_t start = std::max(head - std::min(head, static_cast<uint64_t>(size)), ring->tuned.load());
+
+	samples.resize(static_cast<size_t>(head - start));
+	for(uint64_t position = start; position < head;) {
+
+		size_t const offset = static_cast<size_t>(position % size);
+		size_t const cb = static_cast<size_t>(std::min(static_cast<uint64_t>(size - offset), head - position));
+		memcpy(&samples[static_cast<size_t>(position - start)], &ring->data[offset], cb);
+		position += cb;
+	}
+
+	// Any bytes that the writer has reached since the copy started are not valid, this
+	// includes a block that was in the process of being written when the copy started
+	std::atomic_thread_fence(std::memory_order_acquire);
+	uint64_t const writing = ring->writing.load(std::memory_order_relaxed);
+	uint64_t skip = ((writing > size) && ((writing - size) > start)) ? std::min((writing - size) - start, head - start) : 0;
+	skip += (start + skip) & 1;							// Keep the I/Q samples aligned
+	skip = std::min(skip, head - start);
+
+	if(skip == head - start) return 0;
+
+	// Generate the recording file names from the current UTC time and frequency
+	time_t now = time(nullptr);
+	struct tm utc = {};
+#ifdef _WINDOWS
+	gmtime_s(&utc, &now);
+#else
+	gmtime_r(&now, &utc);
+#endif
+
+	char timestamp[32] = {};
+	char datetime[32] = {};
+	strftime(timestamp, sizeof(timestamp), "%Y%m%d-%H%M%S", &utc);
+	strftime(datetime, sizeof(datetime), "%Y-%m-%dT%H:%M:%SZ", &utc);
+
+	std::string basename(folder);
+	if((!basename.empty()) && (basename.back() != '/') && (basename.back() != '\\')) basename.push_back('/');
+	basename.append("replay-").append(timestamp).append("-").append(std::to_string(frequency));
+
+	// Write the samples into the SigMF data file
+	FILE* file = fopen((basename + ".sigmf-data").c_str(), "wb");
+	if(file == nullptr) throw string_exception(__func__, ": unable to create file ", basename.c_str(), ".sigmf-data");
+
+	size_t const length = samples.size() - static_cast<size_t>(skip);
+	bool const written = (fwrite(&samples[static_cast<size_t>(skip)], 1, length, file) == length);
+	fclose(file);
+
+	if(!written) throw string_exception(__func__, ": unable to write file ", basename.c_str(), ".sigmf-data");
+
+	// Write the SigMF metadata file; the recording ends at the current time, the start
+	// time is not known precisely enough to be worth recording
+	rapidjson::StringBuffer								sb;			// JSON string buffer
+	rapidjson::PrettyWriter<rapidjson::StringBuffer>	writer(sb);	// JSON writer
+
+	writer.StartObject();
+
+	writer.Key("global");
+	writer.StartObject();
+	writer.Key("core:datatype"); writer.String("cu8");
+	writer.Key("core:sample_rate"); writer.Double(static_cast<double>(ring->samplerate));
+	writer.Key("core:version"); writer.String("1.0.0");
+	writer.Key("core:recorder"); writer.String("pvr.rtlradio");
+	writer.Key("core:hw"); writer.String(ring->devicename.c_str());
+	writer.Key("core:description"); writer.String((std::string("Instant replay saved at ") + datetime).c_str());
+	writer.EndObject();
+
+	writer.Key("captures");
+	writer.StartArray();
+	writer.StartObject();
+	writer.Key("core:sample_start"); writer.Uint64(0);
+	writer.Key("core:frequency"); writer.Double(static_cast<double>(frequency));
+	writer.EndObject();
+	writer.EndArray();
+
+	writer.Key("annotations");
+	writer.StartArray();
+	writer.EndArray();
+
+	writer.EndObject();
+
+	file = fopen((basename + ".sigmf-meta").c_str(), "wb");
+	if(file == nullptr) throw string_exception(__func__, ": unable to create file ", basename.c_str(), ".sigmf-meta");
+
+	fwrite(sb.GetString(), 1, sb.GetSize(), file);
+	fclose(file);
+
+	filename = basename + ".sigmf-meta";
+	return length / 2;
+}
+
+//---------------------------------------------------------------------------
+// replaybuffer::write (private, static)
+//
+// Writes a block of samples into a ring
+//
+// Arguments:
+//
+//	ring		- Ring to be written to
+//	buffer		- Block of samples to be written
+//	count		- Size of the block, specified in bytes
+
+void replaybuffer::write(ring_t& ring, uint8_t const* buffer, size_t count)
+{
+	assert(buffer != nullptr);
+
+	// The ring is only ever written by the device that owns it, save() is allowed to copy
+	// it while it's being written to so that the device callback is never blocked
+	if((ring.data == nullptr) || (count == 0)) return;
+
+	uint64_t head = ring.head.load(std::memory_order_relaxed);
+
+	// Only the end of a block larger than the entire ring can be kept
+	if(count > ring.size) { head += (count - ring.size); buffer += (count - ring.size); count = ring.size; }
+
+	// Announce the range about to be overwritten before touching the ring; a concurrent
+	// save uses this to discard any bytes that changed underneath it
+	ring.writing.store(head + count, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+
+	size_t const offset = static_cast<size_t>(head % ring.size);
+	size_t const first = std::min(count, ring.size - offset);
+	memcpy(&ring.data[offset], buffer, first);
+	if(first < count) memcpy(&ring.data[0], &buffer[first], count - first);
+
+	ring.head.store(head + count, std::memory_order_release);
+}
+
+//---------------------------------------------------------------------------
+// replaybuffer::replaydevice Constructor
+//
+// Arguments:
+//
+//	buffer		- Parent replay buffer
+//	device		- Underlying device instance
+//	seconds		- Length of the replay, in seconds
+
+replaybuffer::replaydevice::replaydevice(std::shared_ptr<replaybuffer> const& buffer, std::unique_ptr<rtldevice> device, uint32_t seconds) :
+	m_buffer(buffer), m_device(std::move(device)), m_seconds(seconds)
+{
+	assert(m_buffer);
+	assert(m_device);
+}
+
+//---------------------------------------------------------------------------
+// replaybuffer::replaydevice Destructor
+
+replaybuffer::replaydevice::~replaydevice()
+{
+}
+
+//---------------------------------------------------------------------------
+// replaybuffer::replaydevice::begin_stream
+//
+// Starts streaming data from the device
+//
+// Arguments:
+//
+//	NONE
+
+void replaybuffer::replaydevice::begin_stream(void) const
+{
+	m_device->begin_stream();
+}
+
+//---------------------------------------------------------------------------
+// replaybuffer::replaydevice::cancel_async
+//
+// Cancels any pending asynchronous read operations from the device
+//
+// Arguments:
+//
+//	NONE
+
+void replaybuffer::replaydevice::cancel_async(void) const
+{
+	m_device->cancel_async();
+}
+
+//---------------------------------------------------------------------------
+// replaybuffer::replaydevice::get_device_name
+//
+// Gets the name of the device
+//
+// Arguments:
+//
+//	NONE
+
+char const* replaybuffer::replaydevice::get_device_name(void) const
+{
+	return m_device->get_device_name();
+}
+
+//---------------------------------------------------------------------------
+// replaybuffer::replaydevice::get_frequency (private)
+//
+// Gets the frequency at the center of the delivered samples
+//
+// Arguments:
+//
+//	NONE
+
+uint32_t replaybuffer::replaydevice::get_frequency(void) const
+{
+	// When decimating the samples are centered on the decimation offset rather than
+	// on the tuner center frequency
+	return (m_decimation > 1) ? static_cast<uint32_t>(static_cast<int64_t>(m_frequency) + m_offset) : m_frequency;
+}
+
+//---------------------------------------------------------------------------
+// replaybuffer::replaydevice::get_valid_gains
+//
+// Gets the valid tuner gain values for the device
+//
+// Arguments:
+//
+//	dbs			- vector<> to retrieve the valid gain values
+
+void replaybuffer::replaydevice::get_valid_gains(std::vector<int>& dbs) const
+{
+	m_device->get_valid_gains(dbs);
+}
+
+//---------------------------------------------------------------------------
+// replaybuffer::replaydevice::read
+//
+// Reads data from the device
+//
+// Arguments:
+//
+//	buffer		- Buffer to receive the data
+//	count		- Size of the destination buffer, specified in bytes
+
+size_t replaybuffer::replaydevice::read(uint8_t* buffer, size_t count) const
+{
+	return m_device->read(buffer, count);
+}
+
+//---------------------------------------------------------------------------
+// replaybuffer::replaydevice::read_async
+//
+// Asynchronously reads data from the device
+//
+// Arguments:
+//
+//	callback		- Asynchronous read callback function
+//	bufferlength	- Output buffer length in bytes
+
+void replaybuffer::replaydevice::read_async(asynccallback const& callback, uint32_t bufferlength) const
+{
+	// Each stream writes into its own ring, which stays alive until the stream has stopped
+	// even if the replay buffer has moved on to the ring of a newer stream
+	std::shared_ptr<ring_t> ring = m_buffer->reset(m_samplerate / std::max(m_decimation, 1U), get_frequency(), m_seconds, m_device->get_device_name());
+	std::atomic_store(&m_ring, ring);
+
+	try {
+
+		m_device->read_async([&](uint8_t const* buffer, size_t count) -> void {
+
+			write(*ring, buffer, count);
+			callback(buffer, count);
+
+		}, bufferlength);
+	}
+
+	catch(...) { std::atomic_store(&m_ring, std::shared_ptr<ring_t>()); throw; }
+
+	std::atomic_store(&m_ring, std::shared_ptr<ring_t>());
+}
+
+//---------------------------------------------------------------------------
+// replaybuffer::replaydevice::set_automatic_gain_control
+//
+// Enables/disables the automatic gain control mode of the device
+//
+// Arguments:
+//
+//	enable		- Flag to enable/disable test mode
+
+void replaybuffer::replaydevice::set_automatic_gain_control(bool enable) const
+{
+	m_device->set_automatic_gain_control(enable);
+}
+
+//---------------------------------------------------------------------------
+// replaybuffer::replaydevice::set_center_frequency
+//
+// Sets the center frequency of the device
+//
+// Arguments:
+//
+//	hz		- Frequency to set, specified in hertz
+
+uint32_t replaybuffer::replaydevice::set_center_frequency(uint32_t hz) const
+{
+	m_frequency = m_device->set_center_frequency(hz);
+
+	std::shared_ptr<ring_t> ring = std::atomic_load(&m_ring);
+	if(ring) retune(*ring, get_frequency());
+
+	return m_frequency;
+}
+
+//---------------------------------------------------------------------------
+// replaybuffer::replaydevice::set_decimation
+//
+// Sets the frequency offset and decimation factor applied by the device
+//
+// Arguments:
+//
+//	offset		- Frequency offset to shift to zero, specified in hertz
+//	factor		- Requested decimation factor
+
+uint32_t replaybuffer::replaydevice::set_decimation(int offset, uint32_t factor) const
+{
+	m_decimation = m_device->set_decimation(offset, factor);
+	m_offset = offset;
+
+	std::shared_ptr<ring_t> ring = std::atomic_load(&m_ring);
+	if(ring) retune(*ring, get_frequency());
+
+	return m_decimation;
+}
+
+//---------------------------------------------------------------------------
+// replaybuffer::replaydevice::set_frequency_correction
+//
+// Sets the frequency correction of the device
+//
+// Arguments:
+//
+//	ppm		- Frequency correction to set, specified in parts per million
+
+int replaybuffer::replaydevice::set_frequency_correction(int ppm) const
+{
+	return m_device->set_frequency_correction(ppm);
+}
+
+//---------------------------------------------------------------------------
+// replaybuffer::replaydevice::set_gain
+//
+// Sets the gain of the device
+//
+// Arguments:
+//
+//	db			- Gain to set, specified in tenths of a decibel
+
+int replaybuffer::replaydevice::set_gain(int db) const
+{
+	return m_device->set_gain(db);
+}
+
+//---------------------------------------------------------------------------
+// replaybuffer::replaydevice::set_sample_rate
+//
+// Sets the sample rate of the device
+//
+// Arguments:
+//
+//	hz		- Sample rate to set, specified in hertz
+
+uint32_t replaybuffer::replaydevice::set_sample_rate(uint32_t hz) const
+{
+	// Changing the sample rate also resets any decimation applied by the device
+	m_samplerate = m_device->set_sample_rate(hz);
+	m_decimation = 1;
+
+	return m_samplerate;
+}
+
+//---------------------------------------------------------------------------
+// replaybuffer::replaydevice::set_test_mode
+//
+// Enables/disables the test mode of the device
+//
+// Arguments:
+//
+//	enable		- Flag to enable/disable test mode
+
+void replaybuffer::replaydevice::set_test_mode(bool enable) const
+{
+	m_device->set_test_mode(enable);
+}
+
+//---------------------------------------------------------------------------
+// replaybuffer::ring_t Constructor
+//
+// Arguments:
+//
+//	bytes		- Size of the ring, specified in bytes
+//	rate		- Sample rate of the stream
+//	hz			- Center frequency of the stream
+//	name		- Name of the device
+
+replaybuffer::ring_t::ring_t(size_t bytes, uint32_t rate, uint32_t hz, char const* name) :
+	size(bytes), samplerate(rate), devicename((name) ? name : ""), frequency(hz)
+{
+	if(size == 0) return;
+
+	// The pages of an anonymous mapping are not committed until they are written to, so
+	// a large ring that never fills up does not cost any more memory than a small one
+#ifdef _WINDOWS
+	data = reinterpret_cast<uint8_t*>(VirtualAlloc(nullptr, size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE));
+	if(data == nullptr) throw string_exception(__func__, ": VirtualAlloc() failed");
+#else
+	void* mapping = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if(mapping == MAP_FAILED) throw string_exception(__func__, ": mmap() failed");
+	data = reinterpret_cast<uint8_t*>(mapping);
+#endif
+}
+
+//---------------------------------------------------------------------------
+// replaybuffer::ring_t Destructor
+
+replaybuffer::ring_t::~ring_t()
+{
+#ifdef _WINDOWS
+	if(data) VirtualFree(data, 0, MEM_RELEASE);
+#else
+	if(data) munmap(data, size);
+#endif
+}
+
+//---------------------------------------------------------------------------
+
+#pragma warning(pop)
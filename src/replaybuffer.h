@@ -0,0 +1,187 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2020-2022 Michael G. Brehm
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#ifndef __REPLAYBUFFER_H_
+#define __REPLAYBUFFER_H_
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <string>
+
+#include "rtldevice.h"
+
+#pragma warning(push, 4)
+
+//---------------------------------------------------------------------------
+// Class replaybuffer
+//
+// Implements an "instant replay" buffer that keeps the most recent raw I/Q
+// samples of a device in a fixed-size memory mapped ring.  The ring is written
+// without any locks from the device callback; saving the ring copies it out
+// and discards any samples that were overwritten while they were being copied.
+// Each stream gets a new reference counted ring, a device that is still writing
+// into a previous ring keeps that ring alive until it has stopped
+
+class replaybuffer : public std::enable_shared_from_this<replaybuffer>
+{
+public:
+
+	// Destructor
+	//
+	~replaybuffer();
+
+	//-----------------------------------------------------------------------
+	// Member Functions
+
+	// attach
+	//
+	// Attaches the replay buffer to a device instance
+	std::unique_ptr<rtldevice> attach(std::unique_ptr<rtldevice> device, uint32_t seconds);
+
+	// create (static)
+	//
+	// Factory method, creates a new replaybuffer instance
+	static std::shared_ptr<replaybuffer> create(void);
+
+	// save
+	//
+	// Saves the contents of the replay buffer as a SigMF recording
+	uint64_t save(char const* folder, std::string& filename) const;
+
+private:
+
+	replaybuffer(replaybuffer const&) = delete;
+	replaybuffer& operator=(replaybuffer const&) = delete;
+
+	// Instance Constructor
+	//
+	replaybuffer();
+
+	//-----------------------------------------------------------------------
+	// Private Type Declarations
+
+	// ring_t
+	//
+	// Defines the memory mapped ring of a single stream of samples
+	struct ring_t {
+
+		ring_t(size_t bytes, uint32_t rate, uint32_t hz, char const* name);
+		~ring_t();
+
+		uint8_t*						data = nullptr;		// Ring buffer
+		size_t const					size;				// Ring buffer size
+		uint32_t const					samplerate;			// Sample rate
+		std::string const				devicename;			// Device name
+		std::atomic<uint32_t>			frequency;			// Center frequency
+		std::atomic<uint64_t>			head{ 0 };			// Bytes written into the ring
+		std::atomic<uint64_t>			writing{ 0 };		// Bytes being written into the ring
+		std::atomic<uint64_t>			tuned{ 0 };			// Position of the last retune
+	};
+
+	// replaydevice
+	//
+	// Wraps an rtldevice instance, copying the asynchronous samples into the ring
+	class replaydevice : public rtldevice
+	{
+	public:
+
+		// Instance Constructor
+		//
+		replaydevice(std::shared_ptr<replaybuffer> const& buffer, std::unique_ptr<rtldevice> device, uint32_t seconds);
+
+		// Destructor
+		//
+		~replaydevice();
+
+		//-------------------------------------------------------------------
+		// Member Functions
+
+		void begin_stream(void) const override;
+		void cancel_async(void) const override;
+		char const* get_device_name(void) const override;
+		void get_valid_gains(std::vector<int>& dbs) const override;
+		size_t read(uint8_t* buffer, size_t count) const override;
+		void read_async(asynccallback const& callback, uint32_t bufferlength) const override;
+		void set_automatic_gain_control(bool enable) const override;
+		uint32_t set_center_frequency(uint32_t hz) const override;
+		uint32_t set_decimation(int offset, uint32_t factor) const override;
+		int set_frequency_correction(int ppm) const override;
+		int set_gain(int db) const override;
+		uint32_t set_sample_rate(uint32_t hz) const override;
+		void set_test_mode(bool enable) const override;
+
+	private:
+
+		replaydevice(replaydevice const&) = delete;
+		replaydevice& operator=(replaydevice const&) = delete;
+
+		//-------------------------------------------------------------------
+		// Private Member Functions
+
+		// get_frequency
+		//
+		// Gets the frequency at the center of the delivered samples
+		uint32_t get_frequency(void) const;
+
+		//-------------------------------------------------------------------
+		// Member Variables
+
+		std::shared_ptr<replaybuffer> const	m_buffer;			// Parent replay buffer
+		std::unique_ptr<rtldevice>			m_device;			// Underlying device instance
+		mutable std::shared_ptr<ring_t>		m_ring;				// Ring being written to
+		uint32_t const						m_seconds;			// Length of the replay
+		mutable uint32_t					m_frequency = 0;	// Current center frequency
+		mutable uint32_t					m_samplerate = 0;	// Current sample rate
+		mutable uint32_t					m_decimation = 1;	// Current decimation factor
+		mutable int							m_offset = 0;		// Current decimation offset
+	};
+
+	//-----------------------------------------------------------------------
+	// Private Member Functions
+
+	// reset
+	//
+	// Publishes a new ring for a new stream of samples
+	std::shared_ptr<ring_t> reset(uint32_t samplerate, uint32_t frequency, uint32_t seconds, char const* devicename);
+
+	// retune (static)
+	//
+	// Marks the current position of a ring as the start of a new frequency
+	static void retune(ring_t& ring, uint32_t frequency);
+
+	// write (static)
+	//
+	// Writes a block of samples into a ring
+	static void write(ring_t& ring, uint8_t const* buffer, size_t count);
+
+	//-----------------------------------------------------------------------
+	// Member Variables
+
+	std::shared_ptr<ring_t>			m_ring;					// Current ring (atomic access only)
+};
+
+//-----------------------------------------------------------------------------
+
+#pragma warning(pop)
+
+#endif	// __REPLAYBUFFER_H_
@@ -0,0 +1,842 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2020-2022 Michael G. Brehm
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#ifdef _WINDOWS
+#define NOMINMAX
+#include <WinSock2.h>
+#include <WS2tcpip.h>
+#include <Windows.h>
+#include <getopt/getopt.h>
+#else
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <signal.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <complex>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <rtl-sdr.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <thread>
+#include <vector>
+
+#include "rtl_tcpx.h"
+
+#pragma warning(push, 4)
+
+//---------------------------------------------------------------------------
+// rtl_tcpx
+//
+// I/Q spectrum server for RTL2832 based DVB-T receivers that implements the stock
+// rtl_tcp protocol along with the extensions defined in rtl_tcpx.h, which allow a
+// client to have the server shift and decimate the I/Q samples before they are sent
+// to reduce the network bandwidth required for narrowband signals
+
+// DEFAULT_FREQUENCY
+//
+// Default center frequency of the device
+static uint32_t const DEFAULT_FREQUENCY = 100000000;
+
+// DEFAULT_PORT
+//
+// Default port number on which to listen for a client connection
+static char const* DEFAULT_PORT = "1234";
+
+// DEFAULT_SAMPLE_RATE
+//
+// Default sample rate of the device
+static uint32_t const DEFAULT_SAMPLE_RATE = 2048000;
+
+// FIRST_COMMAND_TIMEOUT
+//
+// Amount of time to wait for the first client command before streaming, in milliseconds
+static int const FIRST_COMMAND_TIMEOUT = 250;
+
+// MAX_QUEUED_BUFFERS
+//
+// Maximum number of device buffers that can be queued for a slow client
+static size_t const MAX_QUEUED_BUFFERS = 64;
+
+// NCO_TABLE_BITS
+//
+// Number of bits used to index the oscillator table of the decimator
+static int const NCO_TABLE_BITS = 12;
+
+// TAPS_PER_PHASE
+//
+// Number of decimation filter taps per unit of the decimation factor
+static uint32_t const TAPS_PER_PHASE = 8;
+
+// g_stop
+//
+// Flag set by the signal handler to stop the server
+static std::atomic<bool> g_stop{ false };
+
+//---------------------------------------------------------------------------
+// Class decimator
+//
+// Shifts a frequency offset within the I/Q samples to zero and decimates the result
+// with a windowed-sinc lowpass filter.  The output is scaled up by the square root of
+// the decimation factor to keep the noise floor at its original level, otherwise the
+// quantization noise of the 8-bit output would dominate a narrow channel; strong
+// signals are limited by their magnitude rather than per component to preserve phase
+
+class decimator
+{
+public:
+
+	// Instance Constructor
+	//
+	decimator(uint32_t samplerate, int32_t offset, uint32_t factor);
+
+	//-----------------------------------------------------------------------
+	// Member Functions
+
+	// process
+	//
+	// Processes a buffer of 8-bit unsigned I/Q samples
+	void process(uint8_t const* samples, size_t length, std::vector<uint8_t>& output);
+
+private:
+
+	decimator(decimator const&) = delete;
+	decimator& operator=(decimator const&) = delete;
+
+	//-----------------------------------------------------------------------
+	// Member Variables
+
+	uint32_t const						m_factor;			// Decimation factor
+	float const							m_gain;				// Output gain
+	std::vector<float>					m_taps;				// Lowpass filter taps
+	std::vector<std::complex<float>>	m_history;			// Filter history (doubled)
+	std::vector<std::complex<float>>	m_nco;				// Oscillator table
+	size_t								m_head = 0;			// Filter history position
+	uint32_t							m_count = 0;		// Samples since last output
+	uint32_t							m_phase = 0;		// Oscillator phase
+	uint32_t							m_phasestep = 0;	// Oscillator phase increment
+};
+
+//---------------------------------------------------------------------------
+// decimator Constructor
+//
+// Arguments:
+//
+//	samplerate	- Sample rate of the input I/Q samples
+//	offset		- Frequency offset to be shifted to zero
+//	factor		- Decimation factor
+
+decimator::decimator(uint32_t samplerate, int32_t offset, uint32_t factor) : m_factor(factor),
+	m_gain(std::sqrt(static_cast<float>(factor)))
+{
+	double const pi = 3.14159265358979323846;
+
+	// Generate a Blackman windowed-sinc lowpass filter with a cutoff at 80% of the output
+	// Nyquist frequency, normalized for unity gain at DC
+	size_t const numtaps = (factor * TAPS_PER_PHASE) + 1;
+	double const cutoff = 0.4 / factor;
+	double const center = (numtaps - 1) / 2.0;
+
+	std::vector<double> taps(numtaps);
+	double sum = 0.0;
+	for(size_t index = 0; index < numtaps; index++) {
+
+		double const x = index - center;
+		double const sinc = (x == 0.0) ? 2.0 * cutoff : std::sin(2.0 * pi * cutoff * x) / (pi * x);
+		double const window = 0.42 - (0.5 * std::cos(2.0 * pi * index / (numtaps - 1))) + (0.08 * std::cos(4.0 * pi * index / (numtaps - 1)));
+
+		taps[index] = sinc * window;
+		sum += taps[index];
+	}
+
+	m_taps.resize(numtaps);
+	for(size_t index = 0; index < numtaps; index++) m_taps[index] = static_cast<float>(taps[index] / sum);
+
+	// The history is kept twice so the filter always has a contiguous window
+	m_history.resize(numtaps * 2);
+
+	// Generate the oscillator table and the phase increment that will shift the offset to zero
+	size_t const tablesize = static_cast<size_t>(1) << NCO_TABLE_BITS;
+	m_nco.resize(tablesize);
+	for(size_t index = 0; index < tablesize; index++)
+		m_nco[index] = std::polar(1.0f, static_cast<float>(2.0 * pi * index / tablesize));
+
+	m_phasestep = static_cast<uint32_t>(static_cast<int64_t>(std::llround(-static_cast<double>(offset) * 4294967296.0 / samplerate)));
+}
+
+//---------------------------------------------------------------------------
+// decimator::process
+//
+// Processes a buffer of 8-bit unsigned I/Q samples
+//
+// Arguments:
+//
+//	samples		- Input I/Q samples
+//	length		- Length of the input I/Q samples, in bytes
+//	output		- Receives the decimated I/Q samples
+
+void decimator::process(uint8_t const* samples, size_t length, std::vector<uint8_t>& output)
+{
+	size_t const numtaps = m_taps.size();
+
+	output.clear();
+	output.reserve(((length / 2) / m_factor + 1) * 2);
+
+	for(size_t index = 0; (index + 1) < length; index += 2) {
+
+		// Convert and shift the sample, then add it to the filter history
+		std::complex<float> const sample((samples[index] - 127.5f) / 127.5f, (samples[index + 1] - 127.5f) / 127.5f);
+		std::complex<float> const shifted = sample * m_nco[m_phase >> (32 - NCO_TABLE_BITS)];
+		m_phase += m_phasestep;
+
+		m_history[m_head] = m_history[m_head + numtaps] = shifted;
+		if(++m_head == numtaps) m_head = 0;
+
+		// Only the samples that survive decimation need to be filtered
+		if(++m_count < m_factor) continue;
+		m_count = 0;
+
+		std::complex<float> const* window = &m_history[m_head];
+		float i = 0.0f, q = 0.0f;
+		for(size_t tap = 0; tap < numtaps; tap++) {
+
+			i += window[tap].real() * m_taps[tap];
+			q += window[tap].imag() * m_taps[tap];
+		}
+
+		i *= m_gain;
+		q *= m_gain;
+
+		float const magnitude = (i * i) + (q * q);
+		if(magnitude > 1.0f) {
+
+			float const scale = 1.0f / std::sqrt(magnitude);
+			i *= scale;
+			q *= scale;
+		}
+
+		output.push_back(static_cast<uint8_t>(std::min(255L, std::max(0L, std::lround((i * 127.5f) + 127.5f)))));
+		output.push_back(static_cast<uint8_t>(std::min(255L, std::max(0L, std::lround((q * 127.5f) + 127.5f)))));
+	}
+}
+
+//---------------------------------------------------------------------------
+// session_t
+//
+// Defines the state of a single client connection
+
+struct session_t {
+
+	rtlsdr_dev_t*						device;				// RTL-SDR device handle
+	int									socket;				// Client socket
+	std::mutex							lock;				// Synchronization object
+	std::condition_variable				cv;					// Session condition variable
+	std::deque<std::vector<uint8_t>>	queue;				// Queued device buffers
+	bool								started = false;	// Streaming has started
+	bool								hello = false;		// Extensions were requested
+	bool								stop = false;		// Session is stopping
+	bool								reconfigure = true;	// Decimation has changed
+	uint32_t							samplerate = 0;		// Device sample rate
+	int32_t								offset = 0;			// Pending frequency offset
+	int32_t								decimationoffset = 0;	// Decimation frequency offset
+	uint32_t							decimation = 1;		// Decimation factor
+};
+
+//---------------------------------------------------------------------------
+// close_socket
+//
+// Closes an open socket, implementation specific
+//
+// Arguments:
+//
+//	socket		- Socket to be closed
+
+static void close_socket(int socket)
+{
+	if(socket == -1) return;
+
+#ifdef _WINDOWS
+	shutdown(static_cast<SOCKET>(socket), SD_BOTH);
+	closesocket(static_cast<SOCKET>(socket));
+#else
+	shutdown(socket, SHUT_RDWR);
+	close(socket);
+#endif
+}
+
+//---------------------------------------------------------------------------
+// execute_command
+//
+// Executes a client command against the device
+//
+// Arguments:
+//
+//	session		- Client session state
+//	cmd			- Command code
+//	param		- Command parameter (host byte order)
+
+static void execute_command(struct session_t& session, uint8_t cmd, uint32_t param)
+{
+	rtlsdr_dev_t* device = session.device;
+
+	switch(cmd) {
+
+		case 0x01:
+			fprintf(stderr, "set frequency %u\n", param);
+			rtlsdr_set_center_freq(device, param);
+			break;
+
+		case 0x02: {
+
+			fprintf(stderr, "set sample rate %u\n", param);
+			rtlsdr_set_sample_rate(device, param);
+
+			// Changing the sample rate always resets the decimation
+			std::unique_lock<std::mutex> lock(session.lock);
+			session.samplerate = rtlsdr_get_sample_rate(device);
+			session.offset = session.decimationoffset = 0;
+			session.decimation = 1;
+			session.reconfigure = true;
+			break;
+		}
+
+		case 0x03:
+			fprintf(stderr, "set gain mode %u\n", param);
+			rtlsdr_set_tuner_gain_mode(device, static_cast<int>(param));
+			break;
+
+		case 0x04:
+			fprintf(stderr, "set gain %d\n", static_cast<int>(param));
+			rtlsdr_set_tuner_gain(device, static_cast<int>(param));
+			break;
+
+		case 0x05:
+			fprintf(stderr, "set frequency correction %d\n", static_cast<int>(param));
+			rtlsdr_set_freq_correction(device, static_cast<int>(param));
+			break;
+
+		case 0x06:
+			fprintf(stderr, "set if stage %u gain %d\n", param >> 16, static_cast<int16_t>(param & 0xFFFF));
+			rtlsdr_set_tuner_if_gain(device, static_cast<int>(param >> 16), static_cast<int16_t>(param & 0xFFFF));
+			break;
+
+		case 0x07:
+			fprintf(stderr, "set test mode %u\n", param);
+			rtlsdr_set_testmode(device, static_cast<int>(param));
+			break;
+
+		case 0x08:
+			fprintf(stderr, "set agc mode %u\n", param);
+			rtlsdr_set_agc_mode(device, static_cast<int>(param));
+			break;
+
+		case 0x09:
+			fprintf(stderr, "set direct sampling %u\n", param);
+			rtlsdr_set_direct_sampling(device, static_cast<int>(param));
+			break;
+
+		case 0x0A:
+			fprintf(stderr, "set offset tuning %u\n", param);
+			rtlsdr_set_offset_tuning(device, static_cast<int>(param));
+			break;
+
+		case 0x0B:
+			fprintf(stderr, "set rtl xtal %u\n", param);
+			rtlsdr_set_xtal_freq(device, param, 0);
+			break;
+
+		case 0x0C:
+			fprintf(stderr, "set tuner xtal %u\n", param);
+			rtlsdr_set_xtal_freq(device, 0, param);
+			break;
+
+		case 0x0D: {
+
+			fprintf(stderr, "set tuner gain by index %u\n", param);
+
+			int const count = rtlsdr_get_tuner_gains(device, nullptr);
+			if((count > 0) && (param < static_cast<uint32_t>(count))) {
+
+				std::vector<int> gains(count);
+				rtlsdr_get_tuner_gains(device, gains.data());
+				rtlsdr_set_tuner_gain(device, gains[param]);
+			}
+			break;
+		}
+
+		case 0x0E:
+			fprintf(stderr, "set bias tee %u\n", param);
+			rtlsdr_set_bias_tee(device, static_cast<int>(param));
+			break;
+
+		case RTLTCPX_CMD_HELLO: {
+
+			// The extensions can only be negotiated before the first I/Q sample is sent
+			std::unique_lock<std::mutex> lock(session.lock);
+			if(session.started == false) {
+
+				fprintf(stderr, "client requested protocol extensions version %u\n", param);
+				session.hello = true;
+			}
+			break;
+		}
+
+		case RTLTCPX_CMD_SET_OFFSET: {
+
+			std::unique_lock<std::mutex> lock(session.lock);
+			session.offset = static_cast<int32_t>(param);
+			break;
+		}
+
+		case RTLTCPX_CMD_SET_DECIMATION: {
+
+			uint32_t const factor = std::max(1U, std::min(param, RTLTCPX_MAX_DECIMATION));
+
+			std::unique_lock<std::mutex> lock(session.lock);
+			fprintf(stderr, "set decimation %u offset %d\n", factor, session.offset);
+			session.decimationoffset = session.offset;
+			session.decimation = factor;
+			session.reconfigure = true;
+			break;
+		}
+	}
+}
+
+//---------------------------------------------------------------------------
+// send_all
+//
+// Sends an entire buffer of data to a socket
+//
+// Arguments:
+//
+//	socket		- Destination socket
+//	buffer		- Data to be sent
+//	length		- Length of the data to be sent
+
+static bool send_all(int socket, void const* buffer, size_t length)
+{
+	char const* data = reinterpret_cast<char const*>(buffer);
+
+	while(length > 0) {
+
+		int const sent = send(socket, data, static_cast<int>(std::min(length, static_cast<size_t>(INT32_MAX))), 0);
+		if(sent <= 0) return false;
+
+		data += sent;
+		length -= static_cast<size_t>(sent);
+	}
+
+	return true;
+}
+
+//---------------------------------------------------------------------------
+// serve_client
+//
+// Streams the device to a connected client until it disconnects
+//
+// Arguments:
+//
+//	device		- RTL-SDR device handle
+//	socket		- Connected client socket
+
+static void serve_client(rtlsdr_dev_t* device, int socket)
+{
+	session_t session;
+	session.device = device;
+	session.socket = socket;
+	session.samplerate = rtlsdr_get_sample_rate(device);
+
+	// Send the stock device information header
+	uint8_t header[12] = { 'R', 'T', 'L', '0' };
+	uint32_t const tunertype = htonl(static_cast<uint32_t>(rtlsdr_get_tuner_type(device)));
+	uint32_t const gaincount = htonl(static_cast<uint32_t>(std::max(0, rtlsdr_get_tuner_gains(device, nullptr))));
+	memcpy(&header[4], &tunertype, sizeof(uint32_t));
+	memcpy(&header[8], &gaincount, sizeof(uint32_t));
+	if(!send_all(socket, header, sizeof(header))) return;
+
+	// read_callback (local)
+	//
+	// Asynchronous read callback function for the RTL-SDR device
+	auto read_callback = [](unsigned char* buffer, uint32_t count, void* context) -> void {
+
+		session_t* session = reinterpret_cast<session_t*>(context);
+
+		std::unique_lock<std::mutex> lock(session->lock);
+		if(session->stop) return;
+
+		// A client that cannot keep up loses the oldest buffers rather than falling behind
+		if(session->queue.size() >= MAX_QUEUED_BUFFERS) session->queue.pop_front();
+		session->queue.emplace_back(buffer, buffer + count);
+		session->cv.notify_all();
+	};
+
+	// reader (local)
+	//
+	// Reads data from the device on a dedicated thread
+	auto reader = [&]() -> void {
+
+		rtlsdr_reset_buffer(device);
+		rtlsdr_read_async(device, read_callback, &session, 0, 0);
+
+		std::unique_lock<std::mutex> lock(session.lock);
+		session.stop = true;
+		session.cv.notify_all();
+	};
+
+	// sender (local)
+	//
+	// Sends the queued device buffers to the client on a dedicated thread
+	auto sender = [&]() -> void {
+
+		std::unique_ptr<decimator>	decimate;		// Active decimator instance
+		std::vector<uint8_t>		output;			// Decimated output buffer
+
+		std::unique_lock<std::mutex> lock(session.lock);
+
+		// Wait for the first command from the client, which may request the extensions
+		session.cv.wait_for(lock, std::chrono::milliseconds(FIRST_COMMAND_TIMEOUT), [&]() -> bool { return session.started || session.stop; });
+		session.started = true;
+
+		if(session.hello) {
+
+			struct rtltcpx_hello hello = {};
+			memcpy(hello.magic, RTLTCPX_MAGIC, sizeof(hello.magic));
+			hello.version = htonl(RTLTCPX_VERSION);
+			hello.maxdecimation = htonl(RTLTCPX_MAX_DECIMATION);
+
+			lock.unlock();
+			bool const sent = send_all(socket, &hello, sizeof(hello));
+			lock.lock();
+
+			if(!sent) session.stop = true;
+		}
+
+		while(session.stop == false) {
+
+			session.cv.wait(lock, [&]() -> bool { return (session.queue.size() > 0) || session.stop; });
+			if(session.stop) break;
+
+			std::vector<uint8_t> buffer(std::move(session.queue.front()));
+			session.queue.pop_front();
+
+			// Apply any change to the decimation between buffers; the buffers that were queued before
+			// the change are discarded rather than being sent through the new decimator
+			if(session.reconfigure) {
+
+				decimate.reset();
+				if(session.decimation > 1) decimate.reset(new decimator(session.samplerate, session.decimationoffset, session.decimation));
+				session.reconfigure = false;
+
+				session.queue.clear();
+				continue;
+			}
+
+			lock.unlock();
+
+			bool sent = false;
+			if(decimate) {
+
+				decimate->process(buffer.data(), buffer.size(), output);
+				sent = send_all(socket, output.data(), output.size());
+			}
+			else sent = send_all(socket, buffer.data(), buffer.size());
+
+			lock.lock();
+			if(!sent) session.stop = true;
+		}
+
+		// Unblock the command loop if the client has gone away
+		lock.unlock();
+	#ifdef _WINDOWS
+		shutdown(static_cast<SOCKET>(socket), SD_BOTH);
+	#else
+		shutdown(socket, SHUT_RDWR);
+	#endif
+	};
+
+	std::thread readerthread(reader);
+	std::thread senderthread(sender);
+
+	// Process commands from the client until it disconnects or the session stops
+	uint8_t command[5] = {};
+	size_t received = 0;
+	while(g_stop.load() == false) {
+
+		{
+			std::unique_lock<std::mutex> lock(session.lock);
+			if(session.stop) break;
+		}
+
+		int const result = recv(socket, reinterpret_cast<char*>(&command[received]), static_cast<int>(sizeof(command) - received), 0);
+		if(result == 0) break;
+		if(result < 0) {
+
+		#ifdef _WINDOWS
+			if(WSAGetLastError() == WSAETIMEDOUT) continue;
+		#else
+			if((errno == EAGAIN) || (errno == EWOULDBLOCK) || (errno == EINTR)) continue;
+		#endif
+			break;
+		}
+
+		received += static_cast<size_t>(result);
+		if(received < sizeof(command)) continue;
+		received = 0;
+
+		uint32_t param = 0;
+		memcpy(&param, &command[1], sizeof(uint32_t));
+		execute_command(session, command[0], ntohl(param));
+
+		// The first command from the client allows the data to start streaming
+		std::unique_lock<std::mutex> lock(session.lock);
+		session.started = true;
+		session.cv.notify_all();
+	}
+
+	// Stop the session and wait for the worker threads
+	{
+		std::unique_lock<std::mutex> lock(session.lock);
+		session.stop = true;
+		session.cv.notify_all();
+	}
+
+	rtlsdr_cancel_async(device);
+	readerthread.join();
+	senderthread.join();
+}
+
+//---------------------------------------------------------------------------
+// signal_handler
+//
+// Handles a request to terminate the server
+//
+// Arguments:
+//
+//	signal		- Signal number / console control event
+
+#ifdef _WINDOWS
+static BOOL WINAPI signal_handler(DWORD /*signal*/)
+{
+	g_stop.store(true);
+	return TRUE;
+}
+#else
+static void signal_handler(int /*signal*/)
+{
+	g_stop.store(true);
+}
+#endif
+
+//---------------------------------------------------------------------------
+// usage
+//
+// Displays the command line usage and exits
+//
+// Arguments:
+//
+//	NONE
+
+static void usage(void)
+{
+	fprintf(stderr,
+		"rtl_tcpx, an I/Q spectrum server for RTL2832 based DVB-T receivers\n"
+		"with support for server-side frequency shift and decimation\n\n"
+		"Usage:\t[-a listen address]\n"
+		"\t[-p listen port (default: 1234)]\n"
+		"\t[-f frequency to tune to [Hz]]\n"
+		"\t[-g gain (default: 0 for auto)]\n"
+		"\t[-s samplerate in Hz (default: 2048000 Hz)]\n"
+		"\t[-d device index (default: 0)]\n"
+		"\t[-P ppm_error (default: 0)]\n"
+		"\t[-T enable bias-T on GPIO PIN 0 (works for rtl-sdr.com v3 dongles)]\n");
+
+	exit(1);
+}
+
+//---------------------------------------------------------------------------
+// main
+//
+// Application entry point
+//
+// Arguments:
+//
+//	argc		- Number of command line arguments
+//	argv		- Array of command line arguments
+
+int main(int argc, char** argv)
+{
+	char const*		address = "127.0.0.1";				// Listen address
+	char const*		port = DEFAULT_PORT;				// Listen port
+	uint32_t		frequency = DEFAULT_FREQUENCY;		// Initial frequency
+	uint32_t		samplerate = DEFAULT_SAMPLE_RATE;	// Initial sample rate
+	uint32_t		index = 0;							// Device index
+	int				gain = 0;							// Initial gain (tenths of a dB)
+	int				ppm = 0;							// Frequency correction
+	int				biastee = 0;						// Bias tee enabled
+
+	int opt = 0;
+	while((opt = getopt(argc, argv, "a:p:f:g:s:d:P:T")) != -1) {
+
+		switch(opt) {
+
+			case 'a': address = optarg; break;
+			case 'p': port = optarg; break;
+			case 'f': frequency = static_cast<uint32_t>(atof(optarg)); break;
+			case 'g': gain = static_cast<int>(atof(optarg) * 10); break;
+			case 's': samplerate = static_cast<uint32_t>(atof(optarg)); break;
+			case 'd': index = static_cast<uint32_t>(atoi(optarg)); break;
+			case 'P': ppm = atoi(optarg); break;
+			case 'T': biastee = 1; break;
+			default: usage(); break;
+		}
+	}
+
+	if(argc > optind) usage();
+
+#ifdef _WINDOWS
+	WSADATA wsadata = {};
+	WSAStartup(MAKEWORD(2, 2), &wsadata);
+	SetConsoleCtrlHandler(signal_handler, TRUE);
+#else
+	struct sigaction action = {};
+	action.sa_handler = signal_handler;
+	sigemptyset(&action.sa_mask);
+	sigaction(SIGINT, &action, nullptr);
+	sigaction(SIGTERM, &action, nullptr);
+	signal(SIGPIPE, SIG_IGN);
+#endif
+
+	// Open and initialize the device
+	rtlsdr_dev_t* device = nullptr;
+	if(rtlsdr_open(&device, index) < 0) {
+
+		fprintf(stderr, "Failed to open rtlsdr device #%u.\n", index);
+		return 1;
+	}
+
+	if(ppm != 0) rtlsdr_set_freq_correction(device, ppm);
+	rtlsdr_set_sample_rate(device, samplerate);
+	rtlsdr_set_center_freq(device, frequency);
+	if(gain == 0) rtlsdr_set_tuner_gain_mode(device, 0);
+	else {
+
+		rtlsdr_set_tuner_gain_mode(device, 1);
+		rtlsdr_set_tuner_gain(device, gain);
+	}
+	rtlsdr_set_bias_tee(device, biastee);
+
+	// Create the listening socket
+	struct addrinfo hints = {};
+	hints.ai_family = AF_UNSPEC;
+	hints.ai_socktype = SOCK_STREAM;
+	hints.ai_protocol = IPPROTO_TCP;
+	hints.ai_flags = AI_PASSIVE;
+
+	struct addrinfo* addrs = nullptr;
+	if(getaddrinfo(address, port, &hints, &addrs) != 0) {
+
+		fprintf(stderr, "Invalid listen address %s:%s\n", address, port);
+		rtlsdr_close(device);
+		return 1;
+	}
+
+	int listener = static_cast<int>(socket(addrs->ai_family, addrs->ai_socktype, addrs->ai_protocol));
+	int reuse = 1;
+	setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, reinterpret_cast<char const*>(&reuse), sizeof(int));
+
+	if((listener == -1) || (bind(listener, addrs->ai_addr, static_cast<int>(addrs->ai_addrlen)) != 0) || (listen(listener, 1) != 0)) {
+
+		fprintf(stderr, "Unable to listen on %s:%s\n", address, port);
+		freeaddrinfo(addrs);
+		close_socket(listener);
+		rtlsdr_close(device);
+		return 1;
+	}
+
+	freeaddrinfo(addrs);
+
+	// Serve one client at a time until the server has been stopped
+	while(g_stop.load() == false) {
+
+		fprintf(stderr, "listening on %s:%s ...\n", address, port);
+
+		int client = -1;
+		while((client == -1) && (g_stop.load() == false)) {
+
+			fd_set readfds;
+			FD_ZERO(&readfds);
+			FD_SET(listener, &readfds);
+
+			struct timeval timeout = { 1, 0 };
+			if(select(listener + 1, &readfds, nullptr, nullptr, &timeout) > 0) client = static_cast<int>(accept(listener, nullptr, nullptr));
+		}
+
+		if(client == -1) break;
+
+		// SO_LINGER allows a client to reconnect immediately after it has disconnected
+		struct linger linger = {};
+		linger.l_onoff = 1;
+		linger.l_linger = 0;
+		setsockopt(client, SOL_SOCKET, SO_LINGER, reinterpret_cast<char const*>(&linger), sizeof(struct linger));
+
+		int nodelay = 1;
+		setsockopt(client, IPPROTO_TCP, TCP_NODELAY, reinterpret_cast<char const*>(&nodelay), sizeof(int));
+
+		// SO_RCVTIMEO allows the command loop to detect that the session has stopped
+	#ifdef _WINDOWS
+		DWORD timeout = 1000;
+	#else
+		struct timeval timeout = { 1, 0 };
+	#endif
+		setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, reinterpret_cast<char const*>(&timeout), sizeof(timeout));
+
+		fprintf(stderr, "client accepted\n");
+		serve_client(device, client);
+		close_socket(client);
+		fprintf(stderr, "client disconnected\n");
+	}
+
+	close_socket(listener);
+	rtlsdr_close(device);
+
+#ifdef _WINDOWS
+	WSACleanup();
+#endif
+
+	return 0;
+}
+
+//---------------------------------------------------------------------------
+
+#pragma warning(pop)
@@ -0,0 +1,94 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2020-2022 Michael G. Brehm
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#ifndef __RTL_TCPX_H_
+#define __RTL_TCPX_H_
+#pragma once
+
+#include <stdint.h>
+
+#pragma warning(push, 4)
+
+//---------------------------------------------------------------------------
+// rtl_tcp protocol extensions
+//
+// A stock rtl_tcp server silently ignores any command that it does not recognize,
+// which allows a client to probe for the extensions: RTLTCPX_CMD_HELLO is sent as
+// the first command after the device information has been received and an extended
+// server answers with a struct rtltcpx_hello ahead of the first I/Q sample.  A stock
+// server is already streaming, so the same 16 bytes are simply I/Q samples that can
+// be discarded.
+//
+// Once negotiated, the client can ask the server to shift a frequency offset within
+// the tuner passband to zero and decimate the I/Q samples before they are sent; the
+// data remains 8-bit unsigned I/Q, but at (sample rate / decimation).  Setting the
+// sample rate of the device (command 0x02) always resets the decimation to one
+
+// RTLTCPX_CMD_HELLO
+//
+// Requests the protocol extensions; the parameter is RTLTCPX_VERSION
+static uint8_t const RTLTCPX_CMD_HELLO = 0xA0;
+
+// RTLTCPX_CMD_SET_OFFSET
+//
+// Sets the frequency offset in hertz (signed) to be shifted to zero before decimation;
+// the offset does not take effect until the next RTLTCPX_CMD_SET_DECIMATION
+static uint8_t const RTLTCPX_CMD_SET_OFFSET = 0xA1;
+
+// RTLTCPX_CMD_SET_DECIMATION
+//
+// Sets the decimation factor (1 = disabled) and applies the frequency offset
+static uint8_t const RTLTCPX_CMD_SET_DECIMATION = 0xA2;
+
+// RTLTCPX_MAGIC
+//
+// Magic value at the start of the struct rtltcpx_hello response
+static char const RTLTCPX_MAGIC[8] = { 'R', 'T', 'L', 'T', 'C', 'P', 'X', '\0' };
+
+// RTLTCPX_MAX_DECIMATION
+//
+// Maximum decimation factor supported by this version of the protocol
+static uint32_t const RTLTCPX_MAX_DECIMATION = 64;
+
+// RTLTCPX_VERSION
+//
+// Version of the protocol extensions
+static uint32_t const RTLTCPX_VERSION = 1;
+
+// struct rtltcpx_hello
+//
+// Response to RTLTCPX_CMD_HELLO; integer values are in network byte order
+struct rtltcpx_hello {
+
+	char		magic[8];			// RTLTCPX_MAGIC
+	uint32_t	version;			// Server protocol version
+	uint32_t	maxdecimation;		// Maximum decimation factor
+};
+
+// struct rtltcpx_hello must be 16 bytes in length to preserve I/Q sample alignment
+static_assert(sizeof(rtltcpx_hello) == 16, "rtltcpx_hello structure size must be 16 bytes in length");
+
+//-----------------------------------------------------------------------------
+
+#pragma warning(pop)
+
+#endif	// __RTL_TCPX_H_
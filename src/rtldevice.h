@@ -53,7 +53,8 @@ public:
 
 	// begin_stream
 	//
-	// Starts streaming data from the device
+	// Starts streaming data from the device; any data buffered before this call,
+	// including data left over from a previous lease of a pooled device, is discarded
 	virtual void begin_stream(void) const = 0;
 
 	// cancel_async
@@ -91,6 +92,14 @@ public:
 	// Sets the center frequency of the device
 	virtual uint32_t set_center_frequency(uint32_t hz) const = 0;
 
+	// set_decimation
+	//
+	// Sets the frequency offset and decimation factor applied by the device; the
+	// offset is shifted to zero before decimating and the decimation factor that
+	// was applied is returned.  Setting the sample rate resets the decimation, and
+	// the factor cannot be changed while the device is streaming, only the offset
+	virtual uint32_t set_decimation(int offset, uint32_t factor) const = 0;
+
 	// set_frequency_correction
 	//
 	// Sets the frequency correction of the device
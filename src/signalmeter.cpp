@@ -23,10 +23,13 @@
 #include "stdafx.h"
 #include "signalmeter.h"
 
+#include <algorithm>
 #include <cmath>
+#include <limits>
 #include <string.h>
 
 #include "align.h"
+#include "fftwcache.h"
 #include "string_exception.h"
 
 #pragma warning(push, 4)
@@ -36,6 +39,11 @@
 // Default FFT size (bins)
 size_t const signalmeter::DEFAULT_FFT_SIZE = 512;
 
+// signalmeter::FFT_AVERAGES
+//
+// Number of FFTs averaged into the power spectrum
+size_t const signalmeter::FFT_AVERAGES = 50;
+
 // signalmeter::RING_BUFFER_SIZE
 //
 // Input ring buffer size
@@ -59,6 +67,8 @@ signalmeter::signalmeter(struct signalprops const& signalprops, struct signalplo
 	size_t bufferrequired = static_cast<size_t>((signalprops.samplerate * 2) * (static_cast<float>(rate) / 1000.0f));
 	if(bufferrequired > RING_BUFFER_SIZE) throw std::invalid_argument("rate");
 
+	if(m_plotprops.width == 0) throw std::invalid_argument("plotprops");
+
 	// Allocate the input ring buffer
 	m_buffer = std::unique_ptr<uint8_t[]>(new uint8_t[RING_BUFFER_SIZE]);
 	if(!m_buffer) throw std::bad_alloc();
@@ -69,17 +79,88 @@ signalmeter::signalmeter(struct signalprops const& signalprops, struct signalplo
 
 	// Calculate the number of bytes required in the input buffer to process and report
 	// updated signal statistics at (apporoximately) the requested rate in milliseconds
+	size_t const framebytes = m_fftsize * 2;
 	size_t bytespersecond = m_signalprops.samplerate * 2;
-	m_fftminbytes = align::down(static_cast<size_t>(bytespersecond * (static_cast<float>(rate) / 1000.0f)),
-		static_cast<unsigned int>(m_fftsize));
+	m_fftminbytes = std::max(framebytes, align::down(static_cast<size_t>(bytespersecond * (static_cast<float>(rate) / 1000.0f)),
+		static_cast<unsigned int>(framebytes)));
+	if(m_fftminbytes >= RING_BUFFER_SIZE) throw std::invalid_argument("rate");
+
+	m_interval.resize(m_fftminbytes);
 
 	// Initialize the finite impulse response filter
-	m_fir.SetupParameters(static_cast<TYPEREAL>(m_signalprops.lowcut), static_cast<TYPEREAL>(m_signalprops.highcut), 
-		-static_cast<TYPEREAL>(m_signalprops.offset), m_signalprops.samplerate);
+	if(m_signalprops.filter) {
+
+		m_fir.SetupParameters(static_cast<TYPEREAL>(m_signalprops.lowcut), static_cast<TYPEREAL>(m_signalprops.highcut),
+			-static_cast<TYPEREAL>(m_signalprops.offset), m_signalprops.samplerate);
+		// The filter can generate up to one full 2048 sample block more than it was given
+		m_filterin.resize(m_fftsize);
+		m_filterout.resize(m_fftsize + 2048);
+		m_samples.reserve((m_fftsize * 2) + 2048);
+	}
+
+	// Generate the Nuttall window; the conversion of the 8-bit samples into the range of -1.0
+	// through +1.0 is folded into the window to save a multiply on every sample
+	m_window.resize(m_fftsize);
+	for(size_t index = 0; index < m_fftsize; index++) {
+
+		double const x = (2.0 * 3.14159265358979323846 * index) / static_cast<double>(m_fftsize - 1);
+		m_window[index] = static_cast<float>((2.8 / 127.5) * (0.355768 - 0.487396 * std::cos(x) + 0.144232 * std::cos(2.0 * x) -
+			0.012604 * std::cos(3.0 * x)));
+	}
+
+	// A full scale signal is reported as 0dB
+	m_reference = 20.0f * std::log10(static_cast<float>(m_fftsize) / 2.0f);
+
+	// Map each point in the signal plot onto the range of FFT bins that it represents; when
+	// there are fewer bins than points adjacent points will map onto the same bin
+	auto tobin = [&](int32_t frequency) -> size_t {
+
+		int64_t bin = ((static_cast<int64_t>(frequency) * static_cast<int64_t>(m_fftsize)) / m_signalprops.samplerate) + (m_fftsize / 2);
+		return static_cast<size_t>(std::min(std::max(bin, static_cast<int64_t>(0)), static_cast<int64_t>(m_fftsize - 1)));
+	};
 
-	// Initialize the fast fourier transform instance
-	m_fft.SetFFTParams(static_cast<int>(m_fftsize), false, 0.0, m_signalprops.samplerate);
-	m_fft.SetFFTAve(50);
+	size_t const binmin = tobin(-(static_cast<int32_t>(m_signalprops.bandwidth) / 2) - static_cast<int32_t>(m_signalprops.offset));
+	size_t const binmax = tobin((static_cast<int32_t>(m_signalprops.bandwidth) / 2) - static_cast<int32_t>(m_signalprops.offset));
+
+	m_plotbins.resize(m_plotprops.width + 1);
+	for(size_t index = 0; index <= m_plotprops.width; index++)
+		m_plotbins[index] = binmin + ((index * (binmax - binmin + 1)) / m_plotprops.width);
+
+	m_spectrum.resize(m_fftsize);
+	m_plot.resize(m_plotprops.width + 1);
+
+	// Allocate the FFT buffers and create the plan, the plan is reused for every frame
+	m_fftin = reinterpret_cast<fftwf_complex*>(fftwf_malloc(sizeof(fftwf_complex) * m_fftsize));
+	m_fftout = reinterpret_cast<fftwf_complex*>(fftwf_malloc(sizeof(fftwf_complex) * m_fftsize));
+	if((m_fftin == nullptr) || (m_fftout == nullptr)) {
+
+		if(m_fftin) fftwf_free(m_fftin);
+		if(m_fftout) fftwf_free(m_fftout);
+		throw string_exception(__func__, ": unable to allocate FFT buffers");
+	}
+
+	try { m_plan = fftwcache::get_plan(static_cast<int>(m_fftsize), m_fftin, m_fftout, FFTW_FORWARD); }
+	catch(...) { fftwf_free(m_fftin); fftwf_free(m_fftout); throw; }
+
+	// Create the worker thread that processes the input samples
+	m_worker = std::thread(&signalmeter::worker, this);
+}
+
+//---------------------------------------------------------------------------
+// signalmeter Destructor
+
+signalmeter::~signalmeter()
+{
+	// Stop the worker thread before releasing anything it uses
+	std::unique_lock<std::mutex> lock(m_lock);
+	m_stop = true;
+	m_cv.notify_all();
+	lock.unlock();
+
+	if(m_worker.joinable()) m_worker.join();
+
+	if(m_fftin) fftwf_free(m_fftin);
+	if(m_fftout) fftwf_free(m_fftout);
 }
 
 //---------------------------------------------------------------------------
@@ -112,132 +193,223 @@ std::unique_ptr<signalmeter> signalmeter::create(struct signalprops const& signa
 
 void signalmeter::inputsamples(uint8_t const* samples, size_t length)
 {
-	size_t		byteswritten = 0;					// Bytes written into ring buffer
-
 	if((samples == nullptr) || (length == 0)) return;
 
-	// Ensure there is enough space in the ring buffer to satisfy the operation
+	// If the worker thread failed, report the exception back to the caller
+	if(m_stopped.load()) {
+
+		if(m_worker_exception) std::rethrow_exception(m_worker_exception);
+		return;
+	}
+
+	// Only the most recent data can ever be used, if the input is larger than the ring buffer
+	// skip over the older part of it (the ring buffer can hold one byte less than its size)
+	if(length >= RING_BUFFER_SIZE) {
+
+		size_t const skip = align::up(length - (RING_BUFFER_SIZE - 2), 2);
+		samples += skip;
+		length -= skip;
+	}
+
+	std::unique_lock<std::mutex> lock(m_lock);
+
+	// If there isn't enough space in the ring buffer, discard the oldest samples rather than
+	// waiting for the worker thread to catch up; the meter only cares about the latest data
 	size_t available = (m_head < m_tail) ? m_tail - m_head : (RING_BUFFER_SIZE - m_head) + m_tail;
-	if(length > available) throw string_exception("Insufficient ring buffer space to accomodate input");
+	if(length >= available) m_tail = (m_tail + align::up((length - available) + 1, 2)) % RING_BUFFER_SIZE;
 
-	// Write the input data into the ring buffer
-	size_t cb = length;
-	while(cb > 0) {
+	// Write the input data into the ring buffer, wrapping around the end if necessary
+	size_t const chunk = std::min(length, RING_BUFFER_SIZE - m_head);
+	memcpy(&m_buffer[m_head], samples, chunk);
+	if(chunk < length) memcpy(&m_buffer[0], &samples[chunk], length - chunk);
+	m_head = (m_head + length) % RING_BUFFER_SIZE;
+
+	m_cv.notify_one();				// Wake up the worker thread
+}
+
+//---------------------------------------------------------------------------
+// signalmeter::processframe (private)
+//
+// Transforms a single frame of input samples into the averaged power spectrum
+//
+// Arguments:
+//
+//	samples		- Pointer to one FFT frame of raw 8-bit I/Q samples
+
+bool signalmeter::processframe(uint8_t const* samples)
+{
+	bool overload = false;
 
-		// If the head is behind the tail linearly, take the data between them otherwise
-		// take the data between the end of the buffer and the head
-		size_t chunk = (m_head < m_tail) ? std::min(cb, m_tail - m_head) : std::min(cb, RING_BUFFER_SIZE - m_head);
-		memcpy(&m_buffer[m_head], &samples[byteswritten], chunk);
+	assert(samples != nullptr);
 
-		m_head += chunk;				// Increment the head position
-		byteswritten += chunk;			// Increment number of bytes written
-		cb -= chunk;					// Decrement remaining bytes
+	// The input is considered overloaded if any sample is within ~2% of full scale
+	for(size_t index = 0; index < (m_fftsize * 2); index++) overload |= (std::fabs(samples[index] - 127.5f) > 124.5f);
 
-		// If the head has reached the end of the buffer, reset it back to zero
-		if(m_head >= RING_BUFFER_SIZE) m_head = 0;
+	if(m_signalprops.filter) {
+
+		// Filter out everything but the desired bandwidth before applying the window
+		for(size_t index = 0; index < m_fftsize; index++)
+			m_filterin[index] = { static_cast<TYPEREAL>(samples[index * 2] - 127.5f), static_cast<TYPEREAL>(samples[(index * 2) + 1] - 127.5f) };
+
+		// The filter generates output in blocks rather than one sample for one sample, collect
+		// the output until there is enough to fill a frame
+		int numsamples = m_fir.ProcessData(static_cast<int>(m_fftsize), m_filterin.data(), m_filterout.data());
+		assert(numsamples <= static_cast<int>(m_filterout.size()));
+		m_samples.insert(m_samples.end(), m_filterout.begin(), m_filterout.begin() + numsamples);
+		if(m_samples.size() < m_fftsize) return overload;
+
+		for(size_t index = 0; index < m_fftsize; index++) {
+
+			m_fftin[index][0] = static_cast<float>(m_samples[index].re) * m_window[index];
+			m_fftin[index][1] = static_cast<float>(m_samples[index].im) * m_window[index];
+		}
+
+		m_samples.erase(m_samples.begin(), m_samples.begin() + m_fftsize);
 	}
 
-	assert(byteswritten == length);		// Verify all bytes were written
-	processsamples();					// Process the available input samples
+	else for(size_t index = 0; index < m_fftsize; index++) {
+
+		m_fftin[index][0] = (samples[index * 2] - 127.5f) * m_window[index];
+		m_fftin[index][1] = (samples[(index * 2) + 1] - 127.5f) * m_window[index];
+	}
+
+	fftwf_execute_dft(m_plan, m_fftin, m_fftout);
+
+	// Average the power of each bin into the spectrum; this is a straight mean until FFT_AVERAGES
+	// frames have been seen and an exponential average with the same time constant thereafter.
+	// The spectrum is stored with the negative frequencies first and DC in the center
+	m_frames = std::min(m_frames + 1, FFT_AVERAGES);
+	float const weight = 1.0f / static_cast<float>(m_frames);
+	size_t const half = m_fftsize / 2;
+
+	float* const upper = &m_spectrum[half];
+	for(size_t index = 0; index < half; index++) {
+
+		float const power = (m_fftout[index][0] * m_fftout[index][0]) + (m_fftout[index][1] * m_fftout[index][1]);
+		upper[index] += (power - upper[index]) * weight;
+	}
+
+	float* const lower = &m_spectrum[0];
+	fftwf_complex const* const negative = &m_fftout[half];
+	for(size_t index = 0; index < half; index++) {
+
+		float const power = (negative[index][0] * negative[index][0]) + (negative[index][1] * negative[index][1]);
+		lower[index] += (power - lower[index]) * weight;
+	}
+
+	return overload;
 }
 
 //---------------------------------------------------------------------------
 // signalmeter::processsamples (private)
 //
-// Processes the available input samples
+// Processes one status interval of input samples
 //
 // Arguments:
 //
-//	NONE
+//	samples		- Pointer to the raw 8-bit I/Q samples
+//	length		- Length of the input data in bytes
 
-void signalmeter::processsamples(void)
+void signalmeter::processsamples(uint8_t const* samples, size_t length)
 {
-	// Allocate a heap buffer to store the converted I/Q samples for the FFT
-	std::unique_ptr<TYPECPX[]> samples(new TYPECPX[m_fftsize]);
-	if(!samples) throw std::bad_alloc();
+	size_t const framebytes = m_fftsize * 2;
 
-	assert((m_fftminbytes % m_fftsize) == 0);
+	assert(samples != nullptr);
+	assert((length % framebytes) == 0);
 
-	// Determine how much data is available in the ring buffer for processing as I/Q samples
-	size_t available = (m_tail > m_head) ? (RING_BUFFER_SIZE - m_tail) + m_head : m_head - m_tail;
-	while(available >= m_fftminbytes) {
+	bool overload = false;
 
-		// Push all of the input samples into the FFT
-		for(size_t iterations = 0; iterations < (available / m_fftsize); iterations++) {
+	// Push the input samples through the FFT one frame at a time
+	for(size_t offset = 0; offset < length; offset += framebytes) overload |= processframe(&samples[offset]);
 
-			// Convert the raw 8-bit I/Q samples into scaled complex I/Q samples
-			for(size_t index = 0; index < m_fftsize; index++) {
+	// Convert the averaged power spectrum into the integer-based signal plot; the strongest bin
+	// is used when a point represents more than one bin and only that bin is converted into dB
+	float const scale = static_cast<float>(m_plotprops.height) / (m_plotprops.maxdb - m_plotprops.mindb);
+	for(size_t index = 0; index < m_plotprops.width; index++) {
 
-				// The FFT expects the I/Q samples in the range of -32767.0 through +32767.0
-				// (32767.0 / 127.5) = 256.9960784313725
-				samples[index] = {
+		float power = m_spectrum[m_plotbins[index]];
+		for(size_t bin = m_plotbins[index] + 1; bin < m_plotbins[index + 1]; bin++) power = std::max(power, m_spectrum[bin]);
 
-				#ifdef FMDSP_USE_DOUBLE_PRECISION
-					(static_cast<TYPEREAL>(m_buffer[m_tail]) - 127.5) * 256.9960784313725,			// I
-					(static_cast<TYPEREAL>(m_buffer[m_tail + 1]) - 127.5) * 256.9960784313725,		// Q
-				#else
-					(static_cast<TYPEREAL>(m_buffer[m_tail]) - 127.5f) * 256.9960784313725f,		// I
-					(static_cast<TYPEREAL>(m_buffer[m_tail + 1]) - 127.5f) * 256.9960784313725f,	// Q
-				#endif
-				};
+		float const db = (10.0f * std::log10(std::max(power, std::numeric_limits<float>::min()))) - m_reference;
+		float const y = (m_plotprops.maxdb - db) * scale;
+		m_plot[index] = static_cast<int>(std::min(std::max(y, 0.0f), static_cast<float>(m_plotprops.height)));
+	}
 
-				m_tail += 2;
-				if(m_tail >= RING_BUFFER_SIZE) m_tail = 0;
-			}
+	// Determine how many Hertz are represented by each measurement in the signal plot and the center point
+	float hzper = static_cast<float>(m_plotprops.width) / static_cast<float>(m_signalprops.bandwidth);
+	int32_t center = static_cast<int>(m_plotprops.width) / 2;
 
-			size_t numsamples = m_fftsize;
+	// Initialize a new signal_status structure with the proper signal type for the low/high cut indexes
+	struct signal_status status = {};
 
-			// If specified, filter out everything but the desired bandwidth
-			if(m_signalprops.filter) {
+	// Power is measured at the center frequency and smoothed
+	float power = ((m_plotprops.mindb - m_plotprops.maxdb) * (static_cast<float>(m_plot[center]) / 
+		static_cast<float>(m_plotprops.height))) + m_plotprops.maxdb;
+	status.power = m_avgpower = (std::isnan(m_avgpower)) ? power : 0.85f * m_avgpower + 0.15f * power;
 
-				numsamples = m_fir.ProcessData(static_cast<int>(m_fftsize), &samples[0], &samples[0]);
-				assert(numsamples == m_fftsize);
-			}
+	// Noise is measured at the low and high cuts, averaged, and smoothed
+	status.lowcut = std::max(0, center + static_cast<int32_t>(m_signalprops.lowcut * hzper));
+	status.highcut = std::min(static_cast<int32_t>(m_plotprops.width - 1), center + static_cast<int32_t>(m_signalprops.highcut * hzper));
+	float noise = ((m_plotprops.mindb - m_plotprops.maxdb) * (static_cast<float>((m_plot[status.lowcut] + m_plot[status.highcut]) / 2.0f) /
+		static_cast<float>(m_plotprops.height))) + m_plotprops.maxdb;
+	status.noise = m_avgnoise = (std::isnan(m_avgnoise)) ? noise : 0.85f * m_avgnoise + 0.15f * noise;
 
-			// Push the current set of samples through the fast fourier transform
-			m_fft.PutInDisplayFFT(static_cast<qint32>(numsamples), &samples[0]);
+	status.snr = m_avgpower + -m_avgnoise;				// SNR in dB
+	status.overload = overload;							// Overload flag
+	status.plotsize = m_plotprops.width;				// Plot width
+	status.plotdata = m_plot.data();					// Plot data
 
-			// Recalculate the amount of available data in the ring buffer after the read operation
-			available = (m_tail > m_head) ? (RING_BUFFER_SIZE - m_tail) + m_head : m_head - m_tail;
-		}
+	// Invoke the callback to report the updated metrics and signal plot
+	m_onstatus(status);
+}
+
+//---------------------------------------------------------------------------
+// signalmeter::worker (private)
+//
+// Worker thread procedure used to process the buffered input samples
+//
+// Arguments:
+//
+//	NONE
+
+void signalmeter::worker(void)
+{
+	try {
+
+		while(true) {
 
-		// Convert the FFT into an integer-based signal plot
-		std::unique_ptr<int[]> plot(new int[m_plotprops.width + 1]);
-		bool overload = m_fft.GetScreenIntegerFFTData(static_cast<qint32>(m_plotprops.height), static_cast<qint32>(m_plotprops.width),
-			static_cast<TYPEREAL>(m_plotprops.maxdb), static_cast<TYPEREAL>(m_plotprops.mindb),
-			-(static_cast<int32_t>(m_signalprops.bandwidth) / 2) - m_signalprops.offset,
-			(static_cast<int32_t>(m_signalprops.bandwidth) / 2) - m_signalprops.offset, &plot[0]);
-
-		// Determine how many Hertz are represented by each measurement in the signal plot and the center point
-		float hzper = static_cast<float>(m_plotprops.width) / static_cast<float>(m_signalprops.bandwidth);
-		int32_t center = static_cast<int>(m_plotprops.width) / 2;
-
-		// Initialize a new signal_status structure with the proper signal type for the low/high cut indexes
-		struct signal_status status = {};
-
-		// Power is measured at the center frequency and smoothed
-		float power = ((m_plotprops.mindb - m_plotprops.maxdb) * (static_cast<float>(plot[center]) / 
-			static_cast<float>(m_plotprops.height))) + m_plotprops.maxdb;
-		status.power = m_avgpower = (std::isnan(m_avgpower)) ? power : 0.85f * m_avgpower + 0.15f * power;
-
-		// Noise is measured at the low and high cuts, averaged, and smoothed
-		status.lowcut = std::max(0, center + static_cast<int32_t>(m_signalprops.lowcut * hzper));
-		status.highcut = std::min(static_cast<int32_t>(m_plotprops.width - 1), center + static_cast<int32_t>(m_signalprops.highcut * hzper));
-		float noise = ((m_plotprops.mindb - m_plotprops.maxdb) * (static_cast<float>((plot[status.lowcut] + plot[status.highcut]) / 2.0f) /
-			static_cast<float>(m_plotprops.height))) + m_plotprops.maxdb;
-		status.noise = m_avgnoise = (std::isnan(m_avgnoise)) ? noise : 0.85f * m_avgnoise + 0.15f * noise;
-
-		status.snr = m_avgpower + -m_avgnoise;				// SNR in dB
-		status.overload = overload;							// Overload flag
-		status.plotsize = m_plotprops.width;				// Plot width
-		status.plotdata = &plot[0];							// Plot data
-
-		// Invoke the callback to report the updated metrics and signal plot
-		m_onstatus(status);
-
-		// Recalculate the amount of available data in the ring buffer
-		available = (m_tail > m_head) ? (RING_BUFFER_SIZE - m_tail) + m_head : m_head - m_tail;
+			std::unique_lock<std::mutex> lock(m_lock);
+
+			// Wait until there is a full status interval of samples in the ring buffer
+			size_t available = 0;
+			m_cv.wait(lock, [&]() -> bool {
+
+				available = (m_tail > m_head) ? (RING_BUFFER_SIZE - m_tail) + m_head : m_head - m_tail;
+				return m_stop || (available >= m_fftminbytes);
+			});
+
+			if(m_stop) break;
+
+			// If the worker has fallen behind, skip over all but the most recent interval
+			size_t const stale = ((available / m_fftminbytes) - 1) * m_fftminbytes;
+			m_tail = (m_tail + stale) % RING_BUFFER_SIZE;
+
+			// Copy the interval out of the ring buffer so the producer is never blocked
+			// for longer than it takes to do that
+			size_t const chunk = std::min(m_fftminbytes, RING_BUFFER_SIZE - m_tail);
+			memcpy(m_interval.data(), &m_buffer[m_tail], chunk);
+			if(chunk < m_fftminbytes) memcpy(&m_interval[chunk], &m_buffer[0], m_fftminbytes - chunk);
+			m_tail = (m_tail + m_fftminbytes) % RING_BUFFER_SIZE;
+
+			lock.unlock();
+
+			processsamples(m_interval.data(), m_interval.size());
+		}
 	}
+
+	catch(...) { m_worker_exception = std::current_exception(); }
+
+	m_stopped.store(true);					// Thread is stopped
 }
 
 //---------------------------------------------------------------------------
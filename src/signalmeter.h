@@ -24,11 +24,17 @@
 #define __SIGNALMETER_H_
 #pragma once
 
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <fftw3.h>
 #include <functional>
 #include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
 
 #include "fmdsp/fastfir.h"
-#include "fmdsp/fft.h"
 
 #include "props.h"
 
@@ -37,7 +43,9 @@
 //---------------------------------------------------------------------------
 // Class signalmeter
 //
-// Implements the FM signal meter
+// Implements the FM signal meter; input samples are only buffered on the
+// caller's thread and processed on a dedicated worker thread, which skips
+// ahead to the most recent data whenever it falls behind
 
 class signalmeter
 {
@@ -45,7 +53,7 @@ public:
 
 	// Destructor
 	//
-	~signalmeter() = default;
+	~signalmeter();
 
 	//-----------------------------------------------------------------------
 	// Type Declarations
@@ -99,6 +107,11 @@ private:
 	// Default FFT size (bins)
 	static size_t const DEFAULT_FFT_SIZE;
 
+	// FFT_AVERAGES
+	//
+	// Number of FFTs averaged into the power spectrum
+	static size_t const FFT_AVERAGES;
+
 	// RING_BUFFER_SIZE
 	//
 	// Input ring buffer size
@@ -112,10 +125,20 @@ private:
 	//-----------------------------------------------------------------------
 	// Private Member Functions
 
+	// processframe
+	//
+	// Transforms a single frame of input samples into the averaged power spectrum
+	bool processframe(uint8_t const* samples);
+
 	// processsamples
 	//
-	// Processes the available input samples
-	void processsamples(void);
+	// Processes one status interval of input samples
+	void processsamples(uint8_t const* samples, size_t length);
+
+	// worker
+	//
+	// Worker thread procedure used to process the buffered input samples
+	void worker(void);
 
 	//-----------------------------------------------------------------------
 	// Member Variables
@@ -128,16 +151,40 @@ private:
 	//
 	CFastFIR				m_fir;							// Finite impulse response filter
 	size_t					m_fftsize{ DEFAULT_FFT_SIZE };	// FFT size (bins)
-	CFft					m_fft;							// FFT instance
 	size_t					m_fftminbytes{ 0 };				// Number of bytes required to process
+	fftwf_complex*			m_fftin{ nullptr };				// FFT input buffer
+	fftwf_complex*			m_fftout{ nullptr };			// FFT output buffer
+	fftwf_plan				m_plan{ nullptr };				// FFT plan
+	std::vector<float>		m_window;						// FFT window function
+	std::vector<uint8_t>	m_interval;						// Status interval sample buffer
+	std::vector<TYPECPX>	m_filterin;						// Filter input buffer
+	std::vector<TYPECPX>	m_filterout;					// Filter output buffer
+	std::vector<TYPECPX>	m_samples;						// Filtered samples pending transform
+	std::vector<float>		m_spectrum;						// Averaged power spectrum (linear)
+	size_t					m_frames{ 0 };					// Number of frames averaged
+	float					m_reference{ 0.0f };			// Full scale reference level (dB)
 	float					m_avgpower{ NAN };				// Average power level
 	float					m_avgnoise{ NAN };				// Average noise level
 
+	// SIGNAL PLOT
+	//
+	std::vector<size_t>		m_plotbins;						// First FFT bin of each plot point
+	std::vector<int>		m_plot;							// Signal plot data
+
 	// RING BUFFER
 	//
 	std::unique_ptr<uint8_t[]>		m_buffer;				// Input ring buffer
 	size_t							m_head{ 0 };			// Ring buffer head position
 	size_t							m_tail{ 0 };			// Ring buffer tail position
+	std::mutex						m_lock;					// Synchronization object
+	std::condition_variable			m_cv;					// Ring buffer condition
+
+	// WORKER THREAD
+	//
+	std::thread						m_worker;				// Sample processing thread
+	std::exception_ptr				m_worker_exception;		// Exception on worker thread
+	bool							m_stop{ false };		// Flag to stop the worker thread
+	std::atomic<bool>				m_stopped{ false };		// Worker thread stopped flag
 };
 
 //-----------------------------------------------------------------------------
@@ -25,18 +25,37 @@
 
 #include <algorithm>
 #include <arpa/inet.h>
+#include <atomic>
+#include <condition_variable>
 #include <cstring>
+#include <mutex>
 #include <netinet/tcp.h>
 #include <netdb.h>
 #include <sys/socket.h>
+#ifndef _WINDOWS
+#include <sys/select.h>
+#include <sys/uio.h>
+#endif
+#include <thread>
 #include <unistd.h>
 
 #include "align.h"
+#include "rtl_tcpx.h"
 #include "socket_exception.h"
 #include "string_exception.h"
 
 #pragma warning(push, 4)
 
+// tcpdevice::RECEIVE_BUFFER_SIZE (static)
+//
+// Size of the kernel socket receive buffer (SO_RCVBUF)
+int const tcpdevice::RECEIVE_BUFFER_SIZE = static_cast<int>(4 MiB);
+
+// tcpdevice::RING_BUFFER_BLOCKS (static)
+//
+// Number of callback-sized blocks held by the asynchronous ring buffer
+size_t const tcpdevice::RING_BUFFER_BLOCKS = 32;
+
 // tcpdevice::s_gaintable_e4k
 //
 std::vector<int> const tcpdevice::s_gaintable_e4k
@@ -122,6 +141,15 @@ tcpdevice::tcpdevice(char const* host, uint16_t port)
 			result = setsockopt(m_socket, SOL_SOCKET, SO_LINGER, reinterpret_cast<char const*>(&linger), sizeof(struct linger));
 			if(result == -1) throw socket_exception(__func__, ": setsockopt(SO_LINGER) failed");
 
+			// SO_RCVBUF
+			//
+			// The receive buffer must be set before the connection is established for the
+			// TCP window scaling to take it into account
+			int rcvbuf = RECEIVE_BUFFER_SIZE;
+
+			result = setsockopt(m_socket, SOL_SOCKET, SO_RCVBUF, reinterpret_cast<char const*>(&rcvbuf), sizeof(int));
+			if(result == -1) throw socket_exception(__func__, ": setsockopt(SO_RCVBUF) failed");
+
 			// Establish the TCP/IP socket connection
 			result = connect(m_socket, addrs->ai_addr, static_cast<int>(addrs->ai_addrlen));
 			if(result != 0) throw socket_exception(__func__, ": connect() failed");
@@ -170,8 +198,30 @@ tcpdevice::tcpdevice(char const* host, uint16_t port)
 			snprintf(devicename, std::extent<decltype(devicename)>::value, "Realtek RTL2832U on %s:%d", host, port);
 			m_name.assign(devicename);
 
+			// Probe for the rtl_tcpx protocol extensions; an extended server answers with a
+			// hello structure ahead of the I/Q samples, a stock server ignores the command and
+			// the same number of bytes are I/Q samples that can be safely discarded
+			struct device_command command = { RTLTCPX_CMD_HELLO, htonl(RTLTCPX_VERSION) };
+			result = send(m_socket, reinterpret_cast<char const*>(&command), sizeof(struct device_command), 0);
+			if(result != sizeof(struct device_command)) throw socket_exception(__func__, ": send() failed");
+
+			struct rtltcpx_hello hello = {};
+			size_t received = 0;
+			while(received < sizeof(struct rtltcpx_hello)) {
+
+				result = recv(m_socket, reinterpret_cast<char*>(&hello) + received, static_cast<int>(sizeof(struct rtltcpx_hello) - received), 0);
+				if(result <= 0) throw socket_exception(__func__, ": recv(struct rtltcpx_hello) failed");
+				received += static_cast<size_t>(result);
+			}
+
+			if(memcmp(hello.magic, RTLTCPX_MAGIC, sizeof(hello.magic)) == 0) {
+
+				m_extended = true;
+				m_maxdecimation = std::max(1U, std::min(ntohl(hello.maxdecimation), RTLTCPX_MAX_DECIMATION));
+			}
+
 			// Turn off internal digital automatic gain control
-			struct device_command command = { 0x08, 0 };
+			command = { 0x08, 0 };
 			result = send(m_socket, reinterpret_cast<char const*>(&command), sizeof(struct device_command), 0);
 			if (result != sizeof(struct device_command)) throw socket_exception(__func__, ": send() failed");
 		}
@@ -217,6 +267,33 @@ tcpdevice::~tcpdevice()
 
 void tcpdevice::begin_stream(void) const
 {
+	assert(m_socket != -1);
+
+	// The server streams continuously, so any data already sitting in the socket receive
+	// buffer was sampled before the device was (re)configured; this is especially true for
+	// an idle pooled device being handed out again.  Discard it so that the consumer only
+	// receives samples at the current settings.  The drain is bounded since the server keeps
+	// sending while this runs; anything beyond that is no older than the drain itself
+	std::unique_ptr<uint8_t[]> discard(new uint8_t[64 KiB]);
+	size_t remaining = static_cast<size_t>(RECEIVE_BUFFER_SIZE) * 2;
+
+	while(remaining > 0) {
+
+		fd_set readfds;
+		FD_ZERO(&readfds);
+		FD_SET(m_socket, &readfds);
+
+		struct timeval timeout = {};
+		int result = select(m_socket + 1, &readfds, nullptr, nullptr, &timeout);
+		if(result == -1) throw socket_exception(__func__, ": select() failed");
+		if(result == 0) break;
+
+		result = recv(m_socket, reinterpret_cast<char*>(&discard[0]), static_cast<int>(64 KiB), 0);
+		if(result == -1) throw socket_exception(__func__, ": recv() failed");
+		if(result == 0) throw string_exception(__func__, ": connection closed by host");
+
+		remaining -= std::min(remaining, static_cast<size_t>(result));
+	}
 }
 
 //---------------------------------------------------------------------------
@@ -348,31 +425,154 @@ size_t tcpdevice::read(uint8_t* buffer, size_t count) const
 
 void tcpdevice::read_async(rtldevice::asynccallback const& callback, uint32_t bufferlength) const
 {
-	std::unique_ptr<uint8_t[]>	buffer(new uint8_t[bufferlength]);		// Input data buffer
-	size_t						offset = 0;								// Buffer offset
+	assert(m_socket != -1);
+
+	if(bufferlength == 0) throw std::invalid_argument("bufferlength");
+
+	size_t const					buffersize = bufferlength * RING_BUFFER_BLOCKS;
+	std::unique_ptr<uint8_t[]>		buffer(new uint8_t[buffersize]);	// Ring buffer
+	std::atomic<size_t>				head{ 0 };							// Bytes received
+	std::atomic<size_t>				tail{ 0 };							// Bytes consumed
+	std::mutex						lock;								// Synchronization object
+	std::condition_variable			cv;									// Wakes the waiting thread
+	std::atomic<bool>				stop{ false };						// Flag to stop the reader
+	std::atomic<bool>				stopped{ false };					// Reader has stopped
+	std::exception_ptr				exception;							// Reader exception
+
+	// reader (local)
+	//
+	// Receives data from the socket into all of the free ring buffer space at once on
+	// a dedicated thread, so the socket continues to drain while the callback is busy
+	auto reader = [&]() -> void {
+
+		try {
+
+			while(stop.load() == false) {
+
+				size_t const in = head.load(std::memory_order_relaxed);
+				size_t const available = buffersize - (in - tail.load(std::memory_order_acquire));
+
+				// If the ring buffer is full, wait for the callback to consume a block
+				if(available == 0) {
+
+					std::unique_lock<std::mutex> critsec(lock);
+					cv.wait_for(critsec, std::chrono::milliseconds(100), [&]() -> bool {
+						return ((in - tail.load()) < buffersize) || stop.load(); });
+
+					continue;
+				}
+
+				head.store(in + read_ring(&buffer[0], buffersize, in % buffersize, available), std::memory_order_release);
+
+				std::unique_lock<std::mutex> critsec(lock);
+				cv.notify_all();
+			}
+		}
+
+		catch(...) { exception = std::current_exception(); }
+
+		std::unique_lock<std::mutex> critsec(lock);
+		stopped.store(true);
+		cv.notify_all();
+	};
 
 	m_stop = false;
 	m_stopped = false;
 
+	std::thread worker(reader);
+
 	try {
 
-		// Continuously read data from the device until the stop condition is set
+		// Deliver each full block to the callback on this thread until the stop condition is set
 		while(m_stop.test(true) == false) {
 
-			// Try to read enough data to fill the input buffer
-			offset += read(&buffer[offset], bufferlength - offset);
-			if(offset == bufferlength) {
+			size_t const out = tail.load(std::memory_order_relaxed);
+
+			// Wait for a full block to become available or for the reader to stop
+			std::unique_lock<std::mutex> critsec(lock);
+			cv.wait_for(critsec, std::chrono::milliseconds(100), [&]() -> bool {
+				return ((head.load() - out) >= bufferlength) || stopped.load(); });
+			critsec.unlock();
+
+			if((head.load(std::memory_order_acquire) - out) >= bufferlength) {
+
+				callback(&buffer[out % buffersize], bufferlength);
+				tail.store(out + bufferlength, std::memory_order_release);
 
-				callback(&buffer[0], offset);		// Buffer is full, invoke callback
-				offset = 0;							// Reset buffer offset
+				critsec.lock();
+				cv.notify_all();
+			}
+
+			// The reader only stops on its own if the connection failed
+			else if(stopped.load()) {
+
+				if(exception) std::rethrow_exception(exception);
+				break;
 			}
 		}
 
+		stop.store(true);
+		worker.join();
+
 		m_stopped = true;							// Operation has been stopped
 	}
 
-	// Ensure that the stopped condition is set on an exception
-	catch(...) { m_stopped = true; throw; }
+	// Ensure the reader is stopped and the stopped condition is set on an exception
+	catch(...) {
+
+		stop.store(true);
+		if(worker.joinable()) worker.join();
+
+		m_stopped = true;
+		throw;
+	}
+}
+
+//---------------------------------------------------------------------------
+// tcpdevice::read_ring (private)
+//
+// Reads as much data from the socket as will fit into a ring buffer
+//
+// Arguments:
+//
+//	buffer		- Ring buffer to receive the data
+//	buffersize	- Overall size of the ring buffer
+//	head		- Offset within the ring buffer to begin writing
+//	count		- Amount of free space within the ring buffer
+
+size_t tcpdevice::read_ring(uint8_t* buffer, size_t buffersize, size_t head, size_t count) const
+{
+	assert((buffer != nullptr) && (head < buffersize) && (count <= buffersize));
+
+	// The free space may wrap around the end of the ring buffer; both segments are filled
+	// with a single scatter read to minimize the number of system calls
+	size_t const first = std::min(count, buffersize - head);
+
+#ifdef _WINDOWS
+	WSABUF buffers[2] = {};
+	DWORD numbuffers = 1;
+	buffers[0].buf = reinterpret_cast<char*>(&buffer[head]);
+	buffers[0].len = static_cast<ULONG>(first);
+	if(count > first) { buffers[1].buf = reinterpret_cast<char*>(&buffer[0]); buffers[1].len = static_cast<ULONG>(count - first); numbuffers++; }
+
+	DWORD read = 0;
+	DWORD flags = 0;
+	if(WSARecv(static_cast<SOCKET>(m_socket), buffers, numbuffers, &read, &flags, nullptr, nullptr) == SOCKET_ERROR)
+		throw socket_exception(__func__, ": WSARecv() failed");
+#else
+	struct iovec buffers[2] = {};
+	int numbuffers = 1;
+	buffers[0].iov_base = &buffer[head];
+	buffers[0].iov_len = first;
+	if(count > first) { buffers[1].iov_base = &buffer[0]; buffers[1].iov_len = count - first; numbuffers++; }
+
+	ssize_t read = readv(m_socket, buffers, numbuffers);
+	if(read == -1) throw socket_exception(__func__, ": readv() failed");
+#endif
+
+	if(read == 0) throw string_exception(__func__, ": connection closed by host");
+
+	return static_cast<size_t>(read);
 }
 
 //---------------------------------------------------------------------------
@@ -413,6 +613,44 @@ uint32_t tcpdevice::set_center_frequency(uint32_t hz) const
 	return hz;
 }
 
+//---------------------------------------------------------------------------
+// tcpdevice::set_decimation
+//
+// Sets the frequency offset and decimation factor applied by the device
+//
+// Arguments:
+//
+//	offset		- Frequency offset to shift to zero, specified in hertz
+//	factor		- Requested decimation factor
+
+uint32_t tcpdevice::set_decimation(int offset, uint32_t factor) const
+{
+	assert(m_socket != -1);
+
+	// A stock rtl_tcp server cannot decimate the samples
+	if(m_extended == false) return 1;
+
+	factor = std::max(1U, std::min(factor, m_maxdecimation));
+
+	// The decimation factor can only be changed when the device is not streaming, data already in
+	// transit at the previous rate cannot be told apart from the data at the new rate.  The offset
+	// can still be changed, which doesn't affect the rate of the samples
+	if(m_stopped.test(false)) factor = m_decimation;
+
+	// The offset is latched by the server when the decimation factor is set
+	struct device_command command = { RTLTCPX_CMD_SET_OFFSET, htonl(static_cast<uint32_t>(offset)) };
+	int result = send(m_socket, reinterpret_cast<char const*>(&command), sizeof(struct device_command), 0);
+	if(result != sizeof(struct device_command)) throw socket_exception(__func__, ": send() failed");
+
+	command = { RTLTCPX_CMD_SET_DECIMATION, htonl(factor) };
+	result = send(m_socket, reinterpret_cast<char const*>(&command), sizeof(struct device_command), 0);
+	if(result != sizeof(struct device_command)) throw socket_exception(__func__, ": send() failed");
+
+	m_decimation = factor;
+
+	return factor;
+}
+
 //---------------------------------------------------------------------------
 // tcpdevice::set_frequency_correction
 //
@@ -485,6 +723,8 @@ uint32_t tcpdevice::set_sample_rate(uint32_t hz) const
 	int result = send(m_socket, reinterpret_cast<char const*>(&command), sizeof(struct device_command), 0);
 	if(result != sizeof(struct device_command)) throw socket_exception(__func__, ": send() failed");
 
+	m_decimation = 1;						// The server resets the decimation
+
 	return hz;
 }
 
@@ -102,6 +102,11 @@ public:
 	// Sets the center frequency of the device
 	uint32_t set_center_frequency(uint32_t hz) const override;
 
+	// set_decimation
+	//
+	// Sets the frequency offset and decimation factor applied by the device
+	uint32_t set_decimation(int offset, uint32_t factor) const override;
+
 	// set_frequency_correction
 	//
 	// Sets the frequency correction of the device
@@ -127,6 +132,16 @@ private:
 	tcpdevice(tcpdevice const&) = delete;
 	tcpdevice& operator=(tcpdevice const&) = delete;
 
+	// RECEIVE_BUFFER_SIZE
+	//
+	// Size of the kernel socket receive buffer (SO_RCVBUF)
+	static int const RECEIVE_BUFFER_SIZE;
+
+	// RING_BUFFER_BLOCKS
+	//
+	// Number of callback-sized blocks held by the asynchronous ring buffer
+	static size_t const RING_BUFFER_BLOCKS;
+
 	// Instance Constructor
 	//
 	tcpdevice(char const* host, uint16_t port);
@@ -175,12 +190,20 @@ private:
 	// Closes an open socket, implementation specific
 	static void close_socket(int socket);
 
+	// read_ring
+	//
+	// Reads as much data from the socket as will fit into a ring buffer
+	size_t read_ring(uint8_t* buffer, size_t buffersize, size_t head, size_t count) const;
+
 	//-----------------------------------------------------------------------
 	// Member Variables
 
 	int					m_socket	= -1;						// TCP/IP socket
 	rtlsdr_tuner		m_tunertype = RTLSDR_TUNER_UNKNOWN;		// Tuner type
 	std::string			m_name;									// Device name
+	bool				m_extended = false;						// Server supports rtl_tcpx
+	uint32_t			m_maxdecimation = 1;					// Maximum decimation factor
+	mutable uint32_t	m_decimation = 1;						// Current decimation factor
 
 	// ASYNCHRONOUS SUPPORT
 	//
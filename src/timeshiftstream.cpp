@@ -0,0 +1,739 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2020-2022 Michael G. Brehm
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#include "stdafx.h"
+#include "timeshiftstream.h"
+
+#include <algorithm>
+#include <chrono>
+#include <memory.h>
+#include <vector>
+
+#include "string_exception.h"
+
+#pragma warning(push, 4)
+
+// timeshiftstream::MAX_LIVE_LATENCY (static)
+//
+// Maximum distance behind the live position that is still considered real-time
+double const timeshiftstream::MAX_LIVE_LATENCY = 5.0 * STREAM_TIME_BASE;
+
+// timeshiftstream::READ_TIMEOUT_MS (static)
+//
+// Maximum time to wait for a packet to become available
+unsigned int const timeshiftstream::READ_TIMEOUT_MS = 50;
+
+//---------------------------------------------------------------------------
+// timeshiftstream Constructor (private)
+//
+// Arguments:
+//
+//	stream		- Underlying PVR stream instance
+//	memorysize	- Length of the memory ring buffer
+//	disksize	- Length of the spill file, or zero for memory only
+//	diskfile	- Spill file name, or nullptr for memory only
+
+timeshiftstream::timeshiftstream(std::unique_ptr<pvrstream> stream, size_t memorysize, uint64_t disksize, char const* diskfile) :
+	m_stream(std::move(stream)), m_memorysize(memorysize), m_diskfile((diskfile) ? diskfile : "")
+{
+	if(!m_stream) throw std::invalid_argument("stream");
+	if(memorysize == 0) throw std::invalid_argument("memorysize");
+
+	// The memory ring is left uninitialized so that pages are only committed as they are written
+	m_memory = std::unique_ptr<uint8_t[]>(new uint8_t[memorysize]);
+
+	// The spill file is optional; if it cannot be created the buffer is limited to the memory ring
+	if((disksize > 0) && (!m_diskfile.empty())) {
+
+		m_disk = fopen(m_diskfile.c_str(), "w+b");
+		if(m_disk != nullptr) m_disksize = disksize;
+	}
+
+	// Create a worker thread on which to perform the transfer operations
+	scalar_condition<bool> started{ false };
+	m_worker = std::thread(&timeshiftstream::transfer, this, std::ref(started));
+	started.wait_until_equals(true);
+}
+
+//---------------------------------------------------------------------------
+// timeshiftstream Destructor
+
+timeshiftstream::~timeshiftstream()
+{
+	close();
+}
+
+//---------------------------------------------------------------------------
+// timeshiftstream::acquisition
+//
+// Gets the signal acquisition state to be cached for the channel
+//
+// Arguments:
+//
+//	acquisitionprops	- Structure to receive the acquisition state
+
+bool timeshiftstream::acquisition(struct acquisitionprops& acquisitionprops) const
+{
+	std::unique_lock<std::mutex> lock(m_streamlock);
+	return m_stream->acquisition(acquisitionprops);
+}
+
+//---------------------------------------------------------------------------
+// timeshiftstream::canpause
+//
+// Flag indicating if the stream can be paused
+//
+// Arguments:
+//
+//	NONE
+
+bool timeshiftstream::canpause(void) const
+{
+	return true;
+}
+
+//---------------------------------------------------------------------------
+// timeshiftstream::canseek
+//
+// Flag indicating if the stream allows seek operations
+//
+// Arguments:
+//
+//	NONE
+
+bool timeshiftstream::canseek(void) const
+{
+	return true;
+}
+
+//---------------------------------------------------------------------------
+// timeshiftstream::close
+//
+// Closes the stream
+//
+// Arguments:
+//
+//	NONE
+
+void timeshiftstream::close(void)
+{
+	// The worker thread has to be stopped before the underlying stream is closed, the
+	// underlying demultiplexer is not safe to use once the stream has been closed; reads
+	// from the underlying streams time out if there is nothing available
+	m_stop = true;								// Signal worker thread to stop
+	if(m_worker.joinable()) m_worker.join();	// Wait for thread
+
+	std::unique_lock<std::mutex> lock(m_streamlock);
+	m_stream->close();							// Close the underlying stream
+	lock.unlock();
+
+	// Close and delete the spill file, the data is of no use once the stream is gone
+	if(m_disk != nullptr) {
+
+		fclose(m_disk);
+		remove(m_diskfile.c_str());
+		m_disk = nullptr;
+	}
+}
+
+//---------------------------------------------------------------------------
+// timeshiftstream::create (static)
+//
+// Factory method, creates a new timeshiftstream instance
+//
+// Arguments:
+//
+//	stream		- Underlying PVR stream instance
+//	memorysize	- Length of the memory ring buffer
+//	disksize	- Length of the spill file, or zero for memory only
+//	diskfile	- Spill file name, or nullptr for memory only
+
+std::unique_ptr<timeshiftstream> timeshiftstream::create(std::unique_ptr<pvrstream> stream, size_t memorysize, uint64_t disksize, char const* diskfile)
+{
+	return std::unique_ptr<timeshiftstream>(new timeshiftstream(std::move(stream), memorysize, disksize, diskfile));
+}
+
+//---------------------------------------------------------------------------
+// timeshiftstream::demuxabort
+//
+// Aborts the demultiplexer
+//
+// Arguments:
+//
+//	NONE
+
+void timeshiftstream::demuxabort(void)
+{
+	std::unique_lock<std::mutex> lock(m_streamlock);
+	m_stream->demuxabort();
+}
+
+//---------------------------------------------------------------------------
+// timeshiftstream::demuxflush
+//
+// Flushes the demultiplexer
+//
+// Arguments:
+//
+//	NONE
+
+void timeshiftstream::demuxflush(void)
+{
+	std::unique_lock<std::mutex> lock(m_streamlock);
+	m_stream->demuxflush();
+
+	// Discard the buffered packets along with those in the underlying stream
+	std::unique_lock<std::mutex> buffer(m_lock);
+	reset();
+}
+
+//---------------------------------------------------------------------------
+// timeshiftstream::demuxread
+//
+// Reads the next packet from the demultiplexer
+//
+// Arguments:
+//
+//	allocator		- DemuxPacket allocation function
+
+DEMUX_PACKET* timeshiftstream::demuxread(std::function<DEMUX_PACKET*(int)> const& allocator)
+{
+	std::unique_lock<std::mutex> lock(m_lock);
+
+	// Wait up to READ_TIMEOUT_MS for there to be a packet available to be read
+	if(!m_cv.wait_for(lock, std::chrono::milliseconds(READ_TIMEOUT_MS), [&]() -> bool { 
+		return ((m_next < m_first + m_packets.size()) || m_stopped.load() == true); })) return allocator(0);
+
+	// If the worker thread was stopped and everything has been read, check for and re-throw any
+	// exception that occurred, otherwise assume it was stopped normally and return an empty packet
+	if(m_next >= m_first + m_packets.size()) {
+
+		if(m_worker_exception) std::rethrow_exception(m_worker_exception);
+		else return allocator(0);
+	}
+
+	// If the stream was paused long enough for the next packet to have been discarded,
+	// resume from the oldest packet that is still available
+	if(m_next < m_first) m_next = m_first;
+
+	struct packet_t const& stored = m_packets[static_cast<size_t>(m_next - m_first)];
+	m_next++;
+
+	// Allocate and initialize the DEMUX_PACKET
+	DEMUX_PACKET* packet = allocator(stored.size);
+	if(packet != nullptr) {
+
+		packet->iStreamId = stored.streamid;
+		packet->iSize = stored.size;
+		packet->duration = stored.duration;
+		packet->dts = packet->pts = stored.pts;
+
+		// A packet that can't be read back from the spill file is sent without any data
+		if((stored.size > 0) && (!fetch(stored.offset, packet->pData, stored.size))) packet->iSize = 0;
+	}
+
+	return packet;
+}
+
+//---------------------------------------------------------------------------
+// timeshiftstream::demuxreset
+//
+// Resets the demultiplexer
+//
+// Arguments:
+//
+//	NONE
+
+void timeshiftstream::demuxreset(void)
+{
+	std::unique_lock<std::mutex> lock(m_streamlock);
+	m_stream->demuxreset();
+
+	// Discard the buffered packets along with those in the underlying stream
+	std::unique_lock<std::mutex> buffer(m_lock);
+	reset();
+}
+
+//---------------------------------------------------------------------------
+// timeshiftstream::enumproperties
+//
+// Enumerates the stream properties
+//
+// Arguments:
+//
+//	callback		- Callback to invoke for each stream
+
+void timeshiftstream::enumproperties(std::function<void(struct streamprops const& props)> const& callback)
+{
+	std::unique_lock<std::mutex> lock(m_streamlock);
+	m_stream->enumproperties(callback);
+}
+
+//---------------------------------------------------------------------------
+// timeshiftstream::fetch (private)
+//
+// Copies stored packet data out of the memory ring or spill file
+//
+// Arguments:
+//
+//	offset		- Logical offset of the data to copy
+//	buffer		- Destination buffer
+//	length		- Length of the data to copy
+
+bool timeshiftstream::fetch(uint64_t offset, uint8_t* buffer, size_t length)
+{
+	assert(buffer != nullptr);
+	assert((offset >= m_tail) && (offset + length <= m_head));
+
+	// The memory ring holds the most recent data, anything older than that is in the spill file
+	uint64_t const boundary = (m_head > m_memorysize) ? m_head - m_memorysize : 0;
+
+	while(length > 0) {
+
+		size_t chunk = 0;
+
+		if(offset >= boundary) {
+
+			size_t const memoffset = static_cast<size_t>(offset % m_memorysize);
+			chunk = std::min(length, m_memorysize - memoffset);
+			memcpy(buffer, &m_memory[memoffset], chunk);
+		}
+
+		else {
+
+			assert(m_disk != nullptr);
+
+			uint64_t const diskoffset = offset % m_disksize;
+			chunk = static_cast<size_t>(std::min({ static_cast<uint64_t>(length), m_disksize - diskoffset, boundary - offset }));
+			if(fseek(m_disk, static_cast<long>(diskoffset), SEEK_SET) != 0) return false;
+			if(fread(buffer, 1, chunk, m_disk) != chunk) return false;
+		}
+
+		offset += chunk;
+		buffer += chunk;
+		length -= chunk;
+	}
+
+	return true;
+}
+
+//---------------------------------------------------------------------------
+// timeshiftstream::length
+//
+// Gets the length of the stream
+//
+// Arguments:
+//
+//	NONE
+
+long long timeshiftstream::length(void) const
+{
+	std::unique_lock<std::mutex> lock(m_lock);
+	return static_cast<long long>(m_head - m_tail);
+}
+
+//---------------------------------------------------------------------------
+// timeshiftstream::pause
+//
+// Pauses or resumes the stream
+//
+// Arguments:
+//
+//	paused		- Flag to pause or resume the stream
+
+void timeshiftstream::pause(bool paused)
+{
+	// The worker thread is unaffected by a pause, the underlying stream continues
+	// to be processed into the buffer until the user resumes playback
+	std::unique_lock<std::mutex> lock(m_lock);
+	m_paused = paused;
+}
+
+//---------------------------------------------------------------------------
+// timeshiftstream::position
+//
+// Gets the current position of the stream
+//
+// Arguments:
+//
+//	NONE
+
+long long timeshiftstream::position(void) const
+{
+	std::unique_lock<std::mutex> lock(m_lock);
+
+	uint64_t const next = std::max(m_next, m_first);
+	if(next >= m_first + m_packets.size()) return static_cast<long long>(m_head - m_tail);
+
+	return static_cast<long long>(m_packets[static_cast<size_t>(next - m_first)].offset - m_tail);
+}
+
+//---------------------------------------------------------------------------
+// timeshiftstream::read
+//
+// Reads data from the live stream
+//
+// Arguments:
+//
+//	buffer		- Buffer to receive the live stream data
+//	count		- Size of the destination buffer in bytes
+
+size_t timeshiftstream::read(uint8_t* /*buffer*/, size_t /*count*/)
+{
+	return 0;
+}
+
+//---------------------------------------------------------------------------
+// timeshiftstream::realtime
+//
+// Gets a flag indicating if the stream is real-time
+//
+// Arguments:
+//
+//	NONE
+
+bool timeshiftstream::realtime(void) const
+{
+	std::unique_lock<std::mutex> lock(m_lock);
+
+	// The stream is only real-time when it's playing at (or very near) the live position
+	if(m_paused) return false;
+
+	uint64_t const next = std::max(m_next, m_first);
+	if(next >= m_first + m_packets.size()) return true;
+
+	return (m_pts - m_packets[static_cast<size_t>(next - m_first)].pts) <= MAX_LIVE_LATENCY;
+}
+
+//---------------------------------------------------------------------------
+// timeshiftstream::reset (private)
+//
+// Discards all stored packets
+//
+// Arguments:
+//
+//	NONE
+
+void timeshiftstream::reset(void)
+{
+	// The logical offsets and time stamps continue from where they were, only
+	// the packets are discarded and the read position is moved to the live position
+	m_first += m_packets.size();
+	m_next = m_first;
+	m_packets.clear();
+	m_tail = m_head;
+
+	// A packet that was being read from the underlying stream when the buffer
+	// was reset belongs to what was discarded and must not be stored
+	m_generation++;
+}
+
+//---------------------------------------------------------------------------
+// timeshiftstream::retune
+//
+// Retunes the stream to a different channel without recreating it
+//
+// Arguments:
+//
+//	tunerprops		- Tuner device properties
+//	channelprops	- Channel properties
+//	subchannel		- Multiplex subchannel number
+
+bool timeshiftstream::retune(struct tunerprops const& tunerprops, struct channelprops const& channelprops, uint32_t subchannel)
+{
+	// Resetting the buffer after the retune also prevents any packet from the previous
+	// channel that the worker thread read just before the retune from being stored
+	std::unique_lock<std::mutex> lock(m_streamlock);
+	if(!m_stream->retune(tunerprops, channelprops, subchannel)) return false;
+
+	// A retuned stream starts playing the new channel live
+	std::unique_lock<std::mutex> buffer(m_lock);
+	reset();
+
+	return true;
+}
+
+//---------------------------------------------------------------------------
+// timeshiftstream::seek
+//
+// Sets the stream pointer to a specific position
+//
+// Arguments:
+//
+//	position	- Delta within the stream to seek, relative to whence
+//	whence		- Starting position from which to apply the delta
+
+long long timeshiftstream::seek(long long position, int whence)
+{
+	std::unique_lock<std::mutex> lock(m_lock);
+
+	long long const length = static_cast<long long>(m_head - m_tail);
+
+	// Convert the requested position into a distance from the oldest available data
+	if(whence == SEEK_CUR) {
+
+		uint64_t const next = std::max(m_next, m_first);
+		position += (next >= m_first + m_packets.size()) ? length : static_cast<long long>(m_packets[static_cast<size_t>(next - m_first)].offset - m_tail);
+	}
+	else if(whence == SEEK_END) position += length;
+	else if(whence != SEEK_SET) return -1;
+
+	uint64_t const target = m_tail + static_cast<uint64_t>(std::max(0LL, std::min(position, length)));
+
+	// Move to the first packet that starts at or after the target position
+	auto found = std::lower_bound(m_packets.begin(), m_packets.end(), target, [](struct packet_t const& packet, uint64_t offset) -> bool {
+		return packet.offset < offset; });
+
+	m_next = m_first + static_cast<uint64_t>(found - m_packets.begin());
+
+	return (found == m_packets.end()) ? length : static_cast<long long>(found->offset - m_tail);
+}
+
+//---------------------------------------------------------------------------
+// timeshiftstream::seektime
+//
+// Sets the stream pointer to a specific presentation time
+//
+// Arguments:
+//
+//	time		- Presentation time to seek to, in milliseconds
+//	backwards	- Flag indicating the direction of the seek
+//	startpts	- Receives the presentation time stamp at the new position
+
+bool timeshiftstream::seektime(double time, bool backwards, double& startpts)
+{
+	std::unique_lock<std::mutex> lock(m_lock);
+
+	if(m_packets.empty()) return false;
+
+	// The packet time stamps are continuous, so the nearest packet can be found with a binary search
+	double const target = time * (STREAM_TIME_BASE / 1000);
+	auto found = std::lower_bound(m_packets.begin(), m_packets.end(), target, [](struct packet_t const& packet, double pts) -> bool {
+		return packet.pts < pts; });
+
+	// When seeking backwards, move to the packet that contains the target time rather than the one after it
+	if(backwards && (found != m_packets.begin()) && ((found == m_packets.end()) || (found->pts > target))) --found;
+	if(found == m_packets.end()) --found;
+
+	m_next = m_first + static_cast<uint64_t>(found - m_packets.begin());
+	startpts = found->pts;
+
+	return true;
+}
+
+//---------------------------------------------------------------------------
+// timeshiftstream::spill (private)
+//
+// Writes data being evicted from the memory ring into the spill file
+//
+// Arguments:
+//
+//	offset		- Logical offset of the evicted data
+//	data		- Pointer to the evicted data
+//	length		- Length of the evicted data
+
+void timeshiftstream::spill(uint64_t offset, uint8_t const* data, size_t length)
+{
+	assert(data != nullptr);
+
+	if(m_disk == nullptr) return;
+
+	while(length > 0) {
+
+		uint64_t const diskoffset = offset % m_disksize;
+		size_t const chunk = static_cast<size_t>(std::min(static_cast<uint64_t>(length), m_disksize - diskoffset));
+
+		// If the data can't be written it's lost; move the tail past it so it will never be read
+		if((fseek(m_disk, static_cast<long>(diskoffset), SEEK_SET) != 0) || (fwrite(data, 1, chunk, m_disk) != chunk))
+			m_tail = std::max(m_tail, offset + chunk);
+
+		offset += chunk;
+		data += chunk;
+		length -= chunk;
+	}
+}
+
+//---------------------------------------------------------------------------
+// timeshiftstream::store (private)
+//
+// Stores a demultiplexer packet from the underlying stream
+//
+// Arguments:
+//
+//	packet		- Demultiplexer packet to be stored
+
+void timeshiftstream::store(DEMUX_PACKET const* packet)
+{
+	assert(packet != nullptr);
+
+	size_t const size = static_cast<size_t>(std::max(packet->iSize, 0));
+	if(size > m_memorysize) return;
+
+	// The underlying streams reset their time stamps when retuned; restamp each packet onto a
+	// continuous timeline so that the stored packets can be located by presentation time
+	struct packet_t stored = { m_head, packet->iStreamId, static_cast<int>(size), packet->duration, m_pts };
+	if(packet->duration > 0.0) m_pts += packet->duration;
+
+	// Copy the packet data into the memory ring; the data being overwritten is spilled to disk first
+	uint64_t offset = m_head;
+	uint8_t const* data = packet->pData;
+	size_t length = size;
+
+	while(length > 0) {
+
+		size_t const memoffset = static_cast<size_t>(offset % m_memorysize);
+		size_t const chunk = std::min(length, m_memorysize - memoffset);
+
+		if(offset >= m_memorysize) spill(offset - m_memorysize, &m_memory[memoffset], chunk);
+		memcpy(&m_memory[memoffset], data, chunk);
+
+		offset += chunk;
+		data += chunk;
+		length -= chunk;
+	}
+
+	m_head = offset;
+	m_packets.push_back(stored);
+
+	// Discard the packets that no longer fit in the memory ring and the spill file
+	uint64_t const capacity = m_memorysize + m_disksize;
+	if(m_head > capacity) m_tail = std::max(m_tail, m_head - capacity);
+
+	while((!m_packets.empty()) && (m_packets.front().offset < m_tail)) {
+
+		m_packets.pop_front();
+		m_first++;
+	}
+
+	m_cv.notify_all();
+}
+
+//---------------------------------------------------------------------------
+// timeshiftstream::status
+//
+// Gets the most recently published signal status of the stream
+//
+// Arguments:
+//
+//	NONE
+
+std::shared_ptr<struct signalstatus const> timeshiftstream::status(void) const
+{
+	// The underlying stream is never replaced and publishes its own status, there
+	// is no need to synchronize with the buffer thread to forward it
+	return m_stream->status();
+}
+
+//---------------------------------------------------------------------------
+// timeshiftstream::timerange
+//
+// Gets the range of presentation times that can be seeked to
+//
+// Arguments:
+//
+//	begin		- Receives the earliest presentation time stamp
+//	end			- Receives the latest presentation time stamp
+
+bool timeshiftstream::timerange(double& begin, double& end) const
+{
+	std::unique_lock<std::mutex> lock(m_lock);
+
+	if(m_packets.empty()) return false;
+
+	begin = m_packets.front().pts;
+	end = m_pts;
+
+	return true;
+}
+
+//---------------------------------------------------------------------------
+// timeshiftstream::transfer (private)
+//
+// Worker thread procedure used to transfer packets into the buffer
+//
+// Arguments:
+//
+//	started		- Condition variable to set when thread has started
+
+void timeshiftstream::transfer(scalar_condition<bool>& started)
+{
+	DEMUX_PACKET				packet = {};			// Packet returned by the allocator
+	std::vector<uint8_t>		data;					// Packet data buffer
+
+	// allocator (local)
+	//
+	// Demultiplexer packet allocator that reuses a single packet and data buffer
+	auto allocator = [&](int size) -> DEMUX_PACKET* {
+
+		data.resize(static_cast<size_t>(std::max(size, 0)));
+
+		packet = DEMUX_PACKET();
+		packet.pData = data.data();
+		packet.iSize = size;
+		packet.iStreamId = -1;
+		packet.pts = packet.dts = STREAM_NOPTS_VALUE;
+
+		return &packet;
+	};
+
+	started = true;
+
+	try {
+
+		while(m_stop.test(false)) {
+
+			// The underlying stream is only ever accessed by one thread at a time; reads time out
+			// quickly so a retune or flush waits no longer than a single read.  The buffer lock is
+			// not held during the read, the buffer generation identifies a packet that was read
+			// before a reset of the buffer that happened while the stream lock was released
+			std::unique_lock<std::mutex> stream(m_streamlock);
+
+			std::unique_lock<std::mutex> buffer(m_lock);
+			uint64_t const generation = m_generation;
+			buffer.unlock();
+
+			DEMUX_PACKET const* demuxpacket = m_stream->demuxread(allocator);
+			stream.unlock();
+
+			// Empty packets indicate that nothing was available from the underlying stream,
+			// the only empty packets that need to be stored are stream change notifications
+			if((demuxpacket != nullptr) && ((demuxpacket->iSize > 0) || (demuxpacket->iStreamId == DEMUX_SPECIALID_STREAMCHANGE))) {
+
+				buffer.lock();
+				if(generation == m_generation) store(demuxpacket);
+			}
+
+			else m_stop.wait_until_equals(true, 10);
+		}
+	}
+
+	catch(...) { m_worker_exception = std::current_exception(); }
+
+	// Wake up the demultiplexer to return the final packets or re-throw the exception
+	std::unique_lock<std::mutex> lock(m_lock);
+	m_stopped.store(true);
+	m_cv.notify_all();
+}
+
+//---------------------------------------------------------------------------
+
+#pragma warning(pop)
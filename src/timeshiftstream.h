@@ -0,0 +1,261 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2020-2022 Michael G. Brehm
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#ifndef __TIMESHIFTSTREAM_H_
+#define __TIMESHIFTSTREAM_H_
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <stdio.h>
+#include <string>
+#include <thread>
+
+#include "pvrstream.h"
+#include "scalar_condition.h"
+
+#pragma warning(push, 4)
+
+//---------------------------------------------------------------------------
+// Class timeshiftstream
+//
+// Implements a timeshift buffer around another PVR stream.  A worker thread
+// keeps reading the demultiplexer packets from the underlying stream so the
+// DSP continues to run while the stream is paused; the packets are restamped
+// onto a continuous timeline and stored in a fixed-size memory ring, and the
+// oldest data is spilled into a fixed-size circular file on disk as the
+// memory ring is overwritten
+
+class timeshiftstream : public pvrstream
+{
+public:
+
+	// Destructor
+	//
+	virtual ~timeshiftstream();
+
+	//-----------------------------------------------------------------------
+	// Member Functions
+
+	// acquisition
+	//
+	// Gets the signal acquisition state to be cached for the channel
+	bool acquisition(struct acquisitionprops& acquisitionprops) const override;
+
+	// canpause
+	//
+	// Flag indicating if the stream can be paused
+	bool canpause(void) const override;
+
+	// canseek
+	//
+	// Flag indicating if the stream allows seek operations
+	bool canseek(void) const override;
+
+	// close
+	//
+	// Closes the stream
+	void close(void) override;
+
+	// create (static)
+	//
+	// Factory method, creates a new timeshiftstream instance
+	static std::unique_ptr<timeshiftstream> create(std::unique_ptr<pvrstream> stream, size_t memorysize, uint64_t disksize, char const* diskfile);
+
+	// demuxabort
+	//
+	// Aborts the demultiplexer
+	void demuxabort(void) override;
+
+	// demuxflush
+	//
+	// Flushes the demultiplexer
+	void demuxflush(void) override;
+
+	// demuxread
+	//
+	// Reads the next packet from the demultiplexer
+	DEMUX_PACKET* demuxread(std::function<DEMUX_PACKET*(int)> const& allocator) override;
+
+	// demuxreset
+	//
+	// Resets the demultiplexer
+	void demuxreset(void) override;
+
+	// enumproperties
+	//
+	// Enumerates the stream properties
+	void enumproperties(std::function<void(struct streamprops const& props)> const& callback) override;
+
+	// length
+	//
+	// Gets the length of the stream
+	long long length(void) const override;
+
+	// pause
+	//
+	// Pauses or resumes the stream
+	void pause(bool paused) override;
+
+	// position
+	//
+	// Gets the current position of the stream
+	long long position(void) const override;
+
+	// read
+	//
+	// Reads available data from the stream
+	size_t read(uint8_t* buffer, size_t count) override;
+
+	// realtime
+	//
+	// Gets a flag indicating if the stream is real-time
+	bool realtime(void) const override;
+
+	// retune
+	//
+	// Retunes the stream to a different channel without recreating it
+	bool retune(struct tunerprops const& tunerprops, struct channelprops const& channelprops, uint32_t subchannel) override;
+
+	// seek
+	//
+	// Sets the stream pointer to a specific position
+	long long seek(long long position, int whence) override;
+
+	// seektime
+	//
+	// Sets the stream pointer to a specific presentation time
+	bool seektime(double time, bool backwards, double& startpts) override;
+
+	// status
+	//
+	// Gets the most recently published signal status of the stream
+	std::shared_ptr<struct signalstatus const> status(void) const override;
+
+	// timerange
+	//
+	// Gets the range of presentation times that can be seeked to
+	bool timerange(double& begin, double& end) const override;
+
+private:
+
+	timeshiftstream(timeshiftstream const&) = delete;
+	timeshiftstream& operator=(timeshiftstream const&) = delete;
+
+	// MAX_LIVE_LATENCY
+	//
+	// Maximum distance behind the live position that is still considered real-time
+	static double const MAX_LIVE_LATENCY;
+
+	// READ_TIMEOUT_MS
+	//
+	// Maximum time to wait for a packet to become available
+	static unsigned int const READ_TIMEOUT_MS;
+
+	// Instance Constructor
+	//
+	timeshiftstream(std::unique_ptr<pvrstream> stream, size_t memorysize, uint64_t disksize, char const* diskfile);
+
+	//-----------------------------------------------------------------------
+	// Private Type Declarations
+
+	// packet_t
+	//
+	// Defines a single stored demultiplexer packet
+	struct packet_t {
+
+		uint64_t			offset;			// Logical offset of the packet data
+		int					streamid;		// Packet stream identifier
+		int					size;			// Length of the packet data
+		double				duration;		// Packet duration
+		double				pts;			// Restamped presentation time stamp
+	};
+
+	//-----------------------------------------------------------------------
+	// Private Member Functions
+
+	// fetch
+	//
+	// Copies stored packet data out of the memory ring or spill file
+	bool fetch(uint64_t offset, uint8_t* buffer, size_t length);
+
+	// reset
+	//
+	// Discards all stored packets
+	void reset(void);
+
+	// spill
+	//
+	// Writes data being evicted from the memory ring into the spill file
+	void spill(uint64_t offset, uint8_t const* data, size_t length);
+
+	// store
+	//
+	// Stores a demultiplexer packet from the underlying stream
+	void store(DEMUX_PACKET const* packet);
+
+	// transfer
+	//
+	// Worker thread procedure used to transfer packets into the buffer
+	void transfer(scalar_condition<bool>& started);
+
+	//-----------------------------------------------------------------------
+	// Member Variables
+
+	std::unique_ptr<pvrstream>			m_stream;					// Underlying PVR stream
+	mutable std::mutex					m_streamlock;				// Synchronization object
+
+	// BUFFER
+	//
+	size_t const						m_memorysize;				// Length of the memory ring
+	std::unique_ptr<uint8_t[]>			m_memory;					// Memory ring buffer
+	uint64_t							m_disksize = 0;				// Length of the spill file
+	std::string const					m_diskfile;					// Spill file name
+	FILE*								m_disk = nullptr;			// Spill file handle
+	std::deque<struct packet_t>			m_packets;					// Stored packets
+	uint64_t							m_first = 0;				// Sequence of the first stored packet
+	uint64_t							m_next = 0;					// Sequence of the next packet to read
+	uint64_t							m_head = 0;					// Logical write offset
+	uint64_t							m_tail = 0;					// Logical offset of oldest data
+	uint64_t							m_generation = 0;			// Incremented when buffer is reset
+	double								m_pts{ STREAM_TIME_BASE };	// Next restamped time stamp
+	bool								m_paused = false;			// Flag indicating stream is paused
+	mutable std::mutex					m_lock;						// Synchronization object
+	std::condition_variable				m_cv;						// Packet stored event condvar
+
+	// STREAM CONTROL
+	//
+	std::thread							m_worker;					// Data transfer thread
+	std::exception_ptr					m_worker_exception;			// Exception on worker thread
+	scalar_condition<bool>				m_stop{ false };			// Condition to stop data transfer
+	std::atomic<bool>					m_stopped{ false };			// Data transfer stopped flag
+};
+
+//-----------------------------------------------------------------------------
+
+#pragma warning(pop)
+
+#endif	// __TIMESHIFTSTREAM_H_
@@ -181,6 +181,25 @@ uint32_t usbdevice::get_center_frequency(void) const
 	return rtlsdr_get_center_freq(m_device);
 }
 
+//---------------------------------------------------------------------------
+// usbdevice::get_device_count (static)
+//
+// Gets the number of connected RTL-SDR devices
+//
+// Arguments:
+//
+//	NONE
+
+uint32_t usbdevice::get_device_count(void)
+{
+#ifdef __ANDROID__
+	kodi::platform::CInterfaceAndroidSystem system;
+	libusb_set_option(nullptr, LIBUSB_OPTION_ANDROID_JNIENV, system.GetJNIEnv());
+#endif
+
+	return rtlsdr_get_device_count();
+}
+
 //---------------------------------------------------------------------------
 // usbdevice::get_device_name
 //
@@ -399,6 +418,21 @@ uint32_t usbdevice::set_center_frequency(uint32_t hz) const
 	return rtlsdr_get_center_freq(m_device);
 }
 
+//---------------------------------------------------------------------------
+// usbdevice::set_decimation
+//
+// Sets the frequency offset and decimation factor applied by the device
+//
+// Arguments:
+//
+//	offset		- Frequency offset to shift to zero, specified in hertz
+//	factor		- Requested decimation factor
+
+uint32_t usbdevice::set_decimation(int /*offset*/, uint32_t /*factor*/) const
+{
+	return 1;				// Decimation is not supported
+}
+
 //---------------------------------------------------------------------------
 // usbdevice::set_frequency_correction
 //
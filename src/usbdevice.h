@@ -77,6 +77,11 @@ public:
 	// Gets the center frequency of the device
 	uint32_t get_center_frequency(void) const;
 
+	// get_device_count (static)
+	//
+	// Gets the number of connected RTL-SDR devices
+	static uint32_t get_device_count(void);
+
 	// get_device_name
 	//
 	// Gets the name of the device
@@ -137,6 +142,11 @@ public:
 	// Sets the center frequency of the device
 	uint32_t set_center_frequency(uint32_t hz) const override;
 
+	// set_decimation
+	//
+	// Sets the frequency offset and decimation factor applied by the device
+	uint32_t set_decimation(int offset, uint32_t factor) const override;
+
 	// set_frequency_correction
 	//
 	// Sets the frequency correction of the device